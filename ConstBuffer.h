@@ -1,27 +1,112 @@
 #pragma once
+#include <cstring>
+#include <memory>
 #include "DirectXUtil.h"
 #include "DirectXBase.h"
+#include "ConstantBufferPool.h"
 
 template<class Type>class ConstBuffer {
 public:
 	// trueを指定した場合には空で生成される
-	ConstBuffer(bool isEmpty = false) { if (!isEmpty)Create(); };
-
-	void Create() {
-		// リソースを作る
-		resource_ = CreateBufferResource(DirectXBase::GetInstance()->GetDevice(), sizeof(Type));
-		// データを書き込む
-		data_ = nullptr;
-		// 書き込むためのアドレスを取得
-		resource_->Map(0, nullptr, reinterpret_cast<void**>(&data_));
+	// useShadowCopyにtrueを指定すると、data_はCPU側のコピーを指し、変わっていればGPUのアドレスを取得するときにまとめて書き込む
+	// （アップロード用のヒープはライトコンバインで読み出しが非常に遅いので、ImGuiで編集するなど読み出す場合に使う）
+	// 前のフレームをGPUが実行している間に書き換えることになるので、作った後に書き換える場合もuseShadowCopyを指定する（フレームごとの領域に書き込まれる）
+	ConstBuffer(bool isEmpty = false, bool useShadowCopy = false) { if (!isEmpty)Create(useShadowCopy); };
+	~ConstBuffer() { Release(); }
+
+	void Create(bool useShadowCopy = false) {
+		Release();
+		// 共有のページから領域を切り出す（リソースは作らない）
+		allocation_ = ConstantBufferPool::Allocate(sizeof(Type));
+		// 書き込むためのアドレス
+		data_ = static_cast<Type*>(allocation_.cpuAddress);
+
+		// CPU側のコピーを使う場合は、最初のGetGPUVirtualAddressで必ず書き込む
+		if (useShadowCopy) {
+			shadow_ = std::make_unique<ShadowCopy>();
+			shadow_->isDirty = true;
+			data_ = &shadow_->current;
+			// 2つ目以降のフレームの領域を確保する（最初のフレームはallocation_を使う）
+			uint32_t framesInFlight = DirectXBase::GetInstance()->GetFramesInFlight();
+			for (uint32_t i = 1; i < framesInFlight; ++i) {
+				shadow_->frameAllocations[i] = ConstantBufferPool::Allocate(sizeof(Type));
+			}
+		}
 	};
 
-	Microsoft::WRL::ComPtr<ID3D12Resource> resource_;
-	Type* data_;
+	// GPU上のアドレス（CPU側のコピーを使う場合は、変わっていれば先に書き込み、このフレームの領域のアドレスを返す）
+	D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() const {
+		if (!shadow_) {
+			return allocation_.gpuAddress;
+		}
+		Flush();
+		return GetFrameAllocation(DirectXBase::GetInstance()->GetFrameIndex()).gpuAddress;
+	}
+	// 空で生成された場合はfalse
+	bool IsCreated() const { return data_ != nullptr; }
+
+	// CPU側のコピーを書き換えたことを記録する（記録しなくても、内容を比べて変わっていれば書き込まれる）
+	void MarkDirty() {
+		if (shadow_) {
+			shadow_->isDirty = true;
+		}
+	}
+	// CPU側のコピーが最後に書き込んだ内容から変わっていれば、このフレームの領域に全体を1回で書き込む
+	// （他のフレームの領域は、そのフレームでGPUのアドレスを取得するときに書き込む）
+	void Flush() const {
+		if (!shadow_) {
+			return;
+		}
+		if (shadow_->isDirty || std::memcmp(&shadow_->current, &shadow_->uploaded, sizeof(Type)) != 0) {
+			std::memcpy(&shadow_->uploaded, &shadow_->current, sizeof(Type));
+			shadow_->isDirty = false;
+			shadow_->version++;
+		}
+		uint32_t frameIndex = DirectXBase::GetInstance()->GetFrameIndex();
+		if (shadow_->frameVersions[frameIndex] != shadow_->version) {
+			WriteToUploadHeap(GetFrameAllocation(frameIndex).cpuAddress, &shadow_->uploaded, sizeof(Type));
+			shadow_->frameVersions[frameIndex] = shadow_->version;
+		}
+	}
+
+	Type* data_ = nullptr;
 
 	// コピー不可にする
 	ConstBuffer(const ConstBuffer&) = delete;
 	ConstBuffer(ConstBuffer&&) = delete;
 	ConstBuffer& operator=(const ConstBuffer&) = delete;
 	ConstBuffer& operator=(ConstBuffer&&) = delete;
+
+private:
+	// CPU側のコピーと、最後にGPUのメモリに書き込んだ内容
+	struct ShadowCopy {
+		Type current{};
+		Type uploaded{};
+		bool isDirty = false;
+		// uploadedが変わるたびに増える値と、フレームの領域ごとの書き込んだ時の値
+		uint64_t version = 0;
+		uint64_t frameVersions[DirectXBase::kMaxFramesInFlight] = {};
+		// 2つ目以降のフレームの領域
+		ConstantBufferPool::Allocation frameAllocations[DirectXBase::kMaxFramesInFlight];
+	};
+
+	const ConstantBufferPool::Allocation& GetFrameAllocation(uint32_t frameIndex) const {
+		return frameIndex == 0 ? allocation_ : shadow_->frameAllocations[frameIndex];
+	}
+
+	void Release() {
+		if (data_) {
+			ConstantBufferPool::Free(allocation_);
+			if (shadow_) {
+				for (uint32_t i = 1; i < DirectXBase::kMaxFramesInFlight; ++i) {
+					ConstantBufferPool::Free(shadow_->frameAllocations[i]);
+				}
+			}
+			data_ = nullptr;
+			shadow_.reset();
+		}
+	}
+
+	ConstantBufferPool::Allocation allocation_;
+	std::unique_ptr<ShadowCopy> shadow_;
 };
@@ -13,7 +13,12 @@ Camera::Camera(Float3 argTranslate, Float3 argRotate, float argFov)
 
 void Camera::TransferConstantBuffer()
 {
-	DirectXBase::GetInstance()->GetCommandList()->SetGraphicsRootConstantBufferView(4, current_->cameraCB_.resource_->GetGPUVirtualAddress());
+	TransferConstantBuffer(DirectXBase::GetInstance()->GetBackend());
+}
+
+void Camera::TransferConstantBuffer(RenderBackend& backend)
+{
+	backend.SetConstantBuffer(4, current_->cameraCB_.GetGPUVirtualAddress());
 }
 
 Matrix Camera::MakeViewMatrix()
@@ -1,6 +1,7 @@
 #pragma once
 #include "MyMath.h"
 #include "ConstBuffer.h"
+#include "RenderBackend.h"
 
 struct CameraCBData {
 	Float3 position;
@@ -12,6 +13,8 @@ public:
 	Camera(Float3 translate, Float3 rotate = Float3(0.0f, 0.0f, 0.0f), float fov = PIf / 2.0f);
 
 	static void TransferConstantBuffer();
+	// 指定した記録先に設定する（並列に記録するときは、先に引数なしで呼んで書き込んでおく）
+	static void TransferConstantBuffer(RenderBackend& backend);
 
 	// カメラの情報を保持
 	Transform transform;
@@ -0,0 +1,995 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <map>
+#include <random>
+
+// MyClass
+#include "Logger.h"
+#include "ModelManager.h"
+#include "TextureManager.h"
+#include "TextureCooker.h"
+#include "ParallelFor.h"
+#include "DescriptorAllocator.h"
+#include "MipResidency.h"
+#include "AtlasPacker.h"
+#include "MipGenerator.h"
+#include "PngDecoder.h"
+#include "MappedFile.h"
+#include "VirtualTexture.h"
+#include "TlsfAllocator.h"
+#include "FrameRing.h"
+#include "FrameLimiter.h"
+#include "DrawPartition.h"
+#include "WorkerPool.h"
+#include "Matrix.h"
+#include "RenderGraph.h"
+#include "AliasingPlanner.h"
+
+namespace {
+	// 処理にかかった時間をミリ秒で計測する
+	template<class Function>
+	double MeasureMilliseconds(Function function)
+	{
+		auto start = std::chrono::steady_clock::now();
+		function();
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	// Textureのヒープ上のアラインメント（64KiB）に切り上げる
+	uint64_t AlignTo64KiB(uint64_t size)
+	{
+		const uint64_t kAlignment = 64 * 1024;
+		return (size + kAlignment - 1) / kAlignment * kAlignment;
+	}
+
+	// 時刻を進めるだけの時計（眠るとOSのスケジューラのように0.2～1.5ms長く眠る）
+	class FakeFrameClock : public FrameClock
+	{
+	public:
+		int64_t Now() override { return time_ += kNowCost; }
+		void Sleep(int64_t nanoseconds) override {
+			int64_t oversleep = std::uniform_int_distribution<int64_t>(200000, 1500000)(random_);
+			time_ += nanoseconds + oversleep;
+			sleptTime_ += nanoseconds + oversleep;
+		}
+		void Spin() override {
+			time_ += kSpinCost;
+			spunTime_ += kSpinCost;
+		}
+		// フレームの処理で時間を進める
+		void Advance(int64_t nanoseconds) { time_ += nanoseconds; }
+
+		int64_t GetSleptTime() const { return sleptTime_; }
+		int64_t GetSpunTime() const { return spunTime_; }
+
+	private:
+		static constexpr int64_t kNowCost = 50;
+		static constexpr int64_t kSpinCost = 100;
+		std::mt19937 random_{ 11 };
+		int64_t time_ = 0;
+		int64_t sleptTime_ = 0;
+		int64_t spunTime_ = 0;
+	};
+
+	// チャンクごとに描画のコマンドを書き込み、提出されたチャンクの数を覚えておく記録先
+	class MockCommandSink : public DrawCommandSink
+	{
+	public:
+		// 1つの描画で書き込むコマンド
+		struct DrawCommand {
+			size_t drawIndex;
+			Matrix wvp;
+		};
+
+		void BeginChunk(uint32_t chunk) override {
+			// チャンクごとの領域は最初に全て用意しておく
+			assert(chunk < chunks_.size());
+			chunks_[chunk].clear();
+		}
+		void EndChunk(uint32_t) override {}
+		void Submit(uint32_t chunkCount) override { submittedChunkCount_ = chunkCount; }
+
+		// 記録する前にチャンクの領域を用意する
+		void Reset(uint32_t maxChunkCount) { chunks_.resize(maxChunkCount); }
+		void Record(uint32_t chunk, size_t drawIndex, const Matrix& wvp) { chunks_[chunk].push_back({ drawIndex, wvp }); }
+
+		uint32_t GetSubmittedChunkCount() const { return submittedChunkCount_; }
+
+	private:
+		std::vector<std::vector<DrawCommand>> chunks_;
+		uint32_t submittedChunkCount_ = 0;
+	};
+
+	// フレームの間隔（ナノ秒）の平均と標準偏差、目標から0.5ms以上ずれたフレームの数をログに出す
+	void LogFrameIntervals(const char* name, const std::vector<int64_t>& intervals, int64_t targetInterval)
+	{
+		double sum = 0.0;
+		for (int64_t interval : intervals) {
+			sum += double(interval);
+		}
+		double mean = sum / double(intervals.size());
+		double variance = 0.0;
+		uint32_t missedFrames = 0;
+		for (int64_t interval : intervals) {
+			variance += (double(interval) - mean) * (double(interval) - mean);
+			missedFrames += std::abs(interval - targetInterval) > 500000;
+		}
+		Log(std::format("    {} : average {:.3f}ms, jitter {:.3f}ms, {} frames off by more than 0.5ms, drift {:.2f}ms\n",
+			name, mean / 1000000.0, std::sqrt(variance / double(intervals.size())) / 1000000.0, missedFrames, (sum - double(targetInterval) * double(intervals.size())) / 1000000.0));
+	}
+
+	// 比較用の、空きをオフセット順に持って先頭から探すファーストフィット
+	class FirstFitAllocator
+	{
+	public:
+		explicit FirstFitAllocator(uint64_t capacity) { freeBlocks_[0] = capacity; }
+
+		uint64_t Allocate(uint64_t size, uint64_t alignment)
+		{
+			for (auto it = freeBlocks_.begin(); it != freeBlocks_.end(); ++it) {
+				uint64_t offset = (it->first + alignment - 1) / alignment * alignment;
+				uint64_t end = it->first + it->second;
+				if (offset + size > end) {
+					continue;
+				}
+				// 前後の余りを空きとして残す
+				uint64_t blockOffset = it->first;
+				freeBlocks_.erase(it);
+				if (offset > blockOffset) {
+					freeBlocks_[blockOffset] = offset - blockOffset;
+				}
+				if (offset + size < end) {
+					freeBlocks_[offset + size] = end - (offset + size);
+				}
+				allocations_[offset] = size;
+				return offset;
+			}
+			return TlsfAllocator::kInvalidOffset;
+		}
+
+		void Free(uint64_t offset)
+		{
+			auto allocation = allocations_.find(offset);
+			uint64_t size = allocation->second;
+			allocations_.erase(allocation);
+
+			// 前後の空きとつなげる
+			auto next = freeBlocks_.lower_bound(offset);
+			if (next != freeBlocks_.end() && next->first == offset + size) {
+				size += next->second;
+				next = freeBlocks_.erase(next);
+			}
+			if (next != freeBlocks_.begin()) {
+				auto previous = std::prev(next);
+				if (previous->first + previous->second == offset) {
+					previous->second += size;
+					return;
+				}
+			}
+			freeBlocks_[offset] = size;
+		}
+
+	private:
+		std::map<uint64_t, uint64_t> freeBlocks_;
+		std::map<uint64_t, uint64_t> allocations_;
+	};
+}
+
+void Benchmark::CompareModelLoad(const std::string& directoryPath, const std::vector<std::string>& modelNames, ID3D12Device* device)
+{
+	Log("Benchmark::CompareModelLoad\n");
+	for (const std::string& name : modelNames) {
+		std::string objFilename = name + ".obj";
+		std::string glbFilename = name + ".glb";
+		// 両方の形式が揃っているメッシュだけを比較する
+		if (!std::filesystem::exists(directoryPath + "/" + objFilename) || !std::filesystem::exists(directoryPath + "/" + glbFilename)) {
+			Log(std::format("  {} : skipped (both {} and {} are required)\n", name, objFilename, glbFilename));
+			continue;
+		}
+
+		ModelData objModel, glbModel;
+		double objMilliseconds = MeasureMilliseconds([&]() { objModel = ModelManager::LoadObjFileStreaming(directoryPath, objFilename, device); });
+		double glbMilliseconds = MeasureMilliseconds([&]() { glbModel = ModelManager::LoadGltfFile(directoryPath, glbFilename, device); });
+		Log(std::format("  {} : obj {:.3f}ms ({} vertices) / glb {:.3f}ms ({} vertices) / x{:.1f}\n",
+			name, objMilliseconds, objModel.vertexCount, glbMilliseconds, glbModel.vertexCount, objMilliseconds / glbMilliseconds));
+	}
+}
+
+void Benchmark::CompareObjLoaders(const std::string& directoryPath, const std::vector<std::string>& modelNames, ID3D12Device* device)
+{
+	Log("Benchmark::CompareObjLoaders\n");
+	for (const std::string& name : modelNames) {
+		std::string filename = name + ".obj";
+		ModelMemoryReport originalReport, streamingReport;
+		ModelData originalModel, streamingModel;
+		double originalMilliseconds = MeasureMilliseconds([&]() { originalModel = ModelManager::LoadObjFile(directoryPath, filename, device, &originalReport); });
+		double streamingMilliseconds = MeasureMilliseconds([&]() { streamingModel = ModelManager::LoadObjFileStreaming(directoryPath, filename, device, false, &streamingReport); });
+		Log(std::format("  {} : original {:.3f}ms (peakCPU {} bytes, steadyCPU {} bytes, GPU {} bytes) / streaming {:.3f}ms (peakCPU {} bytes, steadyCPU {} bytes, GPU {} bytes)\n",
+			name, originalMilliseconds, originalReport.peakCpuBytes, originalReport.steadyCpuBytes, originalReport.gpuBytes,
+			streamingMilliseconds, streamingReport.peakCpuBytes, streamingReport.steadyCpuBytes, streamingReport.gpuBytes));
+		// メモリ使用量の大小はTests/ObjParserTestで確認する（ここでは時間と合わせて記録するだけ）
+		Log(std::format("  {} : vertices {} -> {} (indices {})\n", name, originalModel.vertexCount, streamingModel.vertexCount, streamingModel.indexCount));
+	}
+}
+
+void Benchmark::CompareTextureLoad(const std::vector<std::string>& filePaths)
+{
+	Log("Benchmark::CompareTextureLoad\n");
+	for (const std::string& filePath : filePaths) {
+		// 変換済みのものだけを比較する
+		if (!TextureCooker::IsCookedUpToDate(filePath)) {
+			Log(std::format("  {} : skipped (run with -cook first)\n", filePath));
+			continue;
+		}
+
+		DirectX::ScratchImage sourceImages, cookedImages;
+		double sourceMilliseconds = MeasureMilliseconds([&]() { sourceImages = TextureManager::LoadTexture(filePath); });
+		double cookedMilliseconds = MeasureMilliseconds([&]() { cookedImages = TextureManager::LoadCookedTexture(TextureCooker::GetCookedPath(filePath)); });
+		Log(std::format("  {} : decode {:.3f}ms ({}KB) / dds {:.3f}ms ({}KB) / time x{:.1f}, memory x{:.1f}\n",
+			filePath, sourceMilliseconds, sourceImages.GetPixelsSize() / 1024, cookedMilliseconds, cookedImages.GetPixelsSize() / 1024,
+			sourceMilliseconds / cookedMilliseconds, double(sourceImages.GetPixelsSize()) / double(cookedImages.GetPixelsSize())));
+	}
+}
+
+void Benchmark::MeasureTextureDecodeThreads(const std::vector<std::string>& directoryPaths, uint32_t maxThreadCount)
+{
+	Log("Benchmark::MeasureTextureDecodeThreads\n");
+
+	// 計測対象の画像を集める
+	std::vector<std::string> filePaths;
+	for (const std::string& directoryPath : directoryPaths) {
+		for (const auto& entry : std::filesystem::directory_iterator(directoryPath)) {
+			if (entry.is_regular_file() && entry.path().extension() == ".png") {
+				filePaths.push_back(entry.path().generic_string());
+			}
+		}
+	}
+
+	// キャッシュを通さずに、LoadBatchで並列化しているデコードとミップマップ生成だけを計測する
+	double singleThreadMilliseconds = 0.0;
+	for (uint32_t threadCount = 1; threadCount <= maxThreadCount; ++threadCount) {
+		std::vector<DirectX::ScratchImage> mipImages(filePaths.size());
+		double milliseconds = MeasureMilliseconds([&]() {
+			ParallelFor(filePaths.size(), threadCount, [&](size_t i) { mipImages[i] = TextureManager::LoadTexture(filePaths[i], 1); });
+		});
+		if (threadCount == 1) {
+			singleThreadMilliseconds = milliseconds;
+		}
+		Log(std::format("  {} threads : {} textures {:.3f}ms / x{:.2f}\n", threadCount, filePaths.size(), milliseconds, singleThreadMilliseconds / milliseconds));
+	}
+}
+
+void Benchmark::MeasureDescriptorAllocator(uint32_t descriptorCount, uint32_t frameCount)
+{
+	Log("Benchmark::MeasureDescriptorAllocator\n");
+
+	// 容量を増やしながら全て確保する
+	DescriptorAllocator allocator;
+	allocator.Initialize(128, 1);
+	std::vector<uint32_t> handles(descriptorCount);
+	double allocateMilliseconds = MeasureMilliseconds([&]() {
+		for (uint32_t& handle : handles) {
+			handle = allocator.Allocate();
+		}
+	});
+
+	// 毎フレーム半分を解放し、2フレーム前に解放した場所を再利用して確保し直す
+	uint64_t operationCount = 0;
+	double frameMilliseconds = MeasureMilliseconds([&]() {
+		for (uint32_t frame = 1; frame <= frameCount; ++frame) {
+			for (uint32_t i = frame % 2; i < descriptorCount; i += 2) {
+				allocator.Free(handles[i], frame);
+			}
+			allocator.Retire(frame >= 2 ? frame - 2 : 0);
+			for (uint32_t i = frame % 2; i < descriptorCount; i += 2) {
+				handles[i] = allocator.Allocate();
+				operationCount += 2;
+			}
+		}
+	});
+
+	Log(std::format("  initial {} allocations : {:.3f}ms (capacity {})\n", descriptorCount, allocateMilliseconds, allocator.GetCapacity()));
+	Log(std::format("  {} frames : {} operations {:.3f}ms / {:.1f}M operations per second (capacity {})\n",
+		frameCount, operationCount, frameMilliseconds, double(operationCount) / frameMilliseconds / 1000.0, allocator.GetCapacity()));
+}
+
+void Benchmark::SimulateMipStreaming(uint32_t textureCount, uint32_t frameCount, uint64_t budgetBytes)
+{
+	Log("Benchmark::SimulateMipStreaming\n");
+
+	// 2048x2048のRGBA8のTextureをz方向に4mおきに並べる（64x64のミップまでは常に常駐する）
+	const uint32_t kTextureSize = 2048;
+	StreamedTextureInfo info{ kTextureSize, kTextureSize, {}, 5 };
+	for (uint32_t size = kTextureSize; size > 0; size /= 2) {
+		info.mipSizes.push_back(uint64_t(size) * size * 4);
+	}
+	uint64_t fullBytes = 0;
+	for (uint64_t mipSize : info.mipSizes) {
+		fullBytes += mipSize;
+	}
+
+	MipResidency residency;
+	residency.SetBudget(budgetBytes);
+	std::vector<MipUsage> usages;
+	for (uint32_t i = 0; i < textureCount; ++i) {
+		uint32_t textureId = residency.AddTexture(info);
+		usages.push_back({ textureId, { 2.0f, 0.0f, float(i) * 4.0f }, 1.0f });
+	}
+
+	// カメラは並びの手前から奥まで一定の速さで進む
+	uint64_t uploadedBytes = 0;
+	uint64_t peakBytes = 0;
+	size_t changeCount = 0;
+	double updateMilliseconds = MeasureMilliseconds([&]() {
+		for (uint32_t frame = 0; frame < frameCount; ++frame) {
+			float z = -10.0f + float(textureCount) * 4.0f * float(frame) / float(frameCount);
+			residency.Update(MipCamera{ { 0.0f, 0.0f, z }, 0.45f, 720.0f }, usages);
+			for (const MipResidencyChange& change : residency.GetChanges()) {
+				// 詳細なミップが増える場合は、作り直したリソースに全ミップを転送する
+				for (uint32_t mip = change.newResidentMip; mip < info.mipSizes.size() && change.newResidentMip < change.oldResidentMip; ++mip) {
+					uploadedBytes += info.mipSizes[mip];
+				}
+			}
+			changeCount += residency.GetChanges().size();
+			peakBytes = (std::max)(peakBytes, residency.GetResidentBytes());
+		}
+	});
+
+	Log(std::format("  {} textures, budget {}MB : all mips would be {}MB\n", textureCount, budgetBytes / (1024 * 1024), fullBytes * textureCount / (1024 * 1024)));
+	Log(std::format("  {} frames : peak resident {}MB, {} residency changes, {}MB uploaded, update {:.3f}ms per frame\n",
+		frameCount, peakBytes / (1024 * 1024), changeCount, uploadedBytes / (1024 * 1024), updateMilliseconds / double(frameCount)));
+}
+
+void Benchmark::MeasureAtlasPacking(uint32_t rectCount, uint32_t pageSize)
+{
+	Log("Benchmark::MeasureAtlasPacking\n");
+
+	// スプライトやアイコンを想定した8～128ピクセルの矩形（縁の4ピクセルを含める）
+	std::mt19937 random(12345);
+	std::uniform_int_distribution<uint32_t> distribution(8, 128);
+	std::vector<std::pair<uint32_t, uint32_t>> sizes(rectCount);
+	uint64_t rectArea = 0;
+	for (auto& size : sizes) {
+		size = { distribution(random) + 8, distribution(random) + 8 };
+		rectArea += uint64_t(size.first) * size.second;
+	}
+
+	uint32_t pageCount = 0;
+	std::vector<AtlasPacker::Placement> placements;
+	double packMilliseconds = MeasureMilliseconds([&]() {
+		placements = AtlasPacker::PackPages(sizes, pageSize, pageSize, &pageCount);
+	});
+
+	// 同じ入力から同じ配置になることを確認する
+	std::vector<AtlasPacker::Placement> repeated = AtlasPacker::PackPages(sizes, pageSize, pageSize);
+	bool isDeterministic = true;
+	for (size_t i = 0; i < placements.size(); ++i) {
+		isDeterministic &= placements[i].page == repeated[i].page && placements[i].rect.x == repeated[i].rect.x && placements[i].rect.y == repeated[i].rect.y;
+	}
+
+	double occupancy = pageCount > 0 ? double(rectArea) / (double(pageSize) * pageSize * pageCount) : 0.0;
+	Log(std::format("  {} rects into {}px pages : {} pages, {:.1f}% occupied, {:.3f}ms, deterministic {}\n",
+		rectCount, pageSize, pageCount, occupancy * 100.0, packMilliseconds, isDeterministic));
+}
+
+void Benchmark::CompareMipGeneration(const std::vector<uint32_t>& sizes, uint32_t threadCount)
+{
+	Log("Benchmark::CompareMipGeneration\n");
+	// DirectXTexとの差の許容値（sRGBの値）
+	const int kTolerance = 2;
+
+	for (uint32_t size : sizes) {
+		// 滑らかなグラデーションにノイズを加えた画像（固定のシード）
+		DirectX::ScratchImage image{};
+		HRESULT result = image.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, size, size, 1, 1);
+		assert(SUCCEEDED(result));
+		std::mt19937 random(size);
+		const DirectX::Image& source = *image.GetImage(0, 0, 0);
+		for (uint32_t y = 0; y < size; ++y) {
+			uint8_t* row = source.pixels + y * source.rowPitch;
+			for (uint32_t x = 0; x < size; ++x) {
+				row[x * 4 + 0] = uint8_t((x * 255 / size + random() % 32) & 0xff);
+				row[x * 4 + 1] = uint8_t((y * 255 / size + random() % 32) & 0xff);
+				row[x * 4 + 2] = uint8_t(random() & 0xff);
+				row[x * 4 + 3] = uint8_t(255 - random() % 64);
+			}
+		}
+
+		DirectX::ScratchImage referenceImages{};
+		double directXTexMilliseconds = MeasureMilliseconds([&]() {
+			result = DirectX::GenerateMipMaps(*image.GetImage(0, 0, 0), DirectX::TEX_FILTER_BOX | DirectX::TEX_FILTER_SRGB, 0, referenceImages);
+		});
+		assert(SUCCEEDED(result));
+		std::vector<MipLevel> singleLevels;
+		double singleMilliseconds = MeasureMilliseconds([&]() {
+			singleLevels = MipGenerator::Generate(source.pixels, size, size, source.rowPitch, MipFilter::Box, 1);
+		});
+		std::vector<MipLevel> levels;
+		double boxMilliseconds = MeasureMilliseconds([&]() {
+			levels = MipGenerator::Generate(source.pixels, size, size, source.rowPitch, MipFilter::Box, threadCount);
+		});
+		double kaiserMilliseconds = MeasureMilliseconds([&]() {
+			MipGenerator::Generate(source.pixels, size, size, source.rowPitch, MipFilter::Kaiser, threadCount);
+		});
+
+		// 全ミップの全ての値をDirectXTexと比べる
+		int maxDifference = 0;
+		uint64_t differenceSum = 0;
+		uint64_t valueCount = 0;
+		for (size_t mip = 0; mip < levels.size(); ++mip) {
+			const DirectX::Image& reference = *referenceImages.GetImage(mip, 0, 0);
+			for (uint32_t y = 0; y < levels[mip].height; ++y) {
+				for (uint32_t x = 0; x < levels[mip].width * 4; ++x) {
+					int difference = std::abs(int(levels[mip].pixels[size_t(y) * levels[mip].width * 4 + x]) - int(reference.pixels[y * reference.rowPitch + x]));
+					maxDifference = (std::max)(maxDifference, difference);
+					differenceSum += difference;
+					valueCount++;
+				}
+			}
+		}
+
+		Log(std::format("  {}x{} : DirectXTex box {:.1f}ms / box 1 thread {:.1f}ms / box {} threads {:.1f}ms / kaiser {} threads {:.1f}ms\n",
+			size, size, directXTexMilliseconds, singleMilliseconds, threadCount, boxMilliseconds, threadCount, kaiserMilliseconds));
+		Log(std::format("    vs DirectXTex : max difference {}, mean {:.3f} ({})\n",
+			maxDifference, double(differenceSum) / double(valueCount), maxDifference <= kTolerance ? "within tolerance" : "OUT OF TOLERANCE"));
+	}
+}
+
+void Benchmark::CompareImageDecoders(const std::vector<std::string>& filePaths, uint32_t threadCount)
+{
+	Log("Benchmark::CompareImageDecoders\n");
+	// 繰り返す回数（小さな画像でも計測できるように）
+	const uint32_t kRepeatCount = 10;
+
+	// ファイルの読み込みは計測に含めないよう、先に全てマップしておく
+	std::vector<MappedFile> files(filePaths.size());
+	for (size_t i = 0; i < filePaths.size(); ++i) {
+		bool isOpened = files[i].Open(filePaths[i]);
+		assert(isOpened);
+	}
+
+	std::vector<DirectX::ScratchImage> wicImages(files.size());
+	std::vector<PngImage> pngImages(files.size());
+	auto decodeWic = [&](size_t i) {
+		HRESULT result = DirectX::LoadFromWICMemory(files[i].GetData(), files[i].GetSize(), DirectX::WIC_FLAGS_FORCE_SRGB, nullptr, wicImages[i]);
+		assert(SUCCEEDED(result));
+	};
+	auto decodeBuiltin = [&](size_t i) {
+		bool isDecoded = PngDecoder::Decode(files[i].GetData(), files[i].GetSize(), pngImages[i]);
+		assert(isDecoded);
+	};
+
+	// それぞれ1スレッドとthreadCountスレッドで全ての画像をデコードする
+	auto measure = [&](auto decode, uint32_t threads) {
+		return MeasureMilliseconds([&]() {
+			for (uint32_t repeat = 0; repeat < kRepeatCount; ++repeat) {
+				ParallelFor(files.size(), threads, decode);
+			}
+		}) / kRepeatCount;
+	};
+	double wicSingleMilliseconds = measure(decodeWic, 1);
+	double wicMilliseconds = measure(decodeWic, threadCount);
+	double builtinSingleMilliseconds = measure(decodeBuiltin, 1);
+	double builtinMilliseconds = measure(decodeBuiltin, threadCount);
+
+	Log(std::format("  {} images : WIC 1 thread {:.3f}ms / {} threads {:.3f}ms, builtin 1 thread {:.3f}ms / {} threads {:.3f}ms (x{:.2f} vs WIC)\n",
+		files.size(), wicSingleMilliseconds, threadCount, wicMilliseconds, builtinSingleMilliseconds, threadCount, builtinMilliseconds, wicSingleMilliseconds / builtinSingleMilliseconds));
+
+	// WICの結果をRGBA8にそろえて画素を比べる
+	for (size_t i = 0; i < files.size(); ++i) {
+		DirectX::ScratchImage convertedImage{};
+		const DirectX::Image* wicImage = wicImages[i].GetImage(0, 0, 0);
+		if (wicImage->format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB) {
+			HRESULT result = DirectX::Convert(*wicImage, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, convertedImage);
+			assert(SUCCEEDED(result));
+			wicImage = convertedImage.GetImage(0, 0, 0);
+		}
+
+		const PngImage& pngImage = pngImages[i];
+		int maxDifference = 0;
+		if (wicImage->width != pngImage.width || wicImage->height != pngImage.height) {
+			maxDifference = 255;
+		} else {
+			for (uint32_t y = 0; y < pngImage.height; ++y) {
+				for (uint32_t x = 0; x < pngImage.width * 4; ++x) {
+					int difference = std::abs(int(pngImage.pixels[size_t(y) * pngImage.width * 4 + x]) - int(wicImage->pixels[y * wicImage->rowPitch + x]));
+					maxDifference = (std::max)(maxDifference, difference);
+				}
+			}
+		}
+		Log(std::format("    {} : {}x{} max difference {} ({})\n", filePaths[i], pngImage.width, pngImage.height, maxDifference, maxDifference == 0 ? "identical" : "MISMATCH"));
+	}
+}
+
+void Benchmark::SimulateVirtualTexturing(uint32_t textureSize, uint32_t physicalPagesPerAxis, uint32_t frameCount, uint32_t loadsPerFrame)
+{
+	Log("Benchmark::SimulateVirtualTexturing\n");
+
+	// 128x128のページに4テクセルの縁を付ける
+	VirtualTextureLayout layout(textureSize, textureSize, 128, 4);
+	VirtualTextureSystem system;
+	system.Initialize(physicalPagesPerAxis, physicalPagesPerAxis);
+	uint32_t textureId = system.AddTexture(layout);
+
+	// 1280x720の画面に対して1/8の解像度でフィードバックを書き出す
+	const uint32_t kFeedbackWidth = 160;
+	const uint32_t kFeedbackHeight = 90;
+	const float kFeedbackScale = 8.0f;
+	std::vector<uint32_t> feedback(kFeedbackWidth * kFeedbackHeight);
+
+	uint64_t loadedPages = 0;
+	uint64_t feedbackTexels = 0;
+	uint64_t residentTexels = 0;
+	size_t peakPendingRequests = 0;
+	std::vector<VirtualPage> loadingPages;
+	double feedbackMilliseconds = 0.0;
+	for (uint32_t frame = 0; frame < frameCount; ++frame) {
+		// カメラは仮想テクスチャの上を円を描いて移動し、1画面のピクセルあたり0.5～8テクセルの間で拡大縮小する
+		float time = float(frame) / float(frameCount);
+		float centerX = textureSize * (0.5f + 0.35f * std::cos(time * 6.2832f));
+		float centerY = textureSize * (0.5f + 0.35f * std::sin(time * 6.2832f));
+		float texelsPerPixel = std::exp2(1.5f + 2.5f * std::sin(time * 6.2832f * 3.0f));
+		uint32_t mip = (std::min)(uint32_t((std::max)(std::floor(std::log2(texelsPerPixel)), 0.0f)), layout.GetMipLevels() - 1);
+
+		// 合成したフィードバック（テクセルごとに、そこで使われるミップのページ）
+		for (uint32_t y = 0; y < kFeedbackHeight; ++y) {
+			for (uint32_t x = 0; x < kFeedbackWidth; ++x) {
+				float u = centerX + (float(x) - kFeedbackWidth * 0.5f) * kFeedbackScale * texelsPerPixel;
+				float v = centerY + (float(y) - kFeedbackHeight * 0.5f) * kFeedbackScale * texelsPerPixel;
+				uint32_t& value = feedback[y * kFeedbackWidth + x];
+				if (u < 0.0f || v < 0.0f || u >= float(textureSize) || v >= float(textureSize)) {
+					value = VirtualTextureSystem::kEmptyFeedback;
+					continue;
+				}
+				uint32_t pageX = (std::min)(uint32_t(u) / (128u << mip), layout.GetPagesX(mip) - 1);
+				uint32_t pageY = (std::min)(uint32_t(v) / (128u << mip), layout.GetPagesY(mip) - 1);
+				value = VirtualTextureSystem::PackFeedback(textureId, mip, pageX, pageY);
+			}
+		}
+
+		// 前のフレームで要求したページは1フレーム遅れで読み込みが終わる
+		for (const VirtualPage& page : loadingPages) {
+			if (system.CompleteLoad(page) != VirtualTextureSystem::kInvalidId) {
+				loadedPages++;
+			}
+		}
+		feedbackMilliseconds += MeasureMilliseconds([&]() {
+			system.ProcessFeedback(feedback.data(), feedback.size());
+		});
+		peakPendingRequests = (std::max)(peakPendingRequests, system.GetPendingRequestCount());
+		loadingPages = system.PopRequests(loadsPerFrame);
+		feedbackTexels += system.GetFeedbackTexelCount();
+		residentTexels += system.GetResidentTexelCount();
+	}
+
+	uint64_t tileBytes = uint64_t(layout.GetTileSize()) * layout.GetTileSize() * 4;
+	Log(std::format("  {}x{} virtual texture ({} pages, {}MB), {} physical pages ({}MB)\n",
+		textureSize, textureSize, layout.GetTotalPageCount(), layout.GetTotalPageCount() * tileBytes / (1024 * 1024), system.GetPhysicalPageCount(), system.GetPhysicalPageCount() * tileBytes / (1024 * 1024)));
+	Log(std::format("  {} frames, {} loads per frame : {} pages loaded, {} evicted, peak {} pending requests\n",
+		frameCount, loadsPerFrame, loadedPages, system.GetEvictionCount(), peakPendingRequests));
+	Log(std::format("  exact page resident for {:.1f}% of feedback texels, feedback {:.3f}ms per frame\n",
+		feedbackTexels > 0 ? 100.0 * double(residentTexels) / double(feedbackTexels) : 0.0, feedbackMilliseconds / double(frameCount)));
+}
+
+void Benchmark::MeasureHeapAllocator(uint64_t heapSize, uint32_t operationCount)
+{
+	Log("Benchmark::MeasureHeapAllocator\n");
+
+	// 頂点・インデックスバッファを想定した256バイト～1MBのサイズと256バイト～64KBのアラインメント（固定のシード）
+	struct Operation {
+		bool isAllocate;
+		uint64_t size;
+		uint64_t alignment;
+		uint32_t freeIndex; // 解放する場合の、使用中の中での位置
+	};
+	std::mt19937 random(2024);
+	std::vector<Operation> operations(operationCount);
+	for (Operation& operation : operations) {
+		// 確保を少し多くして、ヒープがほぼ埋まった状態で確保と解放を繰り返す
+		operation.isAllocate = random() % 100 < 55;
+		operation.size = uint64_t(std::exp2(std::uniform_real_distribution<double>(8.0, 20.0)(random)));
+		operation.alignment = uint64_t(1) << (8 + random() % 9);
+		operation.freeIndex = uint32_t(random());
+	}
+
+	// 同じ操作の列を流す（確保できなかったものは飛ばし、使用中が無ければ解放せずに確保する。配置の検証は単体テストで行う）
+	auto run = [&](auto& allocator, std::vector<uint64_t>& offsets, uint32_t& failedCount) {
+		for (const Operation& operation : operations) {
+			if (operation.isAllocate || offsets.empty()) {
+				uint64_t offset = allocator.Allocate(operation.size, operation.alignment);
+				if (offset == TlsfAllocator::kInvalidOffset) {
+					failedCount++;
+					continue;
+				}
+				offsets.push_back(offset);
+			} else {
+				size_t index = operation.freeIndex % offsets.size();
+				allocator.Free(offsets[index]);
+				offsets[index] = offsets.back();
+				offsets.pop_back();
+			}
+		}
+	};
+
+	TlsfAllocator tlsf;
+	tlsf.Initialize(heapSize, 256);
+	std::vector<uint64_t> tlsfOffsets;
+	uint32_t tlsfFailedCount = 0;
+	double tlsfMilliseconds = MeasureMilliseconds([&]() { run(tlsf, tlsfOffsets, tlsfFailedCount); });
+
+	FirstFitAllocator firstFit(heapSize);
+	std::vector<uint64_t> firstFitOffsets;
+	uint32_t firstFitFailedCount = 0;
+	double firstFitMilliseconds = MeasureMilliseconds([&]() { run(firstFit, firstFitOffsets, firstFitFailedCount); });
+
+	Log(std::format("  {} operations in a {}MB heap\n", operationCount, heapSize / (1024 * 1024)));
+	Log(std::format("  TLSF : {:.1f}ns per operation, {} failed, {} live ({:.1f}MB)\n",
+		tlsfMilliseconds * 1000000.0 / operationCount, tlsfFailedCount, tlsfOffsets.size(), tlsf.GetUsedSize() / 1048576.0));
+	Log(std::format("  first fit : {:.1f}ns per operation, {} failed, {} live\n",
+		firstFitMilliseconds * 1000000.0 / operationCount, firstFitFailedCount, firstFitOffsets.size()));
+
+	// デフラグで後ろの確保を前に詰めて、最大の空きがどれだけ増えるか
+	float fragmentation = tlsf.GetFragmentation();
+	uint64_t largestFreeBlock = tlsf.GetLargestFreeBlock();
+	std::vector<TlsfAllocator::Move> moves;
+	double defragmentMilliseconds = MeasureMilliseconds([&]() { moves = tlsf.Defragment(SIZE_MAX); });
+	uint64_t movedBytes = 0;
+	for (const TlsfAllocator::Move& move : moves) {
+		movedBytes += move.size;
+	}
+	Log(std::format("  fragmentation {:.2f} (largest free {:.1f}MB) -> defragment {} moves ({:.1f}MB, {:.3f}ms) -> {:.2f} (largest free {:.1f}MB)\n",
+		fragmentation, largestFreeBlock / 1048576.0, moves.size(), movedBytes / 1048576.0, defragmentMilliseconds,
+		tlsf.GetFragmentation(), tlsf.GetLargestFreeBlock() / 1048576.0));
+}
+
+void Benchmark::SimulateFramesInFlight(uint32_t maxFramesInFlight, uint32_t frameCount)
+{
+	Log("Benchmark::SimulateFramesInFlight\n");
+
+	// 記録に4～8ms、実行に6～14msかかるフレーム（固定のシードで、フレームの数によらず同じ列を使う）
+	std::mt19937 random(7);
+	std::uniform_real_distribution<double> cpuDistribution(4.0, 8.0);
+	std::uniform_real_distribution<double> gpuDistribution(6.0, 14.0);
+	std::vector<std::pair<double, double>> frameCosts(frameCount);
+	for (auto& cost : frameCosts) {
+		cost = { cpuDistribution(random), gpuDistribution(random) };
+	}
+
+	for (uint32_t framesInFlight = 1; framesInFlight <= maxFramesInFlight; ++framesInFlight) {
+		FrameRing ring;
+		ring.Initialize(framesInFlight);
+
+		// Fenceの値ごとの、GPUが到達する時刻
+		std::vector<double> completionTimes(1, 0.0);
+		double cpuTime = 0.0;
+		double gpuTime = 0.0;
+		double waitTime = 0.0;
+		uint32_t peakFramesInFlight = 0;
+		for (const auto& [cpuCost, gpuCost] : frameCosts) {
+			// 記録して提出する（GPUは前に提出したフレームを終えてから実行する）
+			cpuTime += cpuCost;
+			gpuTime = (std::max)(gpuTime, cpuTime) + gpuCost;
+			uint64_t fenceValue = completionTimes.size();
+			completionTimes.push_back(gpuTime);
+
+			// 次のフレームの領域を前回使ったフレームだけを待つ
+			uint64_t reuseFenceValue = ring.Advance(fenceValue);
+			if (completionTimes[reuseFenceValue] > cpuTime) {
+				waitTime += completionTimes[reuseFenceValue] - cpuTime;
+				cpuTime = completionTimes[reuseFenceValue];
+			}
+
+			// 実行中のフレームの数
+			uint32_t runningFrames = 0;
+			for (uint64_t value = fenceValue; value > 0 && completionTimes[value] > cpuTime; --value) {
+				runningFrames++;
+			}
+			peakFramesInFlight = (std::max)(peakFramesInFlight, runningFrames);
+		}
+
+		Log(std::format("  {} frames in flight : {:.2f}ms per frame, CPU waited {:.2f}ms per frame, peak {} frames running\n",
+			framesInFlight, gpuTime / frameCount, waitTime / frameCount, peakFramesInFlight));
+	}
+}
+
+void Benchmark::MeasureFrameLimiter(const std::vector<double>& frameRates, uint32_t frameCount)
+{
+	Log("Benchmark::MeasureFrameLimiter\n");
+
+	for (double frameRate : frameRates) {
+		int64_t targetInterval = int64_t(1000000000.0 / frameRate);
+		Log(std::format("  {:.0f}fps ({:.3f}ms)\n", frameRate, targetInterval / 1000000.0));
+
+		// フレームの処理には目標の20～80%かかり、100フレームごとに目標の3倍かかる（同じシードで両方に同じ列を使う）
+		std::mt19937 random(5);
+		std::uniform_int_distribution<int64_t> workDistribution(targetInterval / 5, targetInterval * 4 / 5);
+		std::vector<int64_t> workTimes(frameCount);
+		for (uint32_t i = 0; i < frameCount; ++i) {
+			workTimes[i] = i % 100 == 99 ? targetInterval * 3 : workDistribution(random);
+		}
+
+		// 止まったフレームとその直後のフレームを除いて比べる
+		auto isSteadyFrame = [](uint32_t i) { return i % 100 != 99 && i % 100 != 0; };
+
+		// 残り時間だけ眠る（これまでの16msのsleep_forに近い）
+		{
+			FakeFrameClock clock;
+			std::vector<int64_t> intervals;
+			int64_t frameStart = clock.Now();
+			for (uint32_t i = 0; i < frameCount; ++i) {
+				clock.Advance(workTimes[i]);
+				int64_t remaining = targetInterval - (clock.Now() - frameStart);
+				if (remaining > 0) {
+					clock.Sleep(remaining);
+				}
+				int64_t now = clock.Now();
+				if (isSteadyFrame(i)) {
+					intervals.push_back(now - frameStart);
+				}
+				frameStart = now;
+			}
+			LogFrameIntervals("sleep only  ", intervals, targetInterval);
+		}
+
+		// FrameLimiter
+		{
+			auto ownedClock = std::make_unique<FakeFrameClock>();
+			FakeFrameClock* clock = ownedClock.get();
+			FrameLimiter limiter(frameRate, std::move(ownedClock));
+			std::vector<int64_t> intervals;
+			limiter.Wait();
+			int64_t frameStart = clock->Now();
+			for (uint32_t i = 0; i < frameCount; ++i) {
+				clock->Advance(workTimes[i]);
+				limiter.Wait();
+				int64_t now = clock->Now();
+				if (isSteadyFrame(i)) {
+					intervals.push_back(now - frameStart);
+				}
+				frameStart = now;
+			}
+			LogFrameIntervals("FrameLimiter", intervals, targetInterval);
+			Log(std::format("    FrameLimiter slept {:.1f}ms, spun {:.1f}ms, sleep estimate {:.3f}ms\n",
+				clock->GetSleptTime() / 1000000.0, clock->GetSpunTime() / 1000000.0, limiter.GetSleepEstimate()));
+		}
+
+		// 実際の時計で1秒間（フレームの処理はしない）
+		{
+			FrameLimiter limiter(frameRate);
+			SystemFrameClock clock;
+			std::vector<int64_t> intervals;
+			limiter.Wait();
+			int64_t frameStart = clock.Now();
+			for (uint32_t i = 0; i < uint32_t(frameRate); ++i) {
+				limiter.Wait();
+				int64_t now = clock.Now();
+				intervals.push_back(now - frameStart);
+				frameStart = now;
+			}
+			LogFrameIntervals("system clock", intervals, targetInterval);
+		}
+	}
+}
+
+void Benchmark::MeasureParallelRecording(size_t drawCount, uint32_t maxThreadCount)
+{
+	Log("Benchmark::MeasureParallelRecording\n");
+
+	// 描画ごとのワールド行列と、共通のビュー・プロジェクション行列
+	std::vector<Matrix> worldMatrices(drawCount);
+	for (size_t i = 0; i < drawCount; ++i) {
+		worldMatrices[i] = Matrix::RotationY(float(i) * 0.01f) * Matrix::Translation({ float(i % 100), float(i / 100), 0.0f });
+	}
+	Matrix viewProjection = Matrix::Translation({ 0.0f, 0.0f, 10.0f }) * Matrix::PerspectiveFovLH(0.45f, 16.0f / 9.0f, 0.1f, 100.0f);
+
+	const uint32_t kFrameCount = 20;
+	const size_t kMinDrawsPerChunk = 256;
+	double singleThreadTime = 0.0;
+	for (uint32_t threadCount = 1; threadCount <= maxThreadCount; threadCount *= 2) {
+		MockCommandSink sink;
+		// 実際のフレームと同じく、スレッドは作ったまま使い回す
+		WorkerPool pool(threadCount);
+		double time = MeasureMilliseconds([&]() {
+			for (uint32_t frame = 0; frame < kFrameCount; ++frame) {
+				sink.Reset(threadCount);
+				RecordDrawsInParallel(pool, drawCount, threadCount, kMinDrawsPerChunk, sink, [&](uint32_t chunk, size_t drawIndex) {
+					sink.Record(chunk, drawIndex, worldMatrices[drawIndex] * viewProjection);
+				});
+			}
+		}) / kFrameCount;
+		if (threadCount == 1) {
+			singleThreadTime = time;
+		}
+		Log(std::format("  {} threads : {:.3f}ms per frame ({:.2f}x), {} chunks\n",
+			threadCount, time, singleThreadTime / time, sink.GetSubmittedChunkCount()));
+	}
+}
+
+void Benchmark::CompileRenderGraph(uint32_t passCount, uint32_t resourceCount, uint32_t graphCount)
+{
+	Log("Benchmark::CompileRenderGraph\n");
+
+	// 影、GBuffer、ライティング、ブルーム、ポストエフェクト、UIと、どこからも読まれないデバッグ表示
+	{
+		RenderGraph graph;
+		uint32_t backBuffer = graph.ImportResource("BackBuffer", nullptr, ResourceState::Present, ResourceState::Present);
+		uint32_t depth = graph.ImportResource("Depth", nullptr, ResourceState::DepthWrite, ResourceState::DepthWrite, false);
+		uint32_t shadowMap = graph.ImportResource("ShadowMap", nullptr, ResourceState::PixelShaderResource, ResourceState::PixelShaderResource, false);
+		uint32_t gBuffer = graph.ImportResource("GBuffer", nullptr, ResourceState::RenderTarget, ResourceState::RenderTarget, false);
+		uint32_t lighting = graph.ImportResource("Lighting", nullptr, ResourceState::UnorderedAccess, ResourceState::UnorderedAccess, false);
+		uint32_t debugView = graph.ImportResource("DebugView", nullptr, ResourceState::RenderTarget, ResourceState::RenderTarget, false);
+
+		uint32_t pass = graph.AddPass("Shadow", nullptr);
+		graph.Write(pass, shadowMap, ResourceState::DepthWrite);
+		pass = graph.AddPass("GBuffer", nullptr);
+		graph.Write(pass, gBuffer, ResourceState::RenderTarget);
+		graph.Write(pass, depth, ResourceState::DepthWrite);
+		pass = graph.AddPass("Lighting", nullptr);
+		graph.Read(pass, gBuffer, ResourceState::NonPixelShaderResource);
+		graph.Read(pass, shadowMap, ResourceState::NonPixelShaderResource);
+		graph.Read(pass, depth, ResourceState::DepthRead);
+		graph.Write(pass, lighting, ResourceState::UnorderedAccess);
+		pass = graph.AddPass("Bloom", nullptr);
+		graph.Read(pass, lighting, ResourceState::UnorderedAccess);
+		graph.Write(pass, lighting, ResourceState::UnorderedAccess);
+		pass = graph.AddPass("Debug", nullptr);
+		graph.Read(pass, gBuffer, ResourceState::PixelShaderResource);
+		graph.Write(pass, debugView, ResourceState::RenderTarget);
+		pass = graph.AddPass("Post", nullptr);
+		graph.Read(pass, lighting, ResourceState::PixelShaderResource);
+		graph.Read(pass, depth, ResourceState::PixelShaderResource);
+		graph.Write(pass, backBuffer, ResourceState::RenderTarget);
+		pass = graph.AddPass("UI", nullptr);
+		graph.Read(pass, backBuffer, ResourceState::RenderTarget);
+		graph.Write(pass, backBuffer, ResourceState::RenderTarget);
+
+		graph.Compile();
+		Log(std::format("  example ({} barriers in {} batches)\n{}", graph.GetBarrierCount(), graph.GetBatchCount(), graph.DumpSchedule()));
+	}
+
+	// ランダムなRenderGraph（最初の2つのリソースが出力で、パスは1～3個のリソースを読んで1個に書き込む）
+	const ResourceState kReadStates[] = { ResourceState::PixelShaderResource, ResourceState::NonPixelShaderResource, ResourceState::CopySource, ResourceState::DepthRead };
+	const ResourceState kWriteStates[] = { ResourceState::RenderTarget, ResourceState::UnorderedAccess, ResourceState::CopyDest, ResourceState::DepthWrite };
+	std::mt19937 random(3);
+	std::vector<RenderGraph> graphs(graphCount);
+	for (RenderGraph& graph : graphs) {
+		for (uint32_t resource = 0; resource < resourceCount; ++resource) {
+			ResourceState state = resource < 2 ? ResourceState::Present : kWriteStates[random() % 4];
+			graph.ImportResource(std::format("Resource{}", resource), nullptr, state, state, resource < 2);
+		}
+		for (uint32_t i = 0; i < passCount; ++i) {
+			uint32_t pass = graph.AddPass(std::format("Pass{}", i), nullptr);
+			uint32_t writeResource = random() % resourceCount;
+			uint32_t readCount = 1 + random() % 3;
+			for (uint32_t j = 0; j < readCount; ++j) {
+				uint32_t resource = random() % resourceCount;
+				if (resource != writeResource) {
+					graph.Read(pass, resource, kReadStates[random() % 4]);
+				}
+			}
+			graph.Write(pass, writeResource, kWriteStates[random() % 4]);
+		}
+	}
+
+	struct Result {
+		const char* name;
+		RenderGraphCompileOptions options;
+	};
+	const Result kResults[] = {
+		{ "no optimization", { false, false, false } },
+		{ "culling        ", { true, false, false } },
+		{ "+ merged reads ", { true, true, false } },
+		{ "+ split        ", { true, true, true } },
+	};
+	for (const Result& result : kResults) {
+		uint64_t barrierCount = 0;
+		uint64_t batchCount = 0;
+		uint64_t culledCount = 0;
+		double time = MeasureMilliseconds([&]() {
+			for (RenderGraph& graph : graphs) {
+				graph.Compile(result.options);
+			}
+		});
+		for (RenderGraph& graph : graphs) {
+			graph.Compile(result.options);
+			barrierCount += graph.GetBarrierCount();
+			batchCount += graph.GetBatchCount();
+			for (uint32_t pass = 0; pass < graph.GetPassCount(); ++pass) {
+				culledCount += graph.IsCulled(pass);
+			}
+		}
+		Log(std::format("  {} : {:.1f} passes culled, {:.1f} barriers in {:.1f} batches per graph, compile {:.1f}us\n",
+			result.name, double(culledCount) / graphCount, double(barrierCount) / graphCount, double(batchCount) / graphCount,
+			time * 1000.0 / graphCount));
+	}
+}
+
+void Benchmark::PlanTransientAliasing(uint32_t resourceCount, uint32_t passCount, uint32_t planCount)
+{
+	Log("Benchmark::PlanTransientAliasing\n");
+	const uint64_t kMiB = 1024 * 1024;
+
+	// 1920x1080のポストエフェクトの連鎖（前のパスの結果を読んで次の一時的なリソースに書き込む）
+	{
+		const uint64_t kFullSize = AlignTo64KiB(1920ull * 1080 * 8);
+		RenderGraph graph;
+		uint32_t backBuffer = graph.ImportResource("BackBuffer", nullptr, ResourceState::Present, ResourceState::Present);
+		uint32_t previous = graph.CreateTransientResource("Scene", { 1920, 1080, 0, ResourceState::RenderTarget, kFullSize, 64 * 1024 });
+		uint32_t pass = graph.AddPass("Scene", nullptr);
+		graph.Write(pass, previous, ResourceState::RenderTarget);
+		const char* kPostNames[] = { "Bloom", "DepthOfField", "MotionBlur", "ToneMap" };
+		for (const char* name : kPostNames) {
+			uint32_t target = graph.CreateTransientResource(name, { 1920, 1080, 0, ResourceState::RenderTarget, kFullSize, 64 * 1024 });
+			pass = graph.AddPass(name, nullptr);
+			graph.Read(pass, previous, ResourceState::PixelShaderResource);
+			graph.Write(pass, target, ResourceState::RenderTarget);
+			previous = target;
+		}
+		pass = graph.AddPass("Copy", nullptr);
+		graph.Read(pass, previous, ResourceState::PixelShaderResource);
+		graph.Write(pass, backBuffer, ResourceState::RenderTarget);
+
+		RenderGraphCompileOptions options;
+		options.aliasTransients = false;
+		graph.Compile(options);
+		uint64_t dedicatedSize = graph.GetAliasingPlan().GetTotalSize();
+		graph.Compile();
+		const AliasingPlan& plan = graph.GetAliasingPlan();
+		Log(std::format("  post chain : {:.1f} MiB -> {:.1f} MiB in {} slots\n{}", double(dedicatedSize) / kMiB, double(plan.GetTotalSize()) / kMiB,
+			plan.slotSizes.size(), graph.DumpSchedule()));
+	}
+
+	// ランダムな期間と、フル・ハーフ・クォーターの解像度でRGBA8・RGBA16F・深度の大きさのリソース
+	std::vector<uint64_t> sizes;
+	for (uint64_t scale : { 1, 2, 4 }) {
+		for (uint64_t bytesPerPixel : { 4, 8 }) {
+			sizes.push_back(AlignTo64KiB(1920 / scale * 1080 / scale * bytesPerPixel));
+		}
+	}
+	std::mt19937 random(4);
+	std::vector<std::vector<AliasingRequest>> requestSets(planCount);
+	for (std::vector<AliasingRequest>& requests : requestSets) {
+		for (uint32_t i = 0; i < resourceCount; ++i) {
+			AliasingRequest& request = requests.emplace_back();
+			request.size = sizes[random() % sizes.size()];
+			request.alignment = 64 * 1024;
+			request.firstPass = random() % passCount;
+			request.lastPass = (std::min)(passCount - 1, request.firstPass + uint32_t(random() % 4));
+		}
+	}
+
+	std::vector<AliasingPlan> plans(planCount);
+	double time = MeasureMilliseconds([&]() {
+		for (uint32_t i = 0; i < planCount; ++i) {
+			plans[i] = PlanAliasing(requestSets[i]);
+		}
+	});
+	uint64_t dedicatedSize = 0;
+	uint64_t totalSize = 0;
+	uint64_t peakSize = 0;
+	for (uint32_t i = 0; i < planCount; ++i) {
+		dedicatedSize += plans[i].dedicatedSize;
+		totalSize += plans[i].GetTotalSize();
+		// 同時に使うリソースの合計の最大値（どう置いてもこれより小さくはできない）
+		uint64_t peak = 0;
+		for (uint32_t pass = 0; pass < passCount; ++pass) {
+			uint64_t live = 0;
+			for (const AliasingRequest& request : requestSets[i]) {
+				live += request.firstPass <= pass && pass <= request.lastPass ? request.size : 0;
+			}
+			peak = (std::max)(peak, live);
+		}
+		peakSize += peak;
+	}
+	Log(std::format("  {} resources over {} passes : dedicated {:.1f} MiB, aliased {:.1f} MiB (saved {:.1f}%), lower bound {:.1f} MiB, plan {:.1f}us\n",
+		resourceCount, passCount, double(dedicatedSize) / planCount / kMiB, double(totalSize) / planCount / kMiB,
+		100.0 * double(dedicatedSize - totalSize) / double(dedicatedSize), double(peakSize) / planCount / kMiB,
+		time * 1000.0 / planCount));
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <d3d12.h>
+
+// 起動時に実行する計測処理（コマンドライン引数 -benchmark で実行）
+class Benchmark
+{
+public:
+	// 同じメッシュのObjとglTFバイナリの読み込み時間を比較する
+	static void CompareModelLoad(const std::string& directoryPath, const std::vector<std::string>& modelNames, ID3D12Device* device);
+
+	// 同じObjファイルを通常の読み込みとストリーミング読み込みで読み、時間とメモリ使用量を比較する
+	// （ストリーミング読み込みの方が読み込み中のピークが小さくなることを確かめる）
+	static void CompareObjLoaders(const std::string& directoryPath, const std::vector<std::string>& modelNames, ID3D12Device* device);
+
+	// 画像のデコードとミップマップ生成と、変換済みのDDSの読み込みの時間とメモリ量を比較する
+	static void CompareTextureLoad(const std::vector<std::string>& filePaths);
+
+	// ディレクトリ内の全ての画像のデコードとミップマップ生成を、1からmaxThreadCountまでのスレッド数で計測する
+	static void MeasureTextureDecodeThreads(const std::vector<std::string>& directoryPaths, uint32_t maxThreadCount);
+
+	// DescriptorAllocatorの確保と解放の速度を計測する（毎フレーム半分を解放して確保し直す）
+	static void MeasureDescriptorAllocator(uint32_t descriptorCount, uint32_t frameCount);
+
+	// 並べたTextureの横をカメラが通り過ぎるときの、ミップのストリーミングの常駐量と転送量を計測する（GPUは使わない）
+	static void SimulateMipStreaming(uint32_t textureCount, uint32_t frameCount, uint64_t budgetBytes);
+
+	// 大きさの異なる矩形をアトラスのページに詰める速度と使用率を計測する（固定のシードで毎回同じ矩形を使う）
+	static void MeasureAtlasPacking(uint32_t rectCount, uint32_t pageSize);
+
+	// MipGeneratorのボックスフィルタをDirectXTexと比べて検証し、カイザーフィルタと合わせて時間を計測する
+	static void CompareMipGeneration(const std::vector<uint32_t>& sizes, uint32_t threadCount);
+
+	// PNGのデコードをWICとPngDecoderで比べる（1スレッドとthreadCountスレッドで計測し、結果の画素が一致するか検証する）
+	static void CompareImageDecoders(const std::vector<std::string>& filePaths, uint32_t threadCount);
+
+	// 大きな仮想テクスチャの上をカメラが移動・拡大縮小するときのフィードバックを作り、ページの要求と物理ページのキャッシュを計測する（GPUは使わない）
+	static void SimulateVirtualTexturing(uint32_t textureSize, uint32_t physicalPagesPerAxis, uint32_t frameCount, uint32_t loadsPerFrame);
+
+	// TlsfAllocatorの確保と解放の速度と断片化を、単純なファーストフィットと比べて計測する（GPUは使わない）
+	static void MeasureHeapAllocator(uint64_t heapSize, uint32_t operationCount);
+
+	// CPUでの記録とGPUでの実行にかかる時間を乱数で決め、FrameRingで同時に実行するフレームの数ごとのフレーム時間を求める
+	// （Fenceは時刻で模擬する。GPUは使わない）
+	static void SimulateFramesInFlight(uint32_t maxFramesInFlight, uint32_t frameCount);
+
+	// 眠ると0.2～1.5ms長くなる偽の時計で、FrameLimiterと残り時間だけ眠る単純な制限のフレームの間隔を比べる
+	// （その後、実際の時計でフレームレートごとに1秒間計測する）
+	static void MeasureFrameLimiter(const std::vector<double>& frameRates, uint32_t frameCount);
+
+	// drawCount個の描画を、偽の記録先に行列の計算とコマンドの書き込みとしてスレッド数を変えて並列に記録する
+	// （GPUは使わない）
+	static void MeasureParallelRecording(size_t drawCount, uint32_t maxThreadCount);
+
+	// 遅延シェーディング風のRenderGraphのコンパイル結果をログに出し、ランダムなRenderGraphでバリアの数とコンパイルの時間を計測する
+	// （GPUは使わない）
+	static void CompileRenderGraph(uint32_t passCount, uint32_t resourceCount, uint32_t graphCount);
+
+	// ポストエフェクトの連鎖とランダムな期間のリソースで、一時的なリソースのメモリを共有して減ったメモリと配置の時間を計測する
+	// （GPUは使わない）
+	static void PlanTransientAliasing(uint32_t resourceCount, uint32_t passCount, uint32_t planCount);
+};
+
@@ -0,0 +1,238 @@
+#include "BufferHeapAllocator.h"
+#include <atomic>
+#include <cassert>
+#include <format>
+
+// MyClass
+#include "DirectXBase.h"
+#include "Logger.h"
+
+namespace {
+	// リソースに破棄を検知するオブジェクトを持たせるためのGUID
+	const GUID kPlacementTrackerGuid = { 0x6c1e4a52, 0x93d7, 0x4f0b, { 0xa1, 0x38, 0x5e, 0x27, 0xc4, 0x90, 0x1b, 0x6d } };
+
+	// リソースのプライベートデータとして持たせ、リソースが破棄されて解放されたときにヒープの範囲を返す
+	class PlacementTracker : public IUnknown
+	{
+	public:
+		PlacementTracker(uint32_t heapIndex, uint64_t offset, uint64_t generation) : heapIndex_(heapIndex), offset_(offset), generation_(generation) {}
+
+		HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override
+		{
+			if (riid == __uuidof(IUnknown)) {
+				*object = static_cast<IUnknown*>(this);
+				AddRef();
+				return S_OK;
+			}
+			*object = nullptr;
+			return E_NOINTERFACE;
+		}
+		ULONG STDMETHODCALLTYPE AddRef() override { return ++refCount_; }
+		ULONG STDMETHODCALLTYPE Release() override
+		{
+			ULONG refCount = --refCount_;
+			if (refCount == 0) {
+				BufferHeapAllocator::GetInstance().OnResourceReleased(heapIndex_, offset_, generation_);
+				delete this;
+			}
+			return refCount;
+		}
+
+	private:
+		std::atomic<ULONG> refCount_ = 1;
+		uint32_t heapIndex_;
+		uint64_t offset_;
+		uint64_t generation_;
+	};
+}
+
+BufferHeapAllocator& BufferHeapAllocator::GetInstance()
+{
+	static BufferHeapAllocator* instance = new BufferHeapAllocator;
+	return *instance;
+}
+
+void BufferHeapAllocator::Initialize(ID3D12Device* device, uint64_t heapSize)
+{
+	BufferHeapAllocator& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	instance.device_ = device;
+	instance.heapSize_ = heapSize;
+	instance.heaps_.clear();
+}
+
+void BufferHeapAllocator::Finalize()
+{
+	BufferHeapAllocator& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	instance.heaps_.clear();
+	instance.device_ = nullptr;
+	instance.generation_++;
+}
+
+bool BufferHeapAllocator::IsInitialized()
+{
+	BufferHeapAllocator& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	return instance.device_ != nullptr;
+}
+
+Microsoft::WRL::ComPtr<ID3D12Resource> BufferHeapAllocator::CreateBuffer(const D3D12_RESOURCE_DESC& desc)
+{
+	BufferHeapAllocator& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	if (!instance.device_) {
+		return nullptr;
+	}
+
+	// 置くときのサイズとアラインメント（バッファは64KB単位）
+	D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = instance.device_->GetResourceAllocationInfo(0, 1, &desc);
+	if (allocationInfo.SizeInBytes > instance.heapSize_) {
+		return nullptr;
+	}
+
+	// 既存のヒープから順に探し、どこにも入らなければヒープを増やす
+	uint32_t heapIndex = 0;
+	uint64_t offset = TlsfAllocator::kInvalidOffset;
+	for (; heapIndex < instance.heaps_.size(); ++heapIndex) {
+		Heap& heap = instance.heaps_[heapIndex];
+		if (heap.heap) {
+			offset = heap.allocator.Allocate(allocationInfo.SizeInBytes, allocationInfo.Alignment);
+			if (offset != TlsfAllocator::kInvalidOffset) {
+				break;
+			}
+		}
+	}
+	if (offset == TlsfAllocator::kInvalidOffset) {
+		heapIndex = instance.CreateHeap();
+		offset = instance.heaps_[heapIndex].allocator.Allocate(allocationInfo.SizeInBytes, allocationInfo.Alignment);
+		assert(offset != TlsfAllocator::kInvalidOffset);
+	}
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> resource = nullptr;
+	HRESULT hr = instance.device_->CreatePlacedResource(instance.heaps_[heapIndex].heap.Get(), offset, &desc,
+		D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&resource));
+	assert(SUCCEEDED(hr));
+
+	// リソースが破棄されるとプライベートデータのPlacementTrackerも解放され、範囲が返される
+	PlacementTracker* tracker = new PlacementTracker(heapIndex, offset, instance.generation_);
+	hr = resource->SetPrivateDataInterface(kPlacementTrackerGuid, tracker);
+	assert(SUCCEEDED(hr));
+	tracker->Release();
+
+	return resource;
+}
+
+void BufferHeapAllocator::EndFrame()
+{
+	BufferHeapAllocator& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+
+	uint64_t completedFenceValue = DirectXBase::GetInstance()->GetCompletedFenceValue();
+	for (Heap& heap : instance.heaps_) {
+		if (!heap.heap || heap.allocator.GetPendingFreeCount() == 0) {
+			continue;
+		}
+		heap.allocator.Retire(completedFenceValue);
+
+		// 空になったヒープは、他に使えるヒープがあれば解放する
+		if (heap.allocator.GetAllocationCount() == 0) {
+			uint32_t liveHeapCount = 0;
+			for (const Heap& other : instance.heaps_) {
+				liveHeapCount += other.heap ? 1 : 0;
+			}
+			if (liveHeapCount > 1) {
+				heap.heap.Reset();
+			}
+		}
+	}
+}
+
+uint32_t BufferHeapAllocator::GetHeapCount()
+{
+	BufferHeapAllocator& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	uint32_t heapCount = 0;
+	for (const Heap& heap : instance.heaps_) {
+		heapCount += heap.heap ? 1 : 0;
+	}
+	return heapCount;
+}
+
+uint64_t BufferHeapAllocator::GetUsedSize()
+{
+	BufferHeapAllocator& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	uint64_t usedSize = 0;
+	for (const Heap& heap : instance.heaps_) {
+		usedSize += heap.heap ? heap.allocator.GetUsedSize() : 0;
+	}
+	return usedSize;
+}
+
+uint64_t BufferHeapAllocator::GetFreeSize()
+{
+	BufferHeapAllocator& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	uint64_t freeSize = 0;
+	for (const Heap& heap : instance.heaps_) {
+		freeSize += heap.heap ? heap.allocator.GetFreeSize() : 0;
+	}
+	return freeSize;
+}
+
+float BufferHeapAllocator::GetFragmentation()
+{
+	BufferHeapAllocator& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	float fragmentation = 0.0f;
+	uint32_t heapCount = 0;
+	for (const Heap& heap : instance.heaps_) {
+		if (heap.heap) {
+			fragmentation += heap.allocator.GetFragmentation();
+			heapCount++;
+		}
+	}
+	return heapCount > 0 ? fragmentation / float(heapCount) : 0.0f;
+}
+
+void BufferHeapAllocator::OnResourceReleased(uint32_t heapIndex, uint64_t offset, uint64_t generation)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	// 終了処理の後に破棄されたリソースは何もしない
+	if (generation != generation_ || heapIndex >= heaps_.size() || !heaps_[heapIndex].heap) {
+		return;
+	}
+
+	// 記録済みの描画がまだ読むかもしれないので、次にSignalするFenceまで待つ
+	heaps_[heapIndex].allocator.Free(offset, DirectXBase::GetInstance()->GetFenceValue() + 1);
+}
+
+uint32_t BufferHeapAllocator::CreateHeap()
+{
+	D3D12_HEAP_DESC heapDesc{};
+	heapDesc.SizeInBytes = heapSize_;
+	heapDesc.Properties.Type = D3D12_HEAP_TYPE_UPLOAD;
+	heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	// バッファだけを置く（Resource Heap Tier 1でも使える）
+	heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+
+	// 解放したヒープの番号があれば再利用する
+	uint32_t heapIndex = 0;
+	for (; heapIndex < heaps_.size(); ++heapIndex) {
+		if (!heaps_[heapIndex].heap) {
+			break;
+		}
+	}
+	if (heapIndex == heaps_.size()) {
+		heaps_.emplace_back();
+	}
+
+	Heap& heap = heaps_[heapIndex];
+	HRESULT hr = device_->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap.heap));
+	assert(SUCCEEDED(hr));
+	heap.allocator.Initialize(heapSize_, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+
+	Log(std::format("BufferHeapAllocator : created heap {} ({}MB)\n", heapIndex, heapSize_ / (1024 * 1024)));
+	return heapIndex;
+}
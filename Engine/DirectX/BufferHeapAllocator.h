@@ -0,0 +1,62 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl.h>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// MyClass
+#include "TlsfAllocator.h"
+
+// アップロード用の大きなID3D12Heapを作り、バッファをその中に置く（CreateBufferResourceから使われる）
+// バッファごとにヒープを確保しないので、小さな頂点・インデックスバッファを大量に作ってもOSやドライバの確保が増えない
+// 置いたリソースが破棄されると、GPUが使い終わってからヒープの範囲を再利用する
+class BufferHeapAllocator final
+{
+public:
+	// 終了時に破棄されるリソースから呼ばれるので、インスタンスは破棄しない
+	static BufferHeapAllocator& GetInstance();
+
+	static void Initialize(ID3D12Device* device, uint64_t heapSize = kDefaultHeapSize_);
+	// 全てのヒープへの参照を捨てる（以降に破棄されたリソースは何もしない。GPUが使い終わってから呼ぶ）
+	static void Finalize();
+	static bool IsInitialized();
+
+	// バッファをヒープの中に作る（初期化前や、ヒープより大きいバッファはnullptrを返すので、呼び出し側で単独のリソースを作る）
+	static Microsoft::WRL::ComPtr<ID3D12Resource> CreateBuffer(const D3D12_RESOURCE_DESC& desc);
+
+	// GPUが使い終わった範囲を再利用できるようにし、空になったヒープを解放する（DirectXBase::EndFrameの後に呼ぶ）
+	static void EndFrame();
+
+	// ヒープの数と、全ヒープの使用中・空きのバイト数
+	static uint32_t GetHeapCount();
+	static uint64_t GetUsedSize();
+	static uint64_t GetFreeSize();
+	// 全ヒープの断片化の度合いの平均（0は空きが1つにまとまっている）
+	static float GetFragmentation();
+
+	// 置いたリソースが破棄されたときに呼ばれる
+	void OnResourceReleased(uint32_t heapIndex, uint64_t offset, uint64_t generation);
+
+private:
+	// 破棄されたリソースの範囲は、GPUが使い終わるまでallocatorの中で解放待ちにする
+	struct Heap {
+		Microsoft::WRL::ComPtr<ID3D12Heap> heap;
+		TlsfAllocator allocator;
+	};
+
+	static const uint64_t kDefaultHeapSize_ = 64 * 1024 * 1024;
+
+	// ヒープを作ってその番号を返す（解放したヒープの番号を再利用する）
+	uint32_t CreateHeap();
+
+	ID3D12Device* device_ = nullptr;
+	uint64_t heapSize_ = kDefaultHeapSize_;
+	// 解放したヒープはheapがnullptrのまま残す（置いたリソースが番号で参照するので詰めない）
+	std::vector<Heap> heaps_;
+	// Finalizeの前に作ったリソースが、後から破棄されても範囲を返さないように区別する
+	uint64_t generation_ = 0;
+
+	// ワーカースレッドでのモデル読み込みに備えて排他する
+	std::mutex mutex_;
+};
@@ -0,0 +1,104 @@
+#include "ConstantBufferAllocator.h"
+#include <algorithm>
+#include <cassert>
+
+// MyClass
+#include "DirectXBase.h"
+#include "DirectXUtil.h"
+
+ConstantBufferAllocator& ConstantBufferAllocator::GetInstance()
+{
+	static ConstantBufferAllocator instance;
+	return instance;
+}
+
+void ConstantBufferAllocator::Initialize(ID3D12Device* device, uint64_t pageSize)
+{
+	ConstantBufferAllocator& instance = GetInstance();
+	assert(pageSize % kAlignment_ == 0);
+	instance.device_ = device;
+	instance.allocator_.Initialize(pageSize);
+	instance.pages_.clear();
+}
+
+void ConstantBufferAllocator::Finalize()
+{
+	ConstantBufferAllocator& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	instance.pages_.clear();
+	instance.allocator_.Initialize(instance.allocator_.GetPageSize());
+}
+
+ConstantBufferAllocator::Allocation ConstantBufferAllocator::Allocate(size_t size)
+{
+	ConstantBufferAllocator& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+
+	LinearAllocator::Allocation allocation = instance.allocator_.Allocate(size, kAlignment_);
+	assert(allocation.page != LinearAllocator::kInvalidPage);
+
+	// 新しいページが必要になったらリソースを作ってマップしたままにする
+	while (instance.pages_.size() < instance.allocator_.GetPageCount()) {
+		Page page;
+		if (instance.device_) {
+			page.resource = CreateBufferResource(instance.device_, instance.allocator_.GetPageSize(), ResourceCategory::ConstantBuffer);
+			HRESULT result = page.resource->Map(0, nullptr, reinterpret_cast<void**>(&page.cpuAddress));
+			assert(SUCCEEDED(result));
+			page.gpuAddress = page.resource->GetGPUVirtualAddress();
+		} else {
+			// ヘッドレスの場合はCPUのメモリに書き込み、GPU上のアドレスはページごとに重ならない値にする
+			page.cpuMemory.resize(instance.allocator_.GetPageSize());
+			page.cpuAddress = page.cpuMemory.data();
+			page.gpuAddress = D3D12_GPU_VIRTUAL_ADDRESS(instance.pages_.size() + 1) << 32;
+		}
+		instance.pages_.push_back(std::move(page));
+	}
+
+	const Page& page = instance.pages_[allocation.page];
+	return { page.cpuAddress + allocation.offset, page.gpuAddress + allocation.offset };
+}
+
+void ConstantBufferAllocator::EndFrame()
+{
+	ConstantBufferAllocator& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+
+	// このフレームの描画は直前にSignalしたFenceの値で終わる
+	DirectXBase* dxBase = DirectXBase::GetInstance();
+	instance.allocator_.Submit(dxBase->GetFenceValue());
+	instance.allocator_.Retire(dxBase->GetCompletedFenceValue());
+}
+
+uint32_t ConstantBufferAllocator::GetPageCount()
+{
+	return GetInstance().allocator_.GetPageCount();
+}
+
+uint64_t ConstantBufferAllocator::GetPageSize()
+{
+	return GetInstance().allocator_.GetPageSize();
+}
+
+ConstantBufferAllocator::Allocation ConstantBufferBlock::Allocate(size_t size)
+{
+	const uint64_t kAlignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+	uint64_t alignedSize = (size + kAlignment - 1) / kAlignment * kAlignment;
+	uint64_t blockSize = (std::min)(kBlockSize_, ConstantBufferAllocator::GetPageSize());
+	if (alignedSize > blockSize) {
+		return ConstantBufferAllocator::Allocate(size);
+	}
+
+	// 残りに収まらなければ新しいブロックを取る（ブロックの先頭は256バイトに揃っているので、切り出す位置も揃う）
+	if (alignedSize > remainingSize_) {
+		ConstantBufferAllocator::Allocation block = ConstantBufferAllocator::Allocate(size_t(blockSize));
+		cpuAddress_ = static_cast<uint8_t*>(block.cpuAddress);
+		gpuAddress_ = block.gpuAddress;
+		remainingSize_ = blockSize;
+	}
+
+	ConstantBufferAllocator::Allocation allocation = { cpuAddress_, gpuAddress_ };
+	cpuAddress_ += alignedSize;
+	gpuAddress_ += alignedSize;
+	remainingSize_ -= alignedSize;
+	return allocation;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl.h>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+// MyClass
+#include "LinearAllocator.h"
+
+// 描画ごとの定数データを、マップしたままのアップロード用のページから確保する（確保したアドレスはそのフレームの間だけ有効）
+// ページはフレームのFenceにGPUが到達したら再利用するので、描画ごとにリソースを作らずに済む
+class ConstantBufferAllocator final
+{
+public:
+	// 確保した定数バッファの書き込み先とGPU上のアドレス
+	struct Allocation {
+		void* cpuAddress;
+		D3D12_GPU_VIRTUAL_ADDRESS gpuAddress;
+	};
+
+	static ConstantBufferAllocator& GetInstance();
+
+	// deviceがnullptrの場合（ヘッドレス）は、ページをCPUのメモリに作る
+	static void Initialize(ID3D12Device* device, uint64_t pageSize = kDefaultPageSize_);
+	// 全てのページを解放する（GPUが使い終わってから呼ぶ）
+	static void Finalize();
+
+	// 定数バッファの領域を確保する（アドレスは256バイトに揃う）
+	static Allocation Allocate(size_t size);
+	// データを書き込んで、そのGPU上のアドレスを返す
+	template<class Type>
+	static D3D12_GPU_VIRTUAL_ADDRESS Upload(const Type& data)
+	{
+		Allocation allocation = Allocate(sizeof(Type));
+		std::memcpy(allocation.cpuAddress, &data, sizeof(Type));
+		return allocation.gpuAddress;
+	}
+
+	// このフレームで確保したページを提出し、GPUが使い終わったページを再利用できるようにする（DirectXBase::EndFrameの後に呼ぶ）
+	static void EndFrame();
+
+	// 作ったページの数
+	static uint32_t GetPageCount();
+	// ページの大きさ
+	static uint64_t GetPageSize();
+
+private:
+	// マップしたままのページ（デバイスが無い場合はCPUのメモリ）
+	struct Page {
+		Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+		std::vector<uint8_t> cpuMemory;
+		uint8_t* cpuAddress = nullptr;
+		D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = 0;
+	};
+
+	// 定数バッファのアドレスのアラインメント
+	static const uint64_t kAlignment_ = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+	static const uint64_t kDefaultPageSize_ = 1024 * 1024;
+
+	ID3D12Device* device_ = nullptr;
+	LinearAllocator allocator_;
+	std::vector<Page> pages_;
+
+	// 複数のスレッドからの描画の記録に備えて排他する
+	std::mutex mutex_;
+};
+
+// ConstantBufferAllocatorからまとめて確保したブロックを、1つのスレッドだけで先頭から切り出す確保先
+// 並列に記録するチャンクごとに持ち、描画ごとではなくブロックを取るときだけConstantBufferAllocatorをロックする
+// 確保したアドレスはConstantBufferAllocatorと同じくそのフレームの間だけ有効なので、次のフレームで使う前にResetする
+class ConstantBufferBlock
+{
+public:
+	// 定数バッファの領域を確保する（ブロックより大きい場合はConstantBufferAllocatorから直接確保する）
+	ConstantBufferAllocator::Allocation Allocate(size_t size);
+	// データを書き込んで、そのGPU上のアドレスを返す
+	template<class Type>
+	D3D12_GPU_VIRTUAL_ADDRESS Upload(const Type& data)
+	{
+		ConstantBufferAllocator::Allocation allocation = Allocate(sizeof(Type));
+		std::memcpy(allocation.cpuAddress, &data, sizeof(Type));
+		return allocation.gpuAddress;
+	}
+
+	// ブロックの残りを捨てる（次の確保で新しいブロックを取る）
+	void Reset() { remainingSize_ = 0; }
+
+private:
+	// 1回に取るブロックの大きさ（256バイトの定数なら256回分）
+	static const uint64_t kBlockSize_ = 64 * 1024;
+
+	uint8_t* cpuAddress_ = nullptr;
+	D3D12_GPU_VIRTUAL_ADDRESS gpuAddress_ = 0;
+	uint64_t remainingSize_ = 0;
+};
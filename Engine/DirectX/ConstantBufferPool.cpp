@@ -0,0 +1,105 @@
+#include "ConstantBufferPool.h"
+#include <cassert>
+
+// MyClass
+#include "DirectXBase.h"
+#include "DirectXUtil.h"
+
+ConstantBufferPool& ConstantBufferPool::GetInstance()
+{
+	static ConstantBufferPool* instance = new ConstantBufferPool;
+	return *instance;
+}
+
+void ConstantBufferPool::Initialize(ID3D12Device* device, uint32_t pageSize)
+{
+	ConstantBufferPool& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	instance.device_ = device;
+	instance.isInitialized_ = true;
+	instance.allocator_.Initialize(pageSize, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+	instance.pages_.clear();
+	instance.retiredSlots_.clear();
+}
+
+void ConstantBufferPool::Finalize()
+{
+	ConstantBufferPool& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	instance.pages_.clear();
+	instance.retiredSlots_.clear();
+	instance.device_ = nullptr;
+	instance.isInitialized_ = false;
+}
+
+ConstantBufferPool::Allocation ConstantBufferPool::Allocate(size_t size)
+{
+	ConstantBufferPool& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	assert(instance.isInitialized_);
+
+	Allocation allocation;
+	allocation.slot = instance.allocator_.Allocate(uint32_t(size));
+	assert(allocation.slot.page != PoolAllocator::kInvalidPage);
+
+	// 新しいページが必要になったらリソースを作ってマップしたままにする
+	while (instance.pages_.size() < instance.allocator_.GetPageCount()) {
+		Page page;
+		if (instance.device_) {
+			page.resource = CreateBufferResource(instance.device_, instance.allocator_.GetPageSize(), ResourceCategory::ConstantBuffer);
+			HRESULT result = page.resource->Map(0, nullptr, reinterpret_cast<void**>(&page.cpuAddress));
+			assert(SUCCEEDED(result));
+			page.gpuAddress = page.resource->GetGPUVirtualAddress();
+		} else {
+			// ヘッドレスの場合はCPUのメモリに書き込み、GPU上のアドレスはページごとに重ならない値にする
+			page.cpuMemory.resize(instance.allocator_.GetPageSize());
+			page.cpuAddress = page.cpuMemory.data();
+			page.gpuAddress = D3D12_GPU_VIRTUAL_ADDRESS(instance.pages_.size() + 1) << 32;
+		}
+		instance.pages_.push_back(std::move(page));
+	}
+
+	const Page& page = instance.pages_[allocation.slot.page];
+	allocation.cpuAddress = page.cpuAddress + allocation.slot.offset;
+	allocation.gpuAddress = page.gpuAddress + allocation.slot.offset;
+	return allocation;
+}
+
+void ConstantBufferPool::Free(const Allocation& allocation)
+{
+	ConstantBufferPool& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	// 終了処理の後に破棄された定数バッファは何もしない
+	if (instance.pages_.empty() || allocation.slot.page == PoolAllocator::kInvalidPage) {
+		return;
+	}
+
+	// 記録済みの描画がまだ読むかもしれないので、次にSignalするFenceまで待つ
+	instance.retiredSlots_.push_back({ DirectXBase::GetInstance()->GetFenceValue() + 1, allocation.slot });
+}
+
+void ConstantBufferPool::EndFrame()
+{
+	ConstantBufferPool& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+
+	uint64_t completedFenceValue = DirectXBase::GetInstance()->GetCompletedFenceValue();
+	while (!instance.retiredSlots_.empty() && instance.retiredSlots_.front().fenceValue <= completedFenceValue) {
+		instance.allocator_.Free(instance.retiredSlots_.front().slot);
+		instance.retiredSlots_.pop_front();
+	}
+}
+
+uint32_t ConstantBufferPool::GetPageCount()
+{
+	ConstantBufferPool& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	return instance.allocator_.GetPageCount();
+}
+
+size_t ConstantBufferPool::GetAllocationCount()
+{
+	ConstantBufferPool& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	return instance.allocator_.GetUsedSlotCount();
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl.h>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// MyClass
+#include "PoolAllocator.h"
+
+// 長く使う定数バッファ（マテリアルや動かないオブジェクトの行列など）を、共有する64KBのページから切り出す
+// ページはマップしたままにするので、確保と解放にリソースの生成やMapは伴わない
+class ConstantBufferPool final
+{
+public:
+	// 確保した定数バッファ
+	struct Allocation {
+		void* cpuAddress = nullptr;
+		D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = 0;
+		PoolAllocator::Allocation slot = { PoolAllocator::kInvalidPage, 0 };
+	};
+
+	// 終了時に破棄される定数バッファから呼ばれるので、インスタンスは破棄しない
+	static ConstantBufferPool& GetInstance();
+
+	// deviceがnullptrの場合（ヘッドレス）は、ページをCPUのメモリに作る
+	static void Initialize(ID3D12Device* device, uint32_t pageSize = kDefaultPageSize_);
+	// 全てのページを解放する（以降の解放は何もしない。GPUが使い終わってから呼ぶ）
+	static void Finalize();
+
+	// 定数バッファの領域を確保する（アドレスは256バイトに揃う）
+	static Allocation Allocate(size_t size);
+	// 領域を解放する（GPUが使い終わるまで再利用しない）
+	static void Free(const Allocation& allocation);
+
+	// GPUが使い終わった領域を再利用できるようにする（DirectXBase::EndFrameの後に呼ぶ）
+	static void EndFrame();
+
+	// 作ったページの数と、使っている定数バッファの数
+	static uint32_t GetPageCount();
+	static size_t GetAllocationCount();
+
+private:
+	// マップしたままのページ（デバイスが無い場合はCPUのメモリ）
+	struct Page {
+		Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+		std::vector<uint8_t> cpuMemory;
+		uint8_t* cpuAddress = nullptr;
+		D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = 0;
+	};
+	// GPUが使い終わるのを待っている領域
+	struct RetiredSlot {
+		uint64_t fenceValue;
+		PoolAllocator::Allocation slot;
+	};
+
+	static const uint32_t kDefaultPageSize_ = 64 * 1024;
+
+	ID3D12Device* device_ = nullptr;
+	// Initializeの後でFinalizeの前か（ヘッドレスの場合はdeviceがnullptrなので、別に覚えておく）
+	bool isInitialized_ = false;
+	PoolAllocator allocator_;
+	std::vector<Page> pages_;
+	std::deque<RetiredSlot> retiredSlots_;
+
+	// ワーカースレッドでのモデル読み込み（マテリアルの登録）に備えて排他する
+	std::mutex mutex_;
+};
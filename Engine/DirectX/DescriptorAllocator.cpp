@@ -0,0 +1,67 @@
+#include "DescriptorAllocator.h"
+#include <cassert>
+
+void DescriptorAllocator::Initialize(uint32_t capacity, uint32_t reservedCount)
+{
+	assert(reservedCount <= capacity && capacity <= kIndexMask_ + 1);
+	capacity_ = capacity;
+	reservedCount_ = reservedCount;
+	nextIndex_ = reservedCount;
+	allocatedCount_ = 0;
+	generations_.assign(capacity, 1);
+	freeIndices_.clear();
+	pendingFrees_.clear();
+}
+
+uint32_t DescriptorAllocator::Allocate()
+{
+	uint32_t index = 0;
+	if (!freeIndices_.empty()) {
+		// 解放された場所を再利用する
+		index = freeIndices_.back();
+		freeIndices_.pop_back();
+	} else {
+		// 空きが無ければ容量を増やす
+		if (nextIndex_ >= capacity_) {
+			assert(capacity_ * 2 <= kIndexMask_ + 1);
+			capacity_ = capacity_ == 0 ? 1 : capacity_ * 2;
+			generations_.resize(capacity_, 1);
+		}
+		index = nextIndex_++;
+	}
+
+	allocatedCount_++;
+	return (uint32_t(generations_[index]) << kIndexBits_) | index;
+}
+
+void DescriptorAllocator::Free(uint32_t handle, uint64_t fenceValue)
+{
+	assert(IsValid(handle));
+	uint32_t index = GetIndex(handle);
+
+	// 世代を進めて、持っているハンドルを無効にする（0は無効なハンドルに使うので飛ばす）
+	uint16_t& generation = generations_[index];
+	generation = static_cast<uint16_t>(generation >= kMaxGeneration_ ? 1 : generation + 1);
+
+	// 場所はGPUが使い終わるまで再利用しない
+	assert(pendingFrees_.empty() || pendingFrees_.back().fenceValue <= fenceValue);
+	pendingFrees_.push_back({ fenceValue, index });
+	allocatedCount_--;
+}
+
+void DescriptorAllocator::Retire(uint64_t completedFenceValue)
+{
+	while (!pendingFrees_.empty() && pendingFrees_.front().fenceValue <= completedFenceValue) {
+		freeIndices_.push_back(pendingFrees_.front().index);
+		pendingFrees_.pop_front();
+	}
+}
+
+bool DescriptorAllocator::IsValid(uint32_t handle) const
+{
+	uint32_t index = GetIndex(handle);
+	if (handle == kInvalidHandle || index < reservedCount_ || index >= nextIndex_) {
+		return false;
+	}
+	return generations_[index] == (handle >> kIndexBits_);
+}
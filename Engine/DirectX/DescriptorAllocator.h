@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// DescriptorHeapの場所の確保と解放を管理する（GPUのリソースには依存しない）
+// ハンドルは下位ビットに場所、上位ビットに世代を持ち、解放済みのハンドルの使用を検出できる
+class DescriptorAllocator
+{
+public:
+	// 無効なハンドル（世代は1から始まるので、確保したハンドルが0になることはない）
+	static const uint32_t kInvalidHandle = 0;
+
+	// capacityは初期の容量、reservedCountは先頭から確保しない数（ImGuiのフォントなど）
+	void Initialize(uint32_t capacity, uint32_t reservedCount = 0);
+
+	// 場所を確保してハンドルを返す（空きが無い場合は容量を2倍に増やす）
+	uint32_t Allocate();
+	// ハンドルを無効にし、fenceValueにGPUが到達したら場所を再利用できるようにする
+	void Free(uint32_t handle, uint64_t fenceValue);
+	// completedFenceValueまでに解放された場所を再利用できるようにする
+	void Retire(uint64_t completedFenceValue);
+
+	// 解放されていないハンドルか
+	bool IsValid(uint32_t handle) const;
+	// ハンドルが指すDescriptorHeap上の場所
+	static uint32_t GetIndex(uint32_t handle) { return handle & kIndexMask_; }
+
+	uint32_t GetCapacity() const { return capacity_; }
+	// これまでに使用したことのある場所の数（この範囲だけDescriptorをコピーすればよい）
+	uint32_t GetUsedRange() const { return nextIndex_; }
+	uint32_t GetAllocatedCount() const { return allocatedCount_; }
+
+private:
+	// 解放待ちの場所
+	struct PendingFree {
+		uint64_t fenceValue;
+		uint32_t index;
+	};
+
+	// int型で扱われても負にならないように、場所20bit・世代11bitにする
+	static const uint32_t kIndexBits_ = 20;
+	static const uint32_t kIndexMask_ = (1u << kIndexBits_) - 1;
+	static const uint32_t kMaxGeneration_ = (1u << 11) - 1;
+
+	uint32_t capacity_ = 0;
+	uint32_t reservedCount_ = 0;
+	// まだ一度も使っていない場所の先頭
+	uint32_t nextIndex_ = 0;
+	uint32_t allocatedCount_ = 0;
+
+	// 場所ごとの現在の世代
+	std::vector<uint16_t> generations_;
+	// 再利用できる場所（最後に解放したものから使う）
+	std::vector<uint32_t> freeIndices_;
+	// GPUが使い終わるのを待っている場所
+	std::deque<PendingFree> pendingFrees_;
+};
@@ -5,6 +5,7 @@ void DescriptorHeap::Create(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE hea
 {
 	heap_ = nullptr;
 	type_ = heapType;
+	numDescriptors_ = numDescriptors;
 	size_ = device->GetDescriptorHandleIncrementSize(type_);
 	// ディスクリプタヒープの設定を行う
 	D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc{};
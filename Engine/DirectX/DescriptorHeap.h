@@ -15,8 +15,12 @@ public:
 	D3D12_CPU_DESCRIPTOR_HANDLE GetCPUHandle(uint32_t index);
 	D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle(uint32_t index);
 
+	D3D12_DESCRIPTOR_HEAP_TYPE GetType() const { return type_; }
+	uint32_t GetNumDescriptors() const { return numDescriptors_; }
+
 private:
 	D3D12_DESCRIPTOR_HEAP_TYPE type_;
 	uint32_t size_;
+	uint32_t numDescriptors_ = 0;
 };
 
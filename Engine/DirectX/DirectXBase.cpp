@@ -1,15 +1,39 @@
 #include "DirectXBase.h"
+#include <algorithm>
 #include <cassert>
-#include <thread>
-#include <chrono>
+#include <vector>
 
 // MyClass
 #include "Logger.h"
 #include "StringUtil.h"
 #include "DirectXUtil.h"
+#include "DrawPartition.h"
+
+namespace {
+	// RenderGraphの一時的なTextureのリソースの設定
+	D3D12_RESOURCE_DESC MakeTransientResourceDesc(const TransientResourceDesc& desc)
+	{
+		D3D12_RESOURCE_DESC resourceDesc{};
+		resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		resourceDesc.Width = desc.width;
+		resourceDesc.Height = desc.height;
+		resourceDesc.DepthOrArraySize = 1;
+		resourceDesc.MipLevels = 1;
+		resourceDesc.Format = DXGI_FORMAT(desc.format);
+		resourceDesc.SampleDesc.Count = 1;
+		// 深度バッファとして作るもの以外はRenderTargetとして書き込めるようにする
+		resourceDesc.Flags = desc.initialState == ResourceState::DepthWrite ? D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL : D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+		return resourceDesc;
+	}
+}
 
 DirectXBase::~DirectXBase()
 {
+	// ヘッドレスの場合はDXCもFenceも作っていない
+	if (isHeadless_) {
+		Log("Released DirectXBase\n");
+		return;
+	}
 	CloseHandle(fenceEvent_);
 	dxcUtils_->Release();
 	dxcCompiler_->Release();
@@ -26,6 +50,19 @@ DirectXBase* DirectXBase::GetInstance()
 	return &instance;
 }
 
+void DirectXBase::InitializeHeadless()
+{
+	isHeadless_ = true;
+	frameRing_.Initialize(framesInFlight_);
+	fenceValue_ = 0;
+	Log("DirectXBase : headless (draws are counted by NullRenderBackend)\n");
+}
+
+bool DirectXBase::IsHeadless()
+{
+	return isHeadless_;
+}
+
 void DirectXBase::InitializeDXGIDevice([[maybe_unused]]bool enableDebugLayer)
 {
 #ifdef _DEBUG
@@ -125,15 +162,19 @@ void DirectXBase::InitializeCommand()
 	result = device_->CreateCommandQueue(&commandQueueDesc, IID_PPV_ARGS(&commandQueue_));
 	assert(SUCCEEDED(result));
 
-	// コマンドアロケータを生成する
-	commandAllocator_ = nullptr;
-	result = device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocator_));
-	assert(SUCCEEDED(result));
+	// コマンドアロケータをフレームの数だけ生成する
+	for (uint32_t i = 0; i < framesInFlight_; ++i) {
+		commandAllocators_[i] = nullptr;
+		result = device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocators_[i]));
+		assert(SUCCEEDED(result));
+	}
+	frameRing_.Initialize(framesInFlight_);
 
-	// コマンドリストを生成する
+	// コマンドリストを生成する（最初のフレームのコマンドアロケータを使う）
 	commandList_ = nullptr;
-	result = device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocator_.Get(), nullptr, IID_PPV_ARGS(&commandList_));
+	result = device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocators_[frameRing_.GetFrameIndex()].Get(), nullptr, IID_PPV_ARGS(&commandList_));
 	assert(SUCCEEDED(result));
+	backend_.SetCommandList(commandList_.Get());
 }
 
 void DirectXBase::CreateSwapChain()
@@ -424,67 +465,97 @@ void DirectXBase::CreateDepthBuffer()
 
 void DirectXBase::BeginFrame()
 {
-	HRESULT result = S_FALSE;
+	// これから書き込むバックバッファのインデックスを取得（ヘッドレスの場合はリソースの無いバックバッファを使う）
+	if (!isHeadless_) {
+		backBufferIndex_ = swapChain_->GetCurrentBackBufferIndex();
+	}
 
-	// これから書き込むバックバッファのインデックスを取得
-	UINT backBufferIndex = swapChain_->GetCurrentBackBufferIndex();
-
-	// TransitionBarrierの設定
-	// 今回のバリアはTransition
-	barrier_.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-	// Noneにしておく
-	barrier_.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-	// バリアを張る対象のリソース。現在のバックバッファに対して行う
-	barrier_.Transition.pResource = swapChainResources_[backBufferIndex].Get();
-	// 遷移前（現在）のResourceState
-	barrier_.Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT;
-	// 遷移後のResourceState
-	barrier_.Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
-	// TransitionBarrierを張る
-	commandList_->ResourceBarrier(1, &barrier_);
-
-	// 描画先のRTVをとDSVを設定する
-	D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = dsvDescriptorHeap_.GetCPUHandle(0);
-	commandList_->OMSetRenderTargets(1, &rtvHandles_[backBufferIndex], false, &dsvHandle);
-	// 指定した色で画面全体をクリアする
-	float clearColor[] = { 0.1f, 0.25f, 0.5f, 1.0f };
-	commandList_->ClearRenderTargetView(rtvHandles_[backBufferIndex], clearColor, 0, nullptr);
-	// 指定した深度で画面全体をクリアする
-	commandList_->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+	// フレームのRenderGraphを組み直す（バックバッファは表示する状態から始まり、表示する状態に戻す）
+	frameGraph_.Reset();
+	backBufferResource_ = frameGraph_.ImportResource("BackBuffer", swapChainResources_[backBufferIndex_].Get(), ResourceState::Present, ResourceState::Present);
+	depthResource_ = frameGraph_.ImportResource("Depth", depthStencilResource_.Get(), ResourceState::DepthWrite, ResourceState::DepthWrite);
+
+	// 描画先を設定して画面全体をクリアするパス
+	uint32_t clearPass = frameGraph_.AddPass("Clear", [this](ID3D12GraphicsCommandList* commandList) {
+		// ヘッドレスの場合はクリアするものが無い
+		if (!commandList) {
+			return;
+		}
+		// 描画先のRTVをとDSVを設定する
+		D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = dsvDescriptorHeap_.GetCPUHandle(0);
+		commandList->OMSetRenderTargets(1, &rtvHandles_[backBufferIndex_], false, &dsvHandle);
+		// 指定した色で画面全体をクリアする
+		float clearColor[] = { 0.1f, 0.25f, 0.5f, 1.0f };
+		commandList->ClearRenderTargetView(rtvHandles_[backBufferIndex_], clearColor, 0, nullptr);
+		// 指定した深度で画面全体をクリアする
+		commandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+	});
+	frameGraph_.Write(clearPass, backBufferResource_, ResourceState::RenderTarget);
+	frameGraph_.Write(clearPass, depthResource_, ResourceState::DepthWrite);
 }
 
 void DirectXBase::EndFrame()
 {
 	HRESULT result = S_FALSE;
 
+	// ヘッドレスの場合は、提出したフレームをGPUが直ちに終えたものとして次のフレームに進む
+	if (isHeadless_) {
+		fenceValue_++;
+		frameRing_.Advance(fenceValue_);
+		frameLimiter_.Wait();
+		return;
+	}
+
 	// GPUとOSに画面の交換を行うよう通知する
-	swapChain_->Present(1, 0);
+	swapChain_->Present(isVSyncEnabled_ ? 1 : 0, 0);
 
 	// Fenceの値を更新
 	fenceValue_++;
 	// GPUがここまでたどり着いたときに、Fenceの値を指定した値に代入するようにSignalを送る
 	commandQueue_->Signal(fence_.Get(), fenceValue_);
 
+	// 次のフレームに進む（そのフレームの領域を前回使ったフレームの終わりのFenceの値が返る）
+	uint64_t reuseFenceValue = frameRing_.Advance(fenceValue_);
+
+	// 次のフレームの領域を前回使ったフレームだけを待つ（それより後のフレームはGPUで実行されたままでよい）
+	WaitForFenceValue(reuseFenceValue);
+
+	// 次のフレーム用のコマンドリストを準備
+	ID3D12CommandAllocator* commandAllocator = commandAllocators_[frameRing_.GetFrameIndex()].Get();
+	result = commandAllocator->Reset();
+	assert(SUCCEEDED(result));
+	result = commandList_->Reset(commandAllocator, nullptr);
+	assert(SUCCEEDED(result));
+
+	// 目標のフレームレートに合わせて次のフレームの開始まで待つ（入力を読む直前に待つので遅延が増えない）
+	frameLimiter_.Wait();
+}
+
+void DirectXBase::WaitForGpu()
+{
+	WaitForFenceValue(fenceValue_);
+}
+
+void DirectXBase::WaitForFenceValue(uint64_t fenceValue)
+{
+	if (isHeadless_) {
+		return;
+	}
 	// Fenceの値が指定したSignal値にたどり着いているか確認する
 	// GetCompletedValueの初期値はFence作成時に渡した初期値
-	if (fence_->GetCompletedValue() < fenceValue_) {
+	if (fence_->GetCompletedValue() < fenceValue) {
 		// 指定したSignalにたどりついていないので、たどり着くまで待つようにイベントを設定する
-		fence_->SetEventOnCompletion(fenceValue_, fenceEvent_);
-		// 約60fpsに制限
-		std::this_thread::sleep_for(std::chrono::microseconds(16000)); // 60fpsに制限
+		fence_->SetEventOnCompletion(fenceValue, fenceEvent_);
 		// イベント待つ
 		WaitForSingleObject(fenceEvent_, INFINITE);
 	}
-
-	// 次のフレーム用のコマンドリストを準備
-	result = commandAllocator_->Reset();
-	assert(SUCCEEDED(result));
-	result = commandList_->Reset(commandAllocator_.Get(), nullptr);
-	assert(SUCCEEDED(result));
 }
 
 void DirectXBase::PreDraw()
 {
+	if (isHeadless_) {
+		return;
+	}
 	// 描画に必要な情報をコマンドリストに積む
 	commandList_->RSSetViewports(1, &viewport_); // Viewportを設定
 	commandList_->RSSetScissorRects(1, &scissorRect_); // Scirssorを設定
@@ -499,12 +570,12 @@ void DirectXBase::PostDraw()
 {
 	HRESULT result = S_FALSE;
 
-	// 画面に書く処理はすべて終わり、画面に映すので、状態を遷移
-	// 今回はRendertargetからPresentにする
-	barrier_.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
-	barrier_.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
-	// TransitionBarrierを張る
-	commandList_->ResourceBarrier(1, &barrier_);
+	// フレームのパスをバリアと共に記録する（最後にバックバッファを画面に映す状態に戻す）
+	frameGraph_.Compile();
+	ExecuteRenderGraph(frameGraph_, commandList_.Get());
+	if (isHeadless_) {
+		return;
+	}
 
 	// コマンドリストの内容を確定させる
 	result = commandList_->Close();
@@ -515,6 +586,306 @@ void DirectXBase::PostDraw()
 	commandQueue_->ExecuteCommandLists(1, commandLists);
 }
 
+void DirectXBase::SetDescriptorHeap(ID3D12DescriptorHeap* descriptorHeap)
+{
+	descriptorHeap_ = descriptorHeap;
+	if (!isHeadless_) {
+		commandList_->SetDescriptorHeaps(1, &descriptorHeap_);
+	}
+}
+
+void DirectXBase::RecordDrawsInParallel(size_t drawCount, const std::function<void(RenderBackend&)>& setupChunk,
+	const std::function<void(RenderBackend&, size_t drawIndex)>& recordDraw, uint32_t threadCount)
+{
+	// チャンクごとのコマンドリストに記録し、ここまでのコマンドリストに続けて提出する
+	class ChunkCommandSink : public DrawCommandSink
+	{
+	public:
+		ChunkCommandSink(DirectXBase& dxBase, const std::function<void(RenderBackend&)>& setupChunk) : dxBase_(dxBase), setupChunk_(setupChunk) {}
+
+		void BeginChunk(uint32_t chunk) override {
+			HRESULT result = S_FALSE;
+			uint32_t frameIndex = dxBase_.frameRing_.GetFrameIndex();
+			Microsoft::WRL::ComPtr<ID3D12CommandAllocator>& commandAllocator = dxBase_.chunkCommandAllocators_[frameIndex][chunk];
+			Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>& commandList = dxBase_.chunkCommandLists_[chunk];
+
+			// 初めて使うチャンクはコマンドアロケータとコマンドリストを作る（チャンクごとに別のスレッドなので排他は要らない）
+			if (!commandAllocator) {
+				result = dxBase_.device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocator));
+				assert(SUCCEEDED(result));
+			} else {
+				// このフレームの領域をGPUが使い終わっていることはEndFrameで待っている
+				result = commandAllocator->Reset();
+				assert(SUCCEEDED(result));
+			}
+			if (!commandList) {
+				result = dxBase_.device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocator.Get(), nullptr, IID_PPV_ARGS(&commandList));
+				assert(SUCCEEDED(result));
+			} else {
+				result = commandList->Reset(commandAllocator.Get(), nullptr);
+				assert(SUCCEEDED(result));
+			}
+
+			dxBase_.SetRenderState(commandList.Get());
+			chunkBackends_[chunk].SetCommandList(commandList.Get());
+			chunkBackends_[chunk].BeginChunk();
+			setupChunk_(chunkBackends_[chunk]);
+		}
+
+		void EndChunk(uint32_t chunk) override {
+			HRESULT result = dxBase_.chunkCommandLists_[chunk]->Close();
+			assert(SUCCEEDED(result));
+		}
+
+		void Submit(uint32_t chunkCount) override {
+			if (chunkCount == 0) {
+				return;
+			}
+			HRESULT result = S_FALSE;
+
+			// チャンクごとにまとめておいたTextureの報告を、チャンクの順に渡す
+			for (uint32_t i = 0; i < chunkCount; ++i) {
+				chunkBackends_[i].SubmitChunk();
+			}
+
+			// ここまでのコマンドリストとチャンクのコマンドリストを順に提出する（同じキューなので、この順に実行される）
+			result = dxBase_.commandList_->Close();
+			assert(SUCCEEDED(result));
+			ID3D12CommandList* commandLists[kMaxRecordChunks + 1] = { dxBase_.commandList_.Get() };
+			for (uint32_t i = 0; i < chunkCount; ++i) {
+				commandLists[i + 1] = dxBase_.chunkCommandLists_[i].Get();
+			}
+			dxBase_.commandQueue_->ExecuteCommandLists(chunkCount + 1, commandLists);
+
+			// 提出したコマンドリストは実行中でもリセットできるので、同じコマンドアロケータで続きを記録する
+			result = dxBase_.commandList_->Reset(dxBase_.commandAllocators_[dxBase_.frameRing_.GetFrameIndex()].Get(), nullptr);
+			assert(SUCCEEDED(result));
+			dxBase_.SetRenderState(dxBase_.commandList_.Get());
+			setupChunk_(dxBase_.backend_);
+		}
+
+		RenderBackend& GetChunkBackend(uint32_t chunk) { return chunkBackends_[chunk]; }
+
+	private:
+		DirectXBase& dxBase_;
+		const std::function<void(RenderBackend&)>& setupChunk_;
+		D3D12RenderBackend chunkBackends_[kMaxRecordChunks];
+	};
+
+	// ヘッドレスの場合は、チャンクごとに数えた回数とTextureの報告を提出するときに足し合わせる
+	class NullChunkSink : public DrawCommandSink
+	{
+	public:
+		NullChunkSink(DirectXBase& dxBase, const std::function<void(RenderBackend&)>& setupChunk) : dxBase_(dxBase), setupChunk_(setupChunk) {}
+
+		void BeginChunk(uint32_t chunk) override {
+			chunkBackends_[chunk].Reset();
+			chunkBackends_[chunk].BeginChunk();
+			setupChunk_(chunkBackends_[chunk]);
+		}
+
+		void EndChunk(uint32_t) override {}
+
+		void Submit(uint32_t chunkCount) override {
+			for (uint32_t i = 0; i < chunkCount; ++i) {
+				chunkBackends_[i].SubmitChunk();
+				dxBase_.nullBackend_.Merge(chunkBackends_[i]);
+			}
+			if (chunkCount > 0) {
+				setupChunk_(dxBase_.nullBackend_);
+			}
+		}
+
+		RenderBackend& GetChunkBackend(uint32_t chunk) { return chunkBackends_[chunk]; }
+
+	private:
+		DirectXBase& dxBase_;
+		const std::function<void(RenderBackend&)>& setupChunk_;
+		NullRenderBackend chunkBackends_[kMaxRecordChunks];
+	};
+
+	// 1つのチャンクが少なすぎると、コマンドリストの準備と提出の方が高くつく
+	const size_t kMinDrawsPerChunk = 256;
+
+	// 毎フレーム呼ぶので、スレッドを作らずにworkerPool_のスレッドで記録する
+	if (threadCount == 0) {
+		threadCount = workerPool_.GetThreadCount();
+	}
+	threadCount = (std::min)(threadCount, kMaxRecordChunks);
+
+	if (isHeadless_) {
+		NullChunkSink sink(*this, setupChunk);
+		::RecordDrawsInParallel(workerPool_, drawCount, threadCount, kMinDrawsPerChunk, sink, [&](uint32_t chunk, size_t drawIndex) {
+			recordDraw(sink.GetChunkBackend(chunk), drawIndex);
+		});
+		return;
+	}
+	ChunkCommandSink sink(*this, setupChunk);
+	::RecordDrawsInParallel(workerPool_, drawCount, threadCount, kMinDrawsPerChunk, sink, [&](uint32_t chunk, size_t drawIndex) {
+		recordDraw(sink.GetChunkBackend(chunk), drawIndex);
+	});
+}
+
+uint32_t DirectXBase::CreateTransientTexture(RenderGraph& graph, const std::string& name, uint32_t width, uint32_t height, DXGI_FORMAT format, ResourceState initialState)
+{
+	assert(initialState == ResourceState::RenderTarget || initialState == ResourceState::DepthWrite);
+	TransientResourceDesc desc;
+	desc.width = width;
+	desc.height = height;
+	desc.format = uint32_t(format);
+	desc.initialState = initialState;
+
+	// ヒープ上の大きさとアラインメント（MSAAは使わないので64KiBに収まる）
+	D3D12_RESOURCE_DESC resourceDesc = MakeTransientResourceDesc(desc);
+	D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = device_->GetResourceAllocationInfo(0, 1, &resourceDesc);
+	assert(allocationInfo.Alignment <= D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+	desc.size = allocationInfo.SizeInBytes;
+	desc.alignment = allocationInfo.Alignment;
+	return graph.CreateTransientResource(name, desc);
+}
+
+void DirectXBase::PlaceTransientResources(RenderGraph& graph)
+{
+	HRESULT result = S_FALSE;
+
+	// GPUが使い終わったヒープとリソースを解放する
+	uint64_t completedFenceValue = GetCompletedFenceValue();
+	while (!retiredTransients_.empty() && retiredTransients_.front().fenceValue <= completedFenceValue) {
+		retiredTransients_.pop_front();
+	}
+
+	// 最大の大きさを指定せずに置いているので、ヒープは1つにまとまっている
+	const AliasingPlan& plan = graph.GetAliasingPlan();
+	assert(plan.heapSizes.size() <= 1);
+	uint64_t heapSize = plan.GetTotalSize();
+	// これまでに積んだコマンドが参照している可能性があるので、作り直したものはGPUが使い終わってから解放する
+	uint64_t fenceValue = GetFenceValue() + 1;
+
+	// ヒープが足りなければ、置いたリソースごと作り直す
+	if (heapSize > transientHeapSize_) {
+		for (TransientResource& entry : transientResources_) {
+			retiredTransients_.push_back({ fenceValue, std::move(entry.resource) });
+		}
+		transientResources_.clear();
+		if (transientHeap_) {
+			retiredTransients_.push_back({ fenceValue, std::move(transientHeap_) });
+		}
+
+		D3D12_HEAP_DESC heapDesc{};
+		heapDesc.SizeInBytes = heapSize;
+		heapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+		heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+		heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+		result = device_->CreateHeap(&heapDesc, IID_PPV_ARGS(&transientHeap_));
+		assert(SUCCEEDED(result));
+		transientHeapSize_ = heapSize;
+		Log(std::format("DirectXBase : transient heap {:.1f} MiB ({:.1f} MiB saved by aliasing)\n",
+			double(heapSize) / (1024.0 * 1024.0), double(plan.GetSavedSize()) / (1024.0 * 1024.0)));
+	}
+
+	// 前のフレームと同じ位置に同じリソースを置く場合は、作ったリソースをそのまま使う
+	std::vector<bool> isUsed(transientResources_.size(), false);
+	for (uint32_t resource = 0; resource < graph.GetResourceCount(); ++resource) {
+		if (!graph.IsTransient(resource) || !graph.IsPlaced(resource)) {
+			continue;
+		}
+		const TransientResourceDesc& desc = graph.GetTransientDesc(resource);
+		uint64_t offset = graph.GetHeapOffset(resource);
+		size_t index = 0;
+		while (index < transientResources_.size() && (isUsed[index] || transientResources_[index].offset != offset || transientResources_[index].desc != desc)) {
+			index++;
+		}
+		if (index == transientResources_.size()) {
+			TransientResource& entry = transientResources_.emplace_back();
+			entry.desc = desc;
+			entry.offset = offset;
+			D3D12_RESOURCE_DESC resourceDesc = MakeTransientResourceDesc(desc);
+			result = device_->CreatePlacedResource(transientHeap_.Get(), offset, &resourceDesc, D3D12_RESOURCE_STATES(desc.initialState), nullptr, IID_PPV_ARGS(&entry.resource));
+			assert(SUCCEEDED(result));
+			isUsed.push_back(false);
+		}
+		isUsed[index] = true;
+		graph.SetResource(resource, transientResources_[index].resource.Get());
+	}
+
+	// このフレームで使わなかったリソースは解放する
+	for (size_t index = transientResources_.size(); index-- > 0;) {
+		if (!isUsed[index]) {
+			retiredTransients_.push_back({ fenceValue, std::move(transientResources_[index].resource) });
+			transientResources_.erase(transientResources_.begin() + index);
+		}
+	}
+}
+
+void DirectXBase::ExecuteRenderGraph(RenderGraph& graph, ID3D12GraphicsCommandList* commandList)
+{
+	if (isHeadless_) {
+		for (const RenderGraphStep& step : graph.GetSchedule()) {
+			nullBackend_.RecordBarriers(uint32_t(step.barriers.size()));
+			if (step.pass != RenderGraph::kInvalidPass) {
+				nullBackend_.RecordPass();
+				graph.ExecutePass(step.pass, nullptr);
+			}
+		}
+		return;
+	}
+
+	PlaceTransientResources(graph);
+
+	std::vector<D3D12_RESOURCE_BARRIER> barriers;
+	for (const RenderGraphStep& step : graph.GetSchedule()) {
+		// パスの前のバリアは1回でまとめて張る
+		barriers.clear();
+		for (const RenderGraphBarrier& barrier : step.barriers) {
+			ID3D12Resource* resource = graph.GetResource(barrier.resource);
+			assert(resource);
+			D3D12_RESOURCE_BARRIER& d3dBarrier = barriers.emplace_back();
+			if (barrier.type == BarrierType::Uav) {
+				d3dBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+				d3dBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+				d3dBarrier.UAV.pResource = resource;
+				continue;
+			}
+			if (barrier.type == BarrierType::Aliasing) {
+				// 前に同じメモリを使っていたリソースは前のフレームのものの場合もあるので指定しない
+				d3dBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+				d3dBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+				d3dBarrier.Aliasing.pResourceBefore = nullptr;
+				d3dBarrier.Aliasing.pResourceAfter = resource;
+				continue;
+			}
+			d3dBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+			d3dBarrier.Flags = barrier.split == BarrierSplit::Begin ? D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY :
+				barrier.split == BarrierSplit::End ? D3D12_RESOURCE_BARRIER_FLAG_END_ONLY : D3D12_RESOURCE_BARRIER_FLAG_NONE;
+			d3dBarrier.Transition.pResource = resource;
+			d3dBarrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+			d3dBarrier.Transition.StateBefore = D3D12_RESOURCE_STATES(barrier.before);
+			d3dBarrier.Transition.StateAfter = D3D12_RESOURCE_STATES(barrier.after);
+		}
+		if (!barriers.empty()) {
+			commandList->ResourceBarrier(UINT(barriers.size()), barriers.data());
+		}
+
+		if (step.pass != RenderGraph::kInvalidPass) {
+			graph.ExecutePass(step.pass, commandList);
+		}
+	}
+}
+
+void DirectXBase::SetRenderState(ID3D12GraphicsCommandList* commandList)
+{
+	D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = dsvDescriptorHeap_.GetCPUHandle(0);
+	commandList->OMSetRenderTargets(1, &rtvHandles_[backBufferIndex_], false, &dsvHandle);
+	commandList->RSSetViewports(1, &viewport_);
+	commandList->RSSetScissorRects(1, &scissorRect_);
+	commandList->SetGraphicsRootSignature(rootSignature_.Get());
+	commandList->SetPipelineState(graphicsPipelineState_.Get());
+	commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	if (descriptorHeap_) {
+		commandList->SetDescriptorHeaps(1, &descriptorHeap_);
+	}
+}
+
 ID3D12Device* DirectXBase::GetDevice()
 {
 	return device_.Get();
@@ -525,6 +896,24 @@ ID3D12GraphicsCommandList* DirectXBase::GetCommandList()
 	return commandList_.Get();
 }
 
+RenderBackend& DirectXBase::GetBackend()
+{
+	if (isHeadless_) {
+		return nullBackend_;
+	}
+	return backend_;
+}
+
+const RenderCallCounts& DirectXBase::GetHeadlessCounts()
+{
+	return nullBackend_.GetCounts();
+}
+
+ID3D12CommandQueue* DirectXBase::GetCommandQueue()
+{
+	return commandQueue_.Get();
+}
+
 DXGI_SWAP_CHAIN_DESC1 DirectXBase::GetSwapChainDesc()
 {
 	return swapChainDesc_;
@@ -550,6 +939,72 @@ ID3D12PipelineState* DirectXBase::GetPipelineStateNoCulling()
 	return graphicsPipelineStateNoCulling_.Get();
 }
 
+uint64_t DirectXBase::GetFenceValue()
+{
+	return fenceValue_;
+}
+
+uint64_t DirectXBase::GetCompletedFenceValue()
+{
+	// ヘッドレスの場合は提出したフレームを直ちに終えている
+	if (isHeadless_) {
+		return fenceValue_;
+	}
+	return fence_->GetCompletedValue();
+}
+
+void DirectXBase::SetFramesInFlight(uint32_t framesInFlight)
+{
+	assert(framesInFlight >= 1 && framesInFlight <= kMaxFramesInFlight);
+	assert(!device_);
+	framesInFlight_ = framesInFlight;
+}
+
+void DirectXBase::SetTargetFrameRate(double targetFrameRate)
+{
+	frameLimiter_.SetTargetFrameRate(targetFrameRate);
+}
+
+void DirectXBase::SetVSync(bool isEnabled)
+{
+	isVSyncEnabled_ = isEnabled;
+}
+
+uint32_t DirectXBase::GetFramesInFlight()
+{
+	return framesInFlight_;
+}
+
+uint32_t DirectXBase::GetFrameIndex()
+{
+	return frameRing_.GetFrameIndex();
+}
+
+RenderGraph& DirectXBase::GetFrameGraph()
+{
+	return frameGraph_;
+}
+
+uint32_t DirectXBase::GetBackBufferResource()
+{
+	return backBufferResource_;
+}
+
+uint32_t DirectXBase::GetDepthResource()
+{
+	return depthResource_;
+}
+
+const FrameLimiter& DirectXBase::GetFrameLimiter()
+{
+	return frameLimiter_;
+}
+
+WorkerPool& DirectXBase::GetWorkerPool()
+{
+	return workerPool_;
+}
+
 D3DResourceLeakChecker::~D3DResourceLeakChecker()
 {
 	Microsoft::WRL::ComPtr<IDXGIDebug1> debug;
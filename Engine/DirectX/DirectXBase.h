@@ -3,6 +3,10 @@
 #include <dxgi1_6.h>
 #include <wrl.h>
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
 #include <dxcapi.h>
 #include <dxgidebug.h>
 
@@ -14,6 +18,11 @@
 // MyClass
 #include "MyWindow.h"
 #include "DescriptorHeap.h"
+#include "FrameRing.h"
+#include "FrameLimiter.h"
+#include "RenderGraph.h"
+#include "RenderBackend.h"
+#include "WorkerPool.h"
 
 // リソースリークチェック
 struct D3DResourceLeakChecker {
@@ -28,12 +37,24 @@ public:
 class DirectXBase
 {
 public:
+	// 同時にGPUで実行できるフレームの最大数
+	static const uint32_t kMaxFramesInFlight = 3;
+	// 描画を並列に記録するときのチャンク（コマンドリスト）の最大数
+	static const uint32_t kMaxRecordChunks = 16;
+
 	// デストラクタ
 	~DirectXBase();
 
 	// シングルトンインスタンスの取得
 	static DirectXBase* GetInstance();
 
+	// 同時にGPUで実行できるフレームの数を設定する（1～kMaxFramesInFlight。Initializeの前に呼ぶ）
+	void SetFramesInFlight(uint32_t framesInFlight);
+	// フレームの終わりに待って制限するフレームレート（0以下の場合は垂直同期だけで制限する）
+	void SetTargetFrameRate(double targetFrameRate);
+	// Presentで垂直同期を待つか（falseにするとSetTargetFrameRateだけで制限する）
+	void SetVSync(bool isEnabled);
+
 	// 初期化
 	void Initialize()
 	{
@@ -83,6 +104,10 @@ public:
 		SetScissor();
 	}
 
+	// ウィンドウもGPUも使わずに初期化する（ヘッドレス。描画はNullRenderBackendで数えるだけになり、提出したフレームはGPUが直ちに終えたものとして扱う）
+	void InitializeHeadless();
+	bool IsHeadless();
+
 	// DXGIデバイス初期化
 	void InitializeDXGIDevice(bool enableDebugLayer = true);
 	// コマンド関連初期化
@@ -114,16 +139,38 @@ public:
 	// 深度バッファ生成
 	void CreateDepthBuffer();
 
-	// フレーム開始処理
+	// フレーム開始処理（フレームのRenderGraphを組み直し、画面をクリアするパスを追加する）
 	void BeginFrame();
-	// フレーム終了処理
+	// フレーム終了処理（次のフレームのコマンドアロケータを前回使ったフレームだけを待つ）
 	void EndFrame();
+	// 提出したコマンドを全てGPUが終えるまで待つ（終了時や、GPUが使っているかもしれないものを作り直すときに呼ぶ）
+	void WaitForGpu();
 
 	// 描画前処理
 	void PreDraw();
-	// 描画後処理
+	// 描画後処理（フレームのRenderGraphをコンパイルして記録し、提出する）
 	void PostDraw();
 
+	// このフレームのRenderGraph（BeginFrameの後にパスを追加し、PostDrawで記録される。ヘッドレスの場合、パスにはnullptrが渡される）
+	RenderGraph& GetFrameGraph();
+	// フレームのRenderGraphでのバックバッファと深度バッファ
+	uint32_t GetBackBufferResource();
+	uint32_t GetDepthResource();
+	// RenderGraphに一時的なTexture（2Dでミップは1つ）を登録する（ヒープ上の大きさはデバイスに問い合わせる）
+	uint32_t CreateTransientTexture(RenderGraph& graph, const std::string& name, uint32_t width, uint32_t height, DXGI_FORMAT format, ResourceState initialState = ResourceState::RenderTarget);
+	// RenderGraphの一時的なリソースをヒープに置き、コンパイルした結果の順にバリアとパスをコマンドリストに記録する
+	// （ヘッドレスの場合はバリアを数えるだけで、パスにはnullptrを渡す）
+	void ExecuteRenderGraph(RenderGraph& graph, ID3D12GraphicsCommandList* commandList);
+
+	// 描画に使うDescriptorHeapを設定する（並列に記録するコマンドリストにも設定される）
+	void SetDescriptorHeap(ID3D12DescriptorHeap* descriptorHeap);
+	// drawCount個の描画をチャンクに分けて複数のスレッドでチャンクごとのコマンドリストに記録し、
+	// ここまでのコマンドリストに続けてチャンクの順に1回のExecuteCommandListsで提出する（提出後もGetCommandListに続けて記録できる）
+	// 描画先とPSOなどの描画の状態は設定済みで、setupChunkでチャンクごとにライトやカメラなどの共通の定数を設定する（続きを記録するGetBackendにも設定される）
+	// recordDrawはチャンクの記録先と描画の番号を受け取る（threadCountが0の場合はハードウェアのスレッド数）
+	void RecordDrawsInParallel(size_t drawCount, const std::function<void(RenderBackend&)>& setupChunk,
+		const std::function<void(RenderBackend&, size_t drawIndex)>& recordDraw, uint32_t threadCount = 0);
+
 	///
 	/// アクセッサ
 	/// 
@@ -132,27 +179,86 @@ public:
 	ID3D12Device* GetDevice();
 	// コマンドリストの取得
 	ID3D12GraphicsCommandList* GetCommandList();
+	// このフレームの描画の記録先（コマンドリストに記録する。ヘッドレスの場合は呼び出しを数える）
+	RenderBackend& GetBackend();
+	// ヘッドレスで数えた呼び出しの回数（これまでの全てのフレームの合計）
+	const RenderCallCounts& GetHeadlessCounts();
+	// コマンドキューの取得
+	ID3D12CommandQueue* GetCommandQueue();
 
 	DXGI_SWAP_CHAIN_DESC1 GetSwapChainDesc();
 	D3D12_RENDER_TARGET_VIEW_DESC GetRtvDesc();
 	ID3D12PipelineState* GetPipelineState();
 	ID3D12PipelineState* GetPipelineStateOutline();
 	ID3D12PipelineState* GetPipelineStateNoCulling();
+	// 最後にSignalしたFenceの値
+	uint64_t GetFenceValue();
+	// GPUが到達済みのFenceの値
+	uint64_t GetCompletedFenceValue();
+	// 同時にGPUで実行できるフレームの数と、今のフレームが使う領域の番号（0～フレームの数-1）
+	uint32_t GetFramesInFlight();
+	uint32_t GetFrameIndex();
+	// フレームの間隔の計測結果
+	const FrameLimiter& GetFrameLimiter();
+	// 毎フレームの並列処理に使うスレッド（RecordDrawsInParallelもこれを使う。読み込み時の処理はParallelForを使う）
+	WorkerPool& GetWorkerPool();
 
 private:
+	// Fenceの値にGPUが到達するまで待つ
+	void WaitForFenceValue(uint64_t fenceValue);
+	// 描画先と描画の状態、DescriptorHeapをコマンドリストに設定する
+	void SetRenderState(ID3D12GraphicsCommandList* commandList);
+	// コンパイルしたRenderGraphの一時的なリソースを、決めた位置に置いて渡す
+	void PlaceTransientResources(RenderGraph& graph);
+
 	Microsoft::WRL::ComPtr<IDXGIFactory7> dxgiFactory_;
 	Microsoft::WRL::ComPtr<IDXGIAdapter4> useAdapter_;
 	Microsoft::WRL::ComPtr<ID3D12Device> device_;
 	Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue_;
-	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> commandAllocator_;
+	// フレームごとのコマンドアロケータ（GPUが前回のフレームを終えてからリセットする）
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> commandAllocators_[kMaxFramesInFlight];
+	uint32_t framesInFlight_ = 2;
+	FrameRing frameRing_;
+	FrameLimiter frameLimiter_{ 0.0 };
+	bool isVSyncEnabled_ = true;
 	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList_;
+	// commandList_に記録する記録先と、ヘッドレスの場合の記録先
+	D3D12RenderBackend backend_;
+	NullRenderBackend nullBackend_;
+	bool isHeadless_ = false;
+	// 並列に記録するチャンクごとのコマンドアロケータ（フレームごと）とコマンドリスト（初めて使うときに作る）
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> chunkCommandAllocators_[kMaxFramesInFlight][kMaxRecordChunks];
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> chunkCommandLists_[kMaxRecordChunks];
+	// 毎フレームの並列処理で使い回すスレッド
+	WorkerPool workerPool_;
+	// 今のフレームで描画するバックバッファと、描画に使うDescriptorHeap
+	UINT backBufferIndex_ = 0;
+	ID3D12DescriptorHeap* descriptorHeap_ = nullptr;
 	Microsoft::WRL::ComPtr<IDXGISwapChain4> swapChain_;
 	DXGI_SWAP_CHAIN_DESC1 swapChainDesc_;
 	DescriptorHeap rtvDescriptorHeap_;
 	Microsoft::WRL::ComPtr<ID3D12Resource> swapChainResources_[2];
 	D3D12_RENDER_TARGET_VIEW_DESC rtvDesc_;
 	D3D12_CPU_DESCRIPTOR_HANDLE rtvHandles_[2];
-	D3D12_RESOURCE_BARRIER barrier_;
+	// フレームのパスと、その中のバックバッファと深度バッファ
+	RenderGraph frameGraph_;
+	uint32_t backBufferResource_ = 0;
+	uint32_t depthResource_ = 0;
+	// RenderGraphの一時的なリソースを置くヒープ（足りなくなったら作り直す）と、置いたリソース（同じ位置に同じものを置く場合は次のフレームでも使う）
+	struct TransientResource {
+		TransientResourceDesc desc;
+		uint64_t offset;
+		Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+	};
+	Microsoft::WRL::ComPtr<ID3D12Heap> transientHeap_;
+	uint64_t transientHeapSize_ = 0;
+	std::vector<TransientResource> transientResources_;
+	// GPUが使い終わるまで保持しておくヒープとリソース
+	struct RetiredTransient {
+		uint64_t fenceValue;
+		Microsoft::WRL::ComPtr<ID3D12Pageable> object;
+	};
+	std::deque<RetiredTransient> retiredTransients_;
 	Microsoft::WRL::ComPtr<ID3D12Fence> fence_;
 	uint64_t fenceValue_;
 	HANDLE fenceEvent_;
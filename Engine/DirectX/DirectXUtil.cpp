@@ -1,5 +1,50 @@
 #include "DirectXUtil.h"
+#include "BufferHeapAllocator.h"
 #include <assert.h>
+#include <atomic>
+#include <cstring>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define DIRECTX_UTIL_USE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace {
+    // リソースに記録のIDと、破棄を検知するオブジェクトを持たせるためのGUID
+    const GUID kAllocationIdGuid = { 0x2ee4efa3, 0xb120, 0x44e5, { 0x96, 0x1f, 0xae, 0xd7, 0xf1, 0xf2, 0x44, 0xd2 } };
+    const GUID kAllocationTrackerGuid = { 0xaed586fa, 0x2557, 0x4088, { 0x81, 0x6e, 0x6c, 0x46, 0x3e, 0x0b, 0x7e, 0xad } };
+
+    // リソースのプライベートデータとして持たせ、リソースが破棄されて解放されたときに記録を消す
+    class AllocationTracker : public IUnknown
+    {
+    public:
+        explicit AllocationTracker(uint64_t allocationId) : allocationId_(allocationId) {}
+
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override
+        {
+            if (riid == __uuidof(IUnknown)) {
+                *object = static_cast<IUnknown*>(this);
+                AddRef();
+                return S_OK;
+            }
+            *object = nullptr;
+            return E_NOINTERFACE;
+        }
+        ULONG STDMETHODCALLTYPE AddRef() override { return ++refCount_; }
+        ULONG STDMETHODCALLTYPE Release() override
+        {
+            ULONG refCount = --refCount_;
+            if (refCount == 0) {
+                ResourceBudget::GetInstance().Unregister(allocationId_);
+                delete this;
+            }
+            return refCount;
+        }
+
+    private:
+        std::atomic<ULONG> refCount_ = 1;
+        uint64_t allocationId_;
+    };
+}
 
 IDxcBlob* CompileShader(const std::wstring& filePath, const wchar_t* profile, IDxcUtils* dxcUtils, IDxcCompiler3* dxcCompiler, IDxcIncludeHandler* includeHandler)
 {
@@ -63,7 +108,7 @@ IDxcBlob* CompileShader(const std::wstring& filePath, const wchar_t* profile, ID
     return shaderBlob;
 }
 
-Microsoft::WRL::ComPtr<ID3D12Resource> CreateBufferResource(ID3D12Device* device, size_t sizeInBytes)
+Microsoft::WRL::ComPtr<ID3D12Resource> CreateBufferResource(ID3D12Device* device, size_t sizeInBytes, ResourceCategory category)
 {
     // 頂点リソース用のヒープの設定
     D3D12_HEAP_PROPERTIES uploadHeapProperties{};
@@ -80,12 +125,18 @@ Microsoft::WRL::ComPtr<ID3D12Resource> CreateBufferResource(ID3D12Device* device
     vertexResourcesDesc.SampleDesc.Count = 1;
     // バッファの場合はこれにする決まり
     vertexResourcesDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-    // 実際に頂点リソースを作る
-    Microsoft::WRL::ComPtr < ID3D12Resource> vertexResource = nullptr;
+    // 大きなヒープの中に置けるものはそこに作る
+    Microsoft::WRL::ComPtr < ID3D12Resource> vertexResource = BufferHeapAllocator::CreateBuffer(vertexResourcesDesc);
+    if (vertexResource) {
+        TrackResource(device, vertexResource.Get(), category);
+        return vertexResource;
+    }
+    // 実際に頂点リソースを作る（ヒープより大きい場合と初期化前は単独のリソースにする）
     HRESULT hr = device->CreateCommittedResource(&uploadHeapProperties, D3D12_HEAP_FLAG_NONE,
         &vertexResourcesDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
         IID_PPV_ARGS(&vertexResource));
     assert(SUCCEEDED(hr));
+    TrackResource(device, vertexResource.Get(), category);
 
     return std::move(vertexResource); // デストラクタを呼ばないように返す
 }
@@ -120,6 +171,53 @@ Microsoft::WRL::ComPtr <ID3D12Resource> CreateDepthStencilTextureResource(ID3D12
         &depthClearValue, // Clear最適値
         IID_PPV_ARGS(&resource)); // 作成するResourceポインタへのポインタ
     assert(SUCCEEDED(hr));
+    TrackResource(device, resource.Get(), ResourceCategory::RenderTarget);
 
     return std::move(resource);
-}
\ No newline at end of file
+}
+
+uint64_t TrackResource(ID3D12Device* device, ID3D12Resource* resource, ResourceCategory category)
+{
+    // 実際に確保されるサイズ（アラインメントを含む）を記録する
+    D3D12_RESOURCE_DESC resourceDesc = resource->GetDesc();
+    D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = device->GetResourceAllocationInfo(0, 1, &resourceDesc);
+    uint64_t allocationId = ResourceBudget::GetInstance().Register(category, allocationInfo.SizeInBytes);
+
+    // リソースが破棄されるとプライベートデータのAllocationTrackerも解放され、記録が消える
+    resource->SetPrivateData(kAllocationIdGuid, sizeof(allocationId), &allocationId);
+    AllocationTracker* tracker = new AllocationTracker(allocationId);
+    HRESULT hr = resource->SetPrivateDataInterface(kAllocationTrackerGuid, tracker);
+    assert(SUCCEEDED(hr));
+    tracker->Release();
+
+    return allocationId;
+}
+
+uint64_t GetTrackedAllocationId(ID3D12Resource* resource)
+{
+    uint64_t allocationId = ResourceBudget::kInvalidId;
+    UINT size = sizeof(allocationId);
+    if (FAILED(resource->GetPrivateData(kAllocationIdGuid, &size, &allocationId))) {
+        return ResourceBudget::kInvalidId;
+    }
+    return allocationId;
+}
+
+void WriteToUploadHeap(void* destination, const void* source, size_t size)
+{
+    uint8_t* destinationBytes = static_cast<uint8_t*>(destination);
+    const uint8_t* sourceBytes = static_cast<const uint8_t*>(source);
+    size_t offset = 0;
+#ifdef DIRECTX_UTIL_USE_SSE
+    // 書き込み先が16バイトに揃っていれば、キャッシュを汚さずに書き込む
+    if (reinterpret_cast<uintptr_t>(destinationBytes) % 16 == 0) {
+        for (; offset + 16 <= size; offset += 16) {
+            __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sourceBytes + offset));
+            _mm_stream_si128(reinterpret_cast<__m128i*>(destinationBytes + offset), value);
+        }
+        _mm_sfence();
+    }
+#endif
+    // 残りはそのままコピーする
+    std::memcpy(destinationBytes + offset, sourceBytes + offset, size - offset);
+}
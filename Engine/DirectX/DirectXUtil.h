@@ -11,6 +11,7 @@
 // MyClass
 #include "StringUtil.h"
 #include "Logger.h"
+#include "ResourceBudget.h"
 
 // シェーダーのコンパイルを行う
 IDxcBlob* CompileShader(
@@ -23,8 +24,16 @@ IDxcBlob* CompileShader(
 	IDxcCompiler3* dxcCompiler,
 	IDxcIncludeHandler* includeHandler);
 
-// リソースの作成を行う
-Microsoft::WRL::ComPtr<ID3D12Resource> CreateBufferResource(ID3D12Device* device, size_t sizeInBytes);
+// リソースの作成を行う（確保したサイズをcategoryとしてResourceBudgetに記録する。BufferHeapAllocatorが初期化されていればその大きなヒープの中に置く）
+Microsoft::WRL::ComPtr<ID3D12Resource> CreateBufferResource(ID3D12Device* device, size_t sizeInBytes, ResourceCategory category = ResourceCategory::Other);
+
+// リソースのサイズをResourceBudgetに記録し、リソースが破棄されたときに記録が消えるようにする（記録のIDを返す）
+uint64_t TrackResource(ID3D12Device* device, ID3D12Resource* resource, ResourceCategory category);
+// TrackResourceで記録したリソースのID（記録していなければResourceBudget::kInvalidId）
+uint64_t GetTrackedAllocationId(ID3D12Resource* resource);
 
 // DepthStencilTextureを作る
-Microsoft::WRL::ComPtr <ID3D12Resource> CreateDepthStencilTextureResource(ID3D12Device* device, int32_t width, int32_t height);
\ No newline at end of file
+Microsoft::WRL::ComPtr <ID3D12Resource> CreateDepthStencilTextureResource(ID3D12Device* device, int32_t width, int32_t height);
+
+// アップロード用のヒープ（ライトコンバインのメモリ）に書き込む（読み出さず、16バイトずつキャッシュを通さずに書き込む）
+void WriteToUploadHeap(void* destination, const void* source, size_t size);
\ No newline at end of file
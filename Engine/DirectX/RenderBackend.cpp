@@ -0,0 +1,89 @@
+#include "RenderBackend.h"
+
+ConstantBufferAllocator::Allocation RenderBackend::AllocateConstants(size_t size)
+{
+	if (isChunk_) {
+		return constantBlock_.Allocate(size);
+	}
+	return ConstantBufferAllocator::Allocate(size);
+}
+
+void RenderBackend::ReportTextureUsage(uint32_t textureHandle, const Float3& center, float radius)
+{
+	if (isChunk_) {
+		textureUsages_.push_back({ textureHandle, center, radius });
+		return;
+	}
+	TextureManager::ReportUsage(textureHandle, center, radius);
+}
+
+void RenderBackend::BeginChunk()
+{
+	// 前のフレームのブロックは再利用されているかもしれないので、新しいブロックから確保する
+	isChunk_ = true;
+	constantBlock_.Reset();
+	textureUsages_.clear();
+}
+
+void RenderBackend::SubmitChunk()
+{
+	TextureManager::ReportUsages(textureUsages_);
+	textureUsages_.clear();
+	constantBlock_.Reset();
+	isChunk_ = false;
+}
+
+void D3D12RenderBackend::SetVertexBuffer(const D3D12_VERTEX_BUFFER_VIEW& view)
+{
+	commandList_->IASetVertexBuffers(0, 1, &view);
+}
+
+void D3D12RenderBackend::SetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW& view)
+{
+	commandList_->IASetIndexBuffer(&view);
+}
+
+void D3D12RenderBackend::SetConstantBuffer(uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+	commandList_->SetGraphicsRootConstantBufferView(rootParameterIndex, address);
+}
+
+void D3D12RenderBackend::SetTexture(uint32_t rootParameterIndex, uint32_t textureHandle)
+{
+	TextureManager::SetDescriptorTable(rootParameterIndex, commandList_, textureHandle);
+}
+
+void D3D12RenderBackend::Draw(uint32_t vertexCount)
+{
+	commandList_->DrawInstanced(vertexCount, 1, 0, 0);
+}
+
+void D3D12RenderBackend::DrawIndexed(uint32_t indexCount)
+{
+	commandList_->DrawIndexedInstanced(indexCount, 1, 0, 0, 0);
+}
+
+RenderCallCounts& RenderCallCounts::operator+=(const RenderCallCounts& other)
+{
+	vertexBuffers += other.vertexBuffers;
+	indexBuffers += other.indexBuffers;
+	constantBuffers += other.constantBuffers;
+	textures += other.textures;
+	draws += other.draws;
+	vertices += other.vertices;
+	passes += other.passes;
+	barriers += other.barriers;
+	return *this;
+}
+
+void NullRenderBackend::Draw(uint32_t vertexCount)
+{
+	counts_.draws++;
+	counts_.vertices += vertexCount;
+}
+
+void NullRenderBackend::DrawIndexed(uint32_t indexCount)
+{
+	counts_.draws++;
+	counts_.vertices += indexCount;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <d3d12.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// MyClass
+#include "ConstantBufferAllocator.h"
+#include "TextureManager.h"
+
+// 描画コマンドの記録先（Object3DやCameraはコマンドリストに直接ではなく、これを通して描画を記録する）
+// D3D12RenderBackendはコマンドリストに記録し、NullRenderBackendはウィンドウもGPUも使わずに呼び出しを数えるだけにする
+class RenderBackend
+{
+public:
+	virtual ~RenderBackend() = default;
+
+	virtual void SetVertexBuffer(const D3D12_VERTEX_BUFFER_VIEW& view) = 0;
+	virtual void SetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW& view) = 0;
+	// ルートパラメータに定数バッファのGPU上のアドレスを設定する
+	virtual void SetConstantBuffer(uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS address) = 0;
+	// ルートパラメータにTextureのSRVのDescriptorTableを設定する
+	virtual void SetTexture(uint32_t rootParameterIndex, uint32_t textureHandle) = 0;
+	// 1つのインスタンスを描画する
+	virtual void Draw(uint32_t vertexCount) = 0;
+	virtual void DrawIndexed(uint32_t indexCount) = 0;
+
+	// 記録先のコマンドリスト（Nullの場合はnullptr）
+	virtual ID3D12GraphicsCommandList* GetCommandList() = 0;
+
+	// 描画ごとの定数データを書き込んで、そのGPU上のアドレスを返す
+	template<class Type>
+	D3D12_GPU_VIRTUAL_ADDRESS UploadConstants(const Type& data)
+	{
+		ConstantBufferAllocator::Allocation allocation = AllocateConstants(sizeof(Type));
+		std::memcpy(allocation.cpuAddress, &data, sizeof(Type));
+		return allocation.gpuAddress;
+	}
+	ConstantBufferAllocator::Allocation AllocateConstants(size_t size);
+	// 画面上の大きさからミップを決めるため、描画に使ったTextureを報告する
+	void ReportTextureUsage(uint32_t textureHandle, const Float3& center, float radius);
+
+	// 並列に記録するチャンクの記録先として使い始める（1つのスレッドだけが記録するので、定数データはチャンクのブロックから確保し、
+	// Textureの報告はチャンクにまとめておく。描画ごとにConstantBufferAllocatorとTextureManagerのロックを取らない）
+	void BeginChunk();
+	// まとめておいたTextureの報告を渡し、通常の記録先に戻す（全てのチャンクを記録し終えた後に、チャンクの順に呼ぶ）
+	void SubmitChunk();
+
+private:
+	bool isChunk_ = false;
+	ConstantBufferBlock constantBlock_;
+	std::vector<TextureUsageReport> textureUsages_;
+};
+
+// コマンドリストに記録する
+class D3D12RenderBackend final : public RenderBackend
+{
+public:
+	explicit D3D12RenderBackend(ID3D12GraphicsCommandList* commandList = nullptr) : commandList_(commandList) {}
+
+	void SetCommandList(ID3D12GraphicsCommandList* commandList) { commandList_ = commandList; }
+
+	void SetVertexBuffer(const D3D12_VERTEX_BUFFER_VIEW& view) override;
+	void SetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW& view) override;
+	void SetConstantBuffer(uint32_t rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS address) override;
+	void SetTexture(uint32_t rootParameterIndex, uint32_t textureHandle) override;
+	void Draw(uint32_t vertexCount) override;
+	void DrawIndexed(uint32_t indexCount) override;
+	ID3D12GraphicsCommandList* GetCommandList() override { return commandList_; }
+
+private:
+	ID3D12GraphicsCommandList* commandList_;
+};
+
+// NullRenderBackendが数えた呼び出しの回数
+struct RenderCallCounts {
+	uint64_t vertexBuffers = 0;
+	uint64_t indexBuffers = 0;
+	uint64_t constantBuffers = 0;
+	uint64_t textures = 0;
+	uint64_t draws = 0;
+	// 描画した頂点（インデックス描画の場合はインデックス）の数
+	uint64_t vertices = 0;
+	// RenderGraphで実行したパスと張ったバリアの数
+	uint64_t passes = 0;
+	uint64_t barriers = 0;
+
+	RenderCallCounts& operator+=(const RenderCallCounts& other);
+};
+
+// GPUを使わずに呼び出しを数えるだけの記録先（ヘッドレスでCPUの処理時間を計測する）
+// 1つのインスタンスは1つのスレッドから使い、並列に記録する場合はチャンクごとのインスタンスを後で足し合わせる
+class NullRenderBackend final : public RenderBackend
+{
+public:
+	void SetVertexBuffer(const D3D12_VERTEX_BUFFER_VIEW&) override { counts_.vertexBuffers++; }
+	void SetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW&) override { counts_.indexBuffers++; }
+	void SetConstantBuffer(uint32_t, D3D12_GPU_VIRTUAL_ADDRESS) override { counts_.constantBuffers++; }
+	void SetTexture(uint32_t, uint32_t) override { counts_.textures++; }
+	void Draw(uint32_t vertexCount) override;
+	void DrawIndexed(uint32_t indexCount) override;
+	ID3D12GraphicsCommandList* GetCommandList() override { return nullptr; }
+
+	// RenderGraphのバリアを張ったこととパスを実行したことを記録する
+	void RecordBarriers(uint32_t barrierCount) { counts_.barriers += barrierCount; }
+	void RecordPass() { counts_.passes++; }
+	// ほかの記録先が数えた回数を足す
+	void Merge(const NullRenderBackend& other) { counts_ += other.counts_; }
+
+	const RenderCallCounts& GetCounts() const { return counts_; }
+	void Reset() { counts_ = RenderCallCounts(); }
+
+private:
+	RenderCallCounts counts_;
+};
@@ -0,0 +1,346 @@
+#include "RenderGraph.h"
+#include <cassert>
+#include <utility>
+
+namespace {
+	// 組み合わせられる読み取りの状態
+	const ResourceState kReadOnlyStates = ResourceState::DepthRead | ResourceState::NonPixelShaderResource | ResourceState::PixelShaderResource | ResourceState::CopySource;
+}
+
+void RenderGraph::Reset()
+{
+	resources_.clear();
+	passes_.clear();
+	schedule_.clear();
+	aliasingPlan_ = AliasingPlan();
+}
+
+uint32_t RenderGraph::ImportResource(const std::string& name, ID3D12Resource* resource, ResourceState initialState, ResourceState finalState, bool isOutput)
+{
+	Resource& entry = resources_.emplace_back();
+	entry.name = name;
+	entry.resource = resource;
+	entry.initialState = initialState;
+	entry.finalState = finalState;
+	entry.isOutput = isOutput;
+	return uint32_t(resources_.size() - 1);
+}
+
+uint32_t RenderGraph::CreateTransientResource(const std::string& name, const TransientResourceDesc& desc)
+{
+	assert(desc.size > 0 && desc.alignment > 0);
+	// 作った時の状態から始まり、使い終わったらその状態に戻す（出力ではないので、読むパスが無ければ書き込むパスは省く）
+	uint32_t resource = ImportResource(name, nullptr, desc.initialState, desc.initialState, false);
+	resources_[resource].isTransient = true;
+	resources_[resource].transientDesc = desc;
+	return resource;
+}
+
+uint32_t RenderGraph::AddPass(const std::string& name, std::function<void(ID3D12GraphicsCommandList*)> execute, bool hasSideEffect)
+{
+	Pass& pass = passes_.emplace_back();
+	pass.name = name;
+	pass.execute = std::move(execute);
+	pass.hasSideEffect = hasSideEffect;
+	return uint32_t(passes_.size() - 1);
+}
+
+void RenderGraph::Read(uint32_t pass, uint32_t resource, ResourceState state)
+{
+	AddUsage(pass, resource, state, false);
+}
+
+void RenderGraph::Write(uint32_t pass, uint32_t resource, ResourceState state)
+{
+	AddUsage(pass, resource, state, true);
+}
+
+void RenderGraph::AddUsage(uint32_t pass, uint32_t resource, ResourceState state, bool isWrite)
+{
+	assert(pass < passes_.size() && resource < resources_.size());
+	for (Usage& usage : passes_[pass].usages) {
+		if (usage.resource != resource) {
+			continue;
+		}
+		// 書き込む場合は1つの状態でしか使えない（読み取りだけなら組み合わせる）
+		assert(usage.state == state || (!usage.isWrite && !isWrite && IsReadOnlyState(usage.state) && IsReadOnlyState(state)));
+		usage.state = usage.state | state;
+		usage.isRead = usage.isRead || !isWrite;
+		usage.isWrite = usage.isWrite || isWrite;
+		return;
+	}
+	passes_[pass].usages.push_back({ resource, state, !isWrite, isWrite });
+}
+
+void RenderGraph::Compile(const RenderGraphCompileOptions& options)
+{
+	schedule_.clear();
+	for (Pass& pass : passes_) {
+		pass.isCulled = false;
+	}
+	if (options.cullPasses) {
+		CullPasses();
+	}
+
+	// 省かなかったパスを追加した順に実行し、最後にリソースを戻す手順を置く
+	for (uint32_t pass = 0; pass < passes_.size(); ++pass) {
+		if (!passes_[pass].isCulled) {
+			schedule_.push_back({ pass, {} });
+		}
+	}
+	size_t passStepCount = schedule_.size();
+	schedule_.push_back({ kInvalidPass, {} });
+
+	// 一時的なリソースを使う期間（-1は使わない）を求めてヒープ上の位置を決める
+	std::vector<int64_t> firstSteps;
+	std::vector<int64_t> transientLastSteps;
+	PlaceTransients(passStepCount, options.aliasTransients, firstSteps, transientLastSteps);
+
+	// リソースごとの今の状態と、最後に使った手順（-1はまだ使っていない）
+	// 一時的なリソースは使い始めるまでメモリをほかのリソースが使っているので、使う直前の手順で遷移させる
+	std::vector<ResourceState> states(resources_.size());
+	std::vector<int64_t> lastSteps(resources_.size(), -1);
+	std::vector<bool> lastUavWrites(resources_.size(), false);
+	for (uint32_t resource = 0; resource < resources_.size(); ++resource) {
+		states[resource] = resources_[resource].initialState;
+		if (firstSteps[resource] >= 0) {
+			lastSteps[resource] = firstSteps[resource] - 1;
+		}
+	}
+
+	for (size_t step = 0; step < passStepCount; ++step) {
+		// 使い終わった一時的なリソースは、メモリをほかのリソースに渡す前に作った時の状態に戻す
+		for (uint32_t resource = 0; resource < resources_.size(); ++resource) {
+			if (transientLastSteps[resource] == int64_t(step) - 1 && states[resource] != resources_[resource].finalState) {
+				AddTransition(resource, states[resource], resources_[resource].finalState, lastSteps[resource], step, false);
+				states[resource] = resources_[resource].finalState;
+			}
+		}
+		// 使い始める一時的なリソースにメモリを切り替える（前のフレームでほかのリソースが使っていた場合もあるので必ず張る）
+		for (uint32_t resource = 0; resource < resources_.size(); ++resource) {
+			if (firstSteps[resource] == int64_t(step)) {
+				schedule_[step].barriers.push_back({ BarrierType::Aliasing, resource, states[resource], states[resource], BarrierSplit::None });
+			}
+		}
+
+		for (const Usage& usage : passes_[schedule_[step].pass].usages) {
+			uint32_t resource = usage.resource;
+			ResourceState current = states[resource];
+			ResourceState target = usage.state;
+
+			if (!usage.isWrite && IsReadOnlyState(target)) {
+				// 既に読める状態であれば遷移しない
+				if (IsReadOnlyState(current) && (current & target) == target) {
+					lastSteps[resource] = int64_t(step);
+					continue;
+				}
+				// 書き込まれるまでの間に読むだけのパスがあれば、その状態もまとめて遷移する
+				if (options.mergeReadStates) {
+					for (size_t next = step + 1; next < passStepCount; ++next) {
+						bool isWritten = false;
+						for (const Usage& nextUsage : passes_[schedule_[next].pass].usages) {
+							if (nextUsage.resource != resource) {
+								continue;
+							}
+							if (nextUsage.isWrite || !IsReadOnlyState(nextUsage.state)) {
+								isWritten = true;
+							} else {
+								target = target | nextUsage.state;
+							}
+						}
+						if (isWritten) {
+							break;
+						}
+					}
+				}
+			}
+
+			if (target != current) {
+				AddTransition(resource, current, target, lastSteps[resource], step, options.splitBarriers);
+				states[resource] = target;
+			} else if (target == ResourceState::UnorderedAccess && lastSteps[resource] >= 0 && (usage.isWrite || lastUavWrites[resource])) {
+				// UAVのまま続けて使う場合は、前のパスの書き込みを待つ
+				schedule_[step].barriers.push_back({ BarrierType::Uav, resource, target, target, BarrierSplit::None });
+			}
+			lastUavWrites[resource] = usage.isWrite && target == ResourceState::UnorderedAccess;
+			lastSteps[resource] = int64_t(step);
+		}
+	}
+
+	// フレームの後の状態に戻す
+	for (uint32_t resource = 0; resource < resources_.size(); ++resource) {
+		if (states[resource] != resources_[resource].finalState) {
+			AddTransition(resource, states[resource], resources_[resource].finalState, lastSteps[resource], passStepCount, options.splitBarriers);
+		}
+	}
+}
+
+void RenderGraph::CullPasses()
+{
+	// 後ろのパスから、出力か後のパスが読むリソースに書き込むパスだけを残す
+	std::vector<bool> isNeeded(resources_.size());
+	for (uint32_t resource = 0; resource < resources_.size(); ++resource) {
+		isNeeded[resource] = resources_[resource].isOutput;
+	}
+	for (size_t i = passes_.size(); i-- > 0;) {
+		Pass& pass = passes_[i];
+		bool isPassNeeded = pass.hasSideEffect;
+		for (const Usage& usage : pass.usages) {
+			isPassNeeded = isPassNeeded || (usage.isWrite && isNeeded[usage.resource]);
+		}
+		pass.isCulled = !isPassNeeded;
+		if (pass.isCulled) {
+			continue;
+		}
+
+		// 読まずに書き込むリソースは、それより前の内容が要らなくなる
+		for (const Usage& usage : pass.usages) {
+			if (usage.isWrite && !usage.isRead) {
+				isNeeded[usage.resource] = false;
+			}
+		}
+		for (const Usage& usage : pass.usages) {
+			if (usage.isRead) {
+				isNeeded[usage.resource] = true;
+			}
+		}
+	}
+}
+
+void RenderGraph::PlaceTransients(size_t passStepCount, bool aliasTransients, std::vector<int64_t>& firstSteps, std::vector<int64_t>& lastSteps)
+{
+	firstSteps.assign(resources_.size(), -1);
+	lastSteps.assign(resources_.size(), -1);
+	for (size_t step = 0; step < passStepCount; ++step) {
+		for (const Usage& usage : passes_[schedule_[step].pass].usages) {
+			if (!resources_[usage.resource].isTransient) {
+				continue;
+			}
+			if (firstSteps[usage.resource] < 0) {
+				firstSteps[usage.resource] = int64_t(step);
+			}
+			lastSteps[usage.resource] = int64_t(step);
+		}
+	}
+
+	// 使う一時的なリソースだけをヒープに置く（共有させない場合は、全てのリソースをフレーム全体で使うものとして置く）
+	std::vector<AliasingRequest> requests;
+	for (uint32_t resource = 0; resource < resources_.size(); ++resource) {
+		Resource& entry = resources_[resource];
+		entry.aliasingRequest = kInvalidPass;
+		if (firstSteps[resource] < 0) {
+			continue;
+		}
+		entry.aliasingRequest = uint32_t(requests.size());
+		AliasingRequest& request = requests.emplace_back();
+		request.size = entry.transientDesc.size;
+		request.alignment = entry.transientDesc.alignment;
+		request.firstPass = aliasTransients ? uint32_t(firstSteps[resource]) : 0;
+		request.lastPass = aliasTransients ? uint32_t(lastSteps[resource]) : uint32_t(passStepCount);
+	}
+	aliasingPlan_ = PlanAliasing(requests);
+}
+
+void RenderGraph::AddTransition(uint32_t resource, ResourceState before, ResourceState after, int64_t lastStep, size_t step, bool splitBarriers)
+{
+	// 最後に使ったパスの直後から使うパスの直前までの間に遷移させる
+	size_t beginStep = size_t(lastStep + 1);
+	if (splitBarriers && beginStep < step) {
+		schedule_[beginStep].barriers.push_back({ BarrierType::Transition, resource, before, after, BarrierSplit::Begin });
+		schedule_[step].barriers.push_back({ BarrierType::Transition, resource, before, after, BarrierSplit::End });
+	} else {
+		schedule_[step].barriers.push_back({ BarrierType::Transition, resource, before, after, BarrierSplit::None });
+	}
+}
+
+uint32_t RenderGraph::GetBarrierCount() const
+{
+	uint32_t count = 0;
+	for (const RenderGraphStep& step : schedule_) {
+		count += uint32_t(step.barriers.size());
+	}
+	return count;
+}
+
+uint32_t RenderGraph::GetBatchCount() const
+{
+	uint32_t count = 0;
+	for (const RenderGraphStep& step : schedule_) {
+		count += step.barriers.empty() ? 0 : 1;
+	}
+	return count;
+}
+
+std::string RenderGraph::DumpSchedule() const
+{
+	std::string text;
+	for (const RenderGraphStep& step : schedule_) {
+		text += step.pass == kInvalidPass ? "(end)" : passes_[step.pass].name;
+		text += " :";
+		for (const RenderGraphBarrier& barrier : step.barriers) {
+			text += " " + resources_[barrier.resource].name;
+			if (barrier.type == BarrierType::Uav) {
+				text += "(UAV)";
+				continue;
+			}
+			if (barrier.type == BarrierType::Aliasing) {
+				text += "(alias)";
+				continue;
+			}
+			text += "(" + GetStateName(barrier.before) + "->" + GetStateName(barrier.after) + ")";
+			if (barrier.split == BarrierSplit::Begin) {
+				text += "[begin]";
+			} else if (barrier.split == BarrierSplit::End) {
+				text += "[end]";
+			}
+		}
+		text += "\n";
+	}
+
+	std::string culled;
+	for (const Pass& pass : passes_) {
+		if (pass.isCulled) {
+			culled += " " + pass.name;
+		}
+	}
+	if (!culled.empty()) {
+		text += "(culled) :" + culled + "\n";
+	}
+	return text;
+}
+
+void RenderGraph::ExecutePass(uint32_t pass, ID3D12GraphicsCommandList* commandList) const
+{
+	if (passes_[pass].execute) {
+		passes_[pass].execute(commandList);
+	}
+}
+
+std::string RenderGraph::GetStateName(ResourceState state)
+{
+	if (state == ResourceState::Common) {
+		return "Common";
+	}
+	static const std::pair<ResourceState, const char*> kNames[] = {
+		{ ResourceState::RenderTarget, "RenderTarget" },
+		{ ResourceState::UnorderedAccess, "UnorderedAccess" },
+		{ ResourceState::DepthWrite, "DepthWrite" },
+		{ ResourceState::DepthRead, "DepthRead" },
+		{ ResourceState::NonPixelShaderResource, "NonPixelShaderResource" },
+		{ ResourceState::PixelShaderResource, "PixelShaderResource" },
+		{ ResourceState::CopyDest, "CopyDest" },
+		{ ResourceState::CopySource, "CopySource" },
+	};
+	std::string name;
+	for (const auto& [flag, flagName] : kNames) {
+		if ((state & flag) == flag) {
+			name += name.empty() ? flagName : std::string("|") + flagName;
+		}
+	}
+	return name;
+}
+
+bool RenderGraph::IsReadOnlyState(ResourceState state)
+{
+	return state != ResourceState::Common && (uint32_t(state) & ~uint32_t(kReadOnlyStates)) == 0;
+}
@@ -0,0 +1,193 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// MyClass
+#include "AliasingPlanner.h"
+
+struct ID3D12Resource;
+struct ID3D12GraphicsCommandList;
+
+// リソースの状態（D3D12_RESOURCE_STATESと同じ値。読み取りの状態はビットを組み合わせられる）
+enum class ResourceState : uint32_t {
+	Common = 0x0,
+	Present = 0x0,
+	RenderTarget = 0x4,
+	UnorderedAccess = 0x8,
+	DepthWrite = 0x10,
+	DepthRead = 0x20,
+	NonPixelShaderResource = 0x40,
+	PixelShaderResource = 0x80,
+	CopyDest = 0x400,
+	CopySource = 0x800,
+};
+
+inline ResourceState operator|(ResourceState a, ResourceState b) { return ResourceState(uint32_t(a) | uint32_t(b)); }
+inline ResourceState operator&(ResourceState a, ResourceState b) { return ResourceState(uint32_t(a) & uint32_t(b)); }
+
+// バリアを分割する場合の前半と後半（前半から後半までの間のパスでは、そのリソースを使わない）
+enum class BarrierSplit : uint8_t {
+	None,
+	Begin,
+	End,
+};
+
+// バリアの種類
+enum class BarrierType : uint8_t {
+	// 状態の遷移
+	Transition,
+	// UAVへの書き込みを待つ
+	Uav,
+	// 一時的なリソースのメモリを、前に同じメモリを使っていたリソースから切り替える
+	Aliasing,
+};
+
+// コンパイルで生成されたバリア
+struct RenderGraphBarrier {
+	BarrierType type = BarrierType::Transition;
+	uint32_t resource = 0;
+	ResourceState before = ResourceState::Common;
+	ResourceState after = ResourceState::Common;
+	BarrierSplit split = BarrierSplit::None;
+};
+
+// 実行の順に並んだ1つのパスと、その前にまとめて張るバリア
+struct RenderGraphStep {
+	// 最後の手順はパスを持たず（kInvalidPass）、リソースを最後の状態に戻すバリアだけを持つ
+	uint32_t pass;
+	std::vector<RenderGraphBarrier> barriers;
+};
+
+// RenderGraphのコンパイルの設定（比較のために個別に無効にできる）
+struct RenderGraphCompileOptions {
+	bool cullPasses = true;
+	bool mergeReadStates = true;
+	bool splitBarriers = true;
+	// 使う期間が重ならない一時的なリソースにメモリを共有させる（falseの場合はそれぞれ専用のメモリに置く）
+	bool aliasTransients = true;
+};
+
+// フレームの中だけで使う一時的なリソース（内容は次のフレームに残らない）
+struct TransientResourceDesc {
+	// 作るTextureの大きさとDXGI_FORMAT
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t format = 0;
+	// 作る時の状態（RenderTargetかDepthWrite）。使い終わったらこの状態に戻す
+	ResourceState initialState = ResourceState::RenderTarget;
+	// ヒープ上の大きさとアラインメント（DirectXBase::CreateTransientTextureで求める）
+	uint64_t size = 0;
+	uint64_t alignment = 0;
+
+	bool operator==(const TransientResourceDesc&) const = default;
+};
+
+// パスが読み書きするリソースを宣言し、実行の順とバリアを決める（コンパイルはGPUに依存しないので、結果を調べて検証できる）
+// ・出力のリソースに影響しないパスは省く
+// ・1つのパスの前に必要なバリアは1回のResourceBarrierにまとめる
+// ・続けて読むだけのパスが複数あれば、読み取りの状態を組み合わせて1回の遷移で済ませる
+// ・最後に使ったパスから次に使うパスまでの間にパスがあれば、バリアを分割してその間に遷移させる
+// ・一時的なリソースは最初に使うパスから最後に使うパスまでの期間を求め、期間が重ならないものに同じメモリを使わせる
+class RenderGraph
+{
+public:
+	static constexpr uint32_t kInvalidPass = UINT32_MAX;
+
+	// 全てのパスとリソースを消す（毎フレーム組み直す）
+	void Reset();
+
+	// 外部のリソースを登録する（フレームの最初はinitialStateで、最後にfinalStateに戻す）
+	// isOutputがtrueの場合は、内容がフレームの後に使われるものとして、書き込むパスを省かない
+	uint32_t ImportResource(const std::string& name, ID3D12Resource* resource, ResourceState initialState, ResourceState finalState, bool isOutput = true);
+	// 一時的なリソースを登録する（コンパイルでヒープ上の位置を決め、実行する前にSetResourceで置いたリソースを渡す）
+	// メモリをほかのリソースと共有するので、最初に書き込むパスでClearかDiscardResourceをしてから使う
+	uint32_t CreateTransientResource(const std::string& name, const TransientResourceDesc& desc);
+
+	// パスを追加する（追加した順に実行される。hasSideEffectがtrueの場合は省かない）
+	uint32_t AddPass(const std::string& name, std::function<void(ID3D12GraphicsCommandList*)> execute, bool hasSideEffect = false);
+	// パスが読む・書くリソースとその状態を宣言する（同じリソースを読んで書く場合は両方宣言する）
+	void Read(uint32_t pass, uint32_t resource, ResourceState state);
+	void Write(uint32_t pass, uint32_t resource, ResourceState state);
+
+	// 実行の順とバリアを決める
+	void Compile(const RenderGraphCompileOptions& options = RenderGraphCompileOptions());
+
+	// コンパイルの結果（最後の手順はパスを持たない）
+	const std::vector<RenderGraphStep>& GetSchedule() const { return schedule_; }
+	bool IsCulled(uint32_t pass) const { return passes_[pass].isCulled; }
+	// バリアの数（分割したバリアは前半と後半で2つ）と、ResourceBarrierを呼ぶ回数
+	uint32_t GetBarrierCount() const;
+	uint32_t GetBatchCount() const;
+	// コンパイルの結果を1行に1手順の文字列にする
+	std::string DumpSchedule() const;
+
+	uint32_t GetPassCount() const { return uint32_t(passes_.size()); }
+	uint32_t GetResourceCount() const { return uint32_t(resources_.size()); }
+	const std::string& GetPassName(uint32_t pass) const { return passes_[pass].name; }
+	const std::string& GetResourceName(uint32_t resource) const { return resources_[resource].name; }
+	ID3D12Resource* GetResource(uint32_t resource) const { return resources_[resource].resource; }
+	ResourceState GetInitialState(uint32_t resource) const { return resources_[resource].initialState; }
+	ResourceState GetFinalState(uint32_t resource) const { return resources_[resource].finalState; }
+	void SetResource(uint32_t resource, ID3D12Resource* d3dResource) { resources_[resource].resource = d3dResource; }
+
+	bool IsTransient(uint32_t resource) const { return resources_[resource].isTransient; }
+	const TransientResourceDesc& GetTransientDesc(uint32_t resource) const { return resources_[resource].transientDesc; }
+	// コンパイルで一時的なリソースを置いた結果（省いたパスでしか使わないリソースは置かない）
+	const AliasingPlan& GetAliasingPlan() const { return aliasingPlan_; }
+	bool IsPlaced(uint32_t resource) const { return resources_[resource].aliasingRequest != kInvalidPass; }
+	uint32_t GetHeapIndex(uint32_t resource) const { return aliasingPlan_.heaps[resources_[resource].aliasingRequest]; }
+	uint64_t GetHeapOffset(uint32_t resource) const { return aliasingPlan_.offsets[resources_[resource].aliasingRequest]; }
+	// パスの処理を実行する
+	void ExecutePass(uint32_t pass, ID3D12GraphicsCommandList* commandList) const;
+
+	// パスが宣言した使い方（同じリソースの読み書きは1つにまとめてある）
+	struct Usage {
+		uint32_t resource;
+		ResourceState state;
+		bool isRead;
+		bool isWrite;
+	};
+	const std::vector<Usage>& GetUsages(uint32_t pass) const { return passes_[pass].usages; }
+
+	// 状態を"RenderTarget|CopySource"のような文字列にする
+	static std::string GetStateName(ResourceState state);
+	// 読み取りだけの状態か（組み合わせられる）
+	static bool IsReadOnlyState(ResourceState state);
+
+private:
+	struct Resource {
+		std::string name;
+		ID3D12Resource* resource = nullptr;
+		ResourceState initialState = ResourceState::Common;
+		ResourceState finalState = ResourceState::Common;
+		bool isOutput = false;
+		bool isTransient = false;
+		TransientResourceDesc transientDesc;
+		// AliasingPlanでの番号（置いていなければkInvalidPass）
+		uint32_t aliasingRequest = kInvalidPass;
+	};
+
+	struct Pass {
+		std::string name;
+		std::function<void(ID3D12GraphicsCommandList*)> execute;
+		bool hasSideEffect = false;
+		bool isCulled = false;
+		std::vector<Usage> usages;
+	};
+
+	// 使い方を追加する（同じリソースは1つにまとめる）
+	void AddUsage(uint32_t pass, uint32_t resource, ResourceState state, bool isWrite);
+	// 出力に影響しないパスに印を付ける
+	void CullPasses();
+	// 一時的なリソースを使う期間を求めてヒープ上の位置を決める（firstSteps・lastStepsに期間を書き込む）
+	void PlaceTransients(size_t passStepCount, bool aliasTransients, std::vector<int64_t>& firstSteps, std::vector<int64_t>& lastSteps);
+	// 遷移のバリアを追加する（lastStepからstepまでの間にパスがあれば分割する）
+	void AddTransition(uint32_t resource, ResourceState before, ResourceState after, int64_t lastStep, size_t step, bool splitBarriers);
+
+	std::vector<Resource> resources_;
+	std::vector<Pass> passes_;
+	std::vector<RenderGraphStep> schedule_;
+	AliasingPlan aliasingPlan_;
+};
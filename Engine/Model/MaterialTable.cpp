@@ -0,0 +1,167 @@
+#include "MaterialTable.h"
+#include <cassert>
+#include <cstring>
+#include <format>
+
+// MyClass
+#include "ModelManager.h"
+#include "TextureManager.h"
+#include "Logger.h"
+#include "Hash.h"
+
+namespace {
+	// パディングを0で埋めたマテリアルを作る（バイト列で比較するため）
+	Material MakeComparableMaterial(const Material& material)
+	{
+		Material result;
+		std::memset(&result, 0, sizeof(Material));
+		result.color = material.color;
+		result.enableLighting = material.enableLighting;
+		result.uvTransform = material.uvTransform;
+		return result;
+	}
+
+	// MTLのマテリアルの内容を、名前を除いて1つの文字列にまとめる
+	std::string SerializeMaterialData(const MaterialData& materialData)
+	{
+		std::string content;
+		content.append(reinterpret_cast<const char*>(&materialData.diffuseColor), sizeof(Float4));
+		content.append(reinterpret_cast<const char*>(&materialData.specularColor), sizeof(Float3));
+		content.append(reinterpret_cast<const char*>(&materialData.shininess), sizeof(float));
+		// テクスチャのパスは区切り文字を挟んで連結する
+		for (const std::string* path : { &materialData.textureFilePath, &materialData.specularTextureFilePath, &materialData.normalTextureFilePath, &materialData.alphaTextureFilePath }) {
+			content += *path;
+			content += '\0';
+		}
+		return content;
+	}
+}
+
+MaterialTable& MaterialTable::GetInstance()
+{
+	static MaterialTable instance;
+
+	return instance;
+}
+
+ConstBuffer<Material>* MaterialTable::Acquire(const Material& material)
+{
+	MaterialTable& table = GetInstance();
+	std::lock_guard<std::recursive_mutex> lock(table.mutex_);
+	table.acquireCount_++;
+
+	Material content = MakeComparableMaterial(material);
+	uint64_t hash = HashBytes(&content, sizeof(Material));
+
+	// 同じ内容の定数バッファがあれば共有する（同じハッシュ値で内容が違うものは比較して除く）
+	auto [begin, end] = table.constBuffers_.equal_range(hash);
+	for (auto itr = begin; itr != end; ++itr) {
+		if (std::memcmp(&itr->second.content, &content, sizeof(Material)) == 0) {
+			itr->second.refCount++;
+			return itr->second.constBuffer.get();
+		}
+	}
+
+	// 新しく定数バッファを作って内容を書き込む
+	ConstBufferEntry& entry = table.constBuffers_.emplace(hash, ConstBufferEntry{})->second;
+	entry.content = content;
+	entry.constBuffer = std::make_unique<ConstBuffer<Material>>();
+	entry.refCount = 1;
+	*entry.constBuffer->data_ = content;
+	table.constBufferKeys_[entry.constBuffer.get()] = hash;
+
+	return entry.constBuffer.get();
+}
+
+void MaterialTable::Release(ConstBuffer<Material>* constBuffer)
+{
+	MaterialTable& table = GetInstance();
+	std::lock_guard<std::recursive_mutex> lock(table.mutex_);
+
+	auto keyItr = table.constBufferKeys_.find(constBuffer);
+	assert(keyItr != table.constBufferKeys_.end());
+	auto [begin, end] = table.constBuffers_.equal_range(keyItr->second);
+	for (auto itr = begin; itr != end; ++itr) {
+		if (itr->second.constBuffer.get() != constBuffer) {
+			continue;
+		}
+		assert(itr->second.refCount > 0);
+		if (--itr->second.refCount == 0) {
+			// 定数バッファの領域は、ConstantBufferPoolがGPUが使い終わるまで再利用しない
+			table.constBufferKeys_.erase(keyItr);
+			table.constBuffers_.erase(itr);
+		}
+		return;
+	}
+}
+
+void MaterialTable::Register(MaterialData& materialData, ID3D12Device* device)
+{
+	MaterialTable& table = GetInstance();
+	std::lock_guard<std::recursive_mutex> lock(table.mutex_);
+
+	std::string content = SerializeMaterialData(materialData);
+	uint64_t hash = HashBytes(content.data(), content.size());
+
+	// 同じ内容のマテリアルが既にあれば、定数バッファとテクスチャを共有する
+	auto [begin, end] = table.materials_.equal_range(hash);
+	for (auto itr = begin; itr != end; ++itr) {
+		if (itr->second.content == content) {
+			// 呼び出し側で読み込んだテクスチャ（glTFに埋め込まれた画像）は、テーブルの参照を使うので手放す
+			if (materialData.textureHandle != 0) {
+				TextureManager::Unload(materialData.textureHandle);
+			}
+			itr->second.refCount++;
+			materialData.materialCB = itr->second.constBuffer;
+			materialData.textureHandle = itr->second.textureHandle;
+			return;
+		}
+	}
+
+	// テクスチャを読み込む（glTFに埋め込まれた画像など、既に読み込まれている場合はそのまま使用する）
+	if (!materialData.textureFilePath.empty() && materialData.textureHandle == 0) {
+		materialData.textureHandle = TextureManager::Load(materialData.textureFilePath, device);
+	}
+
+	// 定数バッファを取得する
+	Material material;
+	std::memset(&material, 0, sizeof(Material));
+	material.color = materialData.diffuseColor;
+	material.enableLighting = true;
+	material.uvTransform = Matrix::Identity();
+	materialData.materialCB = Acquire(material);
+
+	table.materials_.emplace(hash, MaterialEntry{ std::move(content), materialData.materialCB, materialData.textureHandle, 1 });
+	Log(std::format("Registered material:{} (materials:{}, constant buffers:{})\n", materialData.name, table.materials_.size(), table.constBuffers_.size()));
+}
+
+void MaterialTable::Unregister(const MaterialData& materialData)
+{
+	// 登録していないマテリアル（ヘッドレスで作ったモデルなど）は何もしない
+	if (!materialData.materialCB) {
+		return;
+	}
+	MaterialTable& table = GetInstance();
+	std::lock_guard<std::recursive_mutex> lock(table.mutex_);
+
+	std::string content = SerializeMaterialData(materialData);
+	auto [begin, end] = table.materials_.equal_range(HashBytes(content.data(), content.size()));
+	for (auto itr = begin; itr != end; ++itr) {
+		if (itr->second.content != content) {
+			continue;
+		}
+		assert(itr->second.refCount > 0);
+		if (--itr->second.refCount > 0) {
+			return;
+		}
+
+		// 定数バッファとテクスチャの参照を手放す（テクスチャは参照カウントが0になると、ResourceBudgetが追い出せるキャッシュになる）
+		Release(itr->second.constBuffer);
+		if (itr->second.textureHandle != 0) {
+			TextureManager::Unload(itr->second.textureHandle);
+		}
+		table.materials_.erase(itr);
+		return;
+	}
+	assert(0); // 登録していないマテリアル
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// MyClass
+#include "MyMath.h"
+#include "ConstBuffer.h"
+
+struct MaterialData;
+
+// GPUに送るマテリアル情報
+struct Material {
+	Float4 color;
+	int32_t enableLighting;
+	float padding[3];
+	Matrix uvTransform;
+};
+
+// 内容が同じマテリアルを1つの定数バッファとテクスチャ参照で共有するためのテーブル
+class MaterialTable final
+{
+public:
+	static MaterialTable& GetInstance();
+
+	// マテリアルを登録し、同じ内容のものが既にあればその定数バッファを返す（参照カウントが増える）
+	static ConstBuffer<Material>* Acquire(const Material& material);
+	// Acquireで取得した定数バッファの参照カウントを減らし、0になったら解放する（領域はGPUが使い終わるまで再利用されない）
+	static void Release(ConstBuffer<Material>* constBuffer);
+
+	// MTLから読み込んだマテリアルを登録する（同じ内容のものが既にあれば定数バッファとテクスチャを共有する。参照カウントが増える）
+	// textureHandleが設定済みの場合は、その参照をテーブルが引き取る
+	static void Register(MaterialData& materialData, ID3D12Device* device);
+	// Registerしたマテリアルの参照カウントを減らし、0になったら定数バッファとテクスチャの参照を手放す（モデルを解放するときに呼ぶ）
+	static void Unregister(const MaterialData& materialData);
+
+	// 使われている定数バッファの数
+	static size_t GetConstBufferCount() { return GetInstance().constBuffers_.size(); }
+	// 要求された回数（共有せずに生成していた場合の定数バッファの数）
+	static size_t GetAcquireCount() { return GetInstance().acquireCount_; }
+
+private:
+	// 定数バッファの登録情報
+	struct ConstBufferEntry {
+		Material content; // 衝突判定用の内容
+		std::unique_ptr<ConstBuffer<Material>> constBuffer;
+		uint32_t refCount = 0;
+	};
+	// MTLのマテリアルの登録情報
+	struct MaterialEntry {
+		std::string content; // 衝突判定用の内容
+		ConstBuffer<Material>* constBuffer;
+		uint32_t textureHandle;
+		uint32_t refCount = 0;
+	};
+
+	// 内容のハッシュ値をキーにした定数バッファ（ハッシュ値が衝突した場合は同じキーに複数入る）
+	std::unordered_multimap<uint64_t, ConstBufferEntry> constBuffers_;
+	// 定数バッファからキーを引く（Release用）
+	std::unordered_map<const ConstBuffer<Material>*, uint64_t> constBufferKeys_;
+	// 内容のハッシュ値をキーにしたMTLのマテリアル
+	std::unordered_multimap<uint64_t, MaterialEntry> materials_;
+
+	size_t acquireCount_ = 0;
+
+	// ワーカースレッドからのモデル読み込みに備えて排他する（RegisterからAcquire、UnregisterからReleaseを呼ぶので再帰可能にする）
+	std::recursive_mutex mutex_;
+};
+
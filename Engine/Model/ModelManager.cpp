@@ -1,80 +1,40 @@
 #include "ModelManager.h"
 #include <fstream>
 #include <sstream>
+#include <unordered_map>
+#include <algorithm>
 #include <DirectXUtil.h>
 #include <DirectXBase.h>
+#include "MappedFile.h"
 
-ModelData ModelManager::LoadObjFile(const std::string& directoryPath, const std::string& filename, ID3D12Device* device)
+ModelData ModelManager::LoadObjFile(const std::string& directoryPath, const std::string& filename, ID3D12Device* device, ModelMemoryReport* report)
 {
     // 1. 中で必要となる変数の宣言
     ModelData modelData; // 構築するModelData
-    std::vector<Float4> positions; // 位置
-    std::vector<Float3> normals; // 法線
-    std::vector<Float2> texcoords; // テクスチャ座標
-    std::string line; // ファイルから読んだ1行を格納するもの
+    ObjMesh mesh; // ファイルから読んだ要素と展開した頂点
 
     // 2. ファイルを開く
     std::ifstream file(directoryPath + "/" + filename); // ファイルを開く
-    assert(file.is_open()); // とりあえず開けなかったら止める
-
-    // 3. 実際にファイルを読み、ModelDataを構築していく
-    while (std::getline(file, line)) {
-        std::string identifier;
-        std::istringstream s(line);
-        s >> identifier; // 先頭の識別子を読む
+    if (!file.is_open()) {
+        Log(std::format("LoadObjFile {} : failed to open\n", filename));
+        return ModelData{};
+    }
 
-        // identifierに応じた処理
-        if (identifier == "v") {
-            Float4 position;
-            s >> position.x >> position.y >> position.z;
-            position.x *= -1.0f; // 位置のxを反転
-            position.w = 1.0f;
-            positions.push_back(position);
-        } else if (identifier == "vt") {
-            Float2 texcoord;
-            s >> texcoord.x >> texcoord.y;
-            texcoord.y = 1.0f - texcoord.y; // テクスチャが上下反転しないようにする
-            texcoords.push_back(texcoord);
-        } else if (identifier == "vn") {
-            Float3 normal;
-            s >> normal.x >> normal.y >> normal.z;
-            normal.x *= -1.0f; // 法線のxを反転
-            normals.push_back(normal);
-        } else if (identifier == "f") {
-            VertexData triangle[3];
-            // 面は三角形限定。その他は未対応
-            for (int32_t faceVertex = 0; faceVertex < 3; ++faceVertex) {
-                std::string vertexDefinition;
-                s >> vertexDefinition;
-                // 頂点の要素へのIndexは「位置/UV/法線」で格納されているので、分解してIndexを取得する
-                std::istringstream v(vertexDefinition);
-                uint32_t elementIndices[3];
-                for (int32_t element = 0; element < 3; ++element) {
-                    std::string index;
-                    std::getline(v, index, '/'); // /区切りでインデックスを読んでいく
-                    elementIndices[element] = std::stoi(index);
-                }
-                // 要素へのIndexから、実際の要素の値を取得して、頂点を構成する
-                Float4 position = positions[elementIndices[0] - 1];
-                Float2 texcoord = texcoords[elementIndices[1] - 1];
-                Float3 normal = normals[elementIndices[2] - 1];
-                triangle[faceVertex] = { position, texcoord, normal };
-            }
-            // 頂点を逆順に登録することで、回り順を逆にする
-            modelData.vertices.push_back(triangle[2]);
-            modelData.vertices.push_back(triangle[1]);
-            modelData.vertices.push_back(triangle[0]);
-        } else if (identifier == "mtllib") {
-            // materialTemplateLibraryファイルの名前を取得する
-            std::string materialFilename;
-            s >> materialFilename;
-            // 基本的にobjファイルと同一階層にmtlは存在させるので、ディレクトリ名とファイル名を渡す
-            modelData.material = LoadMaterialTemplateFile(directoryPath, materialFilename, device);
-        }
+    // 3. 実際にファイルを読み、三角形ごとに頂点を展開する
+    if (!ObjParser::Parse(file, mesh)) {
+        Log(std::format("LoadObjFile {} : {}\n", filename, mesh.error));
+        return ModelData{};
     }
+    modelData.material = LoadObjMaterial(directoryPath, mesh, device);
+    modelData.vertices = std::move(mesh.vertices);
+    modelData.boundsMin = mesh.boundsMin;
+    modelData.boundsMax = mesh.boundsMax;
+
+    // 描画する頂点数
+    modelData.vertexCount = UINT(modelData.vertices.size());
 
     // vertexResourceの作成
-    modelData.vertexResource = CreateBufferResource(DirectXBase::GetInstance()->GetDevice(), sizeof(VertexData) * modelData.vertices.size());
+    modelData.vertexResource = CreateBufferResource(DirectXBase::GetInstance()->GetDevice(), sizeof(VertexData) * modelData.vertices.size(), ResourceCategory::Mesh);
 
     // 頂点バッファビューを作成する
     modelData.vertexBufferView;
@@ -93,37 +53,615 @@ ModelData ModelManager::LoadObjFile(const std::string& directoryPath, const std:
     // 頂点データをリソースにコピー
     std::memcpy(vertexData, modelData.vertices.data(), sizeof(VertexData) * modelData.vertices.size());
 
-    // 4. ModelDataを返す
+    // 4. メモリ使用量を記録する（展開した頂点はCPU側にも残り続ける）
+    if (report) {
+        *report = mesh.memory;
+    }
+
+    // 5. ModelDataを返す
     return modelData;
 }
 
+ModelData ModelManager::LoadObjFileStreaming(const std::string& directoryPath, const std::string& filename, ID3D12Device* device, bool keepCpuCopy, ModelMemoryReport* report)
+{
+    // 1. 中で必要となる変数の宣言
+    ModelData modelData; // 構築するModelData
+    ObjMesh mesh; // ファイルから読んだ要素と、溶接後の頂点とIndex
+
+    // 2. ファイルを開く
+    std::ifstream file(directoryPath + "/" + filename); // ファイルを開く
+    if (!file.is_open()) {
+        Log(std::format("LoadObjFileStreaming {} : failed to open\n", filename));
+        return ModelData{};
+    }
+
+    // 3. 実際にファイルを読み、同一頂点を溶接する
+    if (!ObjParser::ParseWelded(file, mesh)) {
+        Log(std::format("LoadObjFileStreaming {} : {}\n", filename, mesh.error));
+        return ModelData{};
+    }
+    modelData.material = LoadObjMaterial(directoryPath, mesh, device);
+    modelData.vertexCount = UINT(mesh.vertexKeys.size());
+    modelData.indexCount = UINT(mesh.indices.size());
+    modelData.boundsMin = mesh.boundsMin;
+    modelData.boundsMax = mesh.boundsMax;
+
+    // 4. 頂点数が確定したので、ちょうどのサイズでvertexResourceを作成する
+    modelData.vertexResource = CreateBufferResource(device, sizeof(VertexData) * modelData.vertexCount, ResourceCategory::Mesh);
+    modelData.vertexBufferView.BufferLocation = modelData.vertexResource->GetGPUVirtualAddress();
+    modelData.vertexBufferView.SizeInBytes = UINT(sizeof(VertexData) * modelData.vertexCount);
+    modelData.vertexBufferView.StrideInBytes = sizeof(VertexData);
+
+    // 要素から頂点を組み立てて、アップロードヒープへ直接書き込む
+    VertexData* vertexData = nullptr;
+    modelData.vertexResource->Map(0, nullptr, reinterpret_cast<void**>(&vertexData));
+    ObjParser::AssembleVertices(mesh, vertexData);
+    // CPU側にも残す場合はアップロードヒープを読み戻さずに、もう一度組み立てる
+    if (keepCpuCopy) {
+        modelData.vertices.resize(modelData.vertexCount);
+        ObjParser::AssembleVertices(mesh, modelData.vertices.data());
+    }
+    modelData.vertexResource->Unmap(0, nullptr);
+
+    // 5. indexResourceを作成してIndexを書き込む
+    modelData.indexResource = CreateBufferResource(device, sizeof(uint32_t) * modelData.indexCount, ResourceCategory::Mesh);
+    modelData.indexBufferView.BufferLocation = modelData.indexResource->GetGPUVirtualAddress();
+    modelData.indexBufferView.SizeInBytes = UINT(sizeof(uint32_t) * modelData.indexCount);
+    modelData.indexBufferView.Format = DXGI_FORMAT_R32_UINT;
+
+    uint32_t* indexData = nullptr;
+    modelData.indexResource->Map(0, nullptr, reinterpret_cast<void**>(&indexData));
+    std::memcpy(indexData, mesh.indices.data(), sizeof(uint32_t) * modelData.indexCount);
+    modelData.indexResource->Unmap(0, nullptr);
+
+    // 6. メモリ使用量を記録する（CPU側に残す頂点の分だけ増える）
+    ModelMemoryReport memoryReport = mesh.memory;
+    memoryReport.peakCpuBytes += modelData.vertices.capacity() * sizeof(VertexData);
+    memoryReport.steadyCpuBytes += modelData.vertices.capacity() * sizeof(VertexData);
+    Log(std::format("LoadObjFileStreaming {} : vertices {} / indices {}, peakCPU {} bytes, steadyCPU {} bytes, GPU {} bytes (expanded {} bytes)\n",
+        filename, modelData.vertexCount, modelData.indexCount,
+        memoryReport.peakCpuBytes, memoryReport.steadyCpuBytes, memoryReport.gpuBytes, memoryReport.expandedBytes));
+    if (report) {
+        *report = memoryReport;
+    }
+
+    // 7. ModelDataを返す
+    return modelData;
+}
+
+MaterialData ModelManager::LoadObjMaterial(const std::string& directoryPath, const ObjMesh& mesh, ID3D12Device* device)
+{
+    if (mesh.materialLibrary.empty()) {
+        return MaterialData{};
+    }
+    // 基本的にobjファイルと同一階層にmtlは存在させるので、ディレクトリ名とファイル名を渡す
+    std::vector<MaterialData> materials = LoadMaterialLibrary(directoryPath, mesh.materialLibrary, device);
+    if (materials.empty()) {
+        return MaterialData{};
+    }
+
+    // 1つのモデルにつき1マテリアルなので、最初に指定されたマテリアルを使用する（usemtlが無い場合は先頭のマテリアル）
+    MaterialData usedMaterial = materials.front();
+    bool isMaterialSelected = false;
+    for (const std::string& materialName : mesh.materialNames) {
+        for (const MaterialData& material : materials) {
+            if (!isMaterialSelected && material.name == materialName) {
+                usedMaterial = material;
+                isMaterialSelected = true;
+            }
+        }
+    }
+
+    // モデルが使わないマテリアルの登録を取り消す
+    UnregisterUnusedMaterials(materials, usedMaterial);
+    return usedMaterial;
+}
+
 MaterialData ModelManager::LoadMaterialTemplateFile(const std::string& directoryPath, const std::string& filename, ID3D12Device* device)
+{
+    // 全てのマテリアルを読み込み、先頭のマテリアルを返す
+    std::vector<MaterialData> materials = LoadMaterialLibrary(directoryPath, filename, device);
+    if (materials.empty()) {
+        return MaterialData{};
+    }
+    UnregisterUnusedMaterials(materials, materials.front());
+    return materials.front();
+}
+
+void ModelManager::UnregisterUnusedMaterials(const std::vector<MaterialData>& materials, const MaterialData& usedMaterial)
+{
+    // LoadMaterialLibraryは全てのマテリアルを登録するので、使うもの（名前が最初に一致したもの）以外の参照を手放す
+    bool isUsedFound = false;
+    for (const MaterialData& material : materials) {
+        if (!isUsedFound && material.name == usedMaterial.name && material.materialCB == usedMaterial.materialCB) {
+            isUsedFound = true;
+            continue;
+        }
+        MaterialTable::Unregister(material);
+    }
+}
+
+std::vector<MaterialData> ModelManager::LoadMaterialLibrary(const std::string& directoryPath, const std::string& filename, ID3D12Device* device)
 {
     // 1. 中で必要となる変数の宣言
-    MaterialData materialData; // 構築するMaterialData
+    std::vector<MaterialData> materials; // 構築するMaterialDataの配列
     std::string line; // ファイルから読んだ1行を格納するもの
 
     // 2. ファイルを開く
     std::ifstream file(directoryPath + "/" + filename); // ファイルを開く
     assert(file.is_open()); // とりあえず開けなかったら止める
 
-    // 3. 実際にファイルを読み、MaterialDataを構築していく
+    // 3. 実際にファイルを読み、newmtl毎にMaterialDataを構築していく
     while (std::getline(file, line)) {
         std::string identifier;
         std::istringstream s(line);
         s >> identifier;
 
+        // newmtlより前の行は無視する
+        if (identifier != "newmtl" && materials.empty()) {
+            continue;
+        }
+
         // identifierに応じた処理
-        if (identifier == "map_Kd") {
-            std::string textureFilename;
-            s >> textureFilename;
+        if (identifier == "newmtl") {
+            MaterialData& materialData = materials.emplace_back();
+            s >> materialData.name;
+        } else if (identifier == "Kd") {
+            Float4& color = materials.back().diffuseColor;
+            s >> color.x >> color.y >> color.z;
+        } else if (identifier == "Ks") {
+            Float3& color = materials.back().specularColor;
+            s >> color.x >> color.y >> color.z;
+        } else if (identifier == "Ns") {
+            s >> materials.back().shininess;
+        } else if (identifier == "d") {
+            s >> materials.back().diffuseColor.w;
+        } else if (identifier == "Tr") {
+            // Trは透明度なので不透明度に変換する
+            float transparency = 0.0f;
+            s >> transparency;
+            materials.back().diffuseColor.w = 1.0f - transparency;
+        } else if (identifier.starts_with("map_") || identifier == "bump") {
+            // オプション（-s 1 1 1 など）は読み飛ばし、最後の要素をファイル名とする
+            std::string token, textureFilename;
+            while (s >> token) {
+                textureFilename = token;
+            }
             // 連結してファイルパスにする
-            materialData.textureFilePath = directoryPath + "/" + textureFilename;
-            // 画像を読み込む
-            materialData.textureHandle = TextureManager::Load(materialData.textureFilePath, device);
+            std::string textureFilePath = directoryPath + "/" + textureFilename;
+            if (identifier == "map_Kd") {
+                materials.back().textureFilePath = textureFilePath;
+            } else if (identifier == "map_Ks") {
+                materials.back().specularTextureFilePath = textureFilePath;
+            } else if (identifier == "map_Bump" || identifier == "bump") {
+                materials.back().normalTextureFilePath = textureFilePath;
+            } else if (identifier == "map_d") {
+                materials.back().alphaTextureFilePath = textureFilePath;
+            }
         }
     }
 
-    // 4. MaterialDataを返す
+    // 4. マテリアルテーブルに登録し、同じ内容のマテリアルと定数バッファ・テクスチャを共有する
+    for (MaterialData& materialData : materials) {
+        MaterialTable::Register(materialData, device);
+    }
+
+    // 5. MaterialDataの配列を返す
+    return materials;
+}
+
+namespace {
+    // glTFのアクセッサが指すバイナリ上の範囲
+    struct GltfAccessorView {
+        const uint8_t* data = nullptr; // 先頭要素のアドレス
+        size_t count = 0; // 要素数
+        size_t stride = 0; // 要素間のバイト数
+        int32_t componentType = 0; // 5121:uint8 / 5123:uint16 / 5125:uint32 / 5126:float
+    };
+
+    // glTFのコンポーネントのバイト数を取得する
+    size_t GetGltfComponentSize(int32_t componentType)
+    {
+        switch (componentType) {
+        case 5120: case 5121: return 1; // BYTE / UNSIGNED_BYTE
+        case 5122: case 5123: return 2; // SHORT / UNSIGNED_SHORT
+        case 5125: case 5126: return 4; // UNSIGNED_INT / FLOAT
+        }
+        return 0;
+    }
+
+    // glTFの要素の型からコンポーネント数を取得する
+    size_t GetGltfComponentCount(const std::string& type)
+    {
+        if (type == "SCALAR") { return 1; }
+        if (type == "VEC2") { return 2; }
+        if (type == "VEC3") { return 3; }
+        if (type == "VEC4") { return 4; }
+        return 0;
+    }
+
+    // アクセッサをBINチャンク上の範囲に解決する（範囲外を指している場合はfalseを返す）
+    bool GetGltfAccessorView(const JsonValue& gltf, int32_t accessorIndex, const uint8_t* bin, size_t binSize, GltfAccessorView& view)
+    {
+        const JsonValue& accessor = gltf["accessors"][size_t(accessorIndex)];
+        const JsonValue& bufferView = gltf["bufferViews"][size_t(accessor["bufferView"].AsInt(-1))];
+        // バッファビューを持たないアクセッサと、GLB以外のバッファは非対応
+        if (accessorIndex < 0 || accessor.IsNull() || bufferView.IsNull() || bufferView["buffer"].AsInt(0) != 0 || accessor.Has("sparse")) {
+            return false;
+        }
+
+        view.componentType = accessor["componentType"].AsInt();
+        view.count = size_t(accessor["count"].AsNumber());
+        size_t elementSize = GetGltfComponentSize(view.componentType) * GetGltfComponentCount(accessor["type"].AsString());
+        view.stride = size_t(bufferView["byteStride"].AsNumber(double(elementSize)));
+        size_t offset = size_t(bufferView["byteOffset"].AsNumber()) + size_t(accessor["byteOffset"].AsNumber());
+        size_t viewEnd = size_t(bufferView["byteOffset"].AsNumber()) + size_t(bufferView["byteLength"].AsNumber());
+        if (elementSize == 0 || view.count == 0 || viewEnd > binSize || offset + view.stride * (view.count - 1) + elementSize > viewEnd) {
+            return false;
+        }
+        view.data = bin + offset;
+        return true;
+    }
+
+    // アクセッサのi番目の要素をuint32_tとして読む
+    uint32_t ReadGltfIndex(const GltfAccessorView& view, size_t i)
+    {
+        const uint8_t* element = view.data + view.stride * i;
+        if (view.componentType == 5121) {
+            return *element;
+        } else if (view.componentType == 5123) {
+            uint16_t index;
+            std::memcpy(&index, element, sizeof(uint16_t));
+            return index;
+        }
+        uint32_t index;
+        std::memcpy(&index, element, sizeof(uint32_t));
+        return index;
+    }
+
+    // 三角形リストとして使えるインデックス数（3の倍数に切り捨てる）
+    size_t GetGltfTriangleIndexCount(size_t count)
+    {
+        return count / 3 * 3;
+    }
+
+    // インデックスのアクセッサが符号なし整数で、全ての要素がvertexCount未満か確認する
+    bool IsGltfIndexInRange(const GltfAccessorView& view, size_t vertexCount)
+    {
+        if (view.componentType != 5121 && view.componentType != 5123 && view.componentType != 5125) {
+            return false;
+        }
+        for (size_t i = 0; i < view.count; ++i) {
+            if (ReadGltfIndex(view, i) >= vertexCount) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+ModelData ModelManager::LoadGltfFile(const std::string& directoryPath, const std::string& filename, ID3D12Device* device)
+{
+    // 1. 中で必要となる変数の宣言
+    ModelData modelData; // 構築するModelData
+
+    // 2. ファイルをメモリにマップする
+    MappedFile file;
+    // 書き込み途中のファイルをホットリロードで読むこともあるので、読めなかった場合は止めずに空のModelDataを返す
+    if (!file.Open(directoryPath + "/" + filename)) {
+        Log(std::format("LoadGltfFile {} : failed to open\n", filename));
+        return ModelData{};
+    }
+    const uint8_t* fileData = file.GetData();
+
+    // 3. ヘッダーとチャンクを確認する
+    // ヘッダー: magic("glTF") / version / length、チャンク: length / type / data
+    uint32_t header[3] = {};
+    if (file.GetSize() < sizeof(header) + sizeof(uint32_t) * 2) {
+        Log(std::format("LoadGltfFile {} : file is too small to be a GLB\n", filename));
+        return ModelData{};
+    }
+    std::memcpy(header, fileData, sizeof(header));
+    if (header[0] != 0x46546C67 || header[1] != 2 || header[2] > file.GetSize()) {
+        Log(std::format("LoadGltfFile {} : invalid GLB header (magic {:#x}, version {}, length {})\n", filename, header[0], header[1], header[2]));
+        return ModelData{};
+    }
+
+    std::string_view jsonText;
+    const uint8_t* bin = nullptr;
+    size_t binSize = 0;
+    for (size_t offset = sizeof(header); offset + sizeof(uint32_t) * 2 <= header[2];) {
+        uint32_t chunk[2];
+        std::memcpy(chunk, fileData + offset, sizeof(chunk));
+        offset += sizeof(chunk);
+        if (chunk[0] > header[2] - offset) {
+            Log(std::format("LoadGltfFile {} : chunk {:#x} overruns the file\n", filename, chunk[1]));
+            return ModelData{};
+        }
+        if (chunk[1] == 0x4E4F534A) { // JSON
+            jsonText = std::string_view(reinterpret_cast<const char*>(fileData + offset), chunk[0]);
+        } else if (chunk[1] == 0x004E4942) { // BIN
+            bin = fileData + offset;
+            binSize = chunk[0];
+        }
+        offset += chunk[0];
+    }
+    JsonValue gltf = JsonValue::Parse(jsonText);
+    if (gltf.IsNull()) {
+        Log(std::format("LoadGltfFile {} : failed to parse the JSON chunk\n", filename));
+        return ModelData{};
+    }
+
+    // 4. 最初のメッシュの全プリミティブを1つのモデルにまとめる
+    // ModelDataはマテリアルを1つしか持たない（Objと同じ）ので、プリミティブごとのマテリアルは最初のものだけを使う
+    struct Primitive {
+        GltfAccessorView positions, normals, texcoords, indices;
+        bool hasNormals, hasTexcoords, hasIndices;
+    };
+    std::vector<Primitive> primitives;
+    bool useShortIndex = true;
+    const JsonValue& mesh = gltf["meshes"][0];
+    for (size_t i = 0; i < mesh["primitives"].Size(); ++i) {
+        const JsonValue& primitiveJson = mesh["primitives"][i];
+        const JsonValue& attributes = primitiveJson["attributes"];
+        // 三角形リスト以外は非対応
+        if (primitiveJson["mode"].AsInt(4) != 4) {
+            Log(std::format("LoadGltfFile {} : primitive {} is not a triangle list and was skipped\n", filename, i));
+            continue;
+        }
+
+        Primitive primitive{};
+        bool isValid = GetGltfAccessorView(gltf, attributes["POSITION"].AsInt(-1), bin, binSize, primitive.positions) && primitive.positions.componentType == 5126;
+        primitive.hasNormals = GetGltfAccessorView(gltf, attributes["NORMAL"].AsInt(-1), bin, binSize, primitive.normals) && primitive.normals.componentType == 5126;
+        primitive.hasTexcoords = GetGltfAccessorView(gltf, attributes["TEXCOORD_0"].AsInt(-1), bin, binSize, primitive.texcoords) && primitive.texcoords.componentType == 5126;
+        primitive.hasIndices = GetGltfAccessorView(gltf, primitiveJson["indices"].AsInt(-1), bin, binSize, primitive.indices);
+        if (!isValid) {
+            Log(std::format("LoadGltfFile {} : primitive {} has no readable POSITION and was skipped\n", filename, i));
+            continue;
+        }
+        // 頂点数を超えるインデックスはアップロードヒープの外を参照するので、そのプリミティブは読み込まない
+        if (primitive.hasIndices && !IsGltfIndexInRange(primitive.indices, primitive.positions.count)) {
+            Log(std::format("LoadGltfFile {} : primitive {} has indices out of range and was skipped\n", filename, i));
+            continue;
+        }
+        // 法線とUVの要素数は位置と揃っている必要がある
+        primitive.hasNormals = primitive.hasNormals && primitive.normals.count == primitive.positions.count;
+        primitive.hasTexcoords = primitive.hasTexcoords && primitive.texcoords.count == primitive.positions.count;
+
+        // 32bitのインデックスを持つ場合は、全体を32bitのインデックスにする
+        if (primitive.hasIndices && primitive.indices.componentType == 5125) {
+            useShortIndex = false;
+        }
+        modelData.vertexCount += UINT(primitive.positions.count);
+        modelData.indexCount += UINT(GetGltfTriangleIndexCount(primitive.hasIndices ? primitive.indices.count : primitive.positions.count));
+        primitives.push_back(primitive);
+
+        // マテリアルは最初のプリミティブのものを使用する
+        if (primitives.size() == 1) {
+            modelData.material = LoadGltfMaterial(gltf, primitiveJson["material"].AsInt(-1), bin, binSize, directoryPath, filename, device);
+        }
+    }
+    if (primitives.empty()) {
+        Log(std::format("LoadGltfFile {} : no primitive could be loaded\n", filename));
+        return ModelData{};
+    }
+    // 頂点数が16bitに収まらない場合も32bitのインデックスにする
+    if (modelData.vertexCount > 0xFFFF) {
+        useShortIndex = false;
+    }
+    size_t indexSize = useShortIndex ? sizeof(uint16_t) : sizeof(uint32_t);
+
+    // 5. 頂点数とインデックス数が確定したので、ちょうどのサイズでリソースを作成する
+    modelData.vertexResource = CreateBufferResource(device, sizeof(VertexData) * modelData.vertexCount, ResourceCategory::Mesh);
+    modelData.vertexBufferView.BufferLocation = modelData.vertexResource->GetGPUVirtualAddress();
+    modelData.vertexBufferView.SizeInBytes = UINT(sizeof(VertexData) * modelData.vertexCount);
+    modelData.vertexBufferView.StrideInBytes = sizeof(VertexData);
+
+    modelData.indexResource = CreateBufferResource(device, indexSize * modelData.indexCount, ResourceCategory::Mesh);
+    modelData.indexBufferView.BufferLocation = modelData.indexResource->GetGPUVirtualAddress();
+    modelData.indexBufferView.SizeInBytes = UINT(indexSize * modelData.indexCount);
+    modelData.indexBufferView.Format = useShortIndex ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+
+    // 6. マップしたBINチャンクを読みながら、左手系への変換（xの反転と回り順の入れ替え）をしてアップロードヒープへ書き込む
+    VertexData* vertexData = nullptr;
+    uint8_t* indexData = nullptr;
+    modelData.vertexResource->Map(0, nullptr, reinterpret_cast<void**>(&vertexData));
+    modelData.indexResource->Map(0, nullptr, reinterpret_cast<void**>(&indexData));
+    uint32_t baseVertex = 0;
+    size_t indexOffset = 0;
+    for (const Primitive& primitive : primitives) {
+        for (size_t i = 0; i < primitive.positions.count; ++i) {
+            VertexData vertex = { { 0.0f, 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+            std::memcpy(&vertex.position, primitive.positions.data + primitive.positions.stride * i, sizeof(Float3));
+            if (primitive.hasTexcoords) {
+                // glTFのUVは左上が原点なのでそのまま使用する
+                std::memcpy(&vertex.texcoord, primitive.texcoords.data + primitive.texcoords.stride * i, sizeof(Float2));
+            }
+            if (primitive.hasNormals) {
+                std::memcpy(&vertex.normal, primitive.normals.data + primitive.normals.stride * i, sizeof(Float3));
+            }
+            // Objと同じく右手系から左手系にするため、xを反転
+            vertex.position.x *= -1.0f;
+            vertex.normal.x *= -1.0f;
+            vertexData[baseVertex + i] = vertex;
+            ExpandBounds(modelData, vertex.position, baseVertex + i == 0);
+        }
+
+        // xを反転したので、三角形の2番目と3番目を入れ替えて回り順を逆にする
+        // 3の倍数に満たない末尾のインデックスは三角形にならないので書き込まない
+        size_t indexCount = GetGltfTriangleIndexCount(primitive.hasIndices ? primitive.indices.count : primitive.positions.count);
+        for (size_t i = 0; i < indexCount; i += 3) {
+            uint32_t triangle[3];
+            for (size_t j = 0; j < 3; ++j) {
+                triangle[j] = baseVertex + (primitive.hasIndices ? ReadGltfIndex(primitive.indices, i + j) : uint32_t(i + j));
+            }
+            std::swap(triangle[1], triangle[2]);
+            for (size_t j = 0; j < 3; ++j) {
+                if (useShortIndex) {
+                    uint16_t index = uint16_t(triangle[j]);
+                    std::memcpy(indexData + (indexOffset + i + j) * indexSize, &index, indexSize);
+                } else {
+                    std::memcpy(indexData + (indexOffset + i + j) * indexSize, &triangle[j], indexSize);
+                }
+            }
+        }
+        baseVertex += uint32_t(primitive.positions.count);
+        indexOffset += indexCount;
+    }
+    modelData.vertexResource->Unmap(0, nullptr);
+    modelData.indexResource->Unmap(0, nullptr);
+
+    // 7. ModelDataを返す
+    return modelData;
+}
+
+MaterialData ModelManager::LoadGltfMaterial(const JsonValue& gltf, int32_t materialIndex, const uint8_t* bin, size_t binSize, const std::string& directoryPath, const std::string& filename, ID3D12Device* device)
+{
+    MaterialData materialData;
+    const JsonValue& material = gltf["materials"][size_t(materialIndex)];
+    if (materialIndex >= 0 && !material.IsNull()) {
+        materialData.name = material["name"].AsString();
+
+        // ベースカラーをKdとして扱う
+        const JsonValue& pbr = material["pbrMetallicRoughness"];
+        const JsonValue& factor = pbr["baseColorFactor"];
+        if (factor.Size() == 4) {
+            materialData.diffuseColor = {
+                float(factor[0].AsNumber()), float(factor[1].AsNumber()),
+                float(factor[2].AsNumber()), float(factor[3].AsNumber())
+            };
+        }
+
+        // ベースカラーのテクスチャを読み込む
+        int32_t textureIndex = pbr["baseColorTexture"]["index"].AsInt(-1);
+        const JsonValue& image = gltf["images"][size_t(gltf["textures"][size_t(textureIndex)]["source"].AsInt(-1))];
+        if (textureIndex >= 0 && image.Has("uri")) {
+            // 外部ファイルの画像はObjと同じくディレクトリからの相対パス
+            const std::string& uri = image["uri"].AsString();
+            if (uri.starts_with("data:")) {
+                Log(std::format("LoadGltfFile {} : data URI images are not supported\n", filename));
+            } else {
+                materialData.textureFilePath = directoryPath + "/" + uri;
+            }
+        } else if (textureIndex >= 0 && image.Has("bufferView")) {
+            // GLBに埋め込まれた画像はBINチャンクから直接読み込む
+            const JsonValue& bufferView = gltf["bufferViews"][size_t(image["bufferView"].AsInt())];
+            size_t offset = size_t(bufferView["byteOffset"].AsNumber());
+            size_t length = size_t(bufferView["byteLength"].AsNumber());
+            if (bufferView.IsNull() || offset > binSize || length > binSize - offset) {
+                Log(std::format("LoadGltfFile {} : embedded image {} is outside the BIN chunk\n", filename, image["bufferView"].AsInt()));
+            } else {
+                materialData.textureFilePath = std::format("{}/{}#image{}", directoryPath, filename, gltf["textures"][size_t(textureIndex)]["source"].AsInt());
+                materialData.textureHandle = TextureManager::LoadFromMemory(materialData.textureFilePath, bin + offset, length, device);
+            }
+        }
+    }
+
+    // マテリアルテーブルに登録し、同じ内容のマテリアルと定数バッファ・テクスチャを共有する
+    MaterialTable::Register(materialData, device);
     return materialData;
 }
+
+ModelData ModelManager::LoadModelFile(const std::string& directoryPath, const std::string& filename, ID3D12Device* device)
+{
+    // 拡張子で読み込み方法を切り替える
+    if (filename.ends_with(".glb")) {
+        return LoadGltfFile(directoryPath, filename, device);
+    }
+    return LoadObjFileStreaming(directoryPath, filename, device);
+}
+
+void ModelManager::ExpandBounds(ModelData& modelData, const Float4& position, bool isFirst)
+{
+    if (isFirst) {
+        modelData.boundsMin = { position.x, position.y, position.z };
+        modelData.boundsMax = { position.x, position.y, position.z };
+        return;
+    }
+    modelData.boundsMin = { (std::min)(modelData.boundsMin.x, position.x), (std::min)(modelData.boundsMin.y, position.y), (std::min)(modelData.boundsMin.z, position.z) };
+    modelData.boundsMax = { (std::max)(modelData.boundsMax.x, position.x), (std::max)(modelData.boundsMax.y, position.y), (std::max)(modelData.boundsMax.z, position.z) };
+}
+
+ModelData* ModelManager::Acquire(const std::string& directoryPath, const std::string& filename, ID3D12Device* device)
+{
+    ModelManager& instance = GetInstance();
+    std::lock_guard<std::mutex> lock(instance.mutex_);
+
+    // 読み込み済みであれば共有する（使われずにキャッシュに残っていたものは追い出す対象から外す）
+    std::string key = directoryPath + "/" + filename;
+    CachedModel& cached = instance.models_[key];
+    if (cached.model) {
+        if (cached.refCount++ == 0) {
+            ResourceBudget::GetInstance().RemoveCacheEntry(cached.cacheEntryId);
+            cached.cacheEntryId = ResourceBudget::kInvalidId;
+        }
+        return cached.model.get();
+    }
+
+    cached.model = std::make_unique<ModelData>(LoadModelFile(directoryPath, filename, device));
+    cached.refCount = 1;
+    instance.keys_[cached.model.get()] = key;
+    return cached.model.get();
+}
+
+void ModelManager::Release(ModelData* model)
+{
+    ModelManager& instance = GetInstance();
+    std::lock_guard<std::mutex> lock(instance.mutex_);
+
+    auto keyItr = instance.keys_.find(model);
+    assert(keyItr != instance.keys_.end());
+    CachedModel& cached = instance.models_[keyItr->second];
+    assert(cached.refCount > 0);
+    if (--cached.refCount > 0) {
+        return;
+    }
+
+    // すぐには解放せず、予算を超えたときに追い出せるキャッシュとして残す
+    std::vector<uint64_t> allocationIds = { GetTrackedAllocationId(model->vertexResource.Get()) };
+    if (model->indexResource) {
+        allocationIds.push_back(GetTrackedAllocationId(model->indexResource.Get()));
+    }
+    std::string key = keyItr->second;
+    cached.cacheEntryId = ResourceBudget::GetInstance().AddCacheEntry(allocationIds, [key]() {
+        ModelManager::Evict(key);
+    });
+}
+
+void ModelManager::Evict(const std::string& key)
+{
+    ModelManager& instance = GetInstance();
+    std::lock_guard<std::mutex> lock(instance.mutex_);
+
+    // 追い出すまでの間に再び取得されていれば何もしない
+    auto itr = instance.models_.find(key);
+    if (itr == instance.models_.end() || itr->second.refCount > 0) {
+        return;
+    }
+
+    // マテリアルの定数バッファとテクスチャの参照を手放す（テクスチャは他に使われていなければ、追い出せるキャッシュになる）
+    MaterialTable::Unregister(itr->second.model->material);
+
+    // このフレームまでのコマンドが参照している可能性があるので、GPUが使い終わってから解放する
+    instance.keys_.erase(itr->second.model.get());
+    instance.retiredModels_.push_back({ DirectXBase::GetInstance()->GetFenceValue() + 1, std::move(itr->second.model) });
+    instance.models_.erase(itr);
+}
+
+void ModelManager::Update()
+{
+    ModelManager& instance = GetInstance();
+    std::lock_guard<std::mutex> lock(instance.mutex_);
+
+    uint64_t completedFenceValue = DirectXBase::GetInstance()->GetCompletedFenceValue();
+    while (!instance.retiredModels_.empty() && instance.retiredModels_.front().fenceValue <= completedFenceValue) {
+        instance.retiredModels_.pop_front();
+    }
+}
+
+ModelManager& ModelManager::GetInstance()
+{
+    static ModelManager instance;
+
+    return instance;
+}
@@ -1,21 +1,32 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <d3d12.h>
 
 // MyClass
 #include "MyMath.h"
 #include "TextureManager.h"
-
-struct VertexData {
-	Float4 position;
-	Float2 texcoord;
-	Float3 normal;
-};
+#include "MaterialTable.h"
+#include "ResourceBudget.h"
+#include "Json.h"
+#include "ObjParser.h"
 
 struct MaterialData {
-	std::string textureFilePath;
-	uint32_t textureHandle;
+	std::string name; // newmtlで指定された名前
+	Float4 diffuseColor = { 1.0f, 1.0f, 1.0f, 1.0f }; // Kd（アルファはd）
+	Float3 specularColor = { 0.0f, 0.0f, 0.0f }; // Ks
+	float shininess = 0.0f; // Ns
+	std::string textureFilePath; // map_Kd
+	std::string specularTextureFilePath; // map_Ks
+	std::string normalTextureFilePath; // map_Bump / bump
+	std::string alphaTextureFilePath; // map_d
+	uint32_t textureHandle = 0;
+	// 同じ内容のマテリアルで共有する定数バッファ
+	ConstBuffer<Material>* materialCB = nullptr;
 };
 
 struct ModelData {
@@ -23,14 +34,74 @@ struct ModelData {
 	MaterialData material;
 	Microsoft::WRL::ComPtr<ID3D12Resource> vertexResource;
 	D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
+	// インデックス（ストリーミング読み込みの場合のみ使用する）
+	Microsoft::WRL::ComPtr<ID3D12Resource> indexResource;
+	D3D12_INDEX_BUFFER_VIEW indexBufferView{};
+	// 描画に使用する頂点数とインデックス数（インデックスが0の場合は非インデックス描画）
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+	// ローカル座標での境界の箱（ミップのストリーミングで画面上の大きさを求めるのに使う）
+	Float3 boundsMin = { 0.0f, 0.0f, 0.0f };
+	Float3 boundsMax = { 0.0f, 0.0f, 0.0f };
 };
 
 class ModelManager
 {
 public:
-	// Objファイルの読み込みを行う
-	static ModelData LoadObjFile(const std::string& directoryPath, const std::string& filename, ID3D12Device* device);
-	// mtlファイルの読み込みを行う
+	// Objファイルの読み込みを行う（reportを渡すとストリーミング読み込みと比べるためのメモリ使用量を書き込む）
+	static ModelData LoadObjFile(const std::string& directoryPath, const std::string& filename, ID3D12Device* device, ModelMemoryReport* report = nullptr);
+	// Objファイルをストリーミングで読み込む（同一頂点を溶接し、アップロードヒープへ直接書き込む）
+	// keepCpuCopyがfalseの場合はCPU側の頂点データを保持しない
+	static ModelData LoadObjFileStreaming(const std::string& directoryPath, const std::string& filename, ID3D12Device* device, bool keepCpuCopy = false, ModelMemoryReport* report = nullptr);
+	// glTFバイナリ（.glb）ファイルの読み込みを行う
+	static ModelData LoadGltfFile(const std::string& directoryPath, const std::string& filename, ID3D12Device* device);
+	// 拡張子に応じてObj（ストリーミング）かglTFバイナリで読み込む
+	static ModelData LoadModelFile(const std::string& directoryPath, const std::string& filename, ID3D12Device* device);
+	// mtlファイルの読み込みを行う（先頭のマテリアルを返す）
 	static MaterialData LoadMaterialTemplateFile(const std::string& directoryPath, const std::string& filename, ID3D12Device* device);
+	// mtlファイル内の全てのマテリアルを読み込み、マテリアルテーブルに登録する（使わないものはMaterialTable::Unregisterする）
+	static std::vector<MaterialData> LoadMaterialLibrary(const std::string& directoryPath, const std::string& filename, ID3D12Device* device);
+
+	// LoadModelFileで読み込んだモデルをキャッシュから取得する（同じファイルは共有し、参照カウントが増える）
+	static ModelData* Acquire(const std::string& directoryPath, const std::string& filename, ID3D12Device* device);
+	// 参照カウントを減らす。0になったモデルはキャッシュに残し、ResourceBudgetの予算を超えたら古い順に解放する
+	static void Release(ModelData* model);
+	// 追い出したモデルのうち、GPUが使い終わったものを解放する（フレームの区切りで呼ぶ）
+	static void Update();
+
+	static ModelManager& GetInstance();
+
+private:
+	// キャッシュしたモデル
+	struct CachedModel {
+		std::unique_ptr<ModelData> model;
+		uint32_t refCount = 0;
+		uint64_t cacheEntryId = ResourceBudget::kInvalidId; // 参照カウントが0の場合の、ResourceBudgetでのID
+	};
+	// GPUが使い終わるまで保持しておくモデル
+	struct RetiredModel {
+		uint64_t fenceValue;
+		std::unique_ptr<ModelData> model;
+	};
+
+	// 使われていないモデルをキャッシュから追い出す（ResourceBudgetから呼ばれる）
+	static void Evict(const std::string& key);
+
+	// Objのmtllibとusemtlから、モデルが使うマテリアルを読み込む
+	static MaterialData LoadObjMaterial(const std::string& directoryPath, const ObjMesh& mesh, ID3D12Device* device);
+	// LoadMaterialLibraryで登録したマテリアルのうち、usedMaterial以外の登録を取り消す
+	static void UnregisterUnusedMaterials(const std::vector<MaterialData>& materials, const MaterialData& usedMaterial);
+	// 境界の箱を頂点の位置まで広げる（最初の頂点の場合は箱をその位置にする）
+	static void ExpandBounds(ModelData& modelData, const Float4& position, bool isFirst);
+	// glTFのマテリアルをMaterialDataに変換する
+	static MaterialData LoadGltfMaterial(const JsonValue& gltf, int32_t materialIndex, const uint8_t* bin, size_t binSize, const std::string& directoryPath, const std::string& filename, ID3D12Device* device);
+
+	// "ディレクトリ/ファイル名"をキーにしたモデル
+	std::unordered_map<std::string, CachedModel> models_;
+	// モデルからキーを引く（Release用）
+	std::unordered_map<const ModelData*, std::string> keys_;
+	// 解放待ちのモデル
+	std::deque<RetiredModel> retiredModels_;
+	std::mutex mutex_;
 };
 
@@ -0,0 +1,214 @@
+#include "ObjParser.h"
+#include <algorithm>
+#include <charconv>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+	struct ObjVertexKeyHash {
+		size_t operator()(const ObjVertexKey& key) const
+		{
+			uint64_t hash = (uint64_t(key.position) << 32 | key.texcoord) * 0x9E3779B97F4A7C15ull;
+			return size_t(hash ^ (uint64_t(key.normal) * 0xC2B2AE3D27D4EB4Full));
+		}
+	};
+}
+
+bool ObjParser::Parse(std::istream& stream, ObjMesh& mesh)
+{
+	mesh = ObjMesh{};
+	std::string line; // ファイルから読んだ1行を格納するもの
+
+	while (std::getline(stream, line)) {
+		std::string identifier;
+		std::istringstream s(line);
+		s >> identifier; // 先頭の識別子を読む
+
+		if (identifier != "f") {
+			ParseElement(identifier, s, mesh);
+			continue;
+		}
+
+		VertexData triangle[3];
+		// 面は三角形限定。その他は未対応
+		for (int32_t faceVertex = 0; faceVertex < 3; ++faceVertex) {
+			std::string vertexDefinition;
+			s >> vertexDefinition;
+			ObjVertexKey key;
+			if (!ParseFaceVertex(vertexDefinition, mesh, key)) {
+				return false;
+			}
+			// 要素へのIndexから、実際の要素の値を取得して、頂点を構成する
+			triangle[faceVertex] = { mesh.positions[key.position], mesh.texcoords[key.texcoord], mesh.normals[key.normal] };
+		}
+		// 頂点を逆順に登録することで、回り順を逆にする
+		mesh.vertices.push_back(triangle[2]);
+		mesh.vertices.push_back(triangle[1]);
+		mesh.vertices.push_back(triangle[0]);
+	}
+	ComputeBounds(mesh);
+
+	// 展開した頂点は読み込み後もCPU側に残り続ける
+	mesh.memory.peakCpuBytes =
+		mesh.positions.capacity() * sizeof(Float4) +
+		mesh.texcoords.capacity() * sizeof(Float2) +
+		mesh.normals.capacity() * sizeof(Float3) +
+		mesh.vertices.capacity() * sizeof(VertexData);
+	mesh.memory.steadyCpuBytes = mesh.vertices.capacity() * sizeof(VertexData);
+	mesh.memory.gpuBytes = sizeof(VertexData) * mesh.vertices.size();
+	mesh.memory.expandedBytes = sizeof(VertexData) * mesh.vertices.size();
+	return true;
+}
+
+bool ObjParser::ParseWelded(std::istream& stream, ObjMesh& mesh)
+{
+	mesh = ObjMesh{};
+	std::unordered_map<ObjVertexKey, uint32_t, ObjVertexKeyHash> weldMap; // 要素のIndexの組から溶接後の頂点へのIndexを引く
+	std::string line; // ファイルから読んだ1行を格納するもの
+
+	// 1. 先に要素数だけを数えて、配列を必要な分だけ確保しておく
+	size_t positionCount = 0, texcoordCount = 0, normalCount = 0, faceCount = 0;
+	while (std::getline(stream, line)) {
+		if (line.starts_with("v ")) {
+			positionCount++;
+		} else if (line.starts_with("vt")) {
+			texcoordCount++;
+		} else if (line.starts_with("vn")) {
+			normalCount++;
+		} else if (line.starts_with("f ")) {
+			faceCount++;
+		}
+	}
+	mesh.positions.reserve(positionCount);
+	mesh.texcoords.reserve(texcoordCount);
+	mesh.normals.reserve(normalCount);
+	mesh.indices.reserve(faceCount * 3);
+	weldMap.reserve(faceCount * 3);
+
+	// 先頭に戻って読み直す
+	stream.clear();
+	stream.seekg(0);
+
+	// 2. 実際に読み、要素と溶接後のIndexを構築していく
+	while (std::getline(stream, line)) {
+		std::string identifier;
+		std::istringstream s(line);
+		s >> identifier; // 先頭の識別子を読む
+
+		if (identifier != "f") {
+			ParseElement(identifier, s, mesh);
+			continue;
+		}
+
+		uint32_t triangle[3];
+		// 面は三角形限定。その他は未対応
+		for (int32_t faceVertex = 0; faceVertex < 3; ++faceVertex) {
+			std::string vertexDefinition;
+			s >> vertexDefinition;
+			ObjVertexKey key;
+			if (!ParseFaceVertex(vertexDefinition, mesh, key)) {
+				return false;
+			}
+			// 同じ要素の組み合わせが既にあればその頂点を使い、なければ新しく頂点を追加する
+			auto [itr, inserted] = weldMap.try_emplace(key, uint32_t(mesh.vertexKeys.size()));
+			if (inserted) {
+				mesh.vertexKeys.push_back(key);
+			}
+			triangle[faceVertex] = itr->second;
+		}
+		// 頂点を逆順に登録することで、回り順を逆にする
+		mesh.indices.push_back(triangle[2]);
+		mesh.indices.push_back(triangle[1]);
+		mesh.indices.push_back(triangle[0]);
+	}
+	ComputeBounds(mesh);
+
+	// 3. 読み込み中に確保していたCPU側のメモリ量（ハッシュマップはノードとバケットの概算）
+	// 要素とIndexはアップロードヒープへ書き込んだら不要なので、読み込み後に残るものはない
+	mesh.memory.peakCpuBytes =
+		mesh.positions.capacity() * sizeof(Float4) +
+		mesh.texcoords.capacity() * sizeof(Float2) +
+		mesh.normals.capacity() * sizeof(Float3) +
+		mesh.vertexKeys.capacity() * sizeof(ObjVertexKey) +
+		mesh.indices.capacity() * sizeof(uint32_t) +
+		weldMap.bucket_count() * sizeof(void*) +
+		weldMap.size() * (sizeof(std::pair<const ObjVertexKey, uint32_t>) + sizeof(void*) * 2);
+	mesh.memory.steadyCpuBytes = 0;
+	mesh.memory.gpuBytes = sizeof(VertexData) * mesh.vertexKeys.size() + sizeof(uint32_t) * mesh.indices.size();
+	mesh.memory.expandedBytes = sizeof(VertexData) * mesh.indices.size();
+	return true;
+}
+
+void ObjParser::AssembleVertices(const ObjMesh& mesh, VertexData* destination)
+{
+	for (size_t i = 0; i < mesh.vertexKeys.size(); ++i) {
+		const ObjVertexKey& key = mesh.vertexKeys[i];
+		// 書き込み結合メモリに書き込む場合に備えて、読み戻さずに1頂点分をまとめて書き込む
+		destination[i] = { mesh.positions[key.position], mesh.texcoords[key.texcoord], mesh.normals[key.normal] };
+	}
+}
+
+bool ObjParser::ParseFaceVertex(const std::string& definition, ObjMesh& mesh, ObjVertexKey& key)
+{
+	// 頂点の要素へのIndexは「位置/UV/法線」で格納されているので、分解してIndexを取得する
+	uint32_t elementIndices[3] = {};
+	const size_t elementCounts[3] = { mesh.positions.size(), mesh.texcoords.size(), mesh.normals.size() };
+	const char* begin = definition.data();
+	const char* end = definition.data() + definition.size();
+	for (int32_t element = 0; element < 3; ++element) {
+		auto [next, result] = std::from_chars(begin, end, elementIndices[element]);
+		// Indexは1始まりで、その行までに定義された要素を指す（負の相対Indexと要素の省略は未対応）
+		if (result != std::errc() || elementIndices[element] == 0 || elementIndices[element] > elementCounts[element]) {
+			mesh.error = "invalid face vertex \"" + definition + "\"";
+			return false;
+		}
+		begin = (next != end && *next == '/') ? next + 1 : next;
+	}
+	key = { elementIndices[0] - 1, elementIndices[1] - 1, elementIndices[2] - 1 };
+	return true;
+}
+
+bool ObjParser::ParseElement(const std::string& identifier, std::istream& s, ObjMesh& mesh)
+{
+	if (identifier == "v") {
+		Float4 position;
+		s >> position.x >> position.y >> position.z;
+		position.x *= -1.0f; // 位置のxを反転
+		position.w = 1.0f;
+		mesh.positions.push_back(position);
+	} else if (identifier == "vt") {
+		Float2 texcoord;
+		s >> texcoord.x >> texcoord.y;
+		texcoord.y = 1.0f - texcoord.y; // テクスチャが上下反転しないようにする
+		mesh.texcoords.push_back(texcoord);
+	} else if (identifier == "vn") {
+		Float3 normal;
+		s >> normal.x >> normal.y >> normal.z;
+		normal.x *= -1.0f; // 法線のxを反転
+		mesh.normals.push_back(normal);
+	} else if (identifier == "mtllib") {
+		// マテリアルの読み込みはデバイスが必要なので、ファイル名だけを記録する
+		s >> mesh.materialLibrary;
+	} else if (identifier == "usemtl") {
+		std::string materialName;
+		s >> materialName;
+		mesh.materialNames.push_back(materialName);
+	} else {
+		return false;
+	}
+	return true;
+}
+
+void ObjParser::ComputeBounds(ObjMesh& mesh)
+{
+	for (size_t i = 0; i < mesh.positions.size(); ++i) {
+		const Float4& position = mesh.positions[i];
+		if (i == 0) {
+			mesh.boundsMin = { position.x, position.y, position.z };
+			mesh.boundsMax = { position.x, position.y, position.z };
+			continue;
+		}
+		mesh.boundsMin = { (std::min)(mesh.boundsMin.x, position.x), (std::min)(mesh.boundsMin.y, position.y), (std::min)(mesh.boundsMin.z, position.z) };
+		mesh.boundsMax = { (std::max)(mesh.boundsMax.x, position.x), (std::max)(mesh.boundsMax.y, position.y), (std::max)(mesh.boundsMax.z, position.z) };
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+// MyClass
+#include "Float2.h"
+#include "Float3.h"
+#include "Float4.h"
+
+struct VertexData {
+	Float4 position;
+	Float2 texcoord;
+	Float3 normal;
+};
+
+// モデル読み込み時のメモリ使用量
+struct ModelMemoryReport {
+	size_t peakCpuBytes = 0; // 読み込み中のCPU側のピーク
+	size_t steadyCpuBytes = 0; // 読み込み後もCPU側に残り続けるサイズ
+	size_t gpuBytes = 0; // アップロードヒープに確保したサイズ
+	size_t expandedBytes = 0; // 通常の読み込みで展開した場合の頂点データのサイズ（比較用）
+};
+
+// 溶接後の頂点を構成する要素のIndex（0始まり。要素ごとに32bitなので要素数の上限はない）
+struct ObjVertexKey {
+	uint32_t position;
+	uint32_t texcoord;
+	uint32_t normal;
+
+	bool operator==(const ObjVertexKey& other) const = default;
+};
+
+// Objファイルを読み込んだ結果（座標系の変換済み。GPUのリソースには依存しない）
+struct ObjMesh {
+	// 要素
+	std::vector<Float4> positions;
+	std::vector<Float2> texcoords;
+	std::vector<Float3> normals;
+	// 展開した頂点（溶接しない場合のみ。3頂点ごとに1つの三角形）
+	std::vector<VertexData> vertices;
+	// 溶接後の頂点を構成する要素のIndexと、溶接後の頂点へのIndex（溶接する場合のみ）
+	std::vector<ObjVertexKey> vertexKeys;
+	std::vector<uint32_t> indices;
+	// mtllibで指定されたファイル名（最後に指定されたもの）と、usemtlで指定された名前（指定された順）
+	std::string materialLibrary;
+	std::vector<std::string> materialNames;
+	// ローカル座標での境界の箱
+	Float3 boundsMin = { 0.0f, 0.0f, 0.0f };
+	Float3 boundsMax = { 0.0f, 0.0f, 0.0f };
+	// 読み込み中と読み込み後のCPU側のメモリ使用量と、アップロードするサイズ
+	ModelMemoryReport memory;
+	// 読み込めなかった理由
+	std::string error;
+};
+
+// Objファイルの面と要素を読み込み、右手系から左手系へ変換する（xの反転、回り順の入れ替え、UVの上下反転）
+// 面は「位置/UV/法線」を全て持つ三角形のみ対応
+class ObjParser
+{
+public:
+	// 三角形ごとに頂点を展開して読み込む
+	static bool Parse(std::istream& stream, ObjMesh& mesh);
+	// 同じ要素の組み合わせの頂点を溶接して読み込む（要素数を数えてから確保するため、streamを2回読む）
+	static bool ParseWelded(std::istream& stream, ObjMesh& mesh);
+	// 溶接した頂点を要素から組み立てて、destinationへmesh.vertexKeys.size()個書き込む
+	static void AssembleVertices(const ObjMesh& mesh, VertexData* destination);
+
+private:
+	// 面の1頂点（"位置/UV/法線"）を要素のIndexに分解し、範囲を確認する（範囲外の場合はmesh.errorに理由を書き込む）
+	static bool ParseFaceVertex(const std::string& definition, ObjMesh& mesh, ObjVertexKey& key);
+	// 面以外の行を読み込む（読み込んだ場合はtrue）
+	static bool ParseElement(const std::string& identifier, std::istream& s, ObjMesh& mesh);
+	// 位置から境界の箱を求める
+	static void ComputeBounds(ObjMesh& mesh);
+};
@@ -0,0 +1,134 @@
+#include "AtlasPacker.h"
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+void AtlasPacker::Initialize(uint32_t width, uint32_t height)
+{
+	width_ = width;
+	height_ = height;
+	usedArea_ = 0;
+	// 最初は底辺全体が1本の線分
+	skyline_.assign(1, { 0, 0, width });
+}
+
+bool AtlasPacker::Insert(uint32_t width, uint32_t height, Rect& rect)
+{
+	// 置いた後の上端が最も低い場所を選ぶ（同じ場合は線分の幅が狭い方、さらに左の方）
+	size_t bestIndex = SIZE_MAX;
+	uint32_t bestTop = UINT32_MAX;
+	uint32_t bestWidth = UINT32_MAX;
+	uint32_t bestY = 0;
+	for (size_t i = 0; i < skyline_.size(); ++i) {
+		uint32_t y = 0;
+		if (!Fit(i, width, height, y)) {
+			continue;
+		}
+		uint32_t top = y + height;
+		if (top < bestTop || (top == bestTop && skyline_[i].width < bestWidth)) {
+			bestIndex = i;
+			bestTop = top;
+			bestWidth = skyline_[i].width;
+			bestY = y;
+		}
+	}
+	if (bestIndex == SIZE_MAX) {
+		return false;
+	}
+	rect = { skyline_[bestIndex].x, bestY, width, height };
+
+	// 置いた矩形の上端を新しい線分として挿入する
+	skyline_.insert(skyline_.begin() + bestIndex, { rect.x, bestTop, width });
+
+	// 新しい線分の下に隠れた線分を削る
+	uint32_t right = rect.x + width;
+	for (size_t i = bestIndex + 1; i < skyline_.size();) {
+		SkylineNode& node = skyline_[i];
+		if (node.x >= right) {
+			break;
+		}
+		uint32_t nodeRight = node.x + node.width;
+		if (nodeRight <= right) {
+			skyline_.erase(skyline_.begin() + i);
+			continue;
+		}
+		node.width = nodeRight - right;
+		node.x = right;
+		break;
+	}
+
+	// 同じ高さで隣り合う線分をまとめる
+	for (size_t i = 0; i + 1 < skyline_.size();) {
+		if (skyline_[i].y == skyline_[i + 1].y) {
+			skyline_[i].width += skyline_[i + 1].width;
+			skyline_.erase(skyline_.begin() + i + 1);
+		} else {
+			++i;
+		}
+	}
+
+	usedArea_ += uint64_t(width) * height;
+	return true;
+}
+
+bool AtlasPacker::Fit(size_t index, uint32_t width, uint32_t height, uint32_t& y) const
+{
+	uint32_t x = skyline_[index].x;
+	if (x + width > width_) {
+		return false;
+	}
+
+	// 矩形の幅にかかる線分のうち最も高いものの上に置く
+	y = 0;
+	uint32_t remainingWidth = width;
+	for (size_t i = index; remainingWidth > 0; ++i) {
+		assert(i < skyline_.size());
+		y = (std::max)(y, skyline_[i].y);
+		if (y + height > height_) {
+			return false;
+		}
+		remainingWidth -= (std::min)(remainingWidth, skyline_[i].width);
+	}
+	return true;
+}
+
+std::vector<AtlasPacker::Placement> AtlasPacker::PackPages(const std::vector<std::pair<uint32_t, uint32_t>>& sizes, uint32_t pageWidth, uint32_t pageHeight, uint32_t* pageCount)
+{
+	// 高さ、幅の順に大きいものから置く（同じ大きさなら入力の順）
+	std::vector<size_t> order(sizes.size());
+	std::iota(order.begin(), order.end(), size_t(0));
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		if (sizes[a].second != sizes[b].second) {
+			return sizes[a].second > sizes[b].second;
+		}
+		return sizes[a].first > sizes[b].first;
+	});
+
+	std::vector<Placement> placements(sizes.size(), { kInvalidPage, { 0, 0, 0, 0 } });
+	std::vector<AtlasPacker> pages;
+	for (size_t index : order) {
+		auto [width, height] = sizes[index];
+		if (width > pageWidth || height > pageHeight) {
+			continue;
+		}
+
+		// 前のページから順に空きを探し、どこにも入らなければページを増やす
+		Placement& placement = placements[index];
+		for (uint32_t page = 0; page < pages.size() && placement.page == kInvalidPage; ++page) {
+			if (pages[page].Insert(width, height, placement.rect)) {
+				placement.page = page;
+			}
+		}
+		if (placement.page == kInvalidPage) {
+			pages.emplace_back();
+			pages.back().Initialize(pageWidth, pageHeight);
+			pages.back().Insert(width, height, placement.rect);
+			placement.page = uint32_t(pages.size() - 1);
+		}
+	}
+
+	if (pageCount) {
+		*pageCount = uint32_t(pages.size());
+	}
+	return placements;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// 矩形をページに詰める（スカイライン法のBottom-Left。同じ入力には常に同じ配置を返し、GPUのリソースには依存しない）
+class AtlasPacker
+{
+public:
+	// ページに収まらない矩形のページ番号
+	static const uint32_t kInvalidPage = UINT32_MAX;
+
+	struct Rect {
+		uint32_t x;
+		uint32_t y;
+		uint32_t width;
+		uint32_t height;
+	};
+
+	// 複数のページに詰めた結果の1つの矩形
+	struct Placement {
+		uint32_t page;
+		Rect rect;
+	};
+
+	void Initialize(uint32_t width, uint32_t height);
+
+	// 矩形を置く場所を探して置く（場所が無ければfalseを返す）
+	bool Insert(uint32_t width, uint32_t height, Rect& rect);
+
+	// 置いた矩形の面積の合計
+	uint64_t GetUsedArea() const { return usedArea_; }
+	// ページの面積に対する使用率
+	float GetOccupancy() const { return float(double(usedArea_) / (double(width_) * double(height_))); }
+
+	// 全ての矩形を、必要なだけページを増やして詰める（結果は入力の順。大きい矩形から順に置くので、入力の順序には依存しない）
+	static std::vector<Placement> PackPages(const std::vector<std::pair<uint32_t, uint32_t>>& sizes, uint32_t pageWidth, uint32_t pageHeight, uint32_t* pageCount = nullptr);
+
+private:
+	// スカイラインの水平な線分（xからwidthの範囲の高さがy）
+	struct SkylineNode {
+		uint32_t x;
+		uint32_t y;
+		uint32_t width;
+	};
+
+	// indexの線分の左端に置いた場合の高さを求める（はみ出す場合はfalse）
+	bool Fit(size_t index, uint32_t width, uint32_t height, uint32_t& y) const;
+
+	uint32_t width_ = 0;
+	uint32_t height_ = 0;
+	uint64_t usedArea_ = 0;
+	std::vector<SkylineNode> skyline_;
+};
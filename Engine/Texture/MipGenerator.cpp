@@ -0,0 +1,378 @@
+#include "MipGenerator.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+// MyClass
+#include "ParallelFor.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define MIP_GENERATOR_USE_SSE
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+// AVXはコンパイラが対応していれば実行時に判定して使う
+#if defined(__AVX__) || defined(_MSC_VER)
+#define MIP_GENERATOR_USE_AVX
+#endif
+#endif
+
+namespace {
+	// 1つの出力に使う入力と重み
+	struct FilterTap {
+		uint32_t index;
+		float weight;
+	};
+	// 出力の各要素のタップ（offsets[i]からoffsets[i + 1]までがi番目の出力のタップ）
+	struct FilterTable {
+		std::vector<uint32_t> offsets;
+		std::vector<FilterTap> taps;
+		// ボックスフィルタでちょうど半分にする場合（隣り合う2つの平均なので、タップを使わずに計算する）
+		bool isHalfBox = false;
+	};
+
+	// 並列化の単位にする行数
+	const uint32_t kRowsPerTask = 16;
+
+	// sRGBからリニアへの変換テーブル
+	const std::array<float, 256>& GetSrgbToLinearTable()
+	{
+		static const std::array<float, 256> table = []() {
+			std::array<float, 256> result{};
+			for (uint32_t i = 0; i < 256; ++i) {
+				float value = float(i) / 255.0f;
+				result[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+			}
+			return result;
+		}();
+		return table;
+	}
+
+	// リニアからsRGBへの変換テーブル（最も近い値に丸めるため、隣り合う値の中間点をリニアで持つ）
+	struct LinearToSrgbTable {
+		static const uint32_t kIndexCount = 4096;
+		// thresholds[i]以上であればi + 1以上になる
+		std::array<float, 255> thresholds;
+		// リニアを12bitにした値から、それ以下の最大の候補
+		std::array<uint8_t, kIndexCount + 1> starts;
+	};
+	const LinearToSrgbTable& GetLinearToSrgbTable()
+	{
+		static const LinearToSrgbTable table = []() {
+			LinearToSrgbTable result{};
+			for (uint32_t i = 0; i < 255; ++i) {
+				double srgb = (double(i) + 0.5) / 255.0;
+				result.thresholds[i] = float(srgb <= 0.04045 ? srgb / 12.92 : std::pow((srgb + 0.055) / 1.055, 2.4));
+			}
+			uint32_t code = 0;
+			for (uint32_t index = 0; index <= LinearToSrgbTable::kIndexCount; ++index) {
+				float value = float(index) / float(LinearToSrgbTable::kIndexCount);
+				while (code < 255 && result.thresholds[code] <= value) {
+					code++;
+				}
+				result.starts[index] = uint8_t(code);
+			}
+			return result;
+		}();
+		return table;
+	}
+
+	float Sinc(float x)
+	{
+		const float kPi = 3.14159265358979f;
+		if (std::abs(x) < 1e-6f) {
+			return 1.0f;
+		}
+		return std::sin(kPi * x) / (kPi * x);
+	}
+
+	// 第1種変形ベッセル関数（カイザー窓用）
+	float BesselI0(float x)
+	{
+		float sum = 1.0f;
+		float term = 1.0f;
+		for (int k = 1; k < 20; ++k) {
+			term *= (x / (2.0f * float(k))) * (x / (2.0f * float(k)));
+			sum += term;
+		}
+		return sum;
+	}
+
+	// 入力sourceSize個を出力destinationSize個に縮小するタップを作る
+	FilterTable CreateFilterTable(uint32_t sourceSize, uint32_t destinationSize, MipFilter filter)
+	{
+		FilterTable table;
+		table.offsets.reserve(destinationSize + 1);
+		float scale = float(sourceSize) / float(destinationSize);
+		table.isHalfBox = filter == MipFilter::Box && sourceSize == destinationSize * 2;
+
+		for (uint32_t i = 0; i < destinationSize; ++i) {
+			table.offsets.push_back(uint32_t(table.taps.size()));
+			size_t first = table.taps.size();
+			float weightSum = 0.0f;
+
+			if (filter == MipFilter::Box || sourceSize == 1) {
+				// 出力の1ピクセルが覆う入力の範囲を、重なる面積で平均する
+				float begin = float(i) * scale;
+				float end = begin + scale;
+				for (uint32_t s = uint32_t(begin); s < sourceSize && float(s) < end; ++s) {
+					float weight = (std::min)(end, float(s + 1)) - (std::max)(begin, float(s));
+					if (weight > 0.0f) {
+						table.taps.push_back({ s, weight });
+						weightSum += weight;
+					}
+				}
+			} else {
+				// 出力の間隔で3ピクセル分の幅のカイザー窓のsinc（端は端のピクセルを繰り返す）
+				const float kRadius = 3.0f;
+				const float kAlpha = 4.0f;
+				float center = (float(i) + 0.5f) * scale;
+				float radius = kRadius * scale;
+				int32_t begin = int32_t(std::floor(center - radius));
+				int32_t end = int32_t(std::ceil(center + radius));
+				for (int32_t s = begin; s <= end; ++s) {
+					float x = (float(s) + 0.5f - center) / scale;
+					if (std::abs(x) >= kRadius) {
+						continue;
+					}
+					float ratio = x / kRadius;
+					float weight = Sinc(x) * BesselI0(kAlpha * std::sqrt(1.0f - ratio * ratio)) / BesselI0(kAlpha);
+					uint32_t index = uint32_t((std::clamp)(s, 0, int32_t(sourceSize) - 1));
+					// 同じ入力を指すタップはまとめる
+					if (table.taps.size() > first && table.taps.back().index == index) {
+						table.taps.back().weight += weight;
+					} else {
+						table.taps.push_back({ index, weight });
+					}
+					weightSum += weight;
+				}
+			}
+
+			// 重みの合計を1にする
+			for (size_t t = first; t < table.taps.size(); ++t) {
+				table.taps[t].weight /= weightSum;
+			}
+		}
+		table.offsets.push_back(uint32_t(table.taps.size()));
+		return table;
+	}
+
+#ifdef MIP_GENERATOR_USE_AVX
+	// AVXを実行時に使えるか
+	bool IsAvxSupported()
+	{
+#if defined(__AVX__)
+		return true;
+#elif defined(_MSC_VER)
+		static const bool isSupported = []() {
+			int info[4] = {};
+			__cpuid(info, 1);
+			bool hasAvx = (info[2] & (1 << 28)) != 0;
+			bool hasOsxsave = (info[2] & (1 << 27)) != 0;
+			// OSがYMMレジスタを保存するか
+			return hasAvx && hasOsxsave && (_xgetbv(0) & 0x6) == 0x6;
+		}();
+		return isSupported;
+#else
+		return false;
+#endif
+	}
+#endif
+
+	// 横方向に縮小する（1ピクセルがRGBAの4つのfloat）
+	void FilterRow(const float* source, float* destination, const FilterTable& table, uint32_t destinationWidth)
+	{
+		if (table.isHalfBox) {
+			for (uint32_t x = 0; x < destinationWidth; ++x) {
+#ifdef MIP_GENERATOR_USE_SSE
+				__m128 sum = _mm_add_ps(_mm_loadu_ps(source + size_t(x) * 8), _mm_loadu_ps(source + size_t(x) * 8 + 4));
+				_mm_storeu_ps(destination + size_t(x) * 4, _mm_mul_ps(sum, _mm_set1_ps(0.5f)));
+#else
+				for (uint32_t c = 0; c < 4; ++c) {
+					destination[x * 4 + c] = (source[x * 8 + c] + source[x * 8 + 4 + c]) * 0.5f;
+				}
+#endif
+			}
+			return;
+		}
+
+		for (uint32_t x = 0; x < destinationWidth; ++x) {
+#ifdef MIP_GENERATOR_USE_SSE
+			__m128 sum = _mm_setzero_ps();
+			for (uint32_t t = table.offsets[x]; t < table.offsets[x + 1]; ++t) {
+				const FilterTap& tap = table.taps[t];
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(source + size_t(tap.index) * 4), _mm_set1_ps(tap.weight)));
+			}
+			_mm_storeu_ps(destination + size_t(x) * 4, sum);
+#else
+			float sum[4] = {};
+			for (uint32_t t = table.offsets[x]; t < table.offsets[x + 1]; ++t) {
+				const FilterTap& tap = table.taps[t];
+				for (uint32_t c = 0; c < 4; ++c) {
+					sum[c] += source[size_t(tap.index) * 4 + c] * tap.weight;
+				}
+			}
+			std::memcpy(destination + size_t(x) * 4, sum, sizeof(sum));
+#endif
+		}
+	}
+
+	// destinationに、sourceの1行をweight倍して加える（countはfloatの数）
+#ifdef MIP_GENERATOR_USE_AVX
+	void AccumulateRowAvx(const float* source, float* destination, float weight, size_t count)
+	{
+		__m256 weights = _mm256_set1_ps(weight);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m256 sum = _mm256_add_ps(_mm256_loadu_ps(destination + i), _mm256_mul_ps(_mm256_loadu_ps(source + i), weights));
+			_mm256_storeu_ps(destination + i, sum);
+		}
+		for (; i < count; ++i) {
+			destination[i] += source[i] * weight;
+		}
+	}
+#endif
+	void AccumulateRow(const float* source, float* destination, float weight, size_t count)
+	{
+#ifdef MIP_GENERATOR_USE_AVX
+		if (IsAvxSupported()) {
+			AccumulateRowAvx(source, destination, weight, count);
+			return;
+		}
+#endif
+		size_t i = 0;
+#ifdef MIP_GENERATOR_USE_SSE
+		__m128 weights = _mm_set1_ps(weight);
+		for (; i + 4 <= count; i += 4) {
+			_mm_storeu_ps(destination + i, _mm_add_ps(_mm_loadu_ps(destination + i), _mm_mul_ps(_mm_loadu_ps(source + i), weights)));
+		}
+#endif
+		for (; i < count; ++i) {
+			destination[i] += source[i] * weight;
+		}
+	}
+
+	// リニアのRGBAをsRGBのRGBA8にする
+	void EncodeRow(const float* source, uint8_t* destination, uint32_t width)
+	{
+		for (uint32_t x = 0; x < width; ++x) {
+			for (uint32_t c = 0; c < 3; ++c) {
+				destination[x * 4 + c] = MipGenerator::LinearToSrgb(source[x * 4 + c]);
+			}
+			float alpha = (std::clamp)(source[x * 4 + 3], 0.0f, 1.0f);
+			destination[x * 4 + 3] = uint8_t(alpha * 255.0f + 0.5f);
+		}
+	}
+}
+
+std::vector<MipLevel> MipGenerator::Generate(const uint8_t* pixels, uint32_t width, uint32_t height, size_t rowPitch, MipFilter filter, uint32_t threadCount, uint32_t mipLevels)
+{
+	assert(width > 0 && height > 0);
+	uint32_t fullMipLevels = ComputeMipLevels(width, height);
+	mipLevels = mipLevels == 0 ? fullMipLevels : (std::min)(mipLevels, fullMipLevels);
+
+	std::vector<MipLevel> levels(mipLevels);
+	levels[0].width = width;
+	levels[0].height = height;
+	levels[0].pixels.resize(size_t(width) * height * 4);
+
+	// ミップ0は元の画像をコピーする
+	const std::array<float, 256>& srgbToLinear = GetSrgbToLinearTable();
+	for (uint32_t y = 0; y < height; ++y) {
+		std::memcpy(levels[0].pixels.data() + size_t(y) * width * 4, pixels + y * rowPitch, size_t(width) * 4);
+	}
+
+	// 前のミップから次のミップを作る（前のミップはリニアのfloatで持つ）
+	std::vector<float> current;
+	std::vector<float> next;
+	for (uint32_t mip = 1; mip < mipLevels; ++mip) {
+		uint32_t sourceWidth = levels[mip - 1].width;
+		uint32_t sourceHeight = levels[mip - 1].height;
+		uint32_t destinationWidth = (std::max)(sourceWidth / 2, 1u);
+		uint32_t destinationHeight = (std::max)(sourceHeight / 2, 1u);
+		FilterTable horizontalTable = CreateFilterTable(sourceWidth, destinationWidth, filter);
+		FilterTable verticalTable = CreateFilterTable(sourceHeight, destinationHeight, filter);
+
+		MipLevel& level = levels[mip];
+		level.width = destinationWidth;
+		level.height = destinationHeight;
+		level.pixels.resize(size_t(destinationWidth) * destinationHeight * 4);
+		next.resize(size_t(destinationWidth) * destinationHeight * 4);
+		size_t rowFloatCount = size_t(destinationWidth) * 4;
+
+		// 出力の行をまとめて分担し、必要な入力の行だけを横に縮小してから縦に縮小する（中間のバッファを小さく保つ）
+		uint32_t taskCount = (destinationHeight + kRowsPerTask - 1) / kRowsPerTask;
+		ParallelFor(taskCount, threadCount, [&](size_t task) {
+			uint32_t rowBegin = uint32_t(task) * kRowsPerTask;
+			uint32_t rowEnd = (std::min)(rowBegin + kRowsPerTask, destinationHeight);
+			// タップの入力の行は出力の行の順に並んでいる
+			uint32_t sourceBegin = verticalTable.taps[verticalTable.offsets[rowBegin]].index;
+			uint32_t sourceEnd = verticalTable.taps[verticalTable.offsets[rowEnd] - 1].index + 1;
+
+			// 横方向の縮小（ミップ0は1行ずつリニアに変換しながら読む）
+			std::vector<float> filteredRows(size_t(sourceEnd - sourceBegin) * rowFloatCount);
+			std::vector<float> linearRow(mip == 1 ? size_t(sourceWidth) * 4 : 0);
+			for (uint32_t y = sourceBegin; y < sourceEnd; ++y) {
+				const float* sourceRow = nullptr;
+				if (mip == 1) {
+					const uint8_t* pixelRow = pixels + y * rowPitch;
+					for (uint32_t x = 0; x < sourceWidth; ++x) {
+						linearRow[x * 4 + 0] = srgbToLinear[pixelRow[x * 4 + 0]];
+						linearRow[x * 4 + 1] = srgbToLinear[pixelRow[x * 4 + 1]];
+						linearRow[x * 4 + 2] = srgbToLinear[pixelRow[x * 4 + 2]];
+						linearRow[x * 4 + 3] = float(pixelRow[x * 4 + 3]) / 255.0f;
+					}
+					sourceRow = linearRow.data();
+				} else {
+					sourceRow = current.data() + size_t(y) * sourceWidth * 4;
+				}
+				FilterRow(sourceRow, filteredRows.data() + (y - sourceBegin) * rowFloatCount, horizontalTable, destinationWidth);
+			}
+
+			// 縦方向は行単位で重みを掛けて足し、sRGBに戻す
+			for (uint32_t y = rowBegin; y < rowEnd; ++y) {
+				float* destinationRow = next.data() + y * rowFloatCount;
+				std::fill(destinationRow, destinationRow + rowFloatCount, 0.0f);
+				for (uint32_t t = verticalTable.offsets[y]; t < verticalTable.offsets[y + 1]; ++t) {
+					const FilterTap& tap = verticalTable.taps[t];
+					AccumulateRow(filteredRows.data() + (tap.index - sourceBegin) * rowFloatCount, destinationRow, tap.weight, rowFloatCount);
+				}
+				EncodeRow(destinationRow, level.pixels.data() + y * rowFloatCount, destinationWidth);
+			}
+		});
+		current.swap(next);
+	}
+
+	return levels;
+}
+
+uint32_t MipGenerator::ComputeMipLevels(uint32_t width, uint32_t height)
+{
+	uint32_t mipLevels = 1;
+	while (width > 1 || height > 1) {
+		width = (std::max)(width / 2, 1u);
+		height = (std::max)(height / 2, 1u);
+		mipLevels++;
+	}
+	return mipLevels;
+}
+
+float MipGenerator::SrgbToLinear(uint8_t value)
+{
+	return GetSrgbToLinearTable()[value];
+}
+
+uint8_t MipGenerator::LinearToSrgb(float value)
+{
+	const LinearToSrgbTable& table = GetLinearToSrgbTable();
+	value = (std::clamp)(value, 0.0f, 1.0f);
+	// テーブルで候補を求め、中間点と比べて最も近い値にする（12bitの区間に入る中間点は高々数個）
+	uint32_t code = table.starts[uint32_t(value * float(LinearToSrgbTable::kIndexCount))];
+	while (code < 255 && table.thresholds[code] <= value) {
+		code++;
+	}
+	return uint8_t(code);
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ミップマップの縮小に使うフィルタ
+enum class MipFilter {
+	Box, // 面積の平均（2のべき乗のサイズでは2x2の平均）
+	Kaiser, // カイザー窓のsinc（ぼけにくいが遅い）
+};
+
+// RGBA8（sRGB）の1枚の画像（行のピッチはwidth * 4）
+struct MipLevel {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<uint8_t> pixels;
+};
+
+// RGBA8（sRGB）の画像からミップマップを生成する（DirectXTexに依存せず、SSE/AVXがあれば使う）
+// 色はテーブルでリニアに変換してから縮小し、アルファはそのまま縮小する
+class MipGenerator
+{
+public:
+	// ミップ0（元の画像のコピー）から1x1までの全ミップを生成する（mipLevelsが0の場合は全て。threadCountが0の場合はハードウェアのスレッド数）
+	static std::vector<MipLevel> Generate(const uint8_t* pixels, uint32_t width, uint32_t height, size_t rowPitch, MipFilter filter, uint32_t threadCount = 0, uint32_t mipLevels = 0);
+
+	// 1x1までのミップの数
+	static uint32_t ComputeMipLevels(uint32_t width, uint32_t height);
+
+	// sRGBの値（0～255）をリニア（0～1）に変換する
+	static float SrgbToLinear(uint8_t value);
+	// リニア（0～1）をsRGBの値（0～255）に変換する（最も近い値に丸める）
+	static uint8_t LinearToSrgb(float value);
+};
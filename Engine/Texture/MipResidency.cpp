@@ -0,0 +1,168 @@
+#include "MipResidency.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+uint32_t MipResidency::AddTexture(const StreamedTextureInfo& info)
+{
+	assert(!info.mipSizes.empty() && info.minResidentMip < info.mipSizes.size());
+
+	// 削除されたIDがあれば再利用する
+	uint32_t textureId = 0;
+	if (!freeIds_.empty()) {
+		textureId = freeIds_.back();
+		freeIds_.pop_back();
+	} else {
+		textureId = uint32_t(textures_.size());
+		textures_.emplace_back();
+	}
+
+	// 最初は常に常駐させるミップだけが常駐している
+	TextureState& texture = textures_[textureId];
+	texture = TextureState{};
+	texture.info = info;
+	texture.isUsed = true;
+	texture.residentMip = info.minResidentMip;
+	texture.lastUsedFrame = frame_;
+	for (uint32_t mip = info.minResidentMip; mip < info.mipSizes.size(); ++mip) {
+		residentBytes_ += info.mipSizes[mip];
+	}
+
+	return textureId;
+}
+
+void MipResidency::RemoveTexture(uint32_t textureId)
+{
+	TextureState& texture = textures_[textureId];
+	assert(texture.isUsed);
+	for (uint32_t mip = texture.residentMip; mip < texture.info.mipSizes.size(); ++mip) {
+		residentBytes_ -= texture.info.mipSizes[mip];
+	}
+	texture = TextureState{};
+	freeIds_.push_back(textureId);
+}
+
+void MipResidency::Update(const MipCamera& camera, const std::vector<MipUsage>& usages)
+{
+	frame_++;
+	changes_.clear();
+
+	// 使われていなければ、常に常駐させるミップだけでよい
+	for (TextureState& texture : textures_) {
+		texture.desiredMip = texture.info.minResidentMip;
+		texture.priority = 0.0f;
+	}
+
+	// 画面上で最も大きく映っている使われ方から、必要なミップと優先度を決める
+	for (const MipUsage& usage : usages) {
+		if (usage.textureId >= textures_.size() || !textures_[usage.textureId].isUsed) {
+			continue;
+		}
+		TextureState& texture = textures_[usage.textureId];
+		float projectedPixels = ComputeProjectedPixels(camera, usage.center, usage.radius);
+		uint32_t desiredMip = ComputeDesiredMip(texture.info.width, texture.info.height, uint32_t(texture.info.mipSizes.size()), projectedPixels);
+		texture.desiredMip = (std::min)(texture.desiredMip, desiredMip);
+		texture.priority = (std::max)(texture.priority, projectedPixels);
+		texture.lastUsedFrame = frame_;
+	}
+
+	// 常に常駐させるミップを除いた残りの予算
+	uint64_t baseBytes = residentBytes_;
+	for (const TextureState& texture : textures_) {
+		if (texture.isUsed) {
+			baseBytes -= ComputeStreamedBytes(texture, texture.residentMip);
+		}
+	}
+	uint64_t remainingBytes = budgetBytes_ > baseBytes ? budgetBytes_ - baseBytes : 0;
+
+	std::vector<uint32_t> targetMips(textures_.size());
+	std::vector<uint32_t> order;
+	order.reserve(textures_.size());
+	for (uint32_t id = 0; id < textures_.size(); ++id) {
+		targetMips[id] = textures_[id].info.minResidentMip;
+		if (textures_[id].isUsed) {
+			order.push_back(id);
+		}
+	}
+
+	// 1. 画面上で大きく映っているTextureから順に、必要なミップまで予算を割り当てる
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		if (textures_[a].priority != textures_[b].priority) {
+			return textures_[a].priority > textures_[b].priority;
+		}
+		return a < b;
+	});
+	for (uint32_t id : order) {
+		const TextureState& texture = textures_[id];
+		while (targetMips[id] > texture.desiredMip && texture.info.mipSizes[targetMips[id] - 1] <= remainingBytes) {
+			remainingBytes -= texture.info.mipSizes[targetMips[id] - 1];
+			targetMips[id]--;
+		}
+	}
+
+	// 2. 予算が余っていれば、最近使ったTextureから順に既に常駐しているミップを残す（余らなければ追い出される）
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		if (textures_[a].lastUsedFrame != textures_[b].lastUsedFrame) {
+			return textures_[a].lastUsedFrame > textures_[b].lastUsedFrame;
+		}
+		return a < b;
+	});
+	for (uint32_t id : order) {
+		const TextureState& texture = textures_[id];
+		while (targetMips[id] > texture.residentMip && texture.info.mipSizes[targetMips[id] - 1] <= remainingBytes) {
+			remainingBytes -= texture.info.mipSizes[targetMips[id] - 1];
+			targetMips[id]--;
+		}
+	}
+
+	// 変化を記録する
+	residentBytes_ = baseBytes;
+	for (uint32_t id : order) {
+		TextureState& texture = textures_[id];
+		if (targetMips[id] != texture.residentMip) {
+			changes_.push_back({ id, texture.residentMip, targetMips[id] });
+			texture.residentMip = targetMips[id];
+		}
+		residentBytes_ += ComputeStreamedBytes(texture, texture.residentMip);
+	}
+	// 変化はIDの順に並べる
+	std::sort(changes_.begin(), changes_.end(), [](const MipResidencyChange& a, const MipResidencyChange& b) { return a.textureId < b.textureId; });
+}
+
+uint32_t MipResidency::ComputeDesiredMip(uint32_t width, uint32_t height, uint32_t mipLevels, float projectedPixels)
+{
+	assert(mipLevels > 0);
+	if (projectedPixels <= 0.0f) {
+		return mipLevels - 1;
+	}
+
+	// 画面上の1ピクセルに1テクセル以上が対応するミップを選ぶ
+	float ratio = float((std::max)(width, height)) / projectedPixels;
+	if (ratio <= 1.0f) {
+		return 0;
+	}
+	uint32_t mip = uint32_t(std::floor(std::log2(ratio)));
+	return (std::min)(mip, mipLevels - 1);
+}
+
+float MipResidency::ComputeProjectedPixels(const MipCamera& camera, const Float3& center, float radius)
+{
+	float dx = center.x - camera.position.x;
+	float dy = center.y - camera.position.y;
+	float dz = center.z - camera.position.z;
+	// 境界球の内側にカメラがある場合は、球の表面にいるものとして扱う
+	float distance = (std::max)(std::sqrt(dx * dx + dy * dy + dz * dz), radius);
+	if (distance <= 0.0f) {
+		return 0.0f;
+	}
+	return radius / (distance * std::tan(camera.fovY * 0.5f)) * camera.screenHeight;
+}
+
+uint64_t MipResidency::ComputeStreamedBytes(const TextureState& texture, uint32_t residentMip)
+{
+	uint64_t bytes = 0;
+	for (uint32_t mip = residentMip; mip < texture.info.minResidentMip; ++mip) {
+		bytes += texture.info.mipSizes[mip];
+	}
+	return bytes;
+}
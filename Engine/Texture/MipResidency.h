@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// MyClass
+#include "Float3.h"
+
+// ストリーミングするTextureの情報
+struct StreamedTextureInfo {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	// 各ミップのバイト数（要素数がミップの数）
+	std::vector<uint64_t> mipSizes;
+	// 常に常駐させる最も詳細なミップ（これより小さいミップは読み込み時から常駐する）
+	uint32_t minResidentMip = 0;
+};
+
+// Textureを使っているオブジェクトのワールド座標での境界球（描画ごとに報告する）
+struct MipUsage {
+	uint32_t textureId;
+	Float3 center;
+	float radius;
+};
+
+// 画面上の大きさを求めるためのカメラの情報
+struct MipCamera {
+	Float3 position;
+	float fovY; // 縦の視野角（ラジアン）
+	float screenHeight; // 画面の高さ（ピクセル）
+};
+
+// 常駐させるミップが変わったTexture
+struct MipResidencyChange {
+	uint32_t textureId;
+	uint32_t oldResidentMip;
+	uint32_t newResidentMip;
+};
+
+// カメラから見た大きさと全体の予算から、各Textureの常駐させるミップを決める（GPUのリソースには依存しない）
+class MipResidency
+{
+public:
+	// 無効なID
+	static const uint32_t kInvalidId = UINT32_MAX;
+
+	// Textureを登録してIDを返す（最初は常に常駐させるミップだけが常駐している）
+	uint32_t AddTexture(const StreamedTextureInfo& info);
+	void RemoveTexture(uint32_t textureId);
+
+	// 全Textureで常駐させてよいバイト数
+	void SetBudget(uint64_t budgetBytes) { budgetBytes_ = budgetBytes; }
+
+	// 1フレーム分の使用状況から常駐させるミップを決め直す（変化はGetChangesで取得する）
+	void Update(const MipCamera& camera, const std::vector<MipUsage>& usages);
+
+	// 常駐している最も詳細なミップ
+	uint32_t GetResidentMip(uint32_t textureId) const { return textures_[textureId].residentMip; }
+	// 常駐している全ミップのバイト数
+	uint64_t GetResidentBytes() const { return residentBytes_; }
+	uint64_t GetBudget() const { return budgetBytes_; }
+	// 直前のUpdateで常駐させるミップが変わったTexture
+	const std::vector<MipResidencyChange>& GetChanges() const { return changes_; }
+
+	// 画面上の大きさ（ピクセル）に対して必要な最も詳細なミップを求める
+	static uint32_t ComputeDesiredMip(uint32_t width, uint32_t height, uint32_t mipLevels, float projectedPixels);
+	// カメラから見た境界球の直径を画面上のピクセル数で求める
+	static float ComputeProjectedPixels(const MipCamera& camera, const Float3& center, float radius);
+
+private:
+	struct TextureState {
+		StreamedTextureInfo info;
+		bool isUsed = false; // 登録されているか
+		uint32_t residentMip = 0;
+		uint64_t lastUsedFrame = 0;
+		// Update中の作業用
+		uint32_t desiredMip = 0;
+		float priority = 0.0f;
+	};
+
+	// residentMipからminResidentMipまでより詳細なミップのバイト数
+	static uint64_t ComputeStreamedBytes(const TextureState& texture, uint32_t residentMip);
+
+	std::vector<TextureState> textures_;
+	std::vector<uint32_t> freeIds_;
+	uint64_t budgetBytes_ = UINT64_MAX;
+	uint64_t residentBytes_ = 0;
+	uint64_t frame_ = 0;
+	std::vector<MipResidencyChange> changes_;
+};
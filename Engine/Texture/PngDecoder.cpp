@@ -0,0 +1,535 @@
+#include "PngDecoder.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// MyClass
+#include "Inflate.h"
+#include "MappedFile.h"
+#include "ParallelFor.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define PNG_DECODER_USE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace {
+	// 色の種類
+	enum ColorType : uint8_t {
+		kGray = 0,
+		kRgb = 2,
+		kPalette = 3,
+		kGrayAlpha = 4,
+		kRgba = 6,
+	};
+
+	// フィルタの種類
+	enum FilterType : uint8_t {
+		kNone = 0,
+		kSub = 1,
+		kUp = 2,
+		kAverage = 3,
+		kPaeth = 4,
+	};
+
+	// D3D12の2D Textureの最大サイズ
+	const uint32_t kMaxDimension = 16384;
+
+	// Adam7の各パスの開始位置と間隔
+	struct InterlacePass {
+		uint32_t xStart, yStart, xStep, yStep;
+	};
+	const InterlacePass kAdam7Passes[7] = {
+		{ 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 }, { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 },
+	};
+
+	// IHDRとRGBA8への変換に使う情報
+	struct PngHeader {
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint8_t bitDepth = 0;
+		uint8_t colorType = 0;
+		uint8_t interlace = 0;
+		uint32_t channels = 0;
+		// パレット（RGBA）と透過色
+		uint8_t palette[256][4] = {};
+		uint32_t paletteCount = 0;
+		bool hasTransparentColor = false;
+		uint16_t transparentColor[3] = {};
+	};
+
+	uint32_t ReadBigEndian32(const uint8_t* data)
+	{
+		return (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) | data[3];
+	}
+
+	// 幅がwidthの1行のバイト数（フィルタの種類を除く）
+	size_t ComputeRowBytes(const PngHeader& header, uint32_t width)
+	{
+		return (size_t(width) * header.channels * header.bitDepth + 7) / 8;
+	}
+
+	// 16bitの値を8bitに丸める
+	uint8_t Round16To8(uint32_t value)
+	{
+		return uint8_t((value * 255 + 32767) / 65535);
+	}
+
+	// 1行分のサンプルをRGBA8に変換する（出力は1ピクセルごとにdestinationStrideバイト進む）
+	void ExpandRow(const PngHeader& header, const uint8_t* row, uint32_t width, uint8_t* destination, size_t destinationStride)
+	{
+		const uint32_t bitDepth = header.bitDepth;
+
+		// 8bit未満はグレースケールとパレットのみ
+		if (bitDepth < 8) {
+			const uint32_t mask = (1u << bitDepth) - 1;
+			const uint32_t scale = 255 / mask;
+			for (uint32_t x = 0; x < width; ++x, destination += destinationStride) {
+				uint32_t bitOffset = x * bitDepth;
+				uint32_t value = (row[bitOffset / 8] >> (8 - bitDepth - bitOffset % 8)) & mask;
+				if (header.colorType == kPalette) {
+					std::memcpy(destination, header.palette[value], 4);
+				} else {
+					uint8_t gray = uint8_t(value * scale);
+					destination[0] = destination[1] = destination[2] = gray;
+					destination[3] = header.hasTransparentColor && value == header.transparentColor[0] ? 0 : 255;
+				}
+			}
+			return;
+		}
+
+		// 8bitと16bitはサンプルの位置を揃えて読む
+		const uint32_t sampleBytes = bitDepth / 8;
+		const uint32_t pixelBytes = header.channels * sampleBytes;
+		auto sample = [&](const uint8_t* pixel, uint32_t channel) -> uint32_t {
+			return sampleBytes == 1 ? pixel[channel] : (uint32_t(pixel[channel * 2]) << 8) | pixel[channel * 2 + 1];
+		};
+		auto toByte = [&](uint32_t value) -> uint8_t {
+			return sampleBytes == 1 ? uint8_t(value) : Round16To8(value);
+		};
+
+		// よく使われるRGBA8とRGB8は直接コピーする
+		if (bitDepth == 8 && header.colorType == kRgba && destinationStride == 4) {
+			std::memcpy(destination, row, size_t(width) * 4);
+			return;
+		}
+		if (bitDepth == 8 && header.colorType == kRgb && !header.hasTransparentColor) {
+			for (uint32_t x = 0; x < width; ++x, row += 3, destination += destinationStride) {
+				destination[0] = row[0];
+				destination[1] = row[1];
+				destination[2] = row[2];
+				destination[3] = 255;
+			}
+			return;
+		}
+
+		for (uint32_t x = 0; x < width; ++x, row += pixelBytes, destination += destinationStride) {
+			switch (header.colorType) {
+			case kGray: {
+				uint32_t gray = sample(row, 0);
+				destination[0] = destination[1] = destination[2] = toByte(gray);
+				destination[3] = header.hasTransparentColor && gray == header.transparentColor[0] ? 0 : 255;
+				break;
+			}
+			case kRgb: {
+				uint32_t r = sample(row, 0);
+				uint32_t g = sample(row, 1);
+				uint32_t b = sample(row, 2);
+				destination[0] = toByte(r);
+				destination[1] = toByte(g);
+				destination[2] = toByte(b);
+				bool isTransparent = header.hasTransparentColor && r == header.transparentColor[0] && g == header.transparentColor[1] && b == header.transparentColor[2];
+				destination[3] = isTransparent ? 0 : 255;
+				break;
+			}
+			case kPalette:
+				std::memcpy(destination, header.palette[row[0]], 4);
+				break;
+			case kGrayAlpha:
+				destination[0] = destination[1] = destination[2] = toByte(sample(row, 0));
+				destination[3] = toByte(sample(row, 1));
+				break;
+			default:
+				destination[0] = toByte(sample(row, 0));
+				destination[1] = toByte(sample(row, 1));
+				destination[2] = toByte(sample(row, 2));
+				destination[3] = toByte(sample(row, 3));
+				break;
+			}
+		}
+	}
+
+	// IHDRの内容を確認する
+	bool ParseHeader(const uint8_t* data, uint32_t length, PngHeader& header)
+	{
+		if (length != 13) {
+			return false;
+		}
+		header.width = ReadBigEndian32(data);
+		header.height = ReadBigEndian32(data + 4);
+		header.bitDepth = data[8];
+		header.colorType = data[9];
+		header.interlace = data[12];
+		if (header.width == 0 || header.height == 0 || header.width > kMaxDimension || header.height > kMaxDimension) {
+			return false;
+		}
+		// 圧縮方法とフィルタ方法は0のみ
+		if (data[10] != 0 || data[11] != 0 || header.interlace > 1) {
+			return false;
+		}
+
+		// 色の種類ごとに使えるビット深度が決まっている
+		const uint8_t depth = header.bitDepth;
+		switch (header.colorType) {
+		case kGray:
+			header.channels = 1;
+			return depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16;
+		case kPalette:
+			header.channels = 1;
+			return depth == 1 || depth == 2 || depth == 4 || depth == 8;
+		case kRgb:
+			header.channels = 3;
+			return depth == 8 || depth == 16;
+		case kGrayAlpha:
+			header.channels = 2;
+			return depth == 8 || depth == 16;
+		case kRgba:
+			header.channels = 4;
+			return depth == 8 || depth == 16;
+		default:
+			return false;
+		}
+	}
+
+	// 展開したデータ（各行の先頭にフィルタの種類がある）のフィルタを復元し、RGBA8で書き込む
+	bool ReconstructImage(const PngHeader& header, uint8_t* filtered, size_t filteredSize, PngImage& image)
+	{
+		const uint32_t bytesPerPixel = (std::max)(1u, header.channels * header.bitDepth / 8);
+
+		// インターレースしていなければ全体を1つのパスとして扱う
+		const InterlacePass kFullPass = { 0, 0, 1, 1 };
+		const InterlacePass* passes = header.interlace ? kAdam7Passes : &kFullPass;
+		const uint32_t passCount = header.interlace ? 7 : 1;
+
+		size_t offset = 0;
+		std::vector<uint8_t> zeroRow;
+		for (uint32_t pass = 0; pass < passCount; ++pass) {
+			const InterlacePass& interlace = passes[pass];
+			if (interlace.xStart >= header.width || interlace.yStart >= header.height) {
+				continue;
+			}
+			const uint32_t passWidth = (header.width - interlace.xStart + interlace.xStep - 1) / interlace.xStep;
+			const uint32_t passHeight = (header.height - interlace.yStart + interlace.yStep - 1) / interlace.yStep;
+			const size_t rowBytes = ComputeRowBytes(header, passWidth);
+			if (offset + (rowBytes + 1) * passHeight > filteredSize) {
+				return false;
+			}
+
+			// 最初の行の前の行は全て0として扱う
+			zeroRow.assign(rowBytes, 0);
+			const uint8_t* priorRow = zeroRow.data();
+			for (uint32_t y = 0; y < passHeight; ++y) {
+				uint8_t filterType = filtered[offset];
+				uint8_t* row = filtered + offset + 1;
+				if (!PngDecoder::Unfilter(filterType, row, priorRow, rowBytes, bytesPerPixel)) {
+					return false;
+				}
+				uint32_t imageY = interlace.yStart + y * interlace.yStep;
+				uint8_t* destination = image.pixels.data() + (size_t(imageY) * header.width + interlace.xStart) * 4;
+				ExpandRow(header, row, passWidth, destination, size_t(interlace.xStep) * 4);
+				priorRow = row;
+				offset += rowBytes + 1;
+			}
+		}
+		return true;
+	}
+
+#ifdef PNG_DECODER_USE_SSE
+	// 3バイトか4バイトのピクセルの読み書き
+	__m128i Load4(const uint8_t* pointer)
+	{
+		int32_t value;
+		std::memcpy(&value, pointer, 4);
+		return _mm_cvtsi32_si128(value);
+	}
+	__m128i Load3(const uint8_t* pointer)
+	{
+		int32_t value = 0;
+		std::memcpy(&value, pointer, 3);
+		return _mm_cvtsi32_si128(value);
+	}
+	void Store4(uint8_t* pointer, __m128i value)
+	{
+		int32_t result = _mm_cvtsi128_si32(value);
+		std::memcpy(pointer, &result, 4);
+	}
+	void Store3(uint8_t* pointer, __m128i value)
+	{
+		int32_t result = _mm_cvtsi128_si32(value);
+		std::memcpy(pointer, &result, 3);
+	}
+
+	// 1ピクセル（3か4バイト）ずつ、前のピクセルの結果に依存するフィルタを復元する（3バイトの場合、使わない4バイト目は常に0になる）
+	template<uint32_t kBytesPerPixel>
+	void UnfilterPixelsSse(uint8_t filterType, uint8_t* row, const uint8_t* priorRow, size_t rowBytes)
+	{
+		auto load = [](const uint8_t* pointer) { return kBytesPerPixel == 4 ? Load4(pointer) : Load3(pointer); };
+		auto store = [](uint8_t* pointer, __m128i value) { kBytesPerPixel == 4 ? Store4(pointer, value) : Store3(pointer, value); };
+		const __m128i zero = _mm_setzero_si128();
+
+		// a:左のピクセル、b:上のピクセル、c:左上のピクセル
+		__m128i a = zero;
+		__m128i c = zero;
+		for (size_t x = 0; x + kBytesPerPixel <= rowBytes; x += kBytesPerPixel) {
+			__m128i d = load(row + x);
+			if (filterType == kSub) {
+				d = _mm_add_epi8(d, a);
+				a = d;
+			} else if (filterType == kAverage) {
+				// 切り捨ての平均（avg_epu8は切り上げなので、奇数の場合に1引く）
+				__m128i b = load(priorRow + x);
+				__m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1)));
+				d = _mm_add_epi8(d, average);
+				a = d;
+			} else {
+				// Paethは16bitに広げて計算する
+				__m128i b = _mm_unpacklo_epi8(load(priorRow + x), zero);
+				d = _mm_unpacklo_epi8(d, zero);
+				__m128i pa = _mm_sub_epi16(b, c);
+				__m128i pb = _mm_sub_epi16(a, c);
+				__m128i pc = _mm_add_epi16(pa, pb);
+				pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+				pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+				pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+				__m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+				// 同じ場合はa、b、cの順に優先する
+				__m128i isA = _mm_cmpeq_epi16(pa, smallest);
+				__m128i isB = _mm_cmpeq_epi16(pb, smallest);
+				__m128i predictor = _mm_or_si128(_mm_and_si128(isB, b), _mm_andnot_si128(isB, c));
+				predictor = _mm_or_si128(_mm_and_si128(isA, a), _mm_andnot_si128(isA, predictor));
+				d = _mm_add_epi8(d, predictor);
+				c = b;
+				a = d;
+				d = _mm_packus_epi16(d, d);
+			}
+			store(row + x, d);
+		}
+	}
+#endif
+
+	// 左上のピクセルとの関係から予測する
+	uint8_t PaethPredictor(int32_t a, int32_t b, int32_t c)
+	{
+		int32_t pa = std::abs(b - c);
+		int32_t pb = std::abs(a - c);
+		int32_t pc = std::abs(a + b - 2 * c);
+		if (pa <= pb && pa <= pc) {
+			return uint8_t(a);
+		}
+		return uint8_t(pb <= pc ? b : c);
+	}
+}
+
+bool PngDecoder::IsPng(const void* data, size_t size)
+{
+	static const uint8_t kSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	return size >= 8 && std::memcmp(data, kSignature, 8) == 0;
+}
+
+bool PngDecoder::Unfilter(uint8_t filterType, uint8_t* row, const uint8_t* priorRow, size_t rowBytes, uint32_t bytesPerPixel)
+{
+	switch (filterType) {
+	case kNone:
+		return true;
+	case kUp: {
+		// 前のピクセルに依存しないので、16バイトずつまとめて足す
+		size_t x = 0;
+#ifdef PNG_DECODER_USE_SSE
+		for (; x + 16 <= rowBytes; x += 16) {
+			__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+			__m128i prior = _mm_loadu_si128(reinterpret_cast<const __m128i*>(priorRow + x));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(row + x), _mm_add_epi8(value, prior));
+		}
+#endif
+		for (; x < rowBytes; ++x) {
+			row[x] = uint8_t(row[x] + priorRow[x]);
+		}
+		return true;
+	}
+	case kSub:
+	case kAverage:
+	case kPaeth:
+		break;
+	default:
+		return false;
+	}
+
+#ifdef PNG_DECODER_USE_SSE
+	// RGBとRGBA（8bit）は1ピクセル分をまとめて計算する
+	if (bytesPerPixel == 4) {
+		UnfilterPixelsSse<4>(filterType, row, priorRow, rowBytes);
+		return true;
+	}
+	if (bytesPerPixel == 3) {
+		UnfilterPixelsSse<3>(filterType, row, priorRow, rowBytes);
+		return true;
+	}
+#endif
+
+	// それ以外は1バイトずつ計算する（最初のピクセルは左と左上が0）
+	for (size_t x = 0; x < rowBytes; ++x) {
+		uint8_t a = x >= bytesPerPixel ? row[x - bytesPerPixel] : 0;
+		uint8_t b = priorRow[x];
+		uint8_t c = x >= bytesPerPixel ? priorRow[x - bytesPerPixel] : 0;
+		if (filterType == kSub) {
+			row[x] = uint8_t(row[x] + a);
+		} else if (filterType == kAverage) {
+			row[x] = uint8_t(row[x] + ((a + b) >> 1));
+		} else {
+			row[x] = uint8_t(row[x] + PaethPredictor(a, b, c));
+		}
+	}
+	return true;
+}
+
+bool PngDecoder::Decode(const void* data, size_t size, PngImage& image)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	if (!IsPng(data, size)) {
+		return false;
+	}
+
+	// チャンクを順に読む（CRCは確認せず、展開結果はAdler-32で確認する）
+	PngHeader header;
+	bool hasHeader = false;
+	bool hasEnd = false;
+	std::vector<uint8_t> paletteAlpha;
+	// IDATが1つだけの場合はコピーせずにそのまま展開する
+	const uint8_t* compressedData = nullptr;
+	size_t compressedSize = 0;
+	std::vector<uint8_t> concatenatedData;
+
+	size_t offset = 8;
+	while (!hasEnd && offset + 12 <= size) {
+		uint32_t length = ReadBigEndian32(bytes + offset);
+		const uint8_t* type = bytes + offset + 4;
+		const uint8_t* chunk = bytes + offset + 8;
+		if (length > size - offset - 12) {
+			return false;
+		}
+		offset += size_t(length) + 12;
+
+		if (std::memcmp(type, "IHDR", 4) == 0) {
+			if (hasHeader || !ParseHeader(chunk, length, header)) {
+				return false;
+			}
+			hasHeader = true;
+		} else if (!hasHeader) {
+			// IHDRは最初のチャンクでなければならない
+			return false;
+		} else if (std::memcmp(type, "PLTE", 4) == 0) {
+			if (length % 3 != 0 || length / 3 > 256) {
+				return false;
+			}
+			header.paletteCount = length / 3;
+			for (uint32_t i = 0; i < header.paletteCount; ++i) {
+				header.palette[i][0] = chunk[i * 3 + 0];
+				header.palette[i][1] = chunk[i * 3 + 1];
+				header.palette[i][2] = chunk[i * 3 + 2];
+				header.palette[i][3] = 255;
+			}
+		} else if (std::memcmp(type, "tRNS", 4) == 0) {
+			// パレットは各色のアルファ、グレースケールとRGBは透過させる色
+			if (header.colorType == kPalette) {
+				paletteAlpha.assign(chunk, chunk + (std::min)(length, 256u));
+			} else if (header.colorType == kGray && length >= 2) {
+				header.hasTransparentColor = true;
+				header.transparentColor[0] = uint16_t((chunk[0] << 8) | chunk[1]);
+			} else if (header.colorType == kRgb && length >= 6) {
+				header.hasTransparentColor = true;
+				for (uint32_t i = 0; i < 3; ++i) {
+					header.transparentColor[i] = uint16_t((chunk[i * 2] << 8) | chunk[i * 2 + 1]);
+				}
+			}
+		} else if (std::memcmp(type, "IDAT", 4) == 0) {
+			if (compressedData == nullptr && concatenatedData.empty()) {
+				compressedData = chunk;
+				compressedSize = length;
+			} else {
+				// 2つ目以降のIDATは連結する
+				if (compressedData) {
+					concatenatedData.assign(compressedData, compressedData + compressedSize);
+					compressedData = nullptr;
+				}
+				concatenatedData.insert(concatenatedData.end(), chunk, chunk + length);
+			}
+		} else if (std::memcmp(type, "IEND", 4) == 0) {
+			hasEnd = true;
+		} else if ((type[0] & 0x20) == 0) {
+			// 知らない必須チャンクがある場合はデコードできない
+			return false;
+		}
+	}
+	if (!hasHeader || (compressedData == nullptr && concatenatedData.empty())) {
+		return false;
+	}
+	if (header.colorType == kPalette && header.paletteCount == 0) {
+		return false;
+	}
+	for (size_t i = 0; i < paletteAlpha.size(); ++i) {
+		header.palette[i][3] = paletteAlpha[i];
+	}
+	// パレットの範囲外の番号は不透明の黒にする
+	for (uint32_t i = header.paletteCount; i < 256; ++i) {
+		header.palette[i][3] = 255;
+	}
+
+	// 展開後のサイズ（各行の先頭にフィルタの種類が付く）
+	size_t filteredSize = 0;
+	const uint32_t passCount = header.interlace ? 7 : 1;
+	for (uint32_t pass = 0; pass < passCount; ++pass) {
+		const InterlacePass& interlace = header.interlace ? kAdam7Passes[pass] : InterlacePass{ 0, 0, 1, 1 };
+		if (interlace.xStart >= header.width || interlace.yStart >= header.height) {
+			continue;
+		}
+		uint32_t passWidth = (header.width - interlace.xStart + interlace.xStep - 1) / interlace.xStep;
+		uint32_t passHeight = (header.height - interlace.yStart + interlace.yStep - 1) / interlace.yStep;
+		filteredSize += (ComputeRowBytes(header, passWidth) + 1) * passHeight;
+	}
+
+	// 展開する
+	std::vector<uint8_t> filtered;
+	if (compressedData == nullptr) {
+		compressedData = concatenatedData.data();
+		compressedSize = concatenatedData.size();
+	}
+	if (!Inflate::DecompressZlib(compressedData, compressedSize, filtered, filteredSize) || filtered.size() < filteredSize) {
+		return false;
+	}
+
+	// フィルタを復元してRGBA8にする
+	image.width = header.width;
+	image.height = header.height;
+	image.pixels.resize(size_t(header.width) * header.height * 4);
+	return ReconstructImage(header, filtered.data(), filtered.size(), image);
+}
+
+bool PngDecoder::DecodeFile(const std::string& filePath, PngImage& image)
+{
+	MappedFile file;
+	if (!file.Open(filePath)) {
+		return false;
+	}
+	return Decode(file.GetData(), file.GetSize(), image);
+}
+
+std::vector<PngImage> PngDecoder::DecodeFiles(const std::vector<std::string>& filePaths, uint32_t threadCount)
+{
+	std::vector<PngImage> images(filePaths.size());
+	ParallelFor(filePaths.size(), threadCount, [&](size_t index) {
+		if (!DecodeFile(filePaths[index], images[index])) {
+			images[index] = PngImage{};
+		}
+	});
+	return images;
+}
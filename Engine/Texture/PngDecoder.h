@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// デコードしたPNG（RGBA8。行のピッチはwidth * 4）
+struct PngImage {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	std::vector<uint8_t> pixels;
+};
+
+// WICに依存しないPNGのデコーダ（展開はInflate、フィルタの復元はSSEがあれば使う）
+// 全ての色の種類とビット深度、tRNS、インターレース（Adam7）に対応し、結果は常にRGBA8にする（16bitは8bitに丸める）
+// 状態を持たないので、複数のスレッドから同時に呼んでよい
+class PngDecoder
+{
+public:
+	// PNGのシグネチャで始まっているか
+	static bool IsPng(const void* data, size_t size);
+
+	// メモリ上のPNGをデコードする（壊れている・対応していない場合はfalseを返す）
+	static bool Decode(const void* data, size_t size, PngImage& image);
+	// PNGファイルをマップしてデコードする
+	static bool DecodeFile(const std::string& filePath, PngImage& image);
+	// 複数のPNGファイルを複数のスレッドでデコードする（threadCountが0の場合はハードウェアのスレッド数。失敗した画像は空になる）
+	static std::vector<PngImage> DecodeFiles(const std::vector<std::string>& filePaths, uint32_t threadCount = 0);
+
+	// フィルタを復元する（rowはフィルタの種類の次のバイトから、priorRowは復元済みの前の行で最初の行では全て0）
+	static bool Unfilter(uint8_t filterType, uint8_t* row, const uint8_t* priorRow, size_t rowBytes, uint32_t bytesPerPixel);
+};
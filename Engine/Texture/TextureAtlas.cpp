@@ -0,0 +1,129 @@
+#include "TextureAtlas.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <format>
+
+// MyClass
+#include "AtlasPacker.h"
+#include "TextureManager.h"
+#include "ParallelFor.h"
+#include "Hash.h"
+
+Matrix AtlasRegion::GetUVTransform() const
+{
+	return Matrix::Scaling({ width, height, 1.0f }) * Matrix::Translation({ u, v, 0.0f });
+}
+
+void TextureAtlas::Build(const std::vector<std::string>& filePaths, ID3D12Device* device, uint32_t pageSize, uint32_t gutter)
+{
+	assert(gutter > 0 && (gutter & (gutter - 1)) == 0);
+	Release();
+
+	// 画像をRGBA8に揃えて読む（TextureManagerと同じく変換済みのDDSか選んだデコーダを使う。ミップマップはページにまとめてから作る）
+	std::vector<DirectX::ScratchImage> images(filePaths.size());
+	ParallelFor(filePaths.size(), 0, [&](size_t i) {
+		images[i] = TextureManager::LoadBaseImage(filePaths[i]);
+	});
+
+	// 縁を含めた大きさをgutterの倍数に切り上げ、gutter単位で詰める
+	// （ページ上の位置もgutterの倍数になるので、縁が1ピクセル残るミップまでは隣の画像と混ざらない）
+	uint32_t pageUnits = pageSize / gutter;
+	std::vector<std::pair<uint32_t, uint32_t>> cellUnits(images.size());
+	for (size_t i = 0; i < images.size(); ++i) {
+		const DirectX::TexMetadata& metadata = images[i].GetMetadata();
+		cellUnits[i] = { uint32_t((metadata.width + gutter * 2 + gutter - 1) / gutter), uint32_t((metadata.height + gutter * 2 + gutter - 1) / gutter) };
+	}
+	uint32_t pageCount = 0;
+	std::vector<AtlasPacker::Placement> placements = AtlasPacker::PackPages(cellUnits, pageUnits, pageUnits, &pageCount);
+
+	// ページの画像を作る
+	std::vector<DirectX::ScratchImage> pages(pageCount);
+	for (DirectX::ScratchImage& page : pages) {
+		HRESULT result = page.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, pageSize, pageSize, 1, 1);
+		assert(SUCCEEDED(result));
+		std::memset(page.GetPixels(), 0, page.GetPixelsSize());
+	}
+
+	regions_.resize(filePaths.size());
+	uint64_t imageArea = 0;
+	for (size_t i = 0; i < images.size(); ++i) {
+		const DirectX::Image& source = *images[i].GetImage(0, 0, 0);
+		const AtlasPacker::Placement& placement = placements[i];
+
+		// ページに収まらない画像は単独のTextureとして読み込む
+		if (placement.page == AtlasPacker::kInvalidPage) {
+			Log(std::format("TextureAtlas : {} does not fit in a {}px page, loading it separately\n", filePaths[i], pageSize));
+			uint32_t handle = TextureManager::Load(filePaths[i], device);
+			pageHandles_.push_back(handle);
+			regions_[i] = { handle, 0.0f, 0.0f, 1.0f, 1.0f };
+			regionIndices_[filePaths[i]] = i;
+			continue;
+		}
+
+		// 縁と切り上げた余りには、画像の端の色を引き延ばす
+		const DirectX::Image& destination = *pages[placement.page].GetImage(0, 0, 0);
+		uint32_t cellX = placement.rect.x * gutter;
+		uint32_t cellY = placement.rect.y * gutter;
+		uint32_t cellWidth = placement.rect.width * gutter;
+		uint32_t cellHeight = placement.rect.height * gutter;
+		for (uint32_t y = 0; y < cellHeight; ++y) {
+			size_t sourceY = size_t((std::clamp)(int64_t(y) - int64_t(gutter), int64_t(0), int64_t(source.height - 1)));
+			const uint32_t* sourceRow = reinterpret_cast<const uint32_t*>(source.pixels + sourceY * source.rowPitch);
+			uint32_t* destinationRow = reinterpret_cast<uint32_t*>(destination.pixels + (cellY + y) * destination.rowPitch) + cellX;
+			for (uint32_t x = 0; x < cellWidth; ++x) {
+				size_t sourceX = size_t((std::clamp)(int64_t(x) - int64_t(gutter), int64_t(0), int64_t(source.width - 1)));
+				destinationRow[x] = sourceRow[sourceX];
+			}
+		}
+
+		float texelSize = 1.0f / float(pageSize);
+		regions_[i] = { 0, float(cellX + gutter) * texelSize, float(cellY + gutter) * texelSize, float(source.width) * texelSize, float(source.height) * texelSize };
+		regionIndices_[filePaths[i]] = i;
+		imageArea += uint64_t(source.width) * source.height;
+	}
+	occupancy_ = pageCount > 0 ? float(double(imageArea) / (double(pageSize) * pageSize * pageCount)) : 0.0f;
+
+	// ミップマップは縁が1ピクセル残る段数まで作り、ページごとにTextureを作る
+	uint32_t mipLevels = 1;
+	for (uint32_t size = gutter; size > 1; size /= 2) {
+		mipLevels++;
+	}
+	std::vector<uint32_t> pageTextureHandles(pageCount);
+	for (uint32_t page = 0; page < pageCount; ++page) {
+		// ページはRGBA8（sRGB）なので、MipGeneratorのボックスフィルタで縮小する
+		DirectX::ScratchImage mipImages = TextureManager::GenerateMipMaps(pages[page], 0, mipLevels);
+		pages[page].Release();
+
+		// 内容が同じページは既存のTextureを共有する
+		uint64_t contentHash = HashBytes(mipImages.GetPixels(), mipImages.GetPixelsSize());
+		std::string name = std::format("atlas:{:016x}", contentHash);
+		pageTextureHandles[page] = TextureManager::LoadFromImage(name, std::move(mipImages), contentHash, device);
+		pageHandles_.push_back(pageTextureHandles[page]);
+	}
+	for (size_t i = 0; i < regions_.size(); ++i) {
+		if (placements[i].page != AtlasPacker::kInvalidPage) {
+			regions_[i].textureHandle = pageTextureHandles[placements[i].page];
+		}
+	}
+
+	Log(std::format("TextureAtlas : {} images -> {} pages of {}px ({:.1f}% occupied)\n", filePaths.size(), pageCount, pageSize, occupancy_ * 100.0f));
+}
+
+void TextureAtlas::Release()
+{
+	for (uint32_t handle : pageHandles_) {
+		TextureManager::Unload(handle);
+	}
+	pageHandles_.clear();
+	regions_.clear();
+	regionIndices_.clear();
+	occupancy_ = 0.0f;
+}
+
+const AtlasRegion& TextureAtlas::GetRegion(const std::string& filePath) const
+{
+	auto itr = regionIndices_.find(filePath);
+	assert(itr != regionIndices_.end());
+	return regions_[itr->second];
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <d3d12.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// MyClass
+#include "MyMath.h"
+
+// アトラス上の1枚の画像の場所（UVは0～1）
+struct AtlasRegion {
+	uint32_t textureHandle;
+	float u;
+	float v;
+	float width;
+	float height;
+
+	// 画像全体のUV（0～1）をアトラス上の場所に変換する行列（Material::uvTransformに設定する）
+	Matrix GetUVTransform() const;
+};
+
+// 小さな画像を共有のページにまとめ、1つのTextureとSRVで描画できるようにする
+class TextureAtlas
+{
+public:
+	// 画像を読み込んでページに詰め、ページごとにTextureを作る
+	// gutterは画像の周りに縁の色を引き延ばす幅（2のべき乗。ミップマップはgutterが1ピクセル残る段数まで作る）
+	void Build(const std::vector<std::string>& filePaths, ID3D12Device* device, uint32_t pageSize = 2048, uint32_t gutter = 4);
+	// ページのTextureを解放する
+	void Release();
+
+	// Buildに渡したパスの画像の場所
+	const AtlasRegion& GetRegion(const std::string& filePath) const;
+	size_t GetPageCount() const { return pageHandles_.size(); }
+	// ページの面積に対する画像（縁を除く）の面積の割合
+	float GetOccupancy() const { return occupancy_; }
+
+private:
+	// 作ったページのTextureのハンドル（ページに収まらず単独で読み込んだTextureも含む）
+	std::vector<uint32_t> pageHandles_;
+	std::vector<AtlasRegion> regions_;
+	std::unordered_map<std::string, size_t> regionIndices_;
+	float occupancy_ = 0.0f;
+};
@@ -0,0 +1,128 @@
+#include "TextureCooker.h"
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <filesystem>
+#include <format>
+
+// MyClass
+#include "TextureManager.h"
+#include "StringUtil.h"
+#include "Logger.h"
+
+namespace {
+	// 拡張子を小文字で比較する
+	bool HasExtension(const std::filesystem::path& path, const std::string& extension)
+	{
+		std::string pathExtension = path.extension().string();
+		std::transform(pathExtension.begin(), pathExtension.end(), pathExtension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return pathExtension == extension;
+	}
+}
+
+std::string TextureCooker::GetCookedPath(const std::string& filePath)
+{
+	return std::filesystem::path(filePath).replace_extension(".dds").string();
+}
+
+bool TextureCooker::IsCookedUpToDate(const std::string& filePath)
+{
+	std::error_code errorCode;
+	if (HasExtension(filePath, ".dds")) {
+		return std::filesystem::exists(filePath, errorCode);
+	}
+
+	// 元の画像を変換した後に更新していなければ、変換済みのDDSを使える
+	std::filesystem::path cookedPath = GetCookedPath(filePath);
+	if (!std::filesystem::exists(cookedPath, errorCode)) {
+		return false;
+	}
+	auto sourceTime = std::filesystem::last_write_time(filePath, errorCode);
+	if (errorCode) {
+		return false;
+	}
+	auto cookedTime = std::filesystem::last_write_time(cookedPath, errorCode);
+	return !errorCode && cookedTime >= sourceTime;
+}
+
+bool TextureCooker::CookTexture(const std::string& filePath, bool highQuality)
+{
+	HRESULT result = S_FALSE;
+
+	// 画像をデコードしてミップマップを生成する
+	DirectX::ScratchImage mipImages = TextureManager::LoadTexture(filePath);
+	const DirectX::TexMetadata& metadata = mipImages.GetMetadata();
+
+	DirectX::ScratchImage cookedImages{};
+	const DirectX::ScratchImage* outputImages = &mipImages;
+	// ブロック圧縮のTextureは最上位のミップのサイズが4の倍数である必要があるので、それ以外は非圧縮のまま保存する
+	if (metadata.width % 4 == 0 && metadata.height % 4 == 0) {
+		DXGI_FORMAT format = SelectCompressedFormat(mipImages, highQuality);
+		// 圧縮は全ミップをまとめて複数スレッドで行う
+		result = DirectX::Compress(mipImages.GetImages(), mipImages.GetImageCount(), metadata, format, DirectX::TEX_COMPRESS_PARALLEL, DirectX::TEX_THRESHOLD_DEFAULT, cookedImages);
+		if (FAILED(result)) {
+			Log(std::format("TextureCooker : failed to compress {}\n", filePath));
+			return false;
+		}
+		outputImages = &cookedImages;
+	}
+
+	// DDSとして保存する
+	std::string cookedPath = GetCookedPath(filePath);
+	std::wstring cookedPathW = ConvertString(cookedPath);
+	result = DirectX::SaveToDDSFile(outputImages->GetImages(), outputImages->GetImageCount(), outputImages->GetMetadata(), DirectX::DDS_FLAGS_NONE, cookedPathW.c_str());
+	if (FAILED(result)) {
+		Log(std::format("TextureCooker : failed to save {}\n", cookedPath));
+		return false;
+	}
+
+	Log(std::format("TextureCooker : {} -> {} ({}, {} mips, {}KB -> {}KB)\n",
+		filePath, cookedPath, static_cast<uint32_t>(outputImages->GetMetadata().format), metadata.mipLevels,
+		mipImages.GetPixelsSize() / 1024, outputImages->GetPixelsSize() / 1024));
+	return true;
+}
+
+void TextureCooker::CookDirectory(const std::string& directoryPath, bool highQuality)
+{
+	std::error_code errorCode;
+	uint32_t cookedCount = 0;
+	uint32_t skippedCount = 0;
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(directoryPath, errorCode)) {
+		if (!entry.is_regular_file() || !HasExtension(entry.path(), ".png")) {
+			continue;
+		}
+		std::string filePath = entry.path().generic_string();
+		if (IsCookedUpToDate(filePath)) {
+			skippedCount++;
+			continue;
+		}
+		if (CookTexture(filePath, highQuality)) {
+			cookedCount++;
+		}
+	}
+	Log(std::format("TextureCooker : cooked {} textures, {} up to date\n", cookedCount, skippedCount));
+}
+
+DXGI_FORMAT TextureCooker::SelectCompressedFormat(const DirectX::ScratchImage& mipImages, bool highQuality)
+{
+	// 完全に不透明であればアルファは不要
+	if (mipImages.IsAlphaAllOpaque()) {
+		return DXGI_FORMAT_BC1_UNORM_SRGB;
+	}
+
+	// アルファが0か1しかない（抜きのみ）であればBC1の1bitアルファで足りる
+	bool hasTranslucency = false;
+	const float kAlphaEpsilon = 1.0f / 255.0f;
+	DirectX::EvaluateImage(*mipImages.GetImage(0, 0, 0), [&](const DirectX::XMVECTOR* pixels, size_t width, size_t) {
+		for (size_t x = 0; x < width && !hasTranslucency; ++x) {
+			float alpha = DirectX::XMVectorGetW(pixels[x]);
+			hasTranslucency = alpha > kAlphaEpsilon && alpha < 1.0f - kAlphaEpsilon;
+		}
+	});
+	if (!hasTranslucency) {
+		return DXGI_FORMAT_BC1_UNORM_SRGB;
+	}
+
+	// 半透明の場合、BC7は高品質だが圧縮に時間がかかる
+	return highQuality ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM_SRGB;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+#include "externals/DirectXTex/DirectXTex.h"
+
+// 画像ファイルを、ミップマップ付きのブロック圧縮されたDDSに変換する（起動オプション -cook で実行）
+class TextureCooker final
+{
+public:
+	// 変換後のDDSファイルのパス（拡張子を.ddsに置き換える）
+	static std::string GetCookedPath(const std::string& filePath);
+	// 変換済みのDDSが元の画像より新しいか（DDSそのものを指定した場合は存在するか）
+	static bool IsCookedUpToDate(const std::string& filePath);
+
+	// 1枚の画像を変換する（highQualityがfalseの場合、半透明の画像にBC7ではなくBC3を使う）
+	static bool CookTexture(const std::string& filePath, bool highQuality = true);
+	// ディレクトリ以下の全てのPNGを変換する（変換済みで元の画像が更新されていないものは飛ばす）
+	static void CookDirectory(const std::string& directoryPath, bool highQuality = true);
+
+	// アルファの使われ方から圧縮形式を選ぶ（不透明・抜きのみならBC1、半透明ならBC7かBC3）
+	static DXGI_FORMAT SelectCompressedFormat(const DirectX::ScratchImage& mipImages, bool highQuality);
+};
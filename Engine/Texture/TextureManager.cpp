@@ -1,29 +1,491 @@
 #include "TextureManager.h"
+#include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+
+// MyClass
+#include "MappedFile.h"
+#include "Hash.h"
+#include "TextureCooker.h"
+#include "ParallelFor.h"
+#include "TextureUploader.h"
+#include "DirectXBase.h"
+#include "DirectXUtil.h"
+#include "MipGenerator.h"
+#include "PngDecoder.h"
 
 void TextureManager::Initialize(ID3D12Device* device)
 {
-	GetInstance().srvHeap_.Create(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 128, true);
+	TextureManager& instance = GetInstance();
+	// 描画用のDescriptorHeapは同時にGPUで実行できるフレームの数だけ領域を持つ
+	uint32_t framesInFlight = DirectXBase::GetInstance()->GetFramesInFlight();
+	instance.srvHeap_.Create(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, kInitialDescriptorCount_ * framesInFlight, true);
+	instance.regionSize_ = kInitialDescriptorCount_;
+	instance.pendingCopies_.assign(framesInFlight, {});
+	instance.stagingHeap_.Create(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, kInitialDescriptorCount_, false);
+	// 先頭はImGuiのフォントが使うので確保しない
+	instance.allocator_.Initialize(kInitialDescriptorCount_, 1);
+	instance.textures_.resize(kInitialDescriptorCount_);
 }
 
 int TextureManager::Load(const std::string& filePath, ID3D12Device* device)
 {
-	// テクスチャ読み込みの最大値に達した場合、ログを出力
-	if (GetInstance().index_ >= kMaxTextureValue_) {
-		Log(std::format("Maximum texture loading has been reached. Texture:{}\n", filePath));
+	// Textureを読む
+	DecodedTexture decoded = DecodeTexture(filePath);
+	if (decoded.cachedHandle >= 0) {
+		return decoded.cachedHandle;
+	}
+
+	// Textureを転送する
+	int handle = CreateTexture(std::move(decoded.mipImages), decoded.name, decoded.contentHash, device);
+	TextureUploader::Flush();
+	return handle;
+}
+
+std::vector<uint32_t> TextureManager::LoadBatch(const std::vector<std::string>& filePaths, ID3D12Device* device, uint32_t threadCount)
+{
+	// デコードとミップマップの生成は、それぞれ独立しているので複数のスレッドで行う
+	// （同じ画像がリストに重複している場合は両方デコードされるが、転送時にキャッシュから共有される）
+	// 画像ごとに分担するので、1枚のミップマップの生成は1スレッドで行う
+	std::vector<DecodedTexture> decodedTextures(filePaths.size());
+	ParallelFor(filePaths.size(), threadCount, [&](size_t i) {
+		decodedTextures[i] = DecodeTexture(filePaths[i], 1);
+	});
+
+	// リソースとSRVの生成、転送はリストの順に行う
+	std::vector<uint32_t> handles(filePaths.size());
+	for (size_t i = 0; i < filePaths.size(); ++i) {
+		DecodedTexture& decoded = decodedTextures[i];
+		if (decoded.cachedHandle >= 0) {
+			handles[i] = decoded.cachedHandle;
+		} else {
+			handles[i] = CreateTexture(std::move(decoded.mipImages), decoded.name, decoded.contentHash, device);
+		}
+		// アップロード用のバッファにコピーした画像はすぐに解放する（ストリーミングする画像はTextureManagerが保持している）
+		decoded.mipImages.Release();
+	}
+	// 全てのTextureの転送をまとめて実行する
+	TextureUploader::Flush();
+
+	return handles;
+}
+
+TextureManager::DecodedTexture TextureManager::DecodeTexture(const std::string& filePath, uint32_t mipThreadCount)
+{
+	TextureManager& instance = GetInstance();
+	DecodedTexture decoded;
+	decoded.name = CanonicalizePath(filePath);
+
+	// 同じパスのTextureが読み込み済みであればそれを使う
+	{
+		std::lock_guard<std::mutex> lock(instance.mutex_);
+		decoded.cachedHandle = instance.AcquireCachedTexture(decoded.name, std::nullopt);
+		if (decoded.cachedHandle >= 0) {
+			return decoded;
+		}
+	}
+
+	// 変換済みのDDSがあれば、デコードとミップマップの生成を省略してそのまま使う
+	bool isCooked = TextureCooker::IsCookedUpToDate(filePath);
+	std::string readFilePath = isCooked ? TextureCooker::GetCookedPath(filePath) : filePath;
+
+	// 画像ファイルを読み、内容のハッシュ値を求める
+	MappedFile file;
+	if (!file.Open(readFilePath)) {
+		Log(std::format("Failed to open texture:{}\n", readFilePath));
 		assert(0);
+		decoded.cachedHandle = 0;
+		return decoded;
+	}
+	decoded.contentHash = HashBytes(file.GetData(), file.GetSize());
+
+	// 別のパスに同じ内容の画像が読み込み済みであればそれを使う
+	{
+		std::lock_guard<std::mutex> lock(instance.mutex_);
+		decoded.cachedHandle = instance.AcquireCachedTexture(decoded.name, decoded.contentHash);
+		if (decoded.cachedHandle >= 0) {
+			return decoded;
+		}
 	}
 
-	// Textureを読んで転送する
-	DirectX::ScratchImage mipImages = GetInstance().LoadTexture(filePath);
-	const DirectX::TexMetadata& metadata = mipImages.GetMetadata();
+	// Textureを読む（マップしたファイルをそのままデコードする）
+	decoded.mipImages = isCooked ? LoadCookedTextureFromMemory(file.GetData(), file.GetSize()) : LoadTextureFromMemory(file.GetData(), file.GetSize(), mipThreadCount);
+
+	return decoded;
+}
+
+int TextureManager::LoadFromMemory(const std::string& name, const void* data, size_t size, ID3D12Device* device)
+{
+	TextureManager& instance = GetInstance();
+	uint64_t contentHash = HashBytes(data, size);
+
+	// 同じ名前か同じ内容の画像が読み込み済みであればそれを使う
+	{
+		std::lock_guard<std::mutex> lock(instance.mutex_);
+		int cachedHandle = instance.AcquireCachedTexture(name, contentHash);
+		if (cachedHandle >= 0) {
+			return cachedHandle;
+		}
+	}
+
+	// メモリ上の画像ファイルからTextureを読む
+	DirectX::ScratchImage mipImages = LoadTextureFromMemory(data, size);
+
+	// Textureを転送する
+	int handle = CreateTexture(std::move(mipImages), name, contentHash, device);
+	TextureUploader::Flush();
+	return handle;
+}
+
+int TextureManager::LoadFromImage(const std::string& name, DirectX::ScratchImage&& mipImages, uint64_t contentHash, ID3D12Device* device)
+{
+	// Textureを転送する（キャッシュにあればCreateTextureがそれを返す）
+	int handle = CreateTexture(std::move(mipImages), name, contentHash, device);
+	TextureUploader::Flush();
+	return handle;
+}
+
+void TextureManager::Unload(uint32_t textureHandle)
+{
+	TextureManager& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	assert(instance.allocator_.IsValid(textureHandle));
+
+	TextureEntry& entry = instance.textures_[DescriptorAllocator::GetIndex(textureHandle)];
+	assert(entry.refCount > 0);
+	if (--entry.refCount > 0) {
+		return;
+	}
+
+	// すぐには解放せず、予算を超えたときに追い出せるキャッシュとして残す（再び読み込まれたら再利用する）
+	entry.cacheEntryId = ResourceBudget::GetInstance().AddCacheEntry({ GetTrackedAllocationId(entry.resource.Get()) }, [textureHandle]() {
+		TextureManager::Evict(textureHandle);
+	});
+}
+
+void TextureManager::Evict(uint32_t textureHandle)
+{
+	TextureManager& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+
+	// 追い出すまでの間に再び読み込まれていれば何もしない
+	if (!instance.allocator_.IsValid(textureHandle)) {
+		return;
+	}
+	TextureEntry& entry = instance.textures_[DescriptorAllocator::GetIndex(textureHandle)];
+	if (entry.refCount > 0) {
+		return;
+	}
+
+	// キャッシュから取り除く
+	for (const std::string& name : entry.names) {
+		instance.nameCache_.erase(name);
+	}
+	if (auto itr = instance.contentCache_.find(entry.contentHash); itr != instance.contentCache_.end() && itr->second == textureHandle) {
+		instance.contentCache_.erase(itr);
+	}
+
+	// このフレームまでのコマンドが参照している可能性があるので、リソースと場所はGPUが使い終わってから解放する
+	uint64_t fenceValue = DirectXBase::GetInstance()->GetFenceValue() + 1;
+	instance.retiredResources_.push_back({ fenceValue, std::move(entry.resource), nullptr });
+	instance.allocator_.Free(textureHandle, fenceValue);
+	instance.RemoveStreaming(entry);
+	entry = TextureEntry{};
+}
+
+bool TextureManager::Update(ID3D12Device* device)
+{
+	TextureManager& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	DirectXBase* dxBase = DirectXBase::GetInstance();
+
+	// GPUが使い終わったリソースを解放し、場所を再利用できるようにする
+	uint64_t completedFenceValue = dxBase->GetCompletedFenceValue();
+	instance.allocator_.Retire(completedFenceValue);
+	while (!instance.retiredResources_.empty() && instance.retiredResources_.front().fenceValue <= completedFenceValue) {
+		instance.retiredResources_.pop_front();
+	}
+
+	// このフレームの領域を前回使ったフレームはGPUが終えているので、その後に変更されたSRVをコピーしてよい
+	uint32_t frameIndex = dxBase->GetFrameIndex();
+	for (uint32_t index : instance.pendingCopies_[frameIndex]) {
+		if (index < instance.regionSize_) {
+			device->CopyDescriptorsSimple(1, instance.srvHeap_.GetCPUHandle(frameIndex * instance.regionSize_ + index), instance.stagingHeap_.GetCPUHandle(index), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+		}
+	}
+	instance.pendingCopies_[frameIndex].clear();
+
+	// 描画用のDescriptorHeapに収まっていれば何もしない
+	uint32_t capacity = instance.allocator_.GetCapacity();
+	if (capacity <= instance.regionSize_) {
+		return false;
+	}
+
+	// 大きいDescriptorHeapを作り、全フレームの領域にImGuiのフォント（先頭）以外のSRVをCPU側のDescriptorHeapからコピーする
+	uint32_t framesInFlight = uint32_t(instance.pendingCopies_.size());
+	DescriptorHeap srvHeap;
+	srvHeap.Create(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, capacity * framesInFlight, true);
+	uint32_t usedRange = instance.allocator_.GetUsedRange();
+	for (uint32_t region = 0; region < framesInFlight; ++region) {
+		if (usedRange > 1) {
+			device->CopyDescriptorsSimple(usedRange - 1, srvHeap.GetCPUHandle(region * capacity + 1), instance.stagingHeap_.GetCPUHandle(1), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+		}
+		instance.pendingCopies_[region].clear();
+	}
+
+	// 古いDescriptorHeapは、これまでに積んだコマンドが終わるまで保持する
+	instance.retiredResources_.push_back({ dxBase->GetFenceValue() + 1, nullptr, instance.srvHeap_.heap_ });
+	Log(std::format("TextureManager : descriptor heap grown from {} to {}\n", instance.regionSize_, capacity));
+	instance.srvHeap_ = srvHeap;
+	instance.regionSize_ = capacity;
+
+	return true;
+}
+
+size_t TextureManager::GetLoadedCount()
+{
+	TextureManager& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+
+	return instance.allocator_.GetAllocatedCount();
+}
+
+void TextureManager::EnableMipStreaming(uint64_t budgetBytes)
+{
+	TextureManager& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+
+	instance.isStreamingEnabled_ = true;
+	instance.residency_.SetBudget(budgetBytes);
+}
+
+void TextureManager::ReportUsage(uint32_t textureHandle, const Float3& center, float radius)
+{
+	TextureManager& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	instance.AddUsage(textureHandle, center, radius);
+}
+
+void TextureManager::ReportUsages(const std::vector<TextureUsageReport>& reports)
+{
+	if (reports.empty()) {
+		return;
+	}
+	TextureManager& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	for (const TextureUsageReport& report : reports) {
+		instance.AddUsage(report.textureHandle, report.center, report.radius);
+	}
+}
+
+void TextureManager::AddUsage(uint32_t textureHandle, const Float3& center, float radius)
+{
+	if (!isStreamingEnabled_ || !allocator_.IsValid(textureHandle)) {
+		return;
+	}
+
+	// ストリーミングしていないTextureは報告しなくてよい
+	const TextureEntry& entry = textures_[DescriptorAllocator::GetIndex(textureHandle)];
+	if (entry.streamId != MipResidency::kInvalidId) {
+		usages_.push_back({ entry.streamId, center, radius });
+	}
+}
+
+void TextureManager::UpdateStreaming(const MipCamera& camera, ID3D12Device* device)
+{
+	TextureManager& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	if (!instance.isStreamingEnabled_) {
+		return;
+	}
+
+	// 前のフレームの使用状況から常駐させるミップを決める
+	instance.residency_.Update(camera, instance.usages_);
+	instance.usages_.clear();
+	const std::vector<MipResidencyChange>& changes = instance.residency_.GetChanges();
+	if (changes.empty()) {
+		return;
+	}
+
+	// 常駐させるミップが変わったTextureは、そのミップ以降だけを持つリソースを作り直して転送する
+	uint64_t fenceValue = DirectXBase::GetInstance()->GetFenceValue() + 1;
+	for (const MipResidencyChange& change : changes) {
+		uint32_t handle = instance.streamHandles_[change.textureId];
+		uint32_t index = DescriptorAllocator::GetIndex(handle);
+		TextureEntry& entry = instance.textures_[index];
+
+		DirectX::TexMetadata metadata = GetMipRangeMetadata(entry.streamSource->GetMetadata(), change.newResidentMip);
+		Microsoft::WRL::ComPtr<ID3D12Resource> resource = CreateTextureResource(device, metadata);
+		UploadTextureData(resource.Get(), *entry.streamSource, change.newResidentMip);
+
+		// 同じ場所にSRVを作り直す（描画用のDescriptorHeapには、前のフレームが使っていない領域から順にコピーされる）
+		CreateShaderResourceView(resource.Get(), metadata, index, device);
+		// 以前のリソースは、これまでに積んだコマンドが終わるまで保持する
+		instance.retiredResources_.push_back({ fenceValue, std::move(entry.resource), nullptr });
+		entry.resource = std::move(resource);
+	}
+	// 描画キューは転送が終わるのを待ってから描画する
+	TextureUploader::Flush();
+}
+
+int TextureManager::CreateTexture(DirectX::ScratchImage&& mipImages, const std::string& name, uint64_t contentHash, ID3D12Device* device)
+{
+	TextureManager& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+
+	// デコードしている間に別のスレッドが同じ画像を読み込んでいた場合はそれを使う
+	int cachedHandle = instance.AcquireCachedTexture(name, contentHash);
+	if (cachedHandle >= 0) {
+		return cachedHandle;
+	}
+
+	// SRVを作成するDescriptorHeapの場所を決める（解放された場所があれば再利用し、無ければ容量を増やす）
+	uint32_t handle = instance.allocator_.Allocate();
+	uint32_t index = DescriptorAllocator::GetIndex(handle);
+	if (instance.allocator_.GetCapacity() > instance.stagingHeap_.GetNumDescriptors()) {
+		instance.GrowStagingHeap(device);
+	}
+
+	DirectX::TexMetadata metadata = mipImages.GetMetadata();
+	TextureEntry& entry = instance.textures_[index];
+
+	// ストリーミングする場合は、常に常駐させるミップ以降だけを転送し、詳細なミップのためにTextureデータを保持しておく
+	uint32_t firstMip = instance.isStreamingEnabled_ ? ComputeMinResidentMip(metadata) : 0;
+	if (firstMip > 0) {
+		StreamedTextureInfo info{ uint32_t(metadata.width), uint32_t(metadata.height), {}, firstMip };
+		for (size_t mip = 0; mip < metadata.mipLevels; ++mip) {
+			uint64_t mipSize = 0;
+			for (size_t item = 0; item < metadata.arraySize; ++item) {
+				mipSize += mipImages.GetImage(mip, item, 0)->slicePitch;
+			}
+			info.mipSizes.push_back(mipSize);
+		}
+		entry.streamId = instance.residency_.AddTexture(info);
+		if (entry.streamId >= instance.streamHandles_.size()) {
+			instance.streamHandles_.resize(entry.streamId + 1);
+		}
+		instance.streamHandles_[entry.streamId] = handle;
+		metadata = GetMipRangeMetadata(metadata, firstMip);
+	}
 
 	// リソースの配列に保存
-	Microsoft::WRL::ComPtr<ID3D12Resource>& targetResource = GetInstance().texResources[GetInstance().index_];
-	targetResource = TextureManager::CreateTextureResource(device, metadata);
+	entry.resource = TextureManager::CreateTextureResource(device, metadata);
+
+	TextureManager::UploadTextureData(entry.resource.Get(), mipImages, firstMip);
+	if (firstMip > 0) {
+		entry.streamSource = std::make_unique<DirectX::ScratchImage>(std::move(mipImages));
+	}
+
+	// SRVの生成
+	CreateShaderResourceView(entry.resource.Get(), metadata, index, device);
+
+	// キャッシュに登録する
+	entry.refCount = 1;
+	entry.contentHash = contentHash;
+	entry.names = { name };
+	instance.nameCache_[name] = handle;
+	instance.contentCache_[contentHash] = handle;
+
+	return handle;
+}
+
+void TextureManager::GrowStagingHeap(ID3D12Device* device)
+{
+	// CPU側のDescriptorHeapはGPUから参照されないので、すぐに作り直してよい
+	uint32_t capacity = allocator_.GetCapacity();
+	DescriptorHeap stagingHeap;
+	stagingHeap.Create(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, capacity, false);
+	device->CopyDescriptorsSimple(stagingHeap_.GetNumDescriptors(), stagingHeap.GetCPUHandle(0), stagingHeap_.GetCPUHandle(0), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	stagingHeap_ = stagingHeap;
+	textures_.resize(capacity);
+}
+
+uint32_t TextureManager::ComputeMinResidentMip(const DirectX::TexMetadata& metadata)
+{
+	// 常に常駐させるのは、長辺が64ピクセル以上ある最も小さいミップ
+	const size_t kMinResidentSize = 64;
+	uint32_t mip = 0;
+	while (mip + 1 < metadata.mipLevels && (std::max)(metadata.width >> (mip + 1), metadata.height >> (mip + 1)) >= kMinResidentSize) {
+		mip++;
+	}
+
+	// ブロック圧縮のTextureは最上位のミップのサイズが4の倍数である必要がある
+	if (DirectX::IsCompressed(metadata.format)) {
+		while (mip > 0 && ((metadata.width >> mip) % 4 != 0 || (metadata.height >> mip) % 4 != 0)) {
+			mip--;
+		}
+	}
+	return mip;
+}
+
+DirectX::TexMetadata TextureManager::GetMipRangeMetadata(const DirectX::TexMetadata& metadata, uint32_t firstMip)
+{
+	DirectX::TexMetadata result = metadata;
+	result.width = (std::max)(metadata.width >> firstMip, size_t(1));
+	result.height = (std::max)(metadata.height >> firstMip, size_t(1));
+	result.mipLevels = metadata.mipLevels - firstMip;
+	return result;
+}
+
+void TextureManager::RemoveStreaming(TextureEntry& entry)
+{
+	if (entry.streamId == MipResidency::kInvalidId) {
+		return;
+	}
+	residency_.RemoveTexture(entry.streamId);
+	entry.streamId = MipResidency::kInvalidId;
+	entry.streamSource.reset();
+}
+
+int TextureManager::AcquireCachedTexture(const std::string& name, std::optional<uint64_t> contentHash)
+{
+	uint32_t handle = DescriptorAllocator::kInvalidHandle;
+	if (auto itr = nameCache_.find(name); itr != nameCache_.end()) {
+		handle = itr->second;
+	} else if (contentHash && isContentSharingEnabled_) {
+		auto contentItr = contentCache_.find(*contentHash);
+		if (contentItr == contentCache_.end()) {
+			return -1;
+		}
+		// 同じ内容の画像なので、このパスでも見つかるようにする
+		handle = contentItr->second;
+		textures_[DescriptorAllocator::GetIndex(handle)].names.push_back(name);
+		nameCache_[name] = handle;
+	} else {
+		return -1;
+	}
+
+	// 使われずにキャッシュに残っていたTextureは、追い出す対象から外す
+	TextureEntry& entry = textures_[DescriptorAllocator::GetIndex(handle)];
+	if (entry.refCount++ == 0) {
+		ResourceBudget::GetInstance().RemoveCacheEntry(entry.cacheEntryId);
+		entry.cacheEntryId = ResourceBudget::kInvalidId;
+	}
+	return handle;
+}
+
+std::string TextureManager::CanonicalizePath(const std::string& filePath)
+{
+	// 相対パスの違いや"./"、".."を吸収する
+	std::error_code errorCode;
+	std::filesystem::path path = std::filesystem::weakly_canonical(std::filesystem::path(filePath), errorCode);
+	if (errorCode) {
+		path = std::filesystem::path(filePath).lexically_normal();
+	}
+	std::string result = path.generic_string();
 
-	TextureManager::GetInstance().UploadTextureData(targetResource.Get(), mipImages);
+#ifdef _WIN32
+	// Windowsではパスの大文字と小文字を区別しない
+	std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+#endif
 
+	return result;
+}
+
+void TextureManager::CreateShaderResourceView(ID3D12Resource* resource, const DirectX::TexMetadata& metadata, uint32_t index, ID3D12Device* device)
+{
 	// metaDataを基にSRVの設定
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
 	srvDesc.Format = metadata.format;
@@ -32,13 +494,56 @@ int TextureManager::Load(const std::string& filePath, ID3D12Device* device)
 	srvDesc.Texture2D.MipLevels = UINT(metadata.mipLevels);
 
 	// SRVの生成
-	device->CreateShaderResourceView(targetResource.Get(), &srvDesc, GetInstance().srvHeap_.GetCPUHandle(GetInstance().index_));
+	TextureManager& instance = GetInstance();
+	device->CreateShaderResourceView(resource, &srvDesc, instance.stagingHeap_.GetCPUHandle(index));
+
+	instance.CopyToShaderVisibleHeap(index, device);
+}
 
-	// SRVを作成するDescriptorHeapの場所を決める
-	GetInstance().index_++;
+void TextureManager::CopyToShaderVisibleHeap(uint32_t index, ID3D12Device* device)
+{
+	// 描画用のDescriptorHeapに収まらない場合はUpdateで作り直すときにコピーされる
+	if (index >= regionSize_) {
+		return;
+	}
 
-	// 実際に返すのはインクリメントする前の値なので1引いて返す
-	return GetInstance().index_ - 1;
+	// このフレームの領域はまだGPUが使っていないのですぐにコピーする
+	// 他の領域は前のフレームのコマンドが前のSRVを参照しているかもしれないので、そのフレームになったらUpdateでコピーする
+	uint32_t frameIndex = DirectXBase::GetInstance()->GetFrameIndex();
+	for (uint32_t region = 0; region < pendingCopies_.size(); ++region) {
+		if (region == frameIndex) {
+			device->CopyDescriptorsSimple(1, srvHeap_.GetCPUHandle(region * regionSize_ + index), stagingHeap_.GetCPUHandle(index), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+		} else {
+			pendingCopies_[region].push_back(index);
+		}
+	}
+}
+
+Microsoft::WRL::ComPtr<ID3D12Resource> TextureManager::ReplaceTexture(uint32_t textureHandle, Microsoft::WRL::ComPtr<ID3D12Resource> resource, const DirectX::TexMetadata& metadata, ID3D12Device* device)
+{
+	TextureManager& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+
+	// 読み直している間に解放されたTextureは差し替えない
+	if (!instance.allocator_.IsValid(textureHandle)) {
+		return resource;
+	}
+
+	// 同じ場所にSRVを作り直すので、ハンドルを持っている側はそのまま使える
+	uint32_t index = DescriptorAllocator::GetIndex(textureHandle);
+	CreateShaderResourceView(resource.Get(), metadata, index, device);
+	TextureEntry& entry = instance.textures_[index];
+	entry.resource.Swap(resource);
+	// 読み直したTextureは全ミップを持っているので、ストリーミングの対象から外す
+	instance.RemoveStreaming(entry);
+
+	// 内容が変わったので、以前の内容のハッシュ値では共有しないようにする
+	if (auto itr = instance.contentCache_.find(entry.contentHash); itr != instance.contentCache_.end() && itr->second == textureHandle) {
+		instance.contentCache_.erase(itr);
+	}
+
+	// 差し替え前のリソース（GPUが使い終わるまで保持する必要がある）
+	return resource;
 }
 
 TextureManager& TextureManager::GetInstance()
@@ -50,28 +555,211 @@ TextureManager& TextureManager::GetInstance()
 
 void TextureManager::SetDescriptorTable(UINT rootParamIndex, ID3D12GraphicsCommandList* commandList, uint32_t textureHandle)
 {
-	commandList->SetGraphicsRootDescriptorTable(rootParamIndex, GetInstance().srvHeap_.GetGPUHandle(textureHandle));
+	TextureManager& instance = GetInstance();
+#ifdef _DEBUG
+	// 解放済みのハンドルを使っていないか確認する
+	{
+		std::lock_guard<std::mutex> lock(instance.mutex_);
+		if (!instance.allocator_.IsValid(textureHandle)) {
+			Log(std::format("Invalid or released texture handle:{:#x}\n", textureHandle));
+			assert(0);
+		}
+	}
+#endif
+
+	// 描画用のDescriptorHeapの拡張はフレームの区切りで行うので、このフレームで読み込んだ分が収まらない場合がある
+	uint32_t index = DescriptorAllocator::GetIndex(textureHandle);
+	assert(index < instance.regionSize_);
+	// このフレームの領域のSRVを使う
+	uint32_t frameIndex = DirectXBase::GetInstance()->GetFrameIndex();
+	commandList->SetGraphicsRootDescriptorTable(rootParamIndex, instance.srvHeap_.GetGPUHandle(frameIndex * instance.regionSize_ + index));
+}
+
+DirectX::ScratchImage TextureManager::LoadTexture(const std::string& filePath, uint32_t mipThreadCount)
+{
+	// ミップマップ付きのデータを返す
+	return GenerateMipMaps(DecodeSourceImage(filePath), mipThreadCount);
 }
 
-DirectX::ScratchImage TextureManager::LoadTexture(const std::string& filePath)
+DirectX::ScratchImage TextureManager::DecodeSourceImage(const std::string& filePath)
 {
 	HRESULT result = S_FALSE;
 
+	// 組み込みのデコーダを使う場合は、ファイルをマップしてメモリから読む
+	if (GetImageDecoder() == ImageDecoder::Builtin) {
+		MappedFile file;
+		if (file.Open(filePath) && PngDecoder::IsPng(file.GetData(), file.GetSize())) {
+			DirectX::ScratchImage image = DecodePng(file.GetData(), file.GetSize());
+			if (image.GetImageCount() > 0) {
+				return image;
+			}
+			// デコードできなかったPNGはWICに任せる
+			Log("TextureManager : failed to decode PNG with the builtin decoder, falling back to WIC\n");
+		}
+	}
+
 	// テクスチャファイルを読み込んでプログラムで扱えるようにする
 	DirectX::ScratchImage image{};
 	std::wstring filePathW = ConvertString(filePath);
 	result = DirectX::LoadFromWICFile(filePathW.c_str(), DirectX::WIC_FLAGS_FORCE_SRGB, nullptr, image);
 	assert(SUCCEEDED(result));
+	return image;
+}
+
+DirectX::ScratchImage TextureManager::LoadBaseImage(const std::string& filePath)
+{
+	HRESULT result = S_FALSE;
+	DirectX::ScratchImage image{};
 
-	// ミップマップの作成
+	if (TextureCooker::IsCookedUpToDate(filePath)) {
+		// 変換済みのDDSは圧縮されているので、先頭のミップだけを展開する
+		DirectX::ScratchImage mipImages = LoadCookedTexture(TextureCooker::GetCookedPath(filePath));
+		const DirectX::Image& base = *mipImages.GetImage(0, 0, 0);
+		if (DirectX::IsCompressed(base.format)) {
+			result = DirectX::Decompress(base, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, image);
+		} else {
+			result = image.InitializeFromImage(base);
+		}
+		assert(SUCCEEDED(result));
+	} else {
+		image = DecodeSourceImage(filePath);
+	}
+
+	// RGBA8（sRGB）に揃える
+	if (image.GetMetadata().format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB) {
+		return image;
+	}
+	DirectX::ScratchImage convertedImage{};
+	result = DirectX::Convert(*image.GetImage(0, 0, 0), DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, convertedImage);
+	assert(SUCCEEDED(result));
+	return convertedImage;
+}
+
+DirectX::ScratchImage TextureManager::GenerateMipMaps(const DirectX::ScratchImage& image, uint32_t mipThreadCount, uint32_t mipLevels)
+{
+	HRESULT result = S_FALSE;
+	const DirectX::TexMetadata& metadata = image.GetMetadata();
 	DirectX::ScratchImage mipImages{};
-	result = DirectX::GenerateMipMaps(image.GetImages(), image.GetImageCount(), image.GetMetadata(), DirectX::TEX_FILTER_SRGB, 0, mipImages);
+
+	// RGBA8のsRGB以外（16bitの画像など）はDirectXTexで生成する
+	if (metadata.format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB || metadata.arraySize != 1 || metadata.dimension != DirectX::TEX_DIMENSION_TEXTURE2D) {
+		result = DirectX::GenerateMipMaps(image.GetImages(), image.GetImageCount(), metadata, DirectX::TEX_FILTER_SRGB, mipLevels, mipImages);
+		assert(SUCCEEDED(result));
+		return mipImages;
+	}
+
+	// リニアで縮小したミップをScratchImageにコピーする
+	const DirectX::Image& source = *image.GetImage(0, 0, 0);
+	std::vector<MipLevel> levels = MipGenerator::Generate(source.pixels, uint32_t(source.width), uint32_t(source.height), source.rowPitch, MipFilter::Box, mipThreadCount, mipLevels);
+	result = mipImages.Initialize2D(metadata.format, metadata.width, metadata.height, 1, levels.size());
+	assert(SUCCEEDED(result));
+	for (size_t mip = 0; mip < levels.size(); ++mip) {
+		const DirectX::Image& destination = *mipImages.GetImage(mip, 0, 0);
+		for (uint32_t y = 0; y < levels[mip].height; ++y) {
+			std::memcpy(destination.pixels + y * destination.rowPitch, levels[mip].pixels.data() + size_t(y) * levels[mip].width * 4, size_t(levels[mip].width) * 4);
+		}
+	}
+	return mipImages;
+}
+
+DirectX::ScratchImage TextureManager::LoadCookedTexture(const std::string& filePath)
+{
+	HRESULT result = S_FALSE;
+
+	// DDSファイルにはミップマップまで含まれているので、読み込むだけでよい
+	DirectX::ScratchImage mipImages{};
+	std::wstring filePathW = ConvertString(filePath);
+	result = DirectX::LoadFromDDSFile(filePathW.c_str(), DirectX::DDS_FLAGS_NONE, nullptr, mipImages);
 	assert(SUCCEEDED(result));
 
-	// ミップマップ付きのデータを返す
 	return mipImages;
 }
 
+DirectX::ScratchImage TextureManager::LoadCookedTextureFromMemory(const void* data, size_t size)
+{
+	HRESULT result = S_FALSE;
+
+	// DDSファイルにはミップマップまで含まれているので、読み込むだけでよい
+	DirectX::ScratchImage mipImages{};
+	result = DirectX::LoadFromDDSMemory(data, size, DirectX::DDS_FLAGS_NONE, nullptr, mipImages);
+	assert(SUCCEEDED(result));
+
+	return mipImages;
+}
+
+DirectX::ScratchImage TextureManager::LoadTextureFromMemory(const void* data, size_t size, uint32_t mipThreadCount)
+{
+	HRESULT result = S_FALSE;
+
+	// 組み込みのデコーダを使う場合はPNGをPngDecoderでデコードする
+	if (GetImageDecoder() == ImageDecoder::Builtin && PngDecoder::IsPng(data, size)) {
+		DirectX::ScratchImage image = DecodePng(data, size);
+		if (image.GetImageCount() > 0) {
+			return GenerateMipMaps(image, mipThreadCount);
+		}
+		// デコードできなかったPNGはWICに任せる
+		Log("TextureManager : failed to decode PNG with the builtin decoder, falling back to WIC\n");
+	}
+
+	// メモリ上の画像ファイルを読み込んでプログラムで扱えるようにする
+	DirectX::ScratchImage image{};
+	result = DirectX::LoadFromWICMemory(data, size, DirectX::WIC_FLAGS_FORCE_SRGB, nullptr, image);
+	assert(SUCCEEDED(result));
+
+	// ミップマップ付きのデータを返す
+	return GenerateMipMaps(image, mipThreadCount);
+}
+
+void TextureManager::SetContentSharing(bool isEnabled)
+{
+	TextureManager& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	instance.isContentSharingEnabled_ = isEnabled;
+}
+
+bool TextureManager::IsSharedWithOtherPath(uint32_t textureHandle, const std::string& filePath)
+{
+	TextureManager& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	if (!instance.allocator_.IsValid(textureHandle)) {
+		return false;
+	}
+
+	std::string name = CanonicalizePath(filePath);
+	const TextureEntry& entry = instance.textures_[DescriptorAllocator::GetIndex(textureHandle)];
+	return std::any_of(entry.names.begin(), entry.names.end(), [&name](const std::string& entryName) { return entryName != name; });
+}
+
+void TextureManager::SetImageDecoder(ImageDecoder decoder)
+{
+	GetInstance().imageDecoder_ = decoder;
+}
+
+ImageDecoder TextureManager::GetImageDecoder()
+{
+	return GetInstance().imageDecoder_;
+}
+
+DirectX::ScratchImage TextureManager::DecodePng(const void* data, size_t size)
+{
+	HRESULT result = S_FALSE;
+	DirectX::ScratchImage image{};
+
+	PngImage png;
+	if (!PngDecoder::Decode(data, size, png)) {
+		return image;
+	}
+
+	// WICと同じく、色はsRGBとして扱う
+	result = image.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, png.width, png.height, 1, 1);
+	assert(SUCCEEDED(result));
+	const DirectX::Image& destination = *image.GetImage(0, 0, 0);
+	for (uint32_t y = 0; y < png.height; ++y) {
+		std::memcpy(destination.pixels + y * destination.rowPitch, png.pixels.data() + size_t(y) * png.width * 4, size_t(png.width) * 4);
+	}
+	return image;
+}
+
 Microsoft::WRL::ComPtr<ID3D12Resource> TextureManager::CreateTextureResource(ID3D12Device* device, const DirectX::TexMetadata& metadata)
 {
 	HRESULT result = S_FALSE;
@@ -86,11 +774,9 @@ Microsoft::WRL::ComPtr<ID3D12Resource> TextureManager::CreateTextureResource(ID3
 	resourceDesc.SampleDesc.Count = 1; // サンプリングカウント。1固定
 	resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION(metadata.dimension); // Textureの次元数
 
-	// 利用するHeapの設定
+	// 利用するHeapの設定（VRAMに配置し、TextureUploaderでコピーして転送する）
 	D3D12_HEAP_PROPERTIES heapProperties{};
-	heapProperties.Type = D3D12_HEAP_TYPE_CUSTOM; // 細かい設定を行う
-	heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_WRITE_BACK; // WriteBackポリシーでCPUアクセス可能
-	heapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_L0; // プロセッサの近くに配置
+	heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
 
 	// Resourceを生成する
 	Microsoft::WRL::ComPtr<ID3D12Resource> resource = nullptr;
@@ -98,32 +784,17 @@ Microsoft::WRL::ComPtr<ID3D12Resource> TextureManager::CreateTextureResource(ID3
 		&heapProperties, // Heapの設定
 		D3D12_HEAP_FLAG_NONE, // Heapの特殊な設定
 		&resourceDesc, // Resourceの設定
-		D3D12_RESOURCE_STATE_GENERIC_READ, // 初回のResourceState
+		D3D12_RESOURCE_STATE_COMMON, // 初回のResourceState（コピーキューではCOPY_DEST、描画キューではSRVに暗黙的に遷移する）
 		nullptr, // Clear最適値
 		IID_PPV_ARGS(&resource)); // 作成するResourceポインタへのポインタ
 	assert(SUCCEEDED(result));
+	TrackResource(device, resource.Get(), ResourceCategory::Texture);
 
 	return std::move(resource);
 }
 
-void TextureManager::UploadTextureData(ID3D12Resource* texture, const DirectX::ScratchImage& mipImages)
+void TextureManager::UploadTextureData(ID3D12Resource* texture, const DirectX::ScratchImage& mipImages, uint32_t firstMip)
 {
-	HRESULT result = S_FALSE;
-
-	// Meta情報を取得
-	const DirectX::TexMetadata& metadata = mipImages.GetMetadata();
-	// 全MipMapについて
-	for (size_t mipLevel = 0; mipLevel < metadata.mipLevels; ++mipLevel) {
-		// MipMapLevelを指定して各Imageを取得
-		const DirectX::Image* img = mipImages.GetImage(mipLevel, 0, 0);
-		// Textureに転送
-		result = texture->WriteToSubresource(
-			UINT(mipLevel),
-			nullptr, // 全領域へコピー
-			img->pixels, // 元データアドレス
-			UINT(img->rowPitch), // 1ラインサイズ
-			UINT(img->slicePitch) // 1枚サイズ
-		);
-		assert(SUCCEEDED(result));
-	}
+	// firstMip以降の全MipMapのコピーを記録する（TextureUploader::Flushで転送される）
+	TextureUploader::Upload(texture, mipImages, firstMip);
 }
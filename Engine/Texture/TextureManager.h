@@ -4,31 +4,202 @@
 #include "StringUtil.h"
 #include "Logger.h"
 #include "DescriptorHeap.h"
-#include <array>
+#include "DescriptorAllocator.h"
+#include "MipResidency.h"
+#include "ResourceBudget.h"
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// 画像ファイル（PNG）のデコードに使う実装
+enum class ImageDecoder {
+	Wic, // WIC（DirectXTexのLoadFromWIC～）
+	Builtin, // PngDecoder（PNG以外の画像はWICでデコードする）
+};
+
+// 描画に使ったTextureの報告（並列に記録するチャンクごとにまとめ、ReportUsagesで1回のロックで渡す）
+struct TextureUsageReport {
+	uint32_t textureHandle;
+	Float3 center;
+	float radius;
+};
 
 class TextureManager final
 {
+	// 読み込んだTextureの情報
+	struct TextureEntry {
+		Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+		uint32_t refCount = 0;
+		uint64_t contentHash = 0; // 画像ファイルの内容のハッシュ値
+		std::vector<std::string> names; // このTextureを指しているパス
+		// ストリーミングする場合の全ミップのTextureデータと、MipResidencyでのID
+		std::unique_ptr<DirectX::ScratchImage> streamSource;
+		uint32_t streamId = MipResidency::kInvalidId;
+		// 参照カウントが0でキャッシュに残っている場合の、ResourceBudgetでのID
+		uint64_t cacheEntryId = ResourceBudget::kInvalidId;
+	};
+
 public:
 	static void Initialize(ID3D12Device* device);
 
+	// 同じファイル、または内容が同じファイルが読み込み済みの場合は既存のハンドルを返す（参照カウントが増える）
 	static int Load(const std::string& filePath, ID3D12Device* device);
 
+	// 複数の画像をまとめて読み込む（デコードとミップマップの生成を複数のスレッドで行う。threadCountが0の場合はハードウェアのスレッド数）
+	static std::vector<uint32_t> LoadBatch(const std::vector<std::string>& filePaths, ID3D12Device* device, uint32_t threadCount = 0);
+
+	// メモリ上の画像ファイル（glTFに埋め込まれた画像など）から読み込む
+	static int LoadFromMemory(const std::string& name, const void* data, size_t size, ID3D12Device* device);
+
+	// CPUで作ったTextureデータ（アトラスのページなど）から作る（同じ名前か同じcontentHashのTextureが読み込み済みの場合はそれを使う）
+	static int LoadFromImage(const std::string& name, DirectX::ScratchImage&& mipImages, uint64_t contentHash, ID3D12Device* device);
+
+	// 参照カウントを減らす。0になったTextureはキャッシュに残し、ResourceBudgetの予算を超えたら古い順にハンドルを無効にする
+	// （リソースと場所はGPUが使い終わってから再利用される）
+	static void Unload(uint32_t textureHandle);
+
+	// GPUが使い終わったTextureを解放し、描画用のDescriptorHeapのこのフレームの領域に変更されたSRVをコピーする
+	// 描画用のDescriptorHeapが足りなければ作り直す（作り直した場合はtrueを返す）
+	// フレームの区切りで呼ぶ。trueの場合はDescriptorHeapの先頭にあるImGuiのフォントのSRVを作り直す必要がある
+	static bool Update(ID3D12Device* device);
+
+	// 読み込まれているTextureの数
+	static size_t GetLoadedCount();
+
+	// ミップのストリーミングを有効にする（以降に読み込む大きなTextureは小さいミップだけを転送し、画面上の大きさに応じて詳細なミップを予算の範囲で転送する）
+	static void EnableMipStreaming(uint64_t budgetBytes);
+	// 描画に使ったTextureと、それを使うオブジェクトのワールド座標での境界球を報告する
+	static void ReportUsage(uint32_t textureHandle, const Float3& center, float radius);
+	// まとめておいた報告を順に報告する
+	static void ReportUsages(const std::vector<TextureUsageReport>& reports);
+	// 報告された使用状況から常駐させるミップを決め直し、変わったTextureを作り直す（フレームの区切りで呼ぶ）
+	static void UpdateStreaming(const MipCamera& camera, ID3D12Device* device);
+
 	static TextureManager& GetInstance();
 
 	static void SetDescriptorTable(UINT rootParamIndex, ID3D12GraphicsCommandList* commandList, uint32_t textureHandle);
 
+	// 指定したハンドルのTextureを差し替え、SRVを作り直す（差し替え前のリソースを返す）
+	static Microsoft::WRL::ComPtr<ID3D12Resource> ReplaceTexture(uint32_t textureHandle, Microsoft::WRL::ComPtr<ID3D12Resource> resource, const DirectX::TexMetadata& metadata, ID3D12Device* device);
+
+	// TextureデータをCPUで読む（デコードしてミップマップを生成する。mipThreadCountはミップマップの生成に使うスレッド数で、0の場合はハードウェアのスレッド数）
+	static DirectX::ScratchImage LoadTexture(const std::string& filePath, uint32_t mipThreadCount = 0);
+	// 1枚の画像からミップマップを生成する（RGBA8のsRGBはMipGeneratorで、それ以外はDirectXTexで生成する。mipLevelsが0の場合は1x1まで）
+	static DirectX::ScratchImage GenerateMipMaps(const DirectX::ScratchImage& image, uint32_t mipThreadCount = 0, uint32_t mipLevels = 0);
+	// 変換済みのDDSファイルからTextureデータを読む（ミップマップは生成済み）
+	static DirectX::ScratchImage LoadCookedTexture(const std::string& filePath);
+	// 画像ファイルをミップマップの無いRGBA8（sRGB）の画像として読む
+	// （変換済みのDDSがあればその先頭のミップを展開し、無ければLoadTextureと同じデコーダでデコードする）
+	static DirectX::ScratchImage LoadBaseImage(const std::string& filePath);
+
+	// 内容が同じ画像を別のパスから読み込んだときに、同じTextureを共有するか（既定は共有する）
+	// ホットリロードはパスごとに差し替えるので、共有すると変更していない方のパスのTextureまで差し替わる。読み込む前に無効にする
+	static void SetContentSharing(bool isEnabled);
+	// 指定したハンドルのTextureを、filePath以外のパスも指しているか（内容が同じで共有している場合）
+	static bool IsSharedWithOtherPath(uint32_t textureHandle, const std::string& filePath);
+
+	// PNGのデコードに使う実装を選ぶ（既定はWIC。複数のスレッドから読むので、Textureを読み込む前に設定する）
+	static void SetImageDecoder(ImageDecoder decoder);
+	static ImageDecoder GetImageDecoder();
+	// PngDecoderでPNGをデコードしてRGBA8（sRGB）のTextureデータにする（ミップマップは生成しない。失敗した場合は空のScratchImageを返す）
+	static DirectX::ScratchImage DecodePng(const void* data, size_t size);
+
+	// 描画用のDescriptorHeap（同時にGPUで実行できるフレームごとの領域に分かれていて、先頭はImGuiのフォントが使う）
 	DescriptorHeap srvHeap_;
 private:
-	// TextureデータをCPUで読む
-	static DirectX::ScratchImage LoadTexture(const std::string& filePath);
+	// ホットリロードではワーカースレッドからTextureの読み込みのみを行う
+	friend class AssetHotReloader;
+
+	// デコードしたTextureデータ（読み込み済みの場合はcachedHandleにハンドルが入る）
+	struct DecodedTexture {
+		std::string name;
+		uint64_t contentHash = 0;
+		int cachedHandle = -1;
+		DirectX::ScratchImage mipImages;
+	};
+
+	// 変換前の画像ファイルを選んだデコーダでデコードする（ミップマップは生成しない）
+	static DirectX::ScratchImage DecodeSourceImage(const std::string& filePath);
+	// キャッシュに無ければ画像ファイルをデコードしてミップマップを生成する（複数のスレッドから呼べる）
+	static DecodedTexture DecodeTexture(const std::string& filePath, uint32_t mipThreadCount = 0);
+	// メモリ上の画像ファイルからTextureデータを読む
+	static DirectX::ScratchImage LoadTextureFromMemory(const void* data, size_t size, uint32_t mipThreadCount = 0);
+	// メモリ上のDDSファイルからTextureデータを読む
+	static DirectX::ScratchImage LoadCookedTextureFromMemory(const void* data, size_t size);
+	// 読み込んだTextureデータからリソースとSRVを作る
+	// （ストリーミングするTextureはmipImagesを保持するので、ムーブして渡す）
+	static int CreateTexture(DirectX::ScratchImage&& mipImages, const std::string& name, uint64_t contentHash, ID3D12Device* device);
+	// 読み込み済みのTextureを名前か内容のハッシュ値で探し、見つかれば参照カウントを増やしてハンドルを返す（mutex_をロックして呼ぶ）
+	int AcquireCachedTexture(const std::string& name, std::optional<uint64_t> contentHash);
+	// キャッシュのキーにするため、ファイルのパスを正規化する
+	static std::string CanonicalizePath(const std::string& filePath);
+	// CPU側のDescriptorHeapを確保した容量まで増やす（mutex_をロックして呼ぶ）
+	void GrowStagingHeap(ID3D12Device* device);
+	// metadataを基にSRVを作る（CPU側のDescriptorHeapに作り、描画用のDescriptorHeapに収まる場合はコピーする）
+	static void CreateShaderResourceView(ID3D12Resource* resource, const DirectX::TexMetadata& metadata, uint32_t index, ID3D12Device* device);
+	// CPU側のDescriptorHeapのSRVを、描画用のDescriptorHeapのこのフレームの領域にはすぐにコピーし、他のフレームの領域にはそのフレームになったらコピーする（mutex_をロックして呼ぶ）
+	void CopyToShaderVisibleHeap(uint32_t index, ID3D12Device* device);
+	// ストリーミングする場合に常に常駐させる最も詳細なミップ（ストリーミングしない場合は0）
+	static uint32_t ComputeMinResidentMip(const DirectX::TexMetadata& metadata);
+	// firstMip以降のミップだけを持つTextureのmetadata
+	static DirectX::TexMetadata GetMipRangeMetadata(const DirectX::TexMetadata& metadata, uint32_t firstMip);
+	// 使われていないTextureをキャッシュから追い出す（ResourceBudgetから呼ばれる）
+	static void Evict(uint32_t textureHandle);
+	// ストリーミングの対象から外す（mutex_をロックして呼ぶ）
+	void RemoveStreaming(TextureEntry& entry);
+	// ストリーミングするTextureであれば使用状況に加える（mutex_をロックして呼ぶ）
+	void AddUsage(uint32_t textureHandle, const Float3& center, float radius);
 	// DirectX12のTextureResourceを作る
 	static Microsoft::WRL::ComPtr<ID3D12Resource> CreateTextureResource(ID3D12Device* device, const DirectX::TexMetadata& metadata);
-	// TextureResourceにデータを転送する
-	static void UploadTextureData(ID3D12Resource* texture, const DirectX::ScratchImage& mipImages);
+	// TextureResourceへのデータの転送を記録する（TextureUploader::Flushで実行される）
+	static void UploadTextureData(ID3D12Resource* texture, const DirectX::ScratchImage& mipImages, uint32_t firstMip = 0);
+
+	// GPUが使い終わるまで保持しておくリソース
+	struct RetiredResource {
+		uint64_t fenceValue;
+		Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> descriptorHeap;
+	};
+
+	// DescriptorHeapの初期の容量（足りなくなると2倍ずつ増える）
+	static const uint32_t kInitialDescriptorCount_ = 128;
+
+	// SRVの場所の確保（先頭はImGuiのフォントが使う）
+	DescriptorAllocator allocator_;
+	// SRVを作るCPU側のDescriptorHeap（描画用のDescriptorHeapを作り直すときのコピー元）
+	DescriptorHeap stagingHeap_;
+	// 描画用のDescriptorHeapの1フレーム分の領域の大きさ
+	uint32_t regionSize_ = 0;
+	// フレームの領域ごとの、まだコピーしていないSRVの場所（前のフレームのコマンドが参照しているかもしれないので、そのフレームになるまでコピーしない）
+	std::vector<std::vector<uint32_t>> pendingCopies_;
+
+	// 場所ごとのTextureの情報
+	std::vector<TextureEntry> textures_;
+	// 解放待ちのリソース
+	std::deque<RetiredResource> retiredResources_;
+
+	// 正規化したパスをキーにしたハンドル
+	std::unordered_map<std::string, uint32_t> nameCache_;
+	// 画像ファイルの内容のハッシュ値をキーにしたハンドル（別の場所にある同じ画像を共有する）
+	std::unordered_map<uint64_t, uint32_t> contentCache_;
+	// contentCache_で別のパスと共有するか
+	bool isContentSharingEnabled_ = true;
+
+	// ミップのストリーミング
+	bool isStreamingEnabled_ = false;
+	MipResidency residency_;
+	// MipResidencyのIDごとのハンドル
+	std::vector<uint32_t> streamHandles_;
+	// このフレームで報告された使用状況
+	std::vector<MipUsage> usages_;
 
-	static const uint32_t kMaxTextureValue_ = 128;
-	uint32_t index_ = 1;
+	// PNGのデコードに使う実装
+	ImageDecoder imageDecoder_ = ImageDecoder::Wic;
 
-	std::array<Microsoft::WRL::ComPtr<ID3D12Resource>, kMaxTextureValue_> texResources;
+	// ワーカースレッドからの読み込みに備えて、SRVの確保と生成を排他する
+	std::mutex mutex_;
 };
 
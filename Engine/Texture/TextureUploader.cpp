@@ -0,0 +1,221 @@
+#include "TextureUploader.h"
+#include <cassert>
+#include <cstring>
+#include <format>
+
+// MyClass
+#include "DirectXUtil.h"
+#include "Logger.h"
+
+TextureUploader& TextureUploader::GetInstance()
+{
+	static TextureUploader instance;
+
+	return instance;
+}
+
+void TextureUploader::Initialize(ID3D12Device* device, ID3D12CommandQueue* graphicsQueue, uint64_t ringSize)
+{
+	TextureUploader& instance = GetInstance();
+	HRESULT result = S_FALSE;
+	instance.device_ = device;
+	instance.graphicsQueue_ = graphicsQueue;
+
+	// コピー専用のキューを生成する（描画と並行して転送できる）
+	D3D12_COMMAND_QUEUE_DESC commandQueueDesc{};
+	commandQueueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+	result = device->CreateCommandQueue(&commandQueueDesc, IID_PPV_ARGS(&instance.copyQueue_));
+	assert(SUCCEEDED(result));
+
+	// Fenceを生成する
+	result = device->CreateFence(instance.fenceValue_, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&instance.fence_));
+	assert(SUCCEEDED(result));
+	instance.fenceEvent_ = CreateEvent(NULL, FALSE, FALSE, NULL);
+	assert(instance.fenceEvent_ != nullptr);
+
+	// アップロード用のバッファを生成し、マップしたままにしておく
+	instance.uploadBuffer_ = CreateBufferResource(device, size_t(ringSize), ResourceCategory::Upload);
+	result = instance.uploadBuffer_->Map(0, nullptr, reinterpret_cast<void**>(&instance.mappedData_));
+	assert(SUCCEEDED(result));
+	instance.ring_.Initialize(ringSize);
+}
+
+void TextureUploader::Finalize()
+{
+	TextureUploader& instance = GetInstance();
+	{
+		std::lock_guard<std::mutex> lock(instance.mutex_);
+		instance.WaitForFence(instance.FlushLocked());
+		instance.Retire();
+	}
+
+	instance.uploadBuffer_->Unmap(0, nullptr);
+	instance.mappedData_ = nullptr;
+	instance.uploadBuffer_.Reset();
+	instance.commandList_.Reset();
+	instance.commandAllocators_.clear();
+	instance.copyQueue_.Reset();
+	instance.fence_.Reset();
+	CloseHandle(instance.fenceEvent_);
+	instance.fenceEvent_ = nullptr;
+}
+
+void TextureUploader::Upload(ID3D12Resource* texture, const DirectX::ScratchImage& mipImages, uint32_t firstMip)
+{
+	TextureUploader& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+	instance.BeginRecording();
+
+	// 各サブリソースのアップロード用バッファ上での配置を求める
+	const DirectX::TexMetadata& metadata = mipImages.GetMetadata();
+	D3D12_RESOURCE_DESC resourceDesc = texture->GetDesc();
+	UINT mipLevels = resourceDesc.MipLevels;
+	assert(firstMip + mipLevels <= metadata.mipLevels);
+	UINT subresourceCount = UINT(mipLevels * metadata.arraySize);
+	std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(subresourceCount);
+	std::vector<UINT> rowCounts(subresourceCount);
+	std::vector<UINT64> rowSizes(subresourceCount);
+	UINT64 totalSize = 0;
+	instance.device_->GetCopyableFootprints(&resourceDesc, 0, subresourceCount, 0, layouts.data(), rowCounts.data(), rowSizes.data(), &totalSize);
+
+	ID3D12Resource* uploadBuffer = instance.uploadBuffer_.Get();
+	uint8_t* mappedData = instance.mappedData_;
+	uint64_t baseOffset = 0;
+	if (totalSize > instance.ring_.GetCapacity()) {
+		// リングバッファに収まらない大きなTextureは、一時的なバッファを作って転送する
+		Log(std::format("TextureUploader : {}KB does not fit in the upload ring, using a temporary buffer\n", totalSize / 1024));
+		instance.pendingTemporaryBuffers_.push_back(CreateBufferResource(instance.device_, size_t(totalSize), ResourceCategory::Upload));
+		uploadBuffer = instance.pendingTemporaryBuffers_.back().Get();
+		HRESULT result = uploadBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mappedData));
+		assert(SUCCEEDED(result));
+	} else {
+		// 空きが無ければ、記録済みのコピーを提出して古い転送が終わるのを待つ
+		baseOffset = instance.ring_.Allocate(totalSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+		while (baseOffset == RingAllocator::kInvalidOffset) {
+			instance.FlushLocked();
+			instance.WaitForFence(instance.ring_.GetOldestFenceValue());
+			instance.Retire();
+			instance.BeginRecording();
+			baseOffset = instance.ring_.Allocate(totalSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+		}
+	}
+
+	// 全サブリソースについて
+	for (UINT subresource = 0; subresource < subresourceCount; ++subresource) {
+		// サブリソースの番号はミップが先に進む
+		const DirectX::Image* img = mipImages.GetImage(firstMip + subresource % mipLevels, subresource / mipLevels, 0);
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout = layouts[subresource];
+		layout.Offset += baseOffset;
+
+		// アップロード用のバッファへ1行ずつコピーする（行のピッチは256バイトに揃える必要がある）
+		uint8_t* destination = mappedData + layout.Offset;
+		for (UINT row = 0; row < rowCounts[subresource]; ++row) {
+			std::memcpy(destination + row * layout.Footprint.RowPitch, img->pixels + row * img->rowPitch, size_t(rowSizes[subresource]));
+		}
+
+		// Textureへのコピーを記録する
+		D3D12_TEXTURE_COPY_LOCATION destinationLocation{};
+		destinationLocation.pResource = texture;
+		destinationLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+		destinationLocation.SubresourceIndex = subresource;
+		D3D12_TEXTURE_COPY_LOCATION sourceLocation{};
+		sourceLocation.pResource = uploadBuffer;
+		sourceLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+		sourceLocation.PlacedFootprint = layout;
+		instance.commandList_->CopyTextureRegion(&destinationLocation, 0, 0, 0, &sourceLocation, nullptr);
+	}
+
+	if (uploadBuffer != instance.uploadBuffer_.Get()) {
+		uploadBuffer->Unmap(0, nullptr);
+	}
+}
+
+uint64_t TextureUploader::Flush()
+{
+	TextureUploader& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.mutex_);
+
+	uint64_t fenceValue = instance.FlushLocked();
+	instance.Retire();
+	return fenceValue;
+}
+
+void TextureUploader::BeginRecording()
+{
+	if (isRecording_) {
+		return;
+	}
+	HRESULT result = S_FALSE;
+
+	// コピーが終わったアロケータがあれば再利用し、無ければ新しく作る
+	uint64_t completedFenceValue = fence_->GetCompletedValue();
+	if (commandAllocators_.empty() || commandAllocators_.front().fenceValue > completedFenceValue) {
+		CommandAllocator commandAllocator{ nullptr, 0 };
+		result = device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&commandAllocator.allocator));
+		assert(SUCCEEDED(result));
+		commandAllocators_.push_front(std::move(commandAllocator));
+	} else {
+		result = commandAllocators_.front().allocator->Reset();
+		assert(SUCCEEDED(result));
+	}
+	// 使うアロケータを末尾に回す（先頭が最も古いものになる）
+	commandAllocators_.push_back(std::move(commandAllocators_.front()));
+	commandAllocators_.pop_front();
+
+	// コマンドリストの記録を開始する
+	ID3D12CommandAllocator* allocator = commandAllocators_.back().allocator.Get();
+	if (!commandList_) {
+		result = device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, allocator, nullptr, IID_PPV_ARGS(&commandList_));
+	} else {
+		result = commandList_->Reset(allocator, nullptr);
+	}
+	assert(SUCCEEDED(result));
+	isRecording_ = true;
+}
+
+uint64_t TextureUploader::FlushLocked()
+{
+	if (!isRecording_) {
+		return fenceValue_;
+	}
+	HRESULT result = S_FALSE;
+
+	// コピーキューで実行する
+	result = commandList_->Close();
+	assert(SUCCEEDED(result));
+	ID3D12CommandList* commandLists[] = { commandList_.Get() };
+	copyQueue_->ExecuteCommandLists(1, commandLists);
+	isRecording_ = false;
+
+	// 描画キューはコピーが終わるまで待つ（CPUは待たない）
+	fenceValue_++;
+	copyQueue_->Signal(fence_.Get(), fenceValue_);
+	graphicsQueue_->Wait(fence_.Get(), fenceValue_);
+
+	// 今回使ったリングバッファの領域、アロケータ、一時バッファはこのFenceの値に到達したら再利用できる
+	ring_.Submit(fenceValue_);
+	commandAllocators_.back().fenceValue = fenceValue_;
+	for (Microsoft::WRL::ComPtr<ID3D12Resource>& buffer : pendingTemporaryBuffers_) {
+		temporaryBuffers_.push_back({ std::move(buffer), fenceValue_ });
+	}
+	pendingTemporaryBuffers_.clear();
+
+	return fenceValue_;
+}
+
+void TextureUploader::Retire()
+{
+	uint64_t completedFenceValue = fence_->GetCompletedValue();
+	ring_.Retire(completedFenceValue);
+	while (!temporaryBuffers_.empty() && temporaryBuffers_.front().fenceValue <= completedFenceValue) {
+		temporaryBuffers_.pop_front();
+	}
+}
+
+void TextureUploader::WaitForFence(uint64_t fenceValue)
+{
+	if (fence_->GetCompletedValue() < fenceValue) {
+		fence_->SetEventOnCompletion(fenceValue, fenceEvent_);
+		WaitForSingleObject(fenceEvent_, INFINITE);
+	}
+}
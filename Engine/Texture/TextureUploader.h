@@ -0,0 +1,75 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl.h>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include "externals/DirectXTex/DirectXTex.h"
+
+// MyClass
+#include "RingAllocator.h"
+
+// アップロード用のリングバッファを経由して、DefaultHeapのTextureへコピーキューで転送する
+class TextureUploader final
+{
+public:
+	static TextureUploader& GetInstance();
+
+	// コピーキューとアップロード用のリングバッファを生成する（graphicsQueueは転送の完了を待つキュー）
+	static void Initialize(ID3D12Device* device, ID3D12CommandQueue* graphicsQueue, uint64_t ringSize = kDefaultRingSize_);
+	// 転送が全て終わるのを待ち、リソースを解放する
+	static void Finalize();
+
+	// Textureの全ミップのコピーを記録する（Flushするまで実行されないので、複数のTextureをまとめて転送できる）
+	// firstMipを指定すると、mipImagesのfirstMip以降をTextureのミップ0から順にコピーする
+	static void Upload(ID3D12Resource* texture, const DirectX::ScratchImage& mipImages, uint32_t firstMip = 0);
+	// 記録したコピーをコピーキューで実行し、描画キューがその完了を待つようにする（SignalしたFenceの値を返す）
+	static uint64_t Flush();
+
+private:
+	// コマンドアロケータと、それを使ったコピーが終わるFenceの値
+	struct CommandAllocator {
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator;
+		uint64_t fenceValue;
+	};
+	// リングバッファに収まらないTexture用に一時的に作ったバッファ
+	struct TemporaryBuffer {
+		Microsoft::WRL::ComPtr<ID3D12Resource> buffer;
+		uint64_t fenceValue;
+	};
+
+	// コマンドリストを記録できる状態にする
+	void BeginRecording();
+	// mutex_をロックした状態でFlushする
+	uint64_t FlushLocked();
+	// コピーが終わったリングバッファの領域と一時バッファを解放する
+	void Retire();
+	// 指定したFenceの値にコピーキューが到達するまで待つ
+	void WaitForFence(uint64_t fenceValue);
+
+	static const uint64_t kDefaultRingSize_ = 32 * 1024 * 1024;
+
+	ID3D12Device* device_ = nullptr;
+	ID3D12CommandQueue* graphicsQueue_ = nullptr;
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue> copyQueue_;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList_;
+	std::deque<CommandAllocator> commandAllocators_;
+	bool isRecording_ = false;
+
+	Microsoft::WRL::ComPtr<ID3D12Fence> fence_;
+	uint64_t fenceValue_ = 0;
+	HANDLE fenceEvent_ = nullptr;
+
+	// 永続的にマップしたアップロード用のバッファ
+	Microsoft::WRL::ComPtr<ID3D12Resource> uploadBuffer_;
+	uint8_t* mappedData_ = nullptr;
+	RingAllocator ring_;
+
+	// 次のFlushで提出する一時バッファと、コピーが終わるのを待っている一時バッファ
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> pendingTemporaryBuffers_;
+	std::deque<TemporaryBuffer> temporaryBuffers_;
+
+	// ワーカースレッド（ホットリロード）からの転送に備えて排他する
+	std::mutex mutex_;
+};
@@ -0,0 +1,334 @@
+#include "VirtualTexture.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+VirtualTextureLayout::VirtualTextureLayout(uint32_t width, uint32_t height, uint32_t pageSize, uint32_t border)
+	: width_(width), height_(height), pageSize_(pageSize), border_(border)
+{
+	assert(width > 0 && height > 0 && pageSize > 0);
+
+	// ページが1つになるミップまで分割する
+	for (uint32_t mip = 0; ; ++mip) {
+		uint32_t mipWidth = (std::max)(width >> mip, 1u);
+		uint32_t mipHeight = (std::max)(height >> mip, 1u);
+		pagesX_.push_back((mipWidth + pageSize - 1) / pageSize);
+		pagesY_.push_back((mipHeight + pageSize - 1) / pageSize);
+		if (pagesX_.back() == 1 && pagesY_.back() == 1) {
+			break;
+		}
+	}
+}
+
+uint32_t VirtualTextureLayout::GetTotalPageCount() const
+{
+	uint32_t count = 0;
+	for (uint32_t mip = 0; mip < GetMipLevels(); ++mip) {
+		count += pagesX_[mip] * pagesY_[mip];
+	}
+	return count;
+}
+
+void VirtualTextureLayout::ExtractTile(const MipLevel& level, uint32_t pageX, uint32_t pageY, std::vector<uint8_t>& tile) const
+{
+	const uint32_t tileSize = GetTileSize();
+	tile.resize(size_t(tileSize) * tileSize * 4);
+
+	// 縁を含めた左上の位置（画像の外は端に寄せる）
+	const int32_t left = int32_t(pageX * pageSize_) - int32_t(border_);
+	const int32_t top = int32_t(pageY * pageSize_) - int32_t(border_);
+	const int32_t maxX = int32_t(level.width) - 1;
+	const int32_t maxY = int32_t(level.height) - 1;
+	for (uint32_t y = 0; y < tileSize; ++y) {
+		int32_t sourceY = std::clamp(top + int32_t(y), 0, maxY);
+		const uint8_t* sourceRow = level.pixels.data() + size_t(sourceY) * level.width * 4;
+		uint8_t* destinationRow = tile.data() + size_t(y) * tileSize * 4;
+		for (uint32_t x = 0; x < tileSize; ++x) {
+			int32_t sourceX = std::clamp(left + int32_t(x), 0, maxX);
+			std::memcpy(destinationRow + x * 4, sourceRow + sourceX * 4, 4);
+		}
+	}
+}
+
+void VirtualTextureSystem::Initialize(uint32_t physicalPagesX, uint32_t physicalPagesY)
+{
+	// 間接参照テクスチャには物理ページの位置を8bitずつで入れる
+	assert(physicalPagesX > 0 && physicalPagesY > 0 && physicalPagesX <= 256 && physicalPagesY <= 256);
+
+	physicalPagesX_ = physicalPagesX;
+	physicalPages_.assign(size_t(physicalPagesX) * physicalPagesY, PhysicalPage{});
+	freePhysicalPages_.clear();
+	// 先頭から順に使う
+	for (uint32_t i = uint32_t(physicalPages_.size()); i > 0; --i) {
+		freePhysicalPages_.push_back(i - 1);
+	}
+	lru_.clear();
+	residentPageCount_ = 0;
+}
+
+uint32_t VirtualTextureSystem::AddTexture(const VirtualTextureLayout& layout)
+{
+	assert(layout.GetMipLevels() <= kMaxMipLevels);
+	assert(layout.GetPagesX(0) <= kMaxPagesPerAxis && layout.GetPagesY(0) <= kMaxPagesPerAxis);
+
+	// 削除されたIDがあれば再利用する
+	uint32_t textureId = 0;
+	if (!freeTextureIds_.empty()) {
+		textureId = freeTextureIds_.back();
+		freeTextureIds_.pop_back();
+	} else {
+		textureId = uint32_t(textures_.size());
+		assert(textureId < kMaxTextureCount);
+		textures_.emplace_back();
+	}
+
+	TextureState& texture = textures_[textureId];
+	texture = TextureState{};
+	texture.layout = layout;
+	texture.isUsed = true;
+	texture.pageTable.resize(layout.GetMipLevels());
+	texture.indirection.resize(layout.GetMipLevels());
+	for (uint32_t mip = 0; mip < layout.GetMipLevels(); ++mip) {
+		texture.pageTable[mip].assign(size_t(layout.GetPagesX(mip)) * layout.GetPagesY(mip), kInvalidId);
+	}
+
+	// 最も小さいミップは、どのページの代わりにも使えるように最初に読み込む
+	uint32_t pinnedKey = PackFeedback(textureId, layout.GetMipLevels() - 1, 0, 0);
+	pinnedRequests_.push_back(pinnedKey);
+	requestQueue_.push_back({ pinnedKey, UINT32_MAX });
+	std::push_heap(requestQueue_.begin(), requestQueue_.end(), IsLowerPriority);
+
+	return textureId;
+}
+
+void VirtualTextureSystem::RemoveTexture(uint32_t textureId)
+{
+	TextureState& texture = textures_[textureId];
+	assert(texture.isUsed);
+
+	// 使っていた物理ページを空ける
+	for (std::vector<uint32_t>& pageTable : texture.pageTable) {
+		for (uint32_t physicalPage : pageTable) {
+			if (physicalPage != kInvalidId) {
+				ReleasePhysicalPage(physicalPage);
+			}
+		}
+	}
+
+	// IDが再利用されたときに古い要求や読み込みが混ざらないよう、このTextureのものを消す
+	auto isThisTexture = [&](uint32_t key) { return UnpackFeedback(key).textureId == textureId; };
+	std::erase_if(pinnedRequests_, isThisTexture);
+	std::erase_if(loadingPages_, isThisTexture);
+	std::erase_if(requestQueue_, [&](const Request& request) { return isThisTexture(request.key); });
+	std::make_heap(requestQueue_.begin(), requestQueue_.end(), IsLowerPriority);
+
+	texture = TextureState{};
+	freeTextureIds_.push_back(textureId);
+}
+
+void VirtualTextureSystem::ProcessFeedback(const uint32_t* feedback, size_t count)
+{
+	frame_++;
+	feedbackTexelCount_ = 0;
+	residentTexelCount_ = 0;
+
+	// ページごとに、フィードバックに現れたテクセルの数を数える
+	pageWeights_.clear();
+	for (size_t i = 0; i < count; ++i) {
+		if (feedback[i] == kEmptyFeedback || !IsValidPage(UnpackFeedback(feedback[i]))) {
+			continue;
+		}
+		feedbackTexelCount_++;
+		pageWeights_[feedback[i]]++;
+	}
+
+	// 使われたページとその上のミップのページをたどる
+	// 常駐していれば使ったことにし（上のミップほど後で使ったことになるので、先に追い出されない）、常駐していなければ要求する
+	std::unordered_map<uint32_t, uint32_t> requestWeights;
+	for (const auto& [key, weight] : pageWeights_) {
+		VirtualPage page = UnpackFeedback(key);
+		const VirtualTextureLayout& layout = textures_[page.textureId].layout;
+		if (GetPhysicalPage(page) != kInvalidId) {
+			residentTexelCount_ += weight;
+		}
+		for (; page.mip < layout.GetMipLevels(); ++page.mip, page.x /= 2, page.y /= 2) {
+			// ミップの端ではページの数が半分より多く減ることがある
+			page.x = (std::min)(page.x, layout.GetPagesX(page.mip) - 1);
+			page.y = (std::min)(page.y, layout.GetPagesY(page.mip) - 1);
+			uint32_t physicalPage = GetPhysicalPage(page);
+			if (physicalPage != kInvalidId) {
+				TouchPhysicalPage(physicalPage);
+				continue;
+			}
+			uint32_t requestKey = PackFeedback(page.textureId, page.mip, page.x, page.y);
+			if (!loadingPages_.contains(requestKey)) {
+				// 上のミップは下のミップの要求をまとめて受けるので、常に下のミップより優先される
+				requestWeights[requestKey] += weight;
+			}
+		}
+	}
+
+	// 要求を作り直す（前のフレームの要求で、このフレームに使われなかったものは捨てる）
+	requestQueue_.clear();
+	for (uint32_t pinnedKey : pinnedRequests_) {
+		if (GetPhysicalPage(UnpackFeedback(pinnedKey)) == kInvalidId && !loadingPages_.contains(pinnedKey)) {
+			requestWeights[pinnedKey] = UINT32_MAX;
+		}
+	}
+	for (const auto& [key, weight] : requestWeights) {
+		requestQueue_.push_back({ key, weight });
+	}
+	std::make_heap(requestQueue_.begin(), requestQueue_.end(), IsLowerPriority);
+}
+
+std::vector<VirtualPage> VirtualTextureSystem::PopRequests(size_t maxCount)
+{
+	std::vector<VirtualPage> pages;
+	while (pages.size() < maxCount && !requestQueue_.empty()) {
+		std::pop_heap(requestQueue_.begin(), requestQueue_.end(), IsLowerPriority);
+		uint32_t key = requestQueue_.back().key;
+		requestQueue_.pop_back();
+		loadingPages_.insert(key);
+		pages.push_back(UnpackFeedback(key));
+	}
+	return pages;
+}
+
+uint32_t VirtualTextureSystem::CompleteLoad(const VirtualPage& page)
+{
+	uint32_t key = PackFeedback(page.textureId, page.mip, page.x, page.y);
+	// 読み込み中に仮想テクスチャが消された場合は捨てる
+	if (loadingPages_.erase(key) == 0 || !IsValidPage(page)) {
+		return kInvalidId;
+	}
+	uint32_t& entry = GetPageTableEntry(page);
+	if (entry != kInvalidId) {
+		return entry;
+	}
+
+	// 空きが無ければ、このフレームで使われていない中で最も長く使われていないページを追い出す
+	if (freePhysicalPages_.empty()) {
+		if (lru_.empty() || physicalPages_[lru_.front()].lastUsedFrame >= frame_) {
+			return kInvalidId;
+		}
+		ReleasePhysicalPage(lru_.front());
+		evictionCount_++;
+	}
+	uint32_t physicalPage = freePhysicalPages_.back();
+	freePhysicalPages_.pop_back();
+
+	// 最も小さいミップは追い出さない
+	PhysicalPage& physical = physicalPages_[physicalPage];
+	physical.key = key;
+	physical.isPinned = page.mip == textures_[page.textureId].layout.GetMipLevels() - 1;
+	physical.lastUsedFrame = frame_;
+	if (!physical.isPinned) {
+		physical.lruIterator = lru_.insert(lru_.end(), physicalPage);
+	}
+	entry = physicalPage;
+	residentPageCount_++;
+	textures_[page.textureId].isIndirectionDirty = true;
+	return physicalPage;
+}
+
+uint32_t VirtualTextureSystem::GetPhysicalPage(const VirtualPage& page) const
+{
+	if (!IsValidPage(page)) {
+		return kInvalidId;
+	}
+	const TextureState& texture = textures_[page.textureId];
+	return texture.pageTable[page.mip][page.y * texture.layout.GetPagesX(page.mip) + page.x];
+}
+
+const std::vector<uint32_t>& VirtualTextureSystem::GetIndirection(uint32_t textureId, uint32_t mip)
+{
+	TextureState& texture = textures_[textureId];
+	assert(texture.isUsed && mip < texture.layout.GetMipLevels());
+	if (!texture.isIndirectionDirty) {
+		return texture.indirection[mip];
+	}
+
+	// 小さいミップから順に、常駐していないページには上のミップのページの値を使う
+	const VirtualTextureLayout& layout = texture.layout;
+	for (uint32_t level = layout.GetMipLevels(); level > 0; --level) {
+		uint32_t currentMip = level - 1;
+		uint32_t pagesX = layout.GetPagesX(currentMip);
+		uint32_t pagesY = layout.GetPagesY(currentMip);
+		std::vector<uint32_t>& indirection = texture.indirection[currentMip];
+		indirection.resize(size_t(pagesX) * pagesY);
+		for (uint32_t y = 0; y < pagesY; ++y) {
+			for (uint32_t x = 0; x < pagesX; ++x) {
+				uint32_t physicalPage = texture.pageTable[currentMip][y * pagesX + x];
+				if (physicalPage != kInvalidId) {
+					indirection[y * pagesX + x] = GetPhysicalPageX(physicalPage) | (GetPhysicalPageY(physicalPage) << 8) | (currentMip << 16) | (0xffu << 24);
+				} else if (level == layout.GetMipLevels()) {
+					indirection[y * pagesX + x] = 0;
+				} else {
+					uint32_t parentPagesX = layout.GetPagesX(currentMip + 1);
+					uint32_t parentX = (std::min)(x / 2, parentPagesX - 1);
+					uint32_t parentY = (std::min)(y / 2, layout.GetPagesY(currentMip + 1) - 1);
+					indirection[y * pagesX + x] = texture.indirection[currentMip + 1][parentY * parentPagesX + parentX];
+				}
+			}
+		}
+	}
+	texture.isIndirectionDirty = false;
+	return texture.indirection[mip];
+}
+
+uint32_t VirtualTextureSystem::PackFeedback(uint32_t textureId, uint32_t mip, uint32_t x, uint32_t y)
+{
+	assert(textureId < kMaxTextureCount && mip < kMaxMipLevels && x < kMaxPagesPerAxis && y < kMaxPagesPerAxis);
+	return (textureId << 24) | (mip << 20) | (y << 10) | x;
+}
+
+VirtualPage VirtualTextureSystem::UnpackFeedback(uint32_t value)
+{
+	return { value >> 24, (value >> 20) & 0xf, value & 0x3ff, (value >> 10) & 0x3ff };
+}
+
+bool VirtualTextureSystem::IsValidPage(const VirtualPage& page) const
+{
+	if (page.textureId >= textures_.size() || !textures_[page.textureId].isUsed) {
+		return false;
+	}
+	const VirtualTextureLayout& layout = textures_[page.textureId].layout;
+	return page.mip < layout.GetMipLevels() && page.x < layout.GetPagesX(page.mip) && page.y < layout.GetPagesY(page.mip);
+}
+
+void VirtualTextureSystem::TouchPhysicalPage(uint32_t physicalPage)
+{
+	PhysicalPage& physical = physicalPages_[physicalPage];
+	physical.lastUsedFrame = frame_;
+	if (!physical.isPinned) {
+		lru_.splice(lru_.end(), lru_, physical.lruIterator);
+	}
+}
+
+void VirtualTextureSystem::ReleasePhysicalPage(uint32_t physicalPage)
+{
+	PhysicalPage& physical = physicalPages_[physicalPage];
+	VirtualPage page = UnpackFeedback(physical.key);
+	GetPageTableEntry(page) = kInvalidId;
+	textures_[page.textureId].isIndirectionDirty = true;
+	if (!physical.isPinned) {
+		lru_.erase(physical.lruIterator);
+	}
+	physical = PhysicalPage{};
+	freePhysicalPages_.push_back(physicalPage);
+	residentPageCount_--;
+}
+
+bool VirtualTextureSystem::IsLowerPriority(const Request& a, const Request& b)
+{
+	if (a.weight != b.weight) {
+		return a.weight < b.weight;
+	}
+	// 同じなら小さいミップ（ミップの番号が大きい方）を先に、それも同じならキーの順にする
+	uint32_t mipA = (a.key >> 20) & 0xf;
+	uint32_t mipB = (b.key >> 20) & 0xf;
+	if (mipA != mipB) {
+		return mipA < mipB;
+	}
+	return a.key > b.key;
+}
@@ -0,0 +1,168 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// MyClass
+#include "MipGenerator.h"
+
+// 仮想テクスチャのページ（ミップとページ単位の位置）
+struct VirtualPage {
+	uint32_t textureId;
+	uint32_t mip;
+	uint32_t x;
+	uint32_t y;
+};
+
+// 元の画像を、縁を付けた固定サイズのページに分割する配置
+// （ページの数が1つになるミップまでを扱う。縁はページの境目でフィルタがはみ出す分で、画像の外は端の値を繰り返す）
+class VirtualTextureLayout
+{
+public:
+	VirtualTextureLayout() = default;
+	VirtualTextureLayout(uint32_t width, uint32_t height, uint32_t pageSize, uint32_t border);
+
+	uint32_t GetWidth() const { return width_; }
+	uint32_t GetHeight() const { return height_; }
+	// 縁を除いたページの大きさ（テクセル）
+	uint32_t GetPageSize() const { return pageSize_; }
+	uint32_t GetBorder() const { return border_; }
+	// 縁を含めた、物理テクスチャ上のページの大きさ
+	uint32_t GetTileSize() const { return pageSize_ + border_ * 2; }
+	uint32_t GetMipLevels() const { return uint32_t(pagesX_.size()); }
+	uint32_t GetPagesX(uint32_t mip) const { return pagesX_[mip]; }
+	uint32_t GetPagesY(uint32_t mip) const { return pagesY_[mip]; }
+	// 全ミップのページの数
+	uint32_t GetTotalPageCount() const;
+
+	// ミップの画像からページ（縁を含む）をRGBA8で切り出す（tileはGetTileSizeの2乗 * 4バイトになる）
+	void ExtractTile(const MipLevel& level, uint32_t pageX, uint32_t pageY, std::vector<uint8_t>& tile) const;
+
+private:
+	uint32_t width_ = 0;
+	uint32_t height_ = 0;
+	uint32_t pageSize_ = 0;
+	uint32_t border_ = 0;
+	// ミップごとのページの数
+	std::vector<uint32_t> pagesX_;
+	std::vector<uint32_t> pagesY_;
+};
+
+// 仮想テクスチャのページテーブルと物理ページのキャッシュ（GPUのリソースには依存しない）
+// 1. 描画で書き出したフィードバック（PackFeedbackの値）をProcessFeedbackに渡すと、足りないページが優先度の順に並ぶ
+// 2. PopRequestsで取り出したページを読み込み、CompleteLoadで物理ページに割り当てる（空きが無ければ最も長く使われていないページを追い出す）
+// 3. GetIndirectionで、ページごとに常駐している最も詳細なページを指す間接参照テクスチャのデータを取得する
+class VirtualTextureSystem
+{
+public:
+	// 無効なID・物理ページ
+	static constexpr uint32_t kInvalidId = UINT32_MAX;
+	// フィードバックの何も描かれていないテクセルの値
+	static constexpr uint32_t kEmptyFeedback = UINT32_MAX;
+	// 登録できる仮想テクスチャの数と、1つのミップで扱えるページの数（フィードバックの値に詰めるため）
+	static constexpr uint32_t kMaxTextureCount = 255;
+	static constexpr uint32_t kMaxPagesPerAxis = 1024;
+	static constexpr uint32_t kMaxMipLevels = 16;
+
+	// 物理テクスチャのページ単位の大きさを決める（256x256ページまで）
+	void Initialize(uint32_t physicalPagesX, uint32_t physicalPagesY);
+
+	// 仮想テクスチャを登録してIDを返す（最も小さいミップのページは最優先で要求し、読み込んだら追い出さない）
+	uint32_t AddTexture(const VirtualTextureLayout& layout);
+	// 仮想テクスチャの登録を消し、使っていた物理ページを空ける
+	void RemoveTexture(uint32_t textureId);
+
+	// フィードバックから使われたページを記録し、常駐していないページの要求を作り直す（フレームの区切りで1回呼ぶ）
+	// 要求したページが常駐するまでは、その上のミップで常駐していないページもより高い優先度で要求する
+	void ProcessFeedback(const uint32_t* feedback, size_t count);
+	// 優先度の高い順に最大maxCount個の要求を取り出す（取り出したページは読み込み中になり、再び要求されない）
+	std::vector<VirtualPage> PopRequests(size_t maxCount);
+	// 読み込みが終わったページを物理ページに割り当て、その物理ページの番号を返す（返した場所にタイルを転送する）
+	// 空けられる物理ページが無い、または仮想テクスチャが消された場合はkInvalidIdを返す（必要ならまた要求される）
+	uint32_t CompleteLoad(const VirtualPage& page);
+
+	// ページが常駐していれば、その物理ページを返す（無ければkInvalidId）
+	uint32_t GetPhysicalPage(const VirtualPage& page) const;
+	// 物理ページの番号から、物理テクスチャ上のページ単位の位置を求める
+	uint32_t GetPhysicalPageX(uint32_t physicalPage) const { return physicalPage % physicalPagesX_; }
+	uint32_t GetPhysicalPageY(uint32_t physicalPage) const { return physicalPage / physicalPagesX_; }
+
+	// ミップの間接参照テクスチャ（RGBA8、ページ単位の大きさ）のデータ
+	// 各テクセルは常駐している最も詳細なページの物理ページの位置（R、G）とそのミップ（B）で、Aは常駐していれば255
+	const std::vector<uint32_t>& GetIndirection(uint32_t textureId, uint32_t mip);
+	// 前回の取得からページテーブルが変わったか（変わった仮想テクスチャだけ間接参照テクスチャを転送し直す）
+	bool IsIndirectionDirty(uint32_t textureId) const { return textures_[textureId].isIndirectionDirty; }
+
+	// フィードバックに書き出す値（ミップ4bit、x・y各10bit、仮想テクスチャ8bit）
+	static uint32_t PackFeedback(uint32_t textureId, uint32_t mip, uint32_t x, uint32_t y);
+	static VirtualPage UnpackFeedback(uint32_t value);
+
+	// 直前のProcessFeedbackでの、フィードバックのテクセルの数とそのうち要求したページが常駐していた数
+	size_t GetFeedbackTexelCount() const { return feedbackTexelCount_; }
+	size_t GetResidentTexelCount() const { return residentTexelCount_; }
+	// 待っている要求の数と、常駐しているページの数
+	size_t GetPendingRequestCount() const { return requestQueue_.size(); }
+	size_t GetResidentPageCount() const { return residentPageCount_; }
+	uint32_t GetPhysicalPageCount() const { return uint32_t(physicalPages_.size()); }
+	// これまでに追い出したページの数
+	uint64_t GetEvictionCount() const { return evictionCount_; }
+
+private:
+	struct TextureState {
+		VirtualTextureLayout layout;
+		bool isUsed = false;
+		// ミップごとのページテーブル（物理ページの番号。常駐していなければkInvalidId）
+		std::vector<std::vector<uint32_t>> pageTable;
+		// ミップごとの間接参照テクスチャのデータ
+		std::vector<std::vector<uint32_t>> indirection;
+		bool isIndirectionDirty = true;
+	};
+	struct PhysicalPage {
+		uint32_t key = kEmptyFeedback; // 割り当てられているページ（PackFeedbackの値）
+		bool isPinned = false; // 追い出さない
+		uint64_t lastUsedFrame = 0;
+		std::list<uint32_t>::iterator lruIterator;
+	};
+	struct Request {
+		uint32_t key;
+		uint32_t weight; // 要求したテクセルの数（その下のミップの要求も含む）
+	};
+
+	// ページテーブルの要素
+	uint32_t& GetPageTableEntry(const VirtualPage& page) { return textures_[page.textureId].pageTable[page.mip][page.y * textures_[page.textureId].layout.GetPagesX(page.mip) + page.x]; }
+	// 有効なページか
+	bool IsValidPage(const VirtualPage& page) const;
+	// 物理ページを使ったことにする（追い出す順番の最後に回す）
+	void TouchPhysicalPage(uint32_t physicalPage);
+	// 物理ページの割り当てを外す
+	void ReleasePhysicalPage(uint32_t physicalPage);
+	// 要求の優先度の比較（大きいものを先に取り出す。同じなら小さいミップを先にする）
+	static bool IsLowerPriority(const Request& a, const Request& b);
+
+	uint32_t physicalPagesX_ = 0;
+	std::vector<PhysicalPage> physicalPages_;
+	// 空いている物理ページ
+	std::vector<uint32_t> freePhysicalPages_;
+	// 追い出してよい物理ページ（先頭が最も長く使われていない）
+	std::list<uint32_t> lru_;
+	size_t residentPageCount_ = 0;
+
+	std::vector<TextureState> textures_;
+	std::vector<uint32_t> freeTextureIds_;
+
+	// 読み込みの要求（優先度のヒープ）と、読み込み中のページ
+	std::vector<Request> requestQueue_;
+	std::unordered_set<uint32_t> loadingPages_;
+	// 最も小さいミップのページ（次のProcessFeedbackを待たずに要求する）
+	std::vector<uint32_t> pinnedRequests_;
+
+	uint64_t frame_ = 0;
+	size_t feedbackTexelCount_ = 0;
+	size_t residentTexelCount_ = 0;
+	uint64_t evictionCount_ = 0;
+	// ProcessFeedbackの作業用
+	std::unordered_map<uint32_t, uint32_t> pageWeights_;
+};
@@ -0,0 +1,114 @@
+#include "AliasingPlanner.h"
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+namespace {
+	const uint32_t kInvalidSlot = UINT32_MAX;
+
+	uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+uint64_t AliasingPlan::GetTotalSize() const
+{
+	return std::accumulate(heapSizes.begin(), heapSizes.end(), uint64_t(0));
+}
+
+bool AliasingPlan::IsAliased(uint32_t request) const
+{
+	uint32_t slot = slots[request];
+	return std::count(slots.begin(), slots.end(), slot) > 1;
+}
+
+AliasingPlan PlanAliasing(const std::vector<AliasingRequest>& requests, uint64_t maxHeapSize)
+{
+	AliasingPlan plan;
+	plan.slots.assign(requests.size(), kInvalidSlot);
+	plan.heaps.assign(requests.size(), 0);
+	plan.offsets.assign(requests.size(), 0);
+
+	// 始まりの順に割り当てる（同時に始まる場合は大きい方を先にする）
+	std::vector<uint32_t> order(requests.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		if (requests[a].firstPass != requests[b].firstPass) {
+			return requests[a].firstPass < requests[b].firstPass;
+		}
+		if (requests[a].size != requests[b].size) {
+			return requests[a].size > requests[b].size;
+		}
+		return a < b;
+	});
+
+	// 領域ごとの、最後に割り当てたリソースが使い終わるパスとアラインメント
+	std::vector<uint32_t> slotLastPasses;
+	std::vector<uint64_t> slotAlignments;
+	for (uint32_t request : order) {
+		const AliasingRequest& entry = requests[request];
+		assert(entry.firstPass <= entry.lastPass && entry.alignment > 0);
+		uint64_t size = AlignUp(entry.size, entry.alignment);
+		plan.dedicatedSize += size;
+
+		// 使い終わった領域から、収まる最も小さいもの（無ければ最も大きいもの）を選ぶ
+		uint32_t bestFit = kInvalidSlot;
+		uint32_t largest = kInvalidSlot;
+		for (uint32_t slot = 0; slot < plan.slotSizes.size(); ++slot) {
+			if (slotLastPasses[slot] >= entry.firstPass) {
+				continue;
+			}
+			if (plan.slotSizes[slot] >= size && (bestFit == kInvalidSlot || plan.slotSizes[slot] < plan.slotSizes[bestFit])) {
+				bestFit = slot;
+			}
+			if (largest == kInvalidSlot || plan.slotSizes[slot] > plan.slotSizes[largest]) {
+				largest = slot;
+			}
+		}
+		uint32_t slot = bestFit != kInvalidSlot ? bestFit : largest;
+		if (slot == kInvalidSlot) {
+			// 空いている領域が無ければ新しい色を使う
+			slot = uint32_t(plan.slotSizes.size());
+			plan.slotSizes.push_back(0);
+			slotLastPasses.push_back(0);
+			slotAlignments.push_back(1);
+		}
+		plan.slots[request] = slot;
+		plan.slotSizes[slot] = (std::max)(plan.slotSizes[slot], size);
+		slotLastPasses[slot] = entry.lastPass;
+		slotAlignments[slot] = (std::max)(slotAlignments[slot], entry.alignment);
+	}
+
+	// 領域を大きい順に、収まる最初のヒープの後ろに置く
+	std::vector<uint32_t> slotOrder(plan.slotSizes.size());
+	std::iota(slotOrder.begin(), slotOrder.end(), 0);
+	std::sort(slotOrder.begin(), slotOrder.end(), [&](uint32_t a, uint32_t b) {
+		return plan.slotSizes[a] != plan.slotSizes[b] ? plan.slotSizes[a] > plan.slotSizes[b] : a < b;
+	});
+	std::vector<uint32_t> slotHeaps(plan.slotSizes.size());
+	std::vector<uint64_t> slotOffsets(plan.slotSizes.size());
+	for (uint32_t slot : slotOrder) {
+		uint32_t heap = 0;
+		uint64_t offset = 0;
+		for (; heap < plan.heapSizes.size(); ++heap) {
+			offset = AlignUp(plan.heapSizes[heap], slotAlignments[slot]);
+			if (offset + plan.slotSizes[slot] <= maxHeapSize) {
+				break;
+			}
+		}
+		if (heap == plan.heapSizes.size()) {
+			plan.heapSizes.push_back(0);
+			offset = 0;
+		}
+		slotHeaps[slot] = heap;
+		slotOffsets[slot] = offset;
+		plan.heapSizes[heap] = offset + plan.slotSizes[slot];
+	}
+
+	for (uint32_t request = 0; request < requests.size(); ++request) {
+		plan.heaps[request] = slotHeaps[plan.slots[request]];
+		plan.offsets[request] = slotOffsets[plan.slots[request]];
+	}
+	return plan;
+}
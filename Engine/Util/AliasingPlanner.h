@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// 一時的なリソースのヒープ上の大きさと、使われる期間（実行する順のパスの番号。両端を含む）
+struct AliasingRequest {
+	uint64_t size;
+	uint64_t alignment;
+	uint32_t firstPass;
+	uint32_t lastPass;
+};
+
+// 一時的なリソースをヒープに置いた結果
+struct AliasingPlan {
+	// リソースごとの領域（同じ領域のリソースは使う期間が重ならず、同じメモリを使う）と、置いたヒープとオフセット
+	std::vector<uint32_t> slots;
+	std::vector<uint32_t> heaps;
+	std::vector<uint64_t> offsets;
+	// 領域ごとの大きさ
+	std::vector<uint64_t> slotSizes;
+	// ヒープごとの大きさ
+	std::vector<uint64_t> heapSizes;
+	// 全てのリソースをそれぞれ専用のメモリに置いた場合の合計
+	uint64_t dedicatedSize = 0;
+
+	uint64_t GetTotalSize() const;
+	// 専用のメモリに置いた場合より減ったバイト数
+	uint64_t GetSavedSize() const { return dedicatedSize - GetTotalSize(); }
+	// ほかのリソースとメモリを共有しているか
+	bool IsAliased(uint32_t request) const;
+};
+
+// 使う期間が重ならないリソースに同じメモリを使わせる（GPUのリソースには依存しない）
+// 期間を区間グラフとして、始まりの順に空いている領域を割り当てて色分けする（色の数は同時に使うリソースの最大数になる）
+// 空いている領域からは収まる最も小さいものを選び、収まるものが無ければ最も大きいものを広げる
+// 最後に領域を大きい順にmaxHeapSizeのヒープへ詰める（maxHeapSizeより大きい領域は専用のヒープになる）
+AliasingPlan PlanAliasing(const std::vector<AliasingRequest>& requests, uint64_t maxHeapSize = UINT64_MAX);
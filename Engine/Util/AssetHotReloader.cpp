@@ -0,0 +1,249 @@
+#include "AssetHotReloader.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <sstream>
+
+// MyClass
+#include "DirectXBase.h"
+#include "Logger.h"
+#include "TextureUploader.h"
+
+AssetHotReloader& AssetHotReloader::GetInstance()
+{
+	static AssetHotReloader instance;
+
+	return instance;
+}
+
+void AssetHotReloader::Initialize(const std::vector<std::string>& directoryPaths, ID3D12Device* device)
+{
+	AssetHotReloader& instance = GetInstance();
+	assert(!instance.isRunning_);
+	instance.device_ = device;
+
+	// 共有していると、片方のパスの画像を変更したときにもう片方のTextureも差し替わってしまう
+	TextureManager::SetContentSharing(false);
+
+	// 監視するディレクトリを登録する
+	for (const std::string& directoryPath : directoryPaths) {
+		if (!instance.watcher_.AddDirectory(directoryPath)) {
+			Log(std::format("AssetHotReloader : failed to watch {}\n", directoryPath));
+		}
+	}
+
+	// ワーカースレッドを開始する
+	instance.isRunning_ = true;
+	instance.worker_ = std::thread(&AssetHotReloader::WorkerMain, &instance);
+}
+
+void AssetHotReloader::Finalize()
+{
+	AssetHotReloader& instance = GetInstance();
+
+	// ワーカースレッドを止める
+	instance.isRunning_ = false;
+	if (instance.worker_.joinable()) {
+		instance.worker_.join();
+	}
+
+	// 終了時はGPUの処理が終わっているので全て解放する（差し替えなかったモデルのマテリアルの参照も手放す）
+	for (ReloadedModel& reloaded : instance.reloadedModels_) {
+		MaterialTable::Unregister(reloaded.model.material);
+	}
+	instance.reloadedModels_.clear();
+	instance.reloadedTextures_.clear();
+	instance.retiredAssets_.clear();
+	instance.watchedModels_.clear();
+	instance.watchedTextures_.clear();
+}
+
+void AssetHotReloader::WatchModel(ModelData* model, const std::string& directoryPath, const std::string& filename)
+{
+	AssetHotReloader& instance = GetInstance();
+	WatchedModel watched = { model, directoryPath, filename };
+	{
+		std::lock_guard<std::mutex> lock(instance.watchMutex_);
+		instance.AddWatchedModel(directoryPath + "/" + filename, watched);
+	}
+	// 色やテクスチャを変えたときにも読み直すため、mtlファイルも監視する
+	instance.WatchMaterialLibraries(watched);
+
+	// モデルが使用しているテクスチャも監視する（glTFに埋め込まれた画像は除く）
+	const std::string& textureFilePath = model->material.textureFilePath;
+	if (!textureFilePath.empty() && textureFilePath.find('#') == std::string::npos) {
+		WatchTexture(model->material.textureHandle, textureFilePath);
+	}
+}
+
+void AssetHotReloader::WatchMaterialLibraries(const WatchedModel& watched)
+{
+	// mtlファイルを参照するのはObjのみ
+	if (!watched.filename.ends_with(".obj")) {
+		return;
+	}
+	std::ifstream file(watched.directoryPath + "/" + watched.filename);
+	std::vector<std::string> materialFilenames;
+	std::string line;
+	while (std::getline(file, line)) {
+		if (line.starts_with("mtllib")) {
+			std::istringstream s(line.substr(std::strlen("mtllib")));
+			std::string materialFilename;
+			s >> materialFilename;
+			materialFilenames.push_back(materialFilename);
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(watchMutex_);
+	for (const std::string& materialFilename : materialFilenames) {
+		AddWatchedModel(watched.directoryPath + "/" + materialFilename, watched);
+	}
+}
+
+void AssetHotReloader::AddWatchedModel(const std::string& filePath, const WatchedModel& watched)
+{
+	std::vector<WatchedModel>& models = watchedModels_[filePath];
+	for (const WatchedModel& model : models) {
+		if (model.model == watched.model) {
+			return;
+		}
+	}
+	models.push_back(watched);
+}
+
+void AssetHotReloader::WatchTexture(uint32_t textureHandle, const std::string& filePath)
+{
+	AssetHotReloader& instance = GetInstance();
+	std::lock_guard<std::mutex> lock(instance.watchMutex_);
+
+	// 同じハンドルを二重に登録しない
+	std::vector<uint32_t>& handles = instance.watchedTextures_[filePath];
+	if (std::find(handles.begin(), handles.end(), textureHandle) == handles.end()) {
+		handles.push_back(textureHandle);
+	}
+}
+
+void AssetHotReloader::Update()
+{
+	AssetHotReloader& instance = GetInstance();
+	DirectXBase* dxBase = DirectXBase::GetInstance();
+
+	// これまでに積んだコマンドが古いリソースを参照している可能性がある
+	uint64_t fenceValue = dxBase->GetFenceValue();
+	uint64_t completedFenceValue = dxBase->GetCompletedFenceValue();
+
+	std::vector<ReloadedModel> reloadedModels;
+	std::vector<ReloadedTexture> reloadedTextures;
+	{
+		std::lock_guard<std::mutex> lock(instance.reloadMutex_);
+		reloadedModels.swap(instance.reloadedModels_);
+		// SRVは同じ場所に作り直すが、描画用のDescriptorHeapにはGPUが使っていないフレームの領域から順にコピーされるので、いつ差し替えてもよい
+		reloadedTextures.swap(instance.reloadedTextures_);
+	}
+
+	// モデルの中身を入れ替え、古いリソースはGPUが使い終わるまで保持する
+	for (ReloadedModel& reloaded : reloadedModels) {
+		std::swap(*reloaded.target, reloaded.model);
+		// 古いモデルのマテリアルの参照を手放す（定数バッファとテクスチャは、それぞれGPUが使い終わるまで解放されない）
+		MaterialTable::Unregister(reloaded.model.material);
+		instance.retiredAssets_.push_back({ fenceValue, std::move(reloaded.model), nullptr });
+
+		// 読み直したモデルのテクスチャも監視する
+		const std::string& textureFilePath = reloaded.target->material.textureFilePath;
+		if (!textureFilePath.empty() && textureFilePath.find('#') == std::string::npos) {
+			WatchTexture(reloaded.target->material.textureHandle, textureFilePath);
+		}
+	}
+
+	// テクスチャを差し替える（ハンドルは変わらない）
+	for (ReloadedTexture& reloaded : reloadedTextures) {
+		Microsoft::WRL::ComPtr<ID3D12Resource> oldResource = TextureManager::ReplaceTexture(reloaded.textureHandle, reloaded.resource, reloaded.metadata, instance.device_);
+		instance.retiredAssets_.push_back({ fenceValue, ModelData{}, std::move(oldResource) });
+	}
+
+	// GPUが使い終わった古いリソースを解放する
+	instance.retiredAssets_.remove_if([completedFenceValue](const RetiredAsset& retired) {
+		return retired.fenceValue <= completedFenceValue;
+	});
+}
+
+void AssetHotReloader::WorkerMain()
+{
+#ifdef _WIN32
+	// WICでの画像の読み込みにCOMが必要
+	CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+#endif
+
+	while (isRunning_) {
+		// 変更されたファイルのうち、監視しているものだけを読み直す
+		for (const std::string& filePath : watcher_.PollChanges()) {
+			Reload(filePath);
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(kPollIntervalMilliseconds_));
+	}
+
+#ifdef _WIN32
+	CoUninitialize();
+#endif
+}
+
+void AssetHotReloader::Reload(const std::string& filePath)
+{
+	// 監視対象を取り出す
+	std::vector<WatchedModel> models;
+	std::vector<uint32_t> textureHandles;
+	{
+		std::lock_guard<std::mutex> lock(watchMutex_);
+		if (auto itr = watchedModels_.find(filePath); itr != watchedModels_.end()) {
+			models = itr->second;
+		}
+		if (auto itr = watchedTextures_.find(filePath); itr != watchedTextures_.end()) {
+			textureHandles = itr->second;
+		}
+	}
+
+	// Initializeより前に読み込まれて別のパスと共有しているTextureは、そのパスの画像まで変わってしまうので差し替えない
+	std::erase_if(textureHandles, [&filePath](uint32_t textureHandle) {
+		if (!TextureManager::IsSharedWithOtherPath(textureHandle, filePath)) {
+			return false;
+		}
+		Log(std::format("AssetHotReloader : {} shares its texture with another path and was not reloaded (call Initialize before loading)\n", filePath));
+		return true;
+	});
+
+	// テクスチャはデコードとミップマップの生成、転送までをワーカースレッドで行う
+	if (!textureHandles.empty()) {
+		Log(std::format("AssetHotReloader : reloading texture {}\n", filePath));
+		DirectX::ScratchImage mipImages = TextureManager::LoadTexture(filePath);
+		std::vector<ReloadedTexture> reloadedTextures;
+		for (uint32_t textureHandle : textureHandles) {
+			ReloadedTexture& reloaded = reloadedTextures.emplace_back(ReloadedTexture{ textureHandle, TextureManager::CreateTextureResource(device_, mipImages.GetMetadata()), mipImages.GetMetadata() });
+			TextureManager::UploadTextureData(reloaded.resource.Get(), mipImages);
+		}
+		// コピーを提出して描画キューがその完了を待つようにしてから、差し替え待ちに渡す
+		// （先に渡すと、メインスレッドが差し替えたSRVをコピーの提出より前に描画で使ってしまう）
+		TextureUploader::Flush();
+		std::lock_guard<std::mutex> lock(reloadMutex_);
+		for (ReloadedTexture& reloaded : reloadedTextures) {
+			reloadedTextures_.push_back(std::move(reloaded));
+		}
+	}
+
+	// モデルは頂点・インデックスの生成までをワーカースレッドで行う
+	for (const WatchedModel& watched : models) {
+		Log(std::format("AssetHotReloader : reloading model {}\n", filePath));
+		ModelData model = ModelManager::LoadModelFile(watched.directoryPath, watched.filename, device_);
+		// 書き込み途中などで読めなかった場合は、次の変更まで今のモデルを使い続ける
+		if (!model.vertexResource) {
+			Log(std::format("AssetHotReloader : {} could not be loaded and the current model was kept\n", filePath));
+			continue;
+		}
+		// 読み直したモデルが別のmtlファイルを参照していれば、それも監視する
+		WatchMaterialLibraries(watched);
+		std::lock_guard<std::mutex> lock(reloadMutex_);
+		reloadedModels_.push_back({ watched.model, std::move(model) });
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <unordered_map>
+#include <d3d12.h>
+#include <wrl.h>
+
+// MyClass
+#include "FileWatcher.h"
+#include "ModelManager.h"
+#include "TextureManager.h"
+
+// モデルとテクスチャのファイルの変更を監視し、ワーカースレッドで読み直してフレームの区切りで差し替える
+class AssetHotReloader final
+{
+public:
+	static AssetHotReloader& GetInstance();
+
+	// 監視するディレクトリを指定してワーカースレッドを開始する
+	// パスごとに差し替えられるように、内容が同じ別のパスの画像を共有しないようにするので、Textureを読み込む前に呼ぶ
+	static void Initialize(const std::vector<std::string>& directoryPaths, ID3D12Device* device);
+	// ワーカースレッドを止めて、保持しているリソースを解放する
+	static void Finalize();
+
+	// モデルを監視対象にする（モデルが参照しているmtlファイルと、使用しているテクスチャも監視対象にする）
+	static void WatchModel(ModelData* model, const std::string& directoryPath, const std::string& filename);
+	// テクスチャを監視対象にする
+	static void WatchTexture(uint32_t textureHandle, const std::string& filePath);
+
+	// 読み直しが終わったアセットを差し替え、GPUが使い終わった古いリソースを解放する（フレームの区切りで呼ぶ）
+	static void Update();
+
+private:
+	// 監視しているモデル
+	struct WatchedModel {
+		ModelData* model;
+		std::string directoryPath;
+		std::string filename;
+	};
+	// ワーカースレッドで読み直したモデル
+	struct ReloadedModel {
+		ModelData* target;
+		ModelData model;
+	};
+	// ワーカースレッドで読み直したテクスチャ
+	struct ReloadedTexture {
+		uint32_t textureHandle;
+		Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+		DirectX::TexMetadata metadata;
+	};
+	// GPUが使い終わるまで保持しておく古いリソース
+	struct RetiredAsset {
+		uint64_t fenceValue;
+		ModelData model;
+		Microsoft::WRL::ComPtr<ID3D12Resource> texture;
+	};
+
+	// モデルが参照しているmtlファイルを監視対象にする（Objのmtllibを読む。読み直したときにも呼ぶ）
+	void WatchMaterialLibraries(const WatchedModel& watched);
+	// 同じモデルを二重に登録せずに監視対象にする（watchMutex_をロックして呼ぶ）
+	void AddWatchedModel(const std::string& filePath, const WatchedModel& watched);
+
+	// ワーカースレッドの処理
+	void WorkerMain();
+	// 変更されたファイルを読み直す
+	void Reload(const std::string& filePath);
+
+	static const uint32_t kPollIntervalMilliseconds_ = 200;
+
+	ID3D12Device* device_ = nullptr;
+	FileWatcher watcher_;
+	std::thread worker_;
+	std::atomic<bool> isRunning_ = false;
+
+	// 監視対象（ファイルのパスをキーにする。モデルはmtlファイルのパスでも登録する）
+	std::unordered_map<std::string, std::vector<WatchedModel>> watchedModels_;
+	std::unordered_map<std::string, std::vector<uint32_t>> watchedTextures_;
+	std::mutex watchMutex_;
+
+	// 差し替え待ちのアセット
+	std::vector<ReloadedModel> reloadedModels_;
+	std::vector<ReloadedTexture> reloadedTextures_;
+	std::mutex reloadMutex_;
+
+	// 解放待ちのアセット（メインスレッドのみで扱う）
+	std::list<RetiredAsset> retiredAssets_;
+};
+
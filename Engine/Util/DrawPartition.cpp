@@ -0,0 +1,74 @@
+#include "DrawPartition.h"
+#include <algorithm>
+#include <cassert>
+
+// MyClass
+#include "ParallelFor.h"
+#include "WorkerPool.h"
+
+std::vector<DrawRange> PartitionDraws(size_t drawCount, uint32_t maxChunkCount, size_t minDrawsPerChunk)
+{
+	std::vector<DrawRange> ranges;
+	if (drawCount == 0) {
+		return ranges;
+	}
+
+	// 少ない描画を細かく分けると、コマンドリストごとの準備と提出の方が高くつく
+	size_t chunkCount = (std::max)(size_t(1), (std::min)(size_t((std::max)(maxChunkCount, 1u)), drawCount / (std::max)(minDrawsPerChunk, size_t(1))));
+
+	// 余りは先頭のチャンクから1つずつ配る
+	size_t baseSize = drawCount / chunkCount;
+	size_t remainder = drawCount % chunkCount;
+	ranges.reserve(chunkCount);
+	size_t begin = 0;
+	for (size_t i = 0; i < chunkCount; ++i) {
+		size_t size = baseSize + (i < remainder ? 1 : 0);
+		ranges.push_back({ begin, begin + size });
+		begin += size;
+	}
+	assert(begin == drawCount);
+	return ranges;
+}
+
+namespace {
+	// 範囲ごとのチャンクをparallelForで分担して記録し、チャンクの順にsinkへ提出する
+	template <typename ParallelForFunction>
+	void RecordChunks(size_t drawCount, uint32_t threadCount, size_t minDrawsPerChunk, DrawCommandSink& sink, const std::function<void(uint32_t chunk, size_t drawIndex)>& recordDraw, ParallelForFunction parallelFor)
+	{
+		std::vector<DrawRange> ranges = PartitionDraws(drawCount, threadCount, minDrawsPerChunk);
+
+		// チャンクごとに1つのスレッドが記録する（チャンクの数はスレッド数以下なので、各スレッドが1つずつ持つ）
+		parallelFor(ranges.size(), threadCount, [&](size_t index) {
+			uint32_t chunk = uint32_t(index);
+			sink.BeginChunk(chunk);
+			for (size_t drawIndex = ranges[index].begin; drawIndex < ranges[index].end; ++drawIndex) {
+				recordDraw(chunk, drawIndex);
+			}
+			sink.EndChunk(chunk);
+		});
+
+		// 記録した順に関係なく、チャンクの順に提出する
+		sink.Submit(uint32_t(ranges.size()));
+	}
+}
+
+void RecordDrawsInParallel(size_t drawCount, uint32_t threadCount, size_t minDrawsPerChunk, DrawCommandSink& sink, const std::function<void(uint32_t chunk, size_t drawIndex)>& recordDraw)
+{
+	if (threadCount == 0) {
+		threadCount = GetDefaultThreadCount();
+	}
+	RecordChunks(drawCount, threadCount, minDrawsPerChunk, sink, recordDraw, [](size_t count, uint32_t threads, const std::function<void(size_t index)>& function) {
+		ParallelFor(count, threads, function);
+	});
+}
+
+void RecordDrawsInParallel(WorkerPool& pool, size_t drawCount, uint32_t threadCount, size_t minDrawsPerChunk, DrawCommandSink& sink, const std::function<void(uint32_t chunk, size_t drawIndex)>& recordDraw)
+{
+	// プールのスレッド数より多くのチャンクに分けると、1つのスレッドが複数のチャンクを持つことになる
+	if (threadCount == 0 || threadCount > pool.GetThreadCount()) {
+		threadCount = pool.GetThreadCount();
+	}
+	RecordChunks(drawCount, threadCount, minDrawsPerChunk, sink, recordDraw, [&pool](size_t count, uint32_t threads, const std::function<void(size_t index)>& function) {
+		pool.ParallelFor(count, threads, function);
+	});
+}
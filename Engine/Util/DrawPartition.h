@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class WorkerPool;
+
+// 連続した描画の範囲 [begin, end)
+struct DrawRange {
+	size_t begin;
+	size_t end;
+};
+
+// チャンクごとの描画の記録先（D3D12ではチャンクごとのコマンドリスト。検証では記録を並べる偽物に差し替える）
+class DrawCommandSink
+{
+public:
+	virtual ~DrawCommandSink() = default;
+	// chunk番目のチャンクの記録を始める・終える（チャンクごとに別々のスレッドから同時に呼ばれる）
+	virtual void BeginChunk(uint32_t chunk) = 0;
+	virtual void EndChunk(uint32_t chunk) = 0;
+	// 全てのチャンクを記録し終えた後に呼ばれ、chunkCount個のチャンクをチャンクの順に提出する
+	virtual void Submit(uint32_t chunkCount) = 0;
+};
+
+// drawCount個の描画を、最大maxChunkCount個の連続した範囲に均等に分ける（1つの範囲がminDrawsPerChunkより少なくならないようにする）
+// 範囲は描画の順に並び、drawCountが0の場合は空を返す
+std::vector<DrawRange> PartitionDraws(size_t drawCount, uint32_t maxChunkCount, size_t minDrawsPerChunk);
+
+// 描画をスレッド数以下のチャンクに分けて複数のスレッドで記録し、チャンクの順にsinkへ提出する
+// recordDrawはチャンクの番号と描画の番号を受け取り、そのチャンクの記録先に1つの描画を記録する（同じチャンクの描画は順に1つのスレッドから呼ばれる）
+void RecordDrawsInParallel(size_t drawCount, uint32_t threadCount, size_t minDrawsPerChunk, DrawCommandSink& sink, const std::function<void(uint32_t chunk, size_t drawIndex)>& recordDraw);
+// 毎フレーム記録する場合は、スレッドを作らずにpoolのスレッドで記録する（threadCountが0の場合はpoolのスレッド数）
+void RecordDrawsInParallel(WorkerPool& pool, size_t drawCount, uint32_t threadCount, size_t minDrawsPerChunk, DrawCommandSink& sink, const std::function<void(uint32_t chunk, size_t drawIndex)>& recordDraw);
@@ -0,0 +1,112 @@
+#include "FileWatcher.h"
+#include <algorithm>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+
+FileWatcher::~FileWatcher()
+{
+	if (inotifyFd_ >= 0) {
+		close(inotifyFd_);
+	}
+}
+
+bool FileWatcher::AddDirectory(const std::string& directoryPath)
+{
+	// 初回のみinotifyを初期化する（読み込みでブロックしないようにする）
+	if (inotifyFd_ < 0) {
+		inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (inotifyFd_ < 0) {
+			return false;
+		}
+	}
+
+	// 書き込みが完了した時と、別名保存で置き換えられた時に通知を受ける
+	int watchDescriptor = inotify_add_watch(inotifyFd_, directoryPath.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (watchDescriptor < 0) {
+		return false;
+	}
+	directories_[watchDescriptor] = directoryPath;
+	return true;
+}
+
+std::vector<std::string> FileWatcher::PollChanges()
+{
+	std::vector<std::string> changes;
+	if (inotifyFd_ < 0) {
+		return changes;
+	}
+
+	// 溜まっているイベントを全て読む
+	alignas(inotify_event) char buffer[4096];
+	for (;;) {
+		ssize_t length = read(inotifyFd_, buffer, sizeof(buffer));
+		if (length <= 0) {
+			break;
+		}
+		for (ssize_t offset = 0; offset < length;) {
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+			auto itr = directories_.find(event->wd);
+			if (itr != directories_.end() && event->len > 0 && !(event->mask & IN_ISDIR)) {
+				changes.push_back(itr->second + "/" + event->name);
+			}
+			offset += ssize_t(sizeof(inotify_event) + event->len);
+		}
+	}
+
+	// 同じファイルへの複数回の書き込みは1回にまとめる
+	std::sort(changes.begin(), changes.end());
+	changes.erase(std::unique(changes.begin(), changes.end()), changes.end());
+	return changes;
+}
+
+#else
+
+FileWatcher::~FileWatcher()
+{
+}
+
+bool FileWatcher::AddDirectory(const std::string& directoryPath)
+{
+	std::error_code error;
+	if (!std::filesystem::is_directory(directoryPath, error)) {
+		return false;
+	}
+	directories_.push_back(directoryPath);
+
+	// 現在の更新日時を記録しておく（追加した時点のファイルは変更として扱わない）
+	for (const auto& entry : std::filesystem::directory_iterator(directoryPath, error)) {
+		if (entry.is_regular_file(error)) {
+			writeTimes_[directoryPath + "/" + entry.path().filename().string()] = entry.last_write_time(error);
+		}
+	}
+	return true;
+}
+
+std::vector<std::string> FileWatcher::PollChanges()
+{
+	std::vector<std::string> changes;
+	std::error_code error;
+
+	// 更新日時が変わったファイルと、新しく追加されたファイルを変更として扱う
+	for (const std::string& directoryPath : directories_) {
+		for (const auto& entry : std::filesystem::directory_iterator(directoryPath, error)) {
+			if (!entry.is_regular_file(error)) {
+				continue;
+			}
+			std::string filePath = directoryPath + "/" + entry.path().filename().string();
+			std::filesystem::file_time_type writeTime = entry.last_write_time(error);
+			auto itr = writeTimes_.find(filePath);
+			if (itr == writeTimes_.end() || itr->second != writeTime) {
+				writeTimes_[filePath] = writeTime;
+				changes.push_back(filePath);
+			}
+		}
+	}
+	return changes;
+}
+
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <filesystem>
+
+// ディレクトリ内のファイルの変更を監視する
+// Linuxではinotify、それ以外では更新日時のポーリングで検出する
+class FileWatcher
+{
+public:
+	FileWatcher() = default;
+	~FileWatcher();
+
+	// 監視するディレクトリを追加する（サブディレクトリは含まない）
+	bool AddDirectory(const std::string& directoryPath);
+
+	// 前回の呼び出しから変更されたファイルのパス（"ディレクトリ/ファイル名"）を取得する
+	std::vector<std::string> PollChanges();
+
+	// コピー不可にする
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+private:
+#ifdef __linux__
+	int inotifyFd_ = -1;
+	// watch descriptorからディレクトリのパスを引く
+	std::unordered_map<int, std::string> directories_;
+#else
+	// ディレクトリのパス
+	std::vector<std::string> directories_;
+	// ファイルのパスから最後に確認した更新日時を引く
+	std::unordered_map<std::string, std::filesystem::file_time_type> writeTimes_;
+#endif
+};
+
@@ -0,0 +1,134 @@
+#include "FrameLimiter.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#ifdef _WIN32
+#include <Windows.h>
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#endif
+
+namespace {
+	// 移動平均で新しい値に掛ける重み
+	const double kFrameIntervalWeight = 0.1;
+	const double kSleepWeight = 0.05;
+}
+
+SystemFrameClock::SystemFrameClock()
+{
+#ifdef _WIN32
+	// 高精度タイマーが使えれば、timeBeginPeriodを変えずに1ms未満の精度で眠れる
+	timer_ = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+#endif
+}
+
+SystemFrameClock::~SystemFrameClock()
+{
+#ifdef _WIN32
+	if (timer_) {
+		CloseHandle(timer_);
+	}
+#endif
+}
+
+int64_t SystemFrameClock::Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SystemFrameClock::Sleep(int64_t nanoseconds)
+{
+#ifdef _WIN32
+	if (timer_) {
+		// 負の値は相対時間（100ナノ秒単位）
+		LARGE_INTEGER dueTime{};
+		dueTime.QuadPart = -(std::max)(nanoseconds / 100, int64_t(1));
+		if (SetWaitableTimer(timer_, &dueTime, 0, nullptr, nullptr, FALSE)) {
+			WaitForSingleObject(timer_, INFINITE);
+			return;
+		}
+	}
+#endif
+	std::this_thread::sleep_for(std::chrono::nanoseconds(nanoseconds));
+}
+
+void SystemFrameClock::Spin()
+{
+	std::this_thread::yield();
+}
+
+FrameLimiter::FrameLimiter(double targetFrameRate, std::unique_ptr<FrameClock> clock) : clock_(std::move(clock))
+{
+	if (!clock_) {
+		clock_ = std::make_unique<SystemFrameClock>();
+	}
+	SetTargetFrameRate(targetFrameRate);
+}
+
+void FrameLimiter::SetTargetFrameRate(double targetFrameRate)
+{
+	targetFrameRate_ = (std::max)(targetFrameRate, 0.0);
+	targetInterval_ = targetFrameRate_ > 0.0 ? int64_t(1000000000.0 / targetFrameRate_) : 0;
+	// 目標時刻は次のWaitで数え直す
+	deadline_ = 0;
+}
+
+void FrameLimiter::Wait()
+{
+	int64_t now = clock_->Now();
+	if (!isStarted_) {
+		// 最初のフレームは間隔を測れないので、ここから数え始める
+		isStarted_ = true;
+		lastFrameTime_ = now;
+		deadline_ = targetInterval_ > 0 ? now + targetInterval_ : 0;
+		return;
+	}
+
+	if (targetInterval_ > 0) {
+		if (deadline_ == 0) {
+			deadline_ = lastFrameTime_ + targetInterval_;
+		}
+		WaitUntil(deadline_);
+
+		// 次の目標時刻は今回の目標時刻から数える（今回遅れた分は次のフレームで取り戻す）
+		// 1フレーム以上遅れた場合（読み込みなどで止まった場合）は、取り戻そうとせずに今から数え直す
+		deadline_ += targetInterval_;
+		now = clock_->Now();
+		if (deadline_ < now) {
+			deadline_ = now + targetInterval_;
+		}
+	} else {
+		now = clock_->Now();
+	}
+
+	// 実際の間隔を記録する
+	frameInterval_ = now - lastFrameTime_;
+	lastFrameTime_ = now;
+	averageFrameInterval_ = averageFrameInterval_ == 0.0 ? double(frameInterval_) : averageFrameInterval_ + (double(frameInterval_) - averageFrameInterval_) * kFrameIntervalWeight;
+}
+
+void FrameLimiter::WaitUntil(int64_t deadline)
+{
+	// 眠っても目標時刻を越えない見込みがある間は1msずつ眠り、実際に眠った時間から見積もりを更新する
+	while (deadline - clock_->Now() > EstimateSleepDuration()) {
+		int64_t start = clock_->Now();
+		clock_->Sleep(kSleepQuantum);
+		double observed = double(clock_->Now() - start);
+
+		double delta = observed - sleepMean_;
+		sleepMean_ += delta * kSleepWeight;
+		sleepVariance_ = (1.0 - kSleepWeight) * (sleepVariance_ + delta * delta * kSleepWeight);
+	}
+
+	// 残りはスピンして待つ
+	while (clock_->Now() < deadline) {
+		clock_->Spin();
+	}
+}
+
+int64_t FrameLimiter::EstimateSleepDuration() const
+{
+	return int64_t(sleepMean_ + std::sqrt(sleepVariance_));
+}
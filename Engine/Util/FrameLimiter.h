@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+
+// FrameLimiterが使う時刻の取得と待機（検証では偽の時計に差し替える）
+class FrameClock
+{
+public:
+	virtual ~FrameClock() = default;
+	// 単調に増える時刻（ナノ秒）
+	virtual int64_t Now() = 0;
+	// 少なくともnanosecondsの間スレッドを眠らせる（OSのスケジューラの都合で長くなることがある）
+	virtual void Sleep(int64_t nanoseconds) = 0;
+	// 待ち時間の最後にスピンしている間に呼ばれる
+	virtual void Spin() {}
+};
+
+// steady_clockの時刻と、OSの高精度タイマーで眠る時計
+class SystemFrameClock : public FrameClock
+{
+public:
+	SystemFrameClock();
+	~SystemFrameClock() override;
+
+	int64_t Now() override;
+	void Sleep(int64_t nanoseconds) override;
+	void Spin() override;
+
+private:
+	// Windowsの高精度の待機可能タイマー（作れなかった場合はnullptrで、sleep_forを使う）
+	void* timer_ = nullptr;
+};
+
+// 目標のフレームレートになるように、フレームの終わりで次のフレームの開始時刻まで待つ
+// 眠りすぎないように、誤差の見積もりより残りが長い間だけ1msずつ眠り、最後はスピンして待つ
+// 目標時刻は前回の目標時刻に1フレーム分を足して決めるので、待ちの誤差が積み重ならない
+class FrameLimiter
+{
+public:
+	// targetFrameRateが0以下の場合は待たずに間隔だけを計測する（clockがnullptrの場合はSystemFrameClockを使う）
+	explicit FrameLimiter(double targetFrameRate = 60.0, std::unique_ptr<FrameClock> clock = nullptr);
+
+	void SetTargetFrameRate(double targetFrameRate);
+	double GetTargetFrameRate() const { return targetFrameRate_; }
+
+	// フレームの終わりに呼び、次のフレームの開始時刻まで待つ
+	void Wait();
+
+	// 直前のフレームの実際の間隔と、その移動平均（ミリ秒）
+	double GetFrameInterval() const { return double(frameInterval_) / 1000000.0; }
+	double GetAverageFrameInterval() const { return averageFrameInterval_ / 1000000.0; }
+	// 1ms眠ったときに実際にかかる時間の見積もり（ミリ秒）
+	double GetSleepEstimate() const { return EstimateSleepDuration() / 1000000.0; }
+
+private:
+	// 1回に眠る時間
+	static constexpr int64_t kSleepQuantum = 1000000;
+
+	// deadlineまで眠ってからスピンする
+	void WaitUntil(int64_t deadline);
+	// 1ms眠ったときに実際にかかる時間（これまでの平均と標準偏差の和）
+	int64_t EstimateSleepDuration() const;
+
+	std::unique_ptr<FrameClock> clock_;
+	double targetFrameRate_ = 0.0;
+	// 1フレームの時間（ナノ秒。0の場合は待たない）
+	int64_t targetInterval_ = 0;
+
+	// 次のフレームの開始の目標時刻
+	int64_t deadline_ = 0;
+	// 前回Waitから戻った時刻
+	int64_t lastFrameTime_ = 0;
+	bool isStarted_ = false;
+
+	int64_t frameInterval_ = 0;
+	double averageFrameInterval_ = 0.0;
+
+	// 1ms眠ったときの実際の時間の指数移動平均と分散（ナノ秒）
+	double sleepMean_ = double(kSleepQuantum) * 2.0;
+	double sleepVariance_ = 0.0;
+};
@@ -0,0 +1,22 @@
+#include "FrameRing.h"
+#include <cassert>
+
+void FrameRing::Initialize(uint32_t frameCount)
+{
+	assert(frameCount > 0);
+	fenceValues_.assign(frameCount, 0);
+	frameIndex_ = 0;
+	frameNumber_ = 0;
+}
+
+uint64_t FrameRing::Advance(uint64_t submittedFenceValue)
+{
+	// Fenceの値は提出するたびに増える
+	assert(submittedFenceValue > fenceValues_[(frameIndex_ + GetFrameCount() - 1) % GetFrameCount()]);
+	fenceValues_[frameIndex_] = submittedFenceValue;
+	frameNumber_++;
+
+	// 次の領域は、frameCount個前のフレームが使っている
+	frameIndex_ = (frameIndex_ + 1) % GetFrameCount();
+	return fenceValues_[frameIndex_];
+}
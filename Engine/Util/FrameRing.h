@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// 同時にGPUで実行できるフレーム（コマンドアロケータなどフレームごとの領域）を順に使い回し、
+// 再利用するフレームの領域を前回使ったフレームのFenceの値を覚えておく（GPUのリソースには依存しない）
+class FrameRing
+{
+public:
+	// frameCount個のフレームの領域を使い回す（1の場合は毎フレームGPUを待つ）
+	void Initialize(uint32_t frameCount);
+
+	// 今のフレームをsubmittedFenceValueで提出したことを記録して次のフレームに進む
+	// 次のフレームの領域を再利用する前にGPUが到達している必要のあるFenceの値を返す（まだ使っていなければ0）
+	uint64_t Advance(uint64_t submittedFenceValue);
+
+	// 今のフレームの領域の番号
+	uint32_t GetFrameIndex() const { return frameIndex_; }
+	uint32_t GetFrameCount() const { return uint32_t(fenceValues_.size()); }
+	// これまでに提出したフレームの数
+	uint64_t GetFrameNumber() const { return frameNumber_; }
+	// その領域を最後に使ったフレームのFenceの値（まだ使っていなければ0）
+	uint64_t GetFenceValue(uint32_t frameIndex) const { return fenceValues_[frameIndex]; }
+
+private:
+	std::vector<uint64_t> fenceValues_;
+	uint32_t frameIndex_ = 0;
+	uint64_t frameNumber_ = 0;
+};
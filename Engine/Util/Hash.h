@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// FNV-1aでバイト列のハッシュ値を求める（hashに前回の値を渡すと続けて計算できる）
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
@@ -0,0 +1,384 @@
+#include "Inflate.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+	// 符号の最大の長さ
+	const uint32_t kMaxBits = 15;
+	// 1回の参照で引ける符号の長さ（これより長い符号は1ビットずつ辿る）
+	const uint32_t kFastBits = 10;
+
+	// 長さと距離の符号の基本値と追加ビット数（RFC 1951 3.2.5）
+	const uint16_t kLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const uint8_t kLengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const uint16_t kDistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const uint8_t kDistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	// 符号長の符号の長さが並ぶ順
+	const uint8_t kCodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	// 下位ビットから読むビットの読み込み
+	class BitReader
+	{
+	public:
+		BitReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+		// 少なくともcountビットをbitBuffer_に入れる（データの終わりを超えた分は0を入れ、IsOverrunで検出する）
+		void Refill(uint32_t count)
+		{
+			while (bitCount_ < count) {
+				uint64_t byte = position_ < size_ ? data_[position_] : 0;
+				position_++;
+				bitBuffer_ |= byte << bitCount_;
+				bitCount_ += 8;
+			}
+		}
+		uint32_t Peek(uint32_t count)
+		{
+			Refill(count);
+			return uint32_t(bitBuffer_ & ((uint64_t(1) << count) - 1));
+		}
+		void Consume(uint32_t count)
+		{
+			bitBuffer_ >>= count;
+			bitCount_ -= count;
+		}
+		uint32_t Read(uint32_t count)
+		{
+			if (count == 0) {
+				return 0;
+			}
+			uint32_t value = Peek(count);
+			Consume(count);
+			return value;
+		}
+		// バイト境界まで読み飛ばす
+		void AlignToByte() { Consume(bitCount_ % 8); }
+		// 読み込み済みでまだ使っていないバイトを戻した位置
+		size_t GetBytePosition() const { return position_ - bitCount_ / 8; }
+		// バイト境界から直接読むため、バッファを空にする（AlignToByteの後に呼ぶ）
+		void ResetTo(size_t position)
+		{
+			position_ = position;
+			bitBuffer_ = 0;
+			bitCount_ = 0;
+		}
+		bool IsOverrun() const { return GetBytePosition() > size_; }
+		const uint8_t* GetData() const { return data_; }
+		size_t GetSize() const { return size_; }
+
+	private:
+		const uint8_t* data_;
+		size_t size_;
+		size_t position_ = 0;
+		uint64_t bitBuffer_ = 0;
+		uint32_t bitCount_ = 0;
+	};
+
+	// 正準ハフマン符号の復号表
+	class HuffmanTable
+	{
+	public:
+		// 各記号の符号長から表を作る（符号が過剰な場合はfalse）
+		bool Build(const uint8_t* lengths, uint32_t symbolCount)
+		{
+			std::memset(counts_, 0, sizeof(counts_));
+			for (uint32_t symbol = 0; symbol < symbolCount; ++symbol) {
+				counts_[lengths[symbol]]++;
+			}
+			counts_[0] = 0;
+
+			// 符号が多すぎないか確認する（足りない場合は許す）
+			int32_t left = 1;
+			for (uint32_t length = 1; length <= kMaxBits; ++length) {
+				left = left * 2 - int32_t(counts_[length]);
+				if (left < 0) {
+					return false;
+				}
+			}
+
+			// 符号長ごとの先頭の位置
+			uint16_t offsets[kMaxBits + 2] = {};
+			for (uint32_t length = 1; length <= kMaxBits; ++length) {
+				offsets[length + 1] = offsets[length] + counts_[length];
+			}
+			for (uint32_t symbol = 0; symbol < symbolCount; ++symbol) {
+				if (lengths[symbol] != 0) {
+					symbols_[offsets[lengths[symbol]]++] = uint16_t(symbol);
+				}
+			}
+
+			// 短い符号は、ビットを反転した値で直接引けるようにする
+			std::memset(fast_, 0, sizeof(fast_));
+			uint32_t code = 0;
+			uint32_t index = 0;
+			for (uint32_t length = 1; length <= kFastBits; ++length) {
+				for (uint32_t i = 0; i < counts_[length]; ++i, ++code, ++index) {
+					uint32_t reversed = Reverse(code, length);
+					for (uint32_t fill = reversed; fill < (1u << kFastBits); fill += 1u << length) {
+						fast_[fill] = uint16_t((symbols_[index] << 4) | length);
+					}
+				}
+				code <<= 1;
+			}
+			return true;
+		}
+
+		// 記号を1つ読む（無効な符号の場合は-1）
+		int32_t Decode(BitReader& reader) const
+		{
+			uint32_t bits = reader.Peek(kMaxBits);
+			uint16_t entry = fast_[bits & ((1u << kFastBits) - 1)];
+			if (entry != 0) {
+				reader.Consume(entry & 0xf);
+				return entry >> 4;
+			}
+
+			// 長い符号は1ビットずつ辿る
+			int32_t code = 0;
+			int32_t first = 0;
+			int32_t index = 0;
+			for (uint32_t length = 1; length <= kMaxBits; ++length) {
+				code |= (bits >> (length - 1)) & 1;
+				int32_t count = counts_[length];
+				if (code - count < first) {
+					reader.Consume(length);
+					return symbols_[index + (code - first)];
+				}
+				index += count;
+				first += count;
+				first <<= 1;
+				code <<= 1;
+			}
+			return -1;
+		}
+
+	private:
+		static uint32_t Reverse(uint32_t code, uint32_t length)
+		{
+			uint32_t result = 0;
+			for (uint32_t i = 0; i < length; ++i) {
+				result = (result << 1) | ((code >> i) & 1);
+			}
+			return result;
+		}
+
+		uint16_t counts_[kMaxBits + 1] = {};
+		uint16_t symbols_[288] = {};
+		// 上位12ビットが記号、下位4ビットが符号長（0は表に無い）
+		uint16_t fast_[1 << kFastBits] = {};
+	};
+
+	// 符号化されたブロックを展開する
+	bool DecodeBlock(BitReader& reader, std::vector<uint8_t>& output, const HuffmanTable& literalTable, const HuffmanTable& distanceTable)
+	{
+		while (true) {
+			int32_t symbol = literalTable.Decode(reader);
+			if (symbol < 0 || reader.IsOverrun()) {
+				return false;
+			}
+			if (symbol < 256) {
+				output.push_back(uint8_t(symbol));
+				continue;
+			}
+			if (symbol == 256) {
+				return true;
+			}
+
+			// 長さと距離を読み、既に展開したデータをコピーする
+			symbol -= 257;
+			if (symbol >= 29) {
+				return false;
+			}
+			uint32_t length = kLengthBase[symbol] + reader.Read(kLengthExtra[symbol]);
+			int32_t distanceSymbol = distanceTable.Decode(reader);
+			if (distanceSymbol < 0 || distanceSymbol >= 30) {
+				return false;
+			}
+			uint32_t distance = kDistanceBase[distanceSymbol] + reader.Read(kDistanceExtra[distanceSymbol]);
+			if (distance > output.size()) {
+				return false;
+			}
+			size_t from = output.size() - distance;
+			size_t to = output.size();
+			output.resize(to + length);
+			uint8_t* buffer = output.data();
+			if (distance >= length) {
+				std::memcpy(buffer + to, buffer + from, length);
+			} else {
+				// 重なる場合は同じパターンの繰り返しになるので、コピー済みの範囲を倍にしながらコピーする
+				size_t copied = 0;
+				while (copied < length) {
+					size_t period = to + copied - from;
+					size_t count = (std::min)(period, length - copied);
+					std::memcpy(buffer + to + copied, buffer + from, count);
+					copied += count;
+				}
+			}
+		}
+	}
+
+	// 固定ハフマン符号の表
+	void BuildFixedTables(HuffmanTable& literalTable, HuffmanTable& distanceTable)
+	{
+		uint8_t lengths[288];
+		for (uint32_t i = 0; i < 144; ++i) { lengths[i] = 8; }
+		for (uint32_t i = 144; i < 256; ++i) { lengths[i] = 9; }
+		for (uint32_t i = 256; i < 280; ++i) { lengths[i] = 7; }
+		for (uint32_t i = 280; i < 288; ++i) { lengths[i] = 8; }
+		literalTable.Build(lengths, 288);
+		for (uint32_t i = 0; i < 30; ++i) { lengths[i] = 5; }
+		distanceTable.Build(lengths, 30);
+	}
+
+	// 動的ハフマン符号の表を読む
+	bool ReadDynamicTables(BitReader& reader, HuffmanTable& literalTable, HuffmanTable& distanceTable)
+	{
+		uint32_t literalCount = reader.Read(5) + 257;
+		uint32_t distanceCount = reader.Read(5) + 1;
+		uint32_t codeLengthCount = reader.Read(4) + 4;
+		if (literalCount > 286 || distanceCount > 30) {
+			return false;
+		}
+
+		// 符号長を符号化するための符号
+		uint8_t codeLengths[19] = {};
+		for (uint32_t i = 0; i < codeLengthCount; ++i) {
+			codeLengths[kCodeLengthOrder[i]] = uint8_t(reader.Read(3));
+		}
+		HuffmanTable codeLengthTable;
+		if (!codeLengthTable.Build(codeLengths, 19)) {
+			return false;
+		}
+
+		// リテラルと距離の符号長（続けて並ぶ）
+		uint8_t lengths[286 + 30] = {};
+		uint32_t index = 0;
+		while (index < literalCount + distanceCount) {
+			int32_t symbol = codeLengthTable.Decode(reader);
+			if (symbol < 0 || reader.IsOverrun()) {
+				return false;
+			}
+			if (symbol < 16) {
+				lengths[index++] = uint8_t(symbol);
+				continue;
+			}
+			uint8_t value = 0;
+			uint32_t repeat = 0;
+			if (symbol == 16) {
+				if (index == 0) {
+					return false;
+				}
+				value = lengths[index - 1];
+				repeat = 3 + reader.Read(2);
+			} else if (symbol == 17) {
+				repeat = 3 + reader.Read(3);
+			} else {
+				repeat = 11 + reader.Read(7);
+			}
+			if (index + repeat > literalCount + distanceCount) {
+				return false;
+			}
+			std::memset(lengths + index, value, repeat);
+			index += repeat;
+		}
+
+		// 終端の符号が無いデータは壊れている
+		if (lengths[256] == 0) {
+			return false;
+		}
+		return literalTable.Build(lengths, literalCount) && distanceTable.Build(lengths + literalCount, distanceCount);
+	}
+}
+
+bool Inflate::DecompressRaw(const uint8_t* data, size_t size, std::vector<uint8_t>& output, size_t* consumedSize)
+{
+	BitReader reader(data, size);
+	HuffmanTable literalTable;
+	HuffmanTable distanceTable;
+
+	bool isFinal = false;
+	while (!isFinal) {
+		isFinal = reader.Read(1) != 0;
+		uint32_t type = reader.Read(2);
+
+		if (type == 0) {
+			// 無圧縮のブロックはそのままコピーする
+			reader.AlignToByte();
+			size_t position = reader.GetBytePosition();
+			if (position + 4 > size) {
+				return false;
+			}
+			uint32_t length = data[position] | (data[position + 1] << 8);
+			uint32_t inverse = data[position + 2] | (data[position + 3] << 8);
+			if ((length ^ 0xffff) != inverse || position + 4 + length > size) {
+				return false;
+			}
+			output.insert(output.end(), data + position + 4, data + position + 4 + length);
+			reader.ResetTo(position + 4 + length);
+		} else if (type == 1) {
+			BuildFixedTables(literalTable, distanceTable);
+			if (!DecodeBlock(reader, output, literalTable, distanceTable)) {
+				return false;
+			}
+		} else if (type == 2) {
+			if (!ReadDynamicTables(reader, literalTable, distanceTable) || !DecodeBlock(reader, output, literalTable, distanceTable)) {
+				return false;
+			}
+		} else {
+			return false;
+		}
+		if (reader.IsOverrun()) {
+			return false;
+		}
+	}
+
+	if (consumedSize) {
+		reader.AlignToByte();
+		*consumedSize = reader.GetBytePosition();
+	}
+	return true;
+}
+
+bool Inflate::DecompressZlib(const uint8_t* data, size_t size, std::vector<uint8_t>& output, size_t expectedSize)
+{
+	// ヘッダ（Deflateであること、チェックサム、プリセット辞書が無いこと）を確認する
+	if (size < 6 || (data[0] & 0x0f) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20) != 0) {
+		return false;
+	}
+
+	size_t outputBegin = output.size();
+	output.reserve(outputBegin + expectedSize);
+	size_t consumedSize = 0;
+	if (!DecompressRaw(data + 2, size - 2, output, &consumedSize)) {
+		return false;
+	}
+
+	// 末尾のAdler-32で展開結果を確認する
+	size_t checksumPosition = 2 + consumedSize;
+	if (checksumPosition + 4 > size) {
+		return false;
+	}
+	uint32_t checksum = (uint32_t(data[checksumPosition]) << 24) | (uint32_t(data[checksumPosition + 1]) << 16) | (uint32_t(data[checksumPosition + 2]) << 8) | data[checksumPosition + 3];
+	return Adler32(output.data() + outputBegin, output.size() - outputBegin) == checksum;
+}
+
+uint32_t Inflate::Adler32(const uint8_t* data, size_t size, uint32_t adler)
+{
+	const uint32_t kModulo = 65521;
+	// 32bitで溢れない範囲（5552バイト）ごとに剰余を取る
+	const size_t kBlockSize = 5552;
+	uint32_t a = adler & 0xffff;
+	uint32_t b = adler >> 16;
+	while (size > 0) {
+		size_t blockSize = size < kBlockSize ? size : kBlockSize;
+		for (size_t i = 0; i < blockSize; ++i) {
+			a += data[i];
+			b += a;
+		}
+		a %= kModulo;
+		b %= kModulo;
+		data += blockSize;
+		size -= blockSize;
+	}
+	return (b << 16) | a;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Deflate（RFC 1951）で圧縮されたデータを展開する（zlibに依存しない）
+class Inflate
+{
+public:
+	// zlib形式（RFC 1950。2バイトのヘッダとAdler-32が付く）のデータを展開してoutputの末尾に追加する（壊れたデータの場合はfalseを返す）
+	// expectedSizeが分かっている場合は、あらかじめその分の領域を確保する
+	static bool DecompressZlib(const uint8_t* data, size_t size, std::vector<uint8_t>& output, size_t expectedSize = 0);
+	// ヘッダの無いDeflateのデータを展開してoutputの末尾に追加する（読んだバイト数をconsumedSizeに返す）
+	static bool DecompressRaw(const uint8_t* data, size_t size, std::vector<uint8_t>& output, size_t* consumedSize = nullptr);
+
+	// Adler-32を求める
+	static uint32_t Adler32(const uint8_t* data, size_t size, uint32_t adler = 1);
+};
@@ -0,0 +1,270 @@
+#include "Json.h"
+#include <charconv>
+
+namespace {
+	// 存在しない要素を参照したときに返す値
+	const JsonValue kNullValue{};
+	const std::string kEmptyString{};
+}
+
+// 再帰下降でJSONを解析する
+class JsonValue::Parser
+{
+public:
+	Parser(std::string_view text) : text_(text) {}
+
+	bool ParseValue(JsonValue& out, int32_t depth)
+	{
+		// 深すぎるネストは不正なデータとして扱う
+		if (depth > kMaxDepth_) {
+			return false;
+		}
+
+		SkipWhitespace();
+		if (pos_ >= text_.size()) {
+			return false;
+		}
+
+		char c = text_[pos_];
+		if (c == '{') {
+			return ParseObject(out, depth);
+		} else if (c == '[') {
+			return ParseArray(out, depth);
+		} else if (c == '"') {
+			out.type_ = Type::String;
+			return ParseString(out.string_);
+		} else if (c == 't' || c == 'f' || c == 'n') {
+			return ParseLiteral(out);
+		}
+		return ParseNumber(out);
+	}
+
+	// 末尾に余計な文字が無いか
+	bool IsEnd()
+	{
+		SkipWhitespace();
+		return pos_ == text_.size();
+	}
+
+private:
+	void SkipWhitespace()
+	{
+		while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r')) {
+			pos_++;
+		}
+	}
+
+	bool Consume(char c)
+	{
+		SkipWhitespace();
+		if (pos_ < text_.size() && text_[pos_] == c) {
+			pos_++;
+			return true;
+		}
+		return false;
+	}
+
+	bool ParseObject(JsonValue& out, int32_t depth)
+	{
+		out.type_ = Type::Object;
+		pos_++; // {
+		if (Consume('}')) {
+			return true;
+		}
+		do {
+			SkipWhitespace();
+			std::string key;
+			if (pos_ >= text_.size() || text_[pos_] != '"' || !ParseString(key) || !Consume(':')) {
+				return false;
+			}
+			JsonValue value;
+			if (!ParseValue(value, depth + 1)) {
+				return false;
+			}
+			out.keys_.push_back(std::move(key));
+			out.values_.push_back(std::move(value));
+		} while (Consume(','));
+		return Consume('}');
+	}
+
+	bool ParseArray(JsonValue& out, int32_t depth)
+	{
+		out.type_ = Type::Array;
+		pos_++; // [
+		if (Consume(']')) {
+			return true;
+		}
+		do {
+			JsonValue value;
+			if (!ParseValue(value, depth + 1)) {
+				return false;
+			}
+			out.values_.push_back(std::move(value));
+		} while (Consume(','));
+		return Consume(']');
+	}
+
+	bool ParseString(std::string& out)
+	{
+		pos_++; // "
+		while (pos_ < text_.size()) {
+			char c = text_[pos_++];
+			if (c == '"') {
+				return true;
+			}
+			if (c != '\\') {
+				out += c;
+				continue;
+			}
+			// エスケープシーケンス
+			if (pos_ >= text_.size()) {
+				return false;
+			}
+			char escaped = text_[pos_++];
+			switch (escaped) {
+			case '"': out += '"'; break;
+			case '\\': out += '\\'; break;
+			case '/': out += '/'; break;
+			case 'b': out += '\b'; break;
+			case 'f': out += '\f'; break;
+			case 'n': out += '\n'; break;
+			case 'r': out += '\r'; break;
+			case 't': out += '\t'; break;
+			case 'u': {
+				// \uXXXXをUTF-8に変換する（サロゲートペアは非対応）
+				if (pos_ + 4 > text_.size()) {
+					return false;
+				}
+				uint32_t code = 0;
+				auto result = std::from_chars(text_.data() + pos_, text_.data() + pos_ + 4, code, 16);
+				if (result.ptr != text_.data() + pos_ + 4) {
+					return false;
+				}
+				pos_ += 4;
+				if (code < 0x80) {
+					out += char(code);
+				} else if (code < 0x800) {
+					out += char(0xC0 | (code >> 6));
+					out += char(0x80 | (code & 0x3F));
+				} else {
+					out += char(0xE0 | (code >> 12));
+					out += char(0x80 | ((code >> 6) & 0x3F));
+					out += char(0x80 | (code & 0x3F));
+				}
+				break;
+			}
+			default:
+				return false;
+			}
+		}
+		return false;
+	}
+
+	bool ParseLiteral(JsonValue& out)
+	{
+		std::string_view rest = text_.substr(pos_);
+		if (rest.starts_with("true")) {
+			out.type_ = Type::Bool;
+			out.bool_ = true;
+			pos_ += 4;
+			return true;
+		} else if (rest.starts_with("false")) {
+			out.type_ = Type::Bool;
+			out.bool_ = false;
+			pos_ += 5;
+			return true;
+		} else if (rest.starts_with("null")) {
+			out.type_ = Type::Null;
+			pos_ += 4;
+			return true;
+		}
+		return false;
+	}
+
+	bool ParseNumber(JsonValue& out)
+	{
+		const char* begin = text_.data() + pos_;
+		const char* end = text_.data() + text_.size();
+		auto result = std::from_chars(begin, end, out.number_);
+		if (result.ec != std::errc() || result.ptr == begin) {
+			return false;
+		}
+		out.type_ = Type::Number;
+		pos_ += size_t(result.ptr - begin);
+		return true;
+	}
+
+	static const int32_t kMaxDepth_ = 256;
+
+	std::string_view text_;
+	size_t pos_ = 0;
+};
+
+JsonValue JsonValue::Parse(std::string_view text)
+{
+	JsonValue result;
+	Parser parser(text);
+	if (!parser.ParseValue(result, 0) || !parser.IsEnd()) {
+		return JsonValue{};
+	}
+	return result;
+}
+
+bool JsonValue::AsBool(bool defaultValue) const
+{
+	return type_ == Type::Bool ? bool_ : defaultValue;
+}
+
+double JsonValue::AsNumber(double defaultValue) const
+{
+	return type_ == Type::Number ? number_ : defaultValue;
+}
+
+int32_t JsonValue::AsInt(int32_t defaultValue) const
+{
+	return type_ == Type::Number ? static_cast<int32_t>(number_) : defaultValue;
+}
+
+const std::string& JsonValue::AsString() const
+{
+	return type_ == Type::String ? string_ : kEmptyString;
+}
+
+size_t JsonValue::Size() const
+{
+	return (type_ == Type::Array || type_ == Type::Object) ? values_.size() : 0;
+}
+
+bool JsonValue::Has(std::string_view key) const
+{
+	if (type_ != Type::Object) {
+		return false;
+	}
+	for (const std::string& k : keys_) {
+		if (k == key) {
+			return true;
+		}
+	}
+	return false;
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const
+{
+	if (type_ != Type::Array || index >= values_.size()) {
+		return kNullValue;
+	}
+	return values_[index];
+}
+
+const JsonValue& JsonValue::operator[](std::string_view key) const
+{
+	if (type_ != Type::Object) {
+		return kNullValue;
+	}
+	for (size_t i = 0; i < keys_.size(); ++i) {
+		if (keys_[i] == key) {
+			return values_[i];
+		}
+	}
+	return kNullValue;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// glTFなどの読み込みに使用する最小限のJSONの値
+class JsonValue
+{
+public:
+	enum class Type {
+		Null,
+		Bool,
+		Number,
+		String,
+		Array,
+		Object,
+	};
+
+	// 文字列を解析する（失敗した場合はNullを返す）
+	static JsonValue Parse(std::string_view text);
+
+	Type GetType() const { return type_; }
+	bool IsNull() const { return type_ == Type::Null; }
+
+	// 値の取得（型が違う場合は既定値を返す）
+	bool AsBool(bool defaultValue = false) const;
+	double AsNumber(double defaultValue = 0.0) const;
+	int32_t AsInt(int32_t defaultValue = 0) const;
+	const std::string& AsString() const;
+
+	// 配列の要素数・オブジェクトのメンバ数
+	size_t Size() const;
+	// オブジェクトのメンバを持っているか
+	bool Has(std::string_view key) const;
+
+	// 配列の要素を取得する（範囲外の場合はNullを返す）
+	const JsonValue& operator[](size_t index) const;
+	// オブジェクトのメンバを取得する（存在しない場合はNullを返す）
+	const JsonValue& operator[](std::string_view key) const;
+
+private:
+	class Parser;
+
+	Type type_ = Type::Null;
+	bool bool_ = false;
+	double number_ = 0.0;
+	std::string string_;
+	// 配列の要素、またはオブジェクトのメンバの値
+	std::vector<JsonValue> values_;
+	// オブジェクトのメンバ名（values_と同じ順番）
+	std::vector<std::string> keys_;
+};
+
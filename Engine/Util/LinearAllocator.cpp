@@ -0,0 +1,60 @@
+#include "LinearAllocator.h"
+#include <cassert>
+
+void LinearAllocator::Initialize(uint64_t pageSize)
+{
+	pageSize_ = pageSize;
+	pageCount_ = 0;
+	currentPage_ = kInvalidPage;
+	offset_ = 0;
+	allocatedSize_ = 0;
+	usedPages_.clear();
+	freePages_.clear();
+	submissions_.clear();
+}
+
+LinearAllocator::Allocation LinearAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	// アラインメントは2のべき乗
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+	if (size == 0 || size > pageSize_) {
+		return { kInvalidPage, 0 };
+	}
+
+	// 今のページに収まらなければ次のページに移る（残りは使わない）
+	uint64_t offset = (offset_ + alignment - 1) & ~(alignment - 1);
+	if (currentPage_ == kInvalidPage || offset + size > pageSize_) {
+		if (!freePages_.empty()) {
+			currentPage_ = freePages_.back();
+			freePages_.pop_back();
+		} else {
+			currentPage_ = pageCount_++;
+		}
+		usedPages_.push_back(currentPage_);
+		offset = 0;
+	}
+
+	offset_ = offset + size;
+	allocatedSize_ += size;
+	return { currentPage_, offset };
+}
+
+void LinearAllocator::Submit(uint64_t fenceValue)
+{
+	// 確保中のページも次のフレームには持ち越さない
+	if (!usedPages_.empty()) {
+		submissions_.push_back({ fenceValue, std::move(usedPages_) });
+		usedPages_.clear();
+	}
+	currentPage_ = kInvalidPage;
+	offset_ = 0;
+	allocatedSize_ = 0;
+}
+
+void LinearAllocator::Retire(uint64_t completedFenceValue)
+{
+	while (!submissions_.empty() && submissions_.front().fenceValue <= completedFenceValue) {
+		freePages_.insert(freePages_.end(), submissions_.front().pages.begin(), submissions_.front().pages.end());
+		submissions_.pop_front();
+	}
+}
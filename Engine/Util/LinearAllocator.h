@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// 固定サイズのページの先頭から順に確保し、フレームごとに使ったページをFenceの値に紐づけてまとめて再利用する（GPUのリソースには依存しない）
+// 呼び出し側はGetPageCountの数までページのリソースを作っておき、Allocateで返したページとオフセットに書き込む
+class LinearAllocator
+{
+public:
+	// 確保した場所
+	struct Allocation {
+		uint32_t page;
+		uint64_t offset;
+	};
+
+	// 確保できなかったときのページ
+	static const uint32_t kInvalidPage = UINT32_MAX;
+
+	void Initialize(uint64_t pageSize);
+
+	// 領域を確保する（今のページに収まらなければ空いているページに移り、空きが無ければ新しいページを増やす）
+	// pageSizeより大きい場合はkInvalidPageを返す
+	Allocation Allocate(uint64_t size, uint64_t alignment);
+	// 前回のSubmitから使ったページを、fenceValueに到達したら再利用できるようにする（フレームの区切りで呼ぶ）
+	void Submit(uint64_t fenceValue);
+	// completedFenceValueまでに提出したページを空きに戻す
+	void Retire(uint64_t completedFenceValue);
+
+	uint64_t GetPageSize() const { return pageSize_; }
+	// これまでに作ったページの数
+	uint32_t GetPageCount() const { return pageCount_; }
+	// 空いているページの数
+	size_t GetFreePageCount() const { return freePages_.size(); }
+	// 前回のSubmitから確保したバイト数（アラインメントで飛ばした分を除く）
+	uint64_t GetAllocatedSize() const { return allocatedSize_; }
+
+private:
+	// 提出したページ
+	struct Submission {
+		uint64_t fenceValue;
+		std::vector<uint32_t> pages;
+	};
+
+	uint64_t pageSize_ = 0;
+	uint32_t pageCount_ = 0;
+	// 確保中のページと、その中の次に確保する位置
+	uint32_t currentPage_ = kInvalidPage;
+	uint64_t offset_ = 0;
+	uint64_t allocatedSize_ = 0;
+
+	// まだ提出していないページ
+	std::vector<uint32_t> usedPages_;
+	std::vector<uint32_t> freePages_;
+	std::deque<Submission> submissions_;
+};
@@ -0,0 +1,110 @@
+#include "MappedFile.h"
+#ifdef _WIN32
+#include <Windows.h>
+#include "StringUtil.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+	// ファイルを開く
+	HANDLE file = CreateFileW(ConvertString(filePath).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	fileHandle_ = file;
+
+	// サイズを取得する（空のファイルはマップできない）
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		Close();
+		return false;
+	}
+
+	// 読み取り専用でマップする
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		Close();
+		return false;
+	}
+	mappingHandle_ = mapping;
+
+	data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (data_ == nullptr) {
+		Close();
+		return false;
+	}
+	size_ = size_t(fileSize.QuadPart);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data_) {
+		UnmapViewOfFile(data_);
+		data_ = nullptr;
+	}
+	if (mappingHandle_) {
+		CloseHandle(mappingHandle_);
+		mappingHandle_ = nullptr;
+	}
+	if (fileHandle_) {
+		CloseHandle(fileHandle_);
+		fileHandle_ = nullptr;
+	}
+	size_ = 0;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+	// ファイルを開く
+	int file = open(filePath.c_str(), O_RDONLY);
+	if (file < 0) {
+		return false;
+	}
+
+	// サイズを取得する（空のファイルはマップできない）
+	struct stat fileStat {};
+	if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0) {
+		close(file);
+		return false;
+	}
+
+	// 読み取り専用でマップする（マップ後はファイルを閉じてよい）
+	void* data = mmap(nullptr, size_t(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+	data_ = static_cast<const uint8_t*>(data);
+	size_ = size_t(fileStat.st_size);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data_) {
+		munmap(const_cast<uint8_t*>(data_), size_);
+		data_ = nullptr;
+	}
+	size_ = 0;
+}
+
+#endif
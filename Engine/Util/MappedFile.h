@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// ファイルをメモリにマップして読み取り専用で参照する
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	// ファイルを開いてマップする（失敗した場合はfalseを返す）
+	bool Open(const std::string& filePath);
+	// マップを解除する
+	void Close();
+
+	const uint8_t* GetData() const { return data_; }
+	size_t GetSize() const { return size_; }
+	bool IsOpen() const { return data_ != nullptr; }
+
+	// コピー不可にする
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+private:
+	const uint8_t* data_ = nullptr;
+	size_t size_ = 0;
+#ifdef _WIN32
+	void* fileHandle_ = nullptr;
+	void* mappingHandle_ = nullptr;
+#endif
+};
+
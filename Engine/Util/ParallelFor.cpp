@@ -0,0 +1,56 @@
+#include "ParallelFor.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+uint32_t GetDefaultThreadCount()
+{
+	return (std::max)(std::thread::hardware_concurrency(), 1u);
+}
+
+void ParallelFor(size_t count, uint32_t threadCount, const std::function<void(size_t index)>& function)
+{
+	if (threadCount == 0) {
+		threadCount = GetDefaultThreadCount();
+	}
+	// 処理の数より多くのスレッドは作らない
+	threadCount = static_cast<uint32_t>((std::min)(size_t(threadCount), count));
+	if (threadCount <= 1) {
+		for (size_t i = 0; i < count; ++i) {
+			function(i);
+		}
+		return;
+	}
+
+	// 各スレッドが次の処理を1つずつ取っていく（処理ごとの重さが違っても偏らない）
+	std::atomic<size_t> nextIndex = 0;
+	auto worker = [&]() {
+		for (size_t i = nextIndex++; i < count; i = nextIndex++) {
+			function(i);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(threadCount - 1);
+	for (uint32_t i = 0; i < threadCount - 1; ++i) {
+		threads.emplace_back([&]() {
+#ifdef _WIN32
+			// WICでの画像の読み込みなど、COMを使う処理に備える
+			CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+#endif
+			worker();
+#ifdef _WIN32
+			CoUninitialize();
+#endif
+		});
+	}
+	worker();
+
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+// threadCountに0を指定したときに使うスレッド数（ハードウェアのスレッド数）
+uint32_t GetDefaultThreadCount();
+
+// 0からcount-1までの処理を複数のスレッドで分担して行う（呼び出したスレッドも処理を行い、全て終わるまで戻らない）
+void ParallelFor(size_t count, uint32_t threadCount, const std::function<void(size_t index)>& function);
@@ -0,0 +1,117 @@
+#include "PoolAllocator.h"
+#include <algorithm>
+#include <cassert>
+
+void PoolAllocator::Initialize(uint32_t pageSize, uint32_t minSlotSize)
+{
+	// スロットの番号は16bitで持つ
+	assert((pageSize & (pageSize - 1)) == 0 && (minSlotSize & (minSlotSize - 1)) == 0);
+	assert(minSlotSize <= pageSize && pageSize / minSlotSize <= 65536);
+
+	pageSize_ = pageSize;
+	minSlotSize_ = minSlotSize;
+	pages_.clear();
+	emptyPages_.clear();
+	partialPages_.assign(GetSizeClass(pageSize) + 1, {});
+	usedSlotCount_ = 0;
+	usedBytes_ = 0;
+}
+
+PoolAllocator::Allocation PoolAllocator::Allocate(uint32_t size)
+{
+	if (size == 0 || size > pageSize_) {
+		return { kInvalidPage, 0 };
+	}
+	uint32_t sizeClass = GetSizeClass(size);
+	std::vector<uint32_t>& partialPages = partialPages_[sizeClass];
+
+	// 空きのあるページが無ければ、空いているページか新しいページをこの大きさに使う
+	if (partialPages.empty()) {
+		uint32_t page = 0;
+		if (!emptyPages_.empty()) {
+			page = emptyPages_.back();
+			emptyPages_.pop_back();
+		} else {
+			page = uint32_t(pages_.size());
+			pages_.emplace_back();
+		}
+		AssignPage(page, sizeClass);
+	}
+
+	// 最後に空きができたページから確保する
+	uint32_t page = partialPages.back();
+	Page& pageState = pages_[page];
+	uint32_t slot = pageState.freeSlots.back();
+	pageState.freeSlots.pop_back();
+	pageState.usedCount++;
+	if (pageState.freeSlots.empty()) {
+		partialPages.pop_back();
+		pageState.isPartial = false;
+	}
+
+	uint32_t slotSize = minSlotSize_ << sizeClass;
+	usedSlotCount_++;
+	usedBytes_ += slotSize;
+	return { page, slot * slotSize };
+}
+
+void PoolAllocator::Free(const Allocation& allocation)
+{
+	assert(allocation.page < pages_.size());
+	Page& pageState = pages_[allocation.page];
+	assert(pageState.sizeClass != kUnassigned && pageState.usedCount > 0);
+	uint32_t slotSize = minSlotSize_ << pageState.sizeClass;
+
+	pageState.freeSlots.push_back(uint16_t(allocation.offset / slotSize));
+	pageState.usedCount--;
+	usedSlotCount_--;
+	usedBytes_ -= slotSize;
+
+	std::vector<uint32_t>& partialPages = partialPages_[pageState.sizeClass];
+	if (!pageState.isPartial) {
+		partialPages.push_back(allocation.page);
+		pageState.isPartial = true;
+	}
+
+	// 全て空いたページは、同じ大きさの空きのあるページが他にもあれば戻す（確保と解放を繰り返しても作り直さないように1つは残す）
+	if (pageState.usedCount == 0 && partialPages.size() > 1) {
+		RemovePartialPage(allocation.page);
+		pageState.sizeClass = kUnassigned;
+		pageState.freeSlots.clear();
+		emptyPages_.push_back(allocation.page);
+	}
+}
+
+uint32_t PoolAllocator::GetSizeClass(uint32_t size) const
+{
+	uint32_t sizeClass = 0;
+	while ((minSlotSize_ << sizeClass) < size) {
+		sizeClass++;
+	}
+	return sizeClass;
+}
+
+void PoolAllocator::AssignPage(uint32_t page, uint32_t sizeClass)
+{
+	Page& pageState = pages_[page];
+	pageState.sizeClass = sizeClass;
+	pageState.usedCount = 0;
+
+	// 先頭のスロットから使うように、逆順に積む
+	uint32_t slotCount = pageSize_ / (minSlotSize_ << sizeClass);
+	pageState.freeSlots.resize(slotCount);
+	for (uint32_t i = 0; i < slotCount; ++i) {
+		pageState.freeSlots[i] = uint16_t(slotCount - 1 - i);
+	}
+	partialPages_[sizeClass].push_back(page);
+	pageState.isPartial = true;
+}
+
+void PoolAllocator::RemovePartialPage(uint32_t page)
+{
+	std::vector<uint32_t>& partialPages = partialPages_[pages_[page].sizeClass];
+	auto it = std::find(partialPages.begin(), partialPages.end(), page);
+	assert(it != partialPages.end());
+	partialPages.erase(it);
+	pages_[page].isPartial = false;
+}
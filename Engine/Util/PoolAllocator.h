@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 固定サイズのページを、2のべき乗の大きさのスロットに分けて確保する（GPUのリソースには依存しない）
+// ページは最初に確保したときの大きさのスロット専用になり、大きさごとに空きのあるページのリストを持つ
+// 全てのスロットが空いたページは、その大きさの空きのあるページが他にもあれば、どの大きさにも使えるように戻す
+class PoolAllocator
+{
+public:
+	// 確保した場所
+	struct Allocation {
+		uint32_t page;
+		uint32_t offset;
+	};
+
+	// 確保できなかったときのページ
+	static const uint32_t kInvalidPage = UINT32_MAX;
+
+	// minSlotSizeとpageSizeは2のべき乗
+	void Initialize(uint32_t pageSize, uint32_t minSlotSize);
+
+	// sizeが収まる最小のスロットを確保する（空きが無ければ新しいページを増やす。pageSizeより大きい場合はkInvalidPageを返す）
+	Allocation Allocate(uint32_t size);
+	void Free(const Allocation& allocation);
+
+	uint32_t GetPageSize() const { return pageSize_; }
+	// これまでに作ったページの数（呼び出し側はこの数までページのリソースを作る）
+	uint32_t GetPageCount() const { return uint32_t(pages_.size()); }
+	// 使っているスロットの数と、その合計の大きさ
+	size_t GetUsedSlotCount() const { return usedSlotCount_; }
+	uint64_t GetUsedBytes() const { return usedBytes_; }
+	// sizeが収まるスロットの大きさ
+	uint32_t GetSlotSize(uint32_t size) const { return minSlotSize_ << GetSizeClass(size); }
+
+private:
+	// どの大きさにも使っていないページ
+	static const uint32_t kUnassigned = UINT32_MAX;
+
+	struct Page {
+		uint32_t sizeClass = kUnassigned;
+		uint32_t usedCount = 0;
+		// 空いているスロットの番号
+		std::vector<uint16_t> freeSlots;
+		// 大きさごとの空きのあるページのリストに入っているか
+		bool isPartial = false;
+	};
+
+	// sizeが収まる大きさの番号（minSlotSizeが0番）
+	uint32_t GetSizeClass(uint32_t size) const;
+	// ページを大きさの番号のスロットに分ける
+	void AssignPage(uint32_t page, uint32_t sizeClass);
+	// 空きのあるページのリストから外す
+	void RemovePartialPage(uint32_t page);
+
+	uint32_t pageSize_ = 0;
+	uint32_t minSlotSize_ = 0;
+	std::vector<Page> pages_;
+	// 大きさごとの空きのあるページ
+	std::vector<std::vector<uint32_t>> partialPages_;
+	// どの大きさにも使っていないページ
+	std::vector<uint32_t> emptyPages_;
+	size_t usedSlotCount_ = 0;
+	uint64_t usedBytes_ = 0;
+};
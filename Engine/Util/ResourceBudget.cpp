@@ -0,0 +1,158 @@
+#include "ResourceBudget.h"
+#include <algorithm>
+#include <cassert>
+
+ResourceBudget& ResourceBudget::GetInstance()
+{
+	// 他のマネージャーが終了時に解放するリソースの記録も消せるよう、破棄しない
+	static ResourceBudget* instance = new ResourceBudget();
+
+	return *instance;
+}
+
+uint64_t ResourceBudget::Register(ResourceCategory category, uint64_t sizeInBytes)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	uint64_t allocationId = nextAllocationId_++;
+	allocations_[allocationId] = { category, sizeInBytes, false };
+
+	size_t index = size_t(category);
+	usage_[index] += sizeInBytes;
+	peak_[index] = (std::max)(peak_[index], usage_[index]);
+	totalUsage_ += sizeInBytes;
+	totalPeak_ = (std::max)(totalPeak_, totalUsage_);
+	return allocationId;
+}
+
+void ResourceBudget::Unregister(uint64_t allocationId)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto itr = allocations_.find(allocationId);
+	assert(itr != allocations_.end());
+	const Allocation& allocation = itr->second;
+	usage_[size_t(allocation.category)] -= allocation.sizeInBytes;
+	totalUsage_ -= allocation.sizeInBytes;
+	if (allocation.isReleasing) {
+		releasingBytes_ -= allocation.sizeInBytes;
+	}
+	allocations_.erase(itr);
+}
+
+void ResourceBudget::MarkReleasing(uint64_t allocationId)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	// 既に解放されている場合は何もしない
+	auto itr = allocations_.find(allocationId);
+	if (itr == allocations_.end() || itr->second.isReleasing) {
+		return;
+	}
+	itr->second.isReleasing = true;
+	releasingBytes_ += itr->second.sizeInBytes;
+}
+
+uint64_t ResourceBudget::AddCacheEntry(const std::vector<uint64_t>& allocationIds, std::function<void()> onEvict)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	uint64_t cacheEntryId = nextCacheEntryId_++;
+	cacheEntries_.push_back({ cacheEntryId, allocationIds, std::move(onEvict) });
+	cacheEntryIndices_[cacheEntryId] = std::prev(cacheEntries_.end());
+	return cacheEntryId;
+}
+
+void ResourceBudget::RemoveCacheEntry(uint64_t cacheEntryId)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto itr = cacheEntryIndices_.find(cacheEntryId);
+	if (itr == cacheEntryIndices_.end()) {
+		return;
+	}
+	cacheEntries_.erase(itr->second);
+	cacheEntryIndices_.erase(itr);
+}
+
+void ResourceBudget::SetBudget(uint64_t budgetBytes)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	budgetBytes_ = budgetBytes;
+}
+
+uint64_t ResourceBudget::GetBudget() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return budgetBytes_;
+}
+
+size_t ResourceBudget::Enforce()
+{
+	// 追い出すキャッシュを決める（解放待ちのリソースは既に減ったものとして扱う）
+	std::vector<CacheEntry> evictedEntries;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		while (!cacheEntries_.empty() && totalUsage_ - releasingBytes_ > budgetBytes_) {
+			CacheEntry& entry = cacheEntries_.front();
+			for (uint64_t allocationId : entry.allocationIds) {
+				auto itr = allocations_.find(allocationId);
+				if (itr != allocations_.end() && !itr->second.isReleasing) {
+					itr->second.isReleasing = true;
+					releasingBytes_ += itr->second.sizeInBytes;
+				}
+			}
+			cacheEntryIndices_.erase(entry.id);
+			evictedEntries.push_back(std::move(entry));
+			cacheEntries_.pop_front();
+		}
+	}
+
+	// 追い出す処理は各マネージャーをロックするので、こちらのロックを外してから呼ぶ
+	for (CacheEntry& entry : evictedEntries) {
+		entry.onEvict();
+	}
+	return evictedEntries.size();
+}
+
+uint64_t ResourceBudget::GetUsage(ResourceCategory category) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return usage_[size_t(category)];
+}
+
+uint64_t ResourceBudget::GetPeak(ResourceCategory category) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return peak_[size_t(category)];
+}
+
+uint64_t ResourceBudget::GetTotalUsage() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return totalUsage_;
+}
+
+uint64_t ResourceBudget::GetTotalPeak() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return totalPeak_;
+}
+
+size_t ResourceBudget::GetAllocationCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return allocations_.size();
+}
+
+const char* ResourceBudget::GetCategoryName(ResourceCategory category)
+{
+	switch (category) {
+	case ResourceCategory::Texture: return "Texture";
+	case ResourceCategory::Mesh: return "Mesh";
+	case ResourceCategory::ConstantBuffer: return "ConstantBuffer";
+	case ResourceCategory::Upload: return "Upload";
+	case ResourceCategory::RenderTarget: return "RenderTarget";
+	default: return "Other";
+	}
+}
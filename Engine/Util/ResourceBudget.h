@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// GPUリソースの種類（使用量を分けて記録する）
+enum class ResourceCategory {
+	Texture,
+	Mesh,
+	ConstantBuffer,
+	Upload,
+	RenderTarget,
+	Other,
+	Count
+};
+
+// 確保したGPUリソースのサイズを種類ごとに記録し、予算を超えたら使われていないキャッシュを古い順に追い出す
+// （記録と追い出す対象の選択のみを行い、GPUのリソースには依存しない。DirectXUtilのTrackResourceから記録される）
+class ResourceBudget
+{
+public:
+	// 無効なID
+	static const uint64_t kInvalidId = 0;
+
+	static ResourceBudget& GetInstance();
+
+	// 確保したリソースを記録してIDを返す
+	uint64_t Register(ResourceCategory category, uint64_t sizeInBytes);
+	// 解放したリソースの記録を消す
+	void Unregister(uint64_t allocationId);
+	// 解放が決まったリソース（GPUが使い終わるのを待っている）として、予算の判定から除く
+	void MarkReleasing(uint64_t allocationId);
+
+	// 追い出してよいキャッシュを登録する（追い出すとallocationIdsのリソースが解放される。onEvictはEnforceの中で呼ばれる）
+	uint64_t AddCacheEntry(const std::vector<uint64_t>& allocationIds, std::function<void()> onEvict);
+	// 再び使われたキャッシュを追い出す対象から外す
+	void RemoveCacheEntry(uint64_t cacheEntryId);
+
+	// 全体の予算（バイト数）
+	void SetBudget(uint64_t budgetBytes);
+	uint64_t GetBudget() const;
+	// 予算を超えていれば、登録の古いキャッシュから追い出す（フレームの区切りで呼ぶ。追い出した数を返す）
+	size_t Enforce();
+
+	// 現在の使用量と、これまでの最大の使用量
+	uint64_t GetUsage(ResourceCategory category) const;
+	uint64_t GetPeak(ResourceCategory category) const;
+	uint64_t GetTotalUsage() const;
+	uint64_t GetTotalPeak() const;
+	// 記録しているリソースの数
+	size_t GetAllocationCount() const;
+	// 種類の名前（ログ用）
+	static const char* GetCategoryName(ResourceCategory category);
+
+private:
+	struct Allocation {
+		ResourceCategory category;
+		uint64_t sizeInBytes;
+		bool isReleasing;
+	};
+	struct CacheEntry {
+		uint64_t id;
+		std::vector<uint64_t> allocationIds;
+		std::function<void()> onEvict;
+	};
+
+	static const size_t kCategoryCount = size_t(ResourceCategory::Count);
+
+	std::unordered_map<uint64_t, Allocation> allocations_;
+	uint64_t nextAllocationId_ = 1;
+	uint64_t usage_[kCategoryCount] = {};
+	uint64_t peak_[kCategoryCount] = {};
+	uint64_t totalUsage_ = 0;
+	uint64_t totalPeak_ = 0;
+	// 解放待ちのリソースのサイズ
+	uint64_t releasingBytes_ = 0;
+	uint64_t budgetBytes_ = UINT64_MAX;
+
+	// 追い出してよいキャッシュ（先頭が最も古い）
+	std::list<CacheEntry> cacheEntries_;
+	std::unordered_map<uint64_t, std::list<CacheEntry>::iterator> cacheEntryIndices_;
+	uint64_t nextCacheEntryId_ = 1;
+
+	// ワーカースレッドでのリソースの生成に備えて排他する
+	mutable std::mutex mutex_;
+};
@@ -0,0 +1,61 @@
+#include "RingAllocator.h"
+#include <cassert>
+
+void RingAllocator::Initialize(uint64_t capacity)
+{
+	capacity_ = capacity;
+	head_ = 0;
+	usedSize_ = 0;
+	pendingSize_ = 0;
+	submissions_.clear();
+}
+
+uint64_t RingAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	// アラインメントは2のべき乗
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+	if (size == 0 || size > capacity_) {
+		return kInvalidOffset;
+	}
+
+	// 全て解放されていれば先頭から使う
+	if (usedSize_ == 0) {
+		head_ = 0;
+	}
+
+	// アラインメントを揃え、末尾に収まらない場合は先頭に折り返す
+	uint64_t offset = (head_ + alignment - 1) & ~(alignment - 1);
+	if (offset + size > capacity_) {
+		offset = 0;
+	}
+	// 飛ばした分も、その前の確保が解放されるまで使用中として扱う
+	uint64_t skippedSize = offset >= head_ ? offset - head_ : capacity_ - head_;
+
+	// 空き領域はheadから連続しているので、使用中のサイズだけで判定できる
+	if (usedSize_ + skippedSize + size > capacity_) {
+		return kInvalidOffset;
+	}
+
+	head_ = offset + size;
+	usedSize_ += skippedSize + size;
+	pendingSize_ += skippedSize + size;
+	return offset;
+}
+
+void RingAllocator::Submit(uint64_t fenceValue)
+{
+	if (pendingSize_ == 0) {
+		return;
+	}
+	assert(submissions_.empty() || submissions_.back().fenceValue <= fenceValue);
+	submissions_.push_back({ fenceValue, pendingSize_ });
+	pendingSize_ = 0;
+}
+
+void RingAllocator::Retire(uint64_t completedFenceValue)
+{
+	while (!submissions_.empty() && submissions_.front().fenceValue <= completedFenceValue) {
+		usedSize_ -= submissions_.front().size;
+		submissions_.pop_front();
+	}
+}
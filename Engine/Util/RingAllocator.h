@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+
+// リングバッファ上の領域を先頭から順に確保し、Fenceの値に紐づけて古いものから解放する（GPUのリソースには依存しない）
+class RingAllocator
+{
+public:
+	// 確保できなかったときに返す値
+	static const uint64_t kInvalidOffset = UINT64_MAX;
+
+	void Initialize(uint64_t capacity);
+
+	// 領域を確保してオフセットを返す（空きが足りない場合はkInvalidOffsetを返す）
+	uint64_t Allocate(uint64_t size, uint64_t alignment);
+	// 前回のSubmitから確保した領域を、fenceValueに到達したら解放できるようにする
+	void Submit(uint64_t fenceValue);
+	// completedFenceValueまでに提出した領域を解放する
+	void Retire(uint64_t completedFenceValue);
+
+	// 解放待ちの中で最も古いFenceの値（解放待ちが無い場合は0）
+	uint64_t GetOldestFenceValue() const { return submissions_.empty() ? 0 : submissions_.front().fenceValue; }
+	uint64_t GetCapacity() const { return capacity_; }
+	uint64_t GetUsedSize() const { return usedSize_; }
+
+private:
+	// 提出した領域（確保した順に並ぶので、サイズだけ覚えておけばよい）
+	struct Submission {
+		uint64_t fenceValue;
+		uint64_t size;
+	};
+
+	uint64_t capacity_ = 0;
+	// 次に確保する位置
+	uint64_t head_ = 0;
+	// 使用中のサイズ（アラインメントや折り返しで飛ばした分も含む）
+	uint64_t usedSize_ = 0;
+	// まだ提出していない確保のサイズ
+	uint64_t pendingSize_ = 0;
+
+	std::deque<Submission> submissions_;
+};
@@ -0,0 +1,320 @@
+#include "TlsfAllocator.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+void TlsfAllocator::Initialize(uint64_t capacity, uint64_t granularity)
+{
+	assert(granularity != 0 && (granularity & (granularity - 1)) == 0);
+	capacity_ = capacity / granularity * granularity;
+	granularity_ = granularity;
+	usedSize_ = 0;
+	blocks_.clear();
+	unusedBlocks_.clear();
+	freeHeads_.assign(kFirstLevelCount * kSecondLevelCount, kInvalidIndex);
+	firstLevelBitmap_ = 0;
+	std::fill(std::begin(secondLevelBitmaps_), std::end(secondLevelBitmaps_), 0u);
+	allocations_.clear();
+	pendingFrees_.clear();
+
+	// 最初は全体が1つの空きブロック
+	firstBlock_ = CreateBlock();
+	blocks_[firstBlock_].size = capacity_ / granularity_;
+	blocks_[firstBlock_].isFree = true;
+	if (blocks_[firstBlock_].size > 0) {
+		InsertFreeBlock(firstBlock_);
+	}
+}
+
+uint64_t TlsfAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+	if (size == 0) {
+		return kInvalidOffset;
+	}
+
+	// 単位に直す（アラインメントがgranularityより大きい場合は、先頭を揃えるために余分に探す）
+	uint64_t units = (size + granularity_ - 1) / granularity_;
+	uint64_t alignmentUnits = (std::max)(alignment / granularity_, uint64_t(1));
+	uint32_t index = FindFreeBlock(units + alignmentUnits - 1);
+	if (index == kInvalidIndex) {
+		return kInvalidOffset;
+	}
+	return AllocateFromBlock(index, units, alignmentUnits);
+}
+
+void TlsfAllocator::Free(uint64_t offset)
+{
+	auto it = allocations_.find(offset);
+	assert(it != allocations_.end());
+	uint32_t index = it->second;
+	allocations_.erase(it);
+
+	Block& block = blocks_[index];
+	usedSize_ -= block.size * granularity_;
+	block.isFree = true;
+	block.isPendingFree = false;
+
+	// 前後の空きブロックとつなげる
+	uint32_t nextIndex = block.nextPhysical;
+	if (nextIndex != kInvalidIndex && blocks_[nextIndex].isFree) {
+		RemoveFreeBlock(nextIndex);
+		MergeBlocks(index, nextIndex);
+	}
+	uint32_t previousIndex = blocks_[index].previousPhysical;
+	if (previousIndex != kInvalidIndex && blocks_[previousIndex].isFree) {
+		RemoveFreeBlock(previousIndex);
+		MergeBlocks(previousIndex, index);
+		index = previousIndex;
+	}
+	InsertFreeBlock(index);
+}
+
+void TlsfAllocator::Free(uint64_t offset, uint64_t fenceValue)
+{
+	auto it = allocations_.find(offset);
+	assert(it != allocations_.end() && !blocks_[it->second].isPendingFree);
+	assert(pendingFrees_.empty() || pendingFrees_.back().fenceValue <= fenceValue);
+	blocks_[it->second].isPendingFree = true;
+	pendingFrees_.push_back({ fenceValue, offset });
+}
+
+void TlsfAllocator::Retire(uint64_t completedFenceValue)
+{
+	while (!pendingFrees_.empty() && pendingFrees_.front().fenceValue <= completedFenceValue) {
+		Free(pendingFrees_.front().offset);
+		pendingFrees_.pop_front();
+	}
+}
+
+std::vector<TlsfAllocator::Move> TlsfAllocator::Defragment(size_t maxMoves)
+{
+	std::vector<Move> moves;
+
+	// 後ろにある確保から順に、それより前で最初に収まる空きに移す
+	std::vector<uint32_t> allocatedBlocks;
+	allocatedBlocks.reserve(allocations_.size());
+	for (const auto& [offset, index] : allocations_) {
+		// 解放待ちの範囲は、GPUが使っている場所から動かせない
+		if (!blocks_[index].isPendingFree) {
+			allocatedBlocks.push_back(index);
+		}
+	}
+	std::sort(allocatedBlocks.begin(), allocatedBlocks.end(), [&](uint32_t a, uint32_t b) { return blocks_[a].offset > blocks_[b].offset; });
+
+	for (uint32_t allocatedIndex : allocatedBlocks) {
+		if (moves.size() >= maxMoves) {
+			break;
+		}
+		const uint64_t units = blocks_[allocatedIndex].size;
+		const uint64_t alignmentUnits = blocks_[allocatedIndex].alignment;
+		const uint64_t oldOffset = blocks_[allocatedIndex].offset;
+
+		for (uint32_t index = firstBlock_; index != kInvalidIndex && blocks_[index].offset < oldOffset; index = blocks_[index].nextPhysical) {
+			const Block& block = blocks_[index];
+			if (!block.isFree) {
+				continue;
+			}
+			uint64_t alignedOffset = (block.offset + alignmentUnits - 1) / alignmentUnits * alignmentUnits;
+			if (alignedOffset + units > block.offset + block.size) {
+				continue;
+			}
+
+			// 新しい場所を確保してから古い場所を解放する
+			uint64_t newOffset = AllocateFromBlock(index, units, alignmentUnits);
+			moves.push_back({ oldOffset * granularity_, newOffset, units * granularity_ });
+			Free(oldOffset * granularity_);
+			break;
+		}
+	}
+	return moves;
+}
+
+uint64_t TlsfAllocator::GetLargestFreeBlock() const
+{
+	if (firstLevelBitmap_ == 0) {
+		return 0;
+	}
+	// 最も大きい区分のリストの中で最大のもの
+	uint32_t firstLevel = 63 - uint32_t(std::countl_zero(firstLevelBitmap_));
+	uint32_t secondLevel = 31 - uint32_t(std::countl_zero(secondLevelBitmaps_[firstLevel]));
+	uint64_t largest = 0;
+	for (uint32_t index = freeHeads_[firstLevel * kSecondLevelCount + secondLevel]; index != kInvalidIndex; index = blocks_[index].nextFree) {
+		largest = (std::max)(largest, blocks_[index].size);
+	}
+	return largest * granularity_;
+}
+
+float TlsfAllocator::GetFragmentation() const
+{
+	uint64_t freeSize = GetFreeSize();
+	if (freeSize == 0) {
+		return 0.0f;
+	}
+	return 1.0f - float(double(GetLargestFreeBlock()) / double(freeSize));
+}
+
+void TlsfAllocator::Mapping(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+{
+	// 小さいものは1段目を0にして、大きさをそのまま2段目にする
+	if (size < kSecondLevelCount) {
+		firstLevel = 0;
+		secondLevel = uint32_t(size);
+		return;
+	}
+	uint32_t log2 = 63 - uint32_t(std::countl_zero(size));
+	firstLevel = log2 - kSecondLevelLog2 + 1;
+	secondLevel = uint32_t(size >> (log2 - kSecondLevelLog2)) - kSecondLevelCount;
+}
+
+uint32_t TlsfAllocator::FindFreeBlock(uint64_t size) const
+{
+	// 区分の中には小さいブロックも混ざるので、1つ上の区分から探す（区分の中の全てのブロックがsize以上になる）
+	uint64_t searchSize = size;
+	if (size >= kSecondLevelCount) {
+		uint32_t log2 = 63 - uint32_t(std::countl_zero(size));
+		searchSize += (uint64_t(1) << (log2 - kSecondLevelLog2)) - 1;
+	}
+	uint32_t firstLevel = 0;
+	uint32_t secondLevel = 0;
+	Mapping(searchSize, firstLevel, secondLevel);
+	if (firstLevel >= kFirstLevelCount) {
+		return kInvalidIndex;
+	}
+
+	// 同じ1段目の中で、より大きい2段目の区分を探す
+	uint32_t secondLevelMap = secondLevelBitmaps_[firstLevel] & (~0u << secondLevel);
+	if (secondLevelMap == 0) {
+		// 無ければより大きい1段目の区分を探す
+		uint64_t firstLevelMap = firstLevel + 1 < 64 ? firstLevelBitmap_ & (~uint64_t(0) << (firstLevel + 1)) : 0;
+		if (firstLevelMap == 0) {
+			return kInvalidIndex;
+		}
+		firstLevel = uint32_t(std::countr_zero(firstLevelMap));
+		secondLevelMap = secondLevelBitmaps_[firstLevel];
+	}
+	secondLevel = uint32_t(std::countr_zero(secondLevelMap));
+	return freeHeads_[firstLevel * kSecondLevelCount + secondLevel];
+}
+
+void TlsfAllocator::InsertFreeBlock(uint32_t index)
+{
+	Block& block = blocks_[index];
+	uint32_t firstLevel = 0;
+	uint32_t secondLevel = 0;
+	Mapping(block.size, firstLevel, secondLevel);
+	uint32_t& head = freeHeads_[firstLevel * kSecondLevelCount + secondLevel];
+
+	block.previousFree = kInvalidIndex;
+	block.nextFree = head;
+	if (head != kInvalidIndex) {
+		blocks_[head].previousFree = index;
+	}
+	head = index;
+	firstLevelBitmap_ |= uint64_t(1) << firstLevel;
+	secondLevelBitmaps_[firstLevel] |= 1u << secondLevel;
+}
+
+void TlsfAllocator::RemoveFreeBlock(uint32_t index)
+{
+	Block& block = blocks_[index];
+	uint32_t firstLevel = 0;
+	uint32_t secondLevel = 0;
+	Mapping(block.size, firstLevel, secondLevel);
+	uint32_t& head = freeHeads_[firstLevel * kSecondLevelCount + secondLevel];
+
+	if (block.previousFree != kInvalidIndex) {
+		blocks_[block.previousFree].nextFree = block.nextFree;
+	} else {
+		head = block.nextFree;
+	}
+	if (block.nextFree != kInvalidIndex) {
+		blocks_[block.nextFree].previousFree = block.previousFree;
+	}
+	block.previousFree = kInvalidIndex;
+	block.nextFree = kInvalidIndex;
+
+	// 区分が空になったらビットを落とす
+	if (head == kInvalidIndex) {
+		secondLevelBitmaps_[firstLevel] &= ~(1u << secondLevel);
+		if (secondLevelBitmaps_[firstLevel] == 0) {
+			firstLevelBitmap_ &= ~(uint64_t(1) << firstLevel);
+		}
+	}
+}
+
+uint32_t TlsfAllocator::SplitBlock(uint32_t index, uint64_t size)
+{
+	uint32_t nextIndex = CreateBlock();
+	// CreateBlockでblocks_が伸びるので、参照はその後に取る
+	Block& block = blocks_[index];
+	Block& next = blocks_[nextIndex];
+	next.offset = block.offset + size;
+	next.size = block.size - size;
+	next.previousPhysical = index;
+	next.nextPhysical = block.nextPhysical;
+	if (block.nextPhysical != kInvalidIndex) {
+		blocks_[block.nextPhysical].previousPhysical = nextIndex;
+	}
+	block.size = size;
+	block.nextPhysical = nextIndex;
+	return nextIndex;
+}
+
+void TlsfAllocator::MergeBlocks(uint32_t index, uint32_t nextIndex)
+{
+	Block& block = blocks_[index];
+	const Block& next = blocks_[nextIndex];
+	block.size += next.size;
+	block.nextPhysical = next.nextPhysical;
+	if (next.nextPhysical != kInvalidIndex) {
+		blocks_[next.nextPhysical].previousPhysical = index;
+	}
+	DestroyBlock(nextIndex);
+}
+
+uint64_t TlsfAllocator::AllocateFromBlock(uint32_t index, uint64_t size, uint64_t alignment)
+{
+	RemoveFreeBlock(index);
+
+	// 先頭の揃えるための隙間は空きブロックとして残す
+	uint64_t alignedOffset = (blocks_[index].offset + alignment - 1) / alignment * alignment;
+	uint64_t padding = alignedOffset - blocks_[index].offset;
+	if (padding > 0) {
+		uint32_t alignedIndex = SplitBlock(index, padding);
+		InsertFreeBlock(index);
+		index = alignedIndex;
+	}
+	// 後ろの余りも空きブロックにする
+	if (blocks_[index].size > size) {
+		uint32_t remainderIndex = SplitBlock(index, size);
+		blocks_[remainderIndex].isFree = true;
+		InsertFreeBlock(remainderIndex);
+	}
+
+	Block& block = blocks_[index];
+	block.isFree = false;
+	block.alignment = alignment;
+	usedSize_ += block.size * granularity_;
+	uint64_t offset = block.offset * granularity_;
+	allocations_[offset] = index;
+	return offset;
+}
+
+uint32_t TlsfAllocator::CreateBlock()
+{
+	if (!unusedBlocks_.empty()) {
+		uint32_t index = unusedBlocks_.back();
+		unusedBlocks_.pop_back();
+		blocks_[index] = Block{};
+		return index;
+	}
+	blocks_.emplace_back();
+	return uint32_t(blocks_.size() - 1);
+}
+
+void TlsfAllocator::DestroyBlock(uint32_t index)
+{
+	blocks_[index] = Block{};
+	unusedBlocks_.push_back(index);
+}
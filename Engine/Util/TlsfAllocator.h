@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+// TLSF（Two-Level Segregated Fit）で、1つの連続した領域（ID3D12Heapなど）の中のオフセットを確保する（GPUのリソースには依存しない）
+// 空きブロックを大きさの2段階の区分ごとのリストで持ち、ビットマップで探すので、確保と解放は空きの数によらず一定の時間で終わる
+// ブロックの情報は領域の外に持つので、CPUから触れないGPUのメモリにも使える
+class TlsfAllocator
+{
+public:
+	// 確保できなかったときに返す値
+	static constexpr uint64_t kInvalidOffset = UINT64_MAX;
+
+	// デフラグでの移動（呼び出し側がoldOffsetからnewOffsetへsizeバイトをコピーする）
+	struct Move {
+		uint64_t oldOffset;
+		uint64_t newOffset;
+		uint64_t size;
+	};
+
+	// capacityの領域をgranularity（2のべき乗）単位で管理する（確保のアラインメントは常にgranularity以上になる）
+	void Initialize(uint64_t capacity, uint64_t granularity);
+
+	// sizeバイトをalignment（2のべき乗）に揃えて確保し、オフセットを返す（収まる空きが無ければkInvalidOffsetを返す）
+	uint64_t Allocate(uint64_t size, uint64_t alignment);
+	// Allocateで返したオフセットを解放する（前後の空きとつなげる）
+	void Free(uint64_t offset);
+	// GPUがまだ使っているかもしれない範囲を、fenceValueに到達してから解放する（それまではデフラグでも動かさない）
+	void Free(uint64_t offset, uint64_t fenceValue);
+	// completedFenceValueまでに解放を頼まれた範囲を解放する
+	void Retire(uint64_t completedFenceValue);
+
+	// 後ろにある確保を、それより前の収まる空きに移す（最大maxMoves個。移した結果を返すので、呼び出し側でデータをコピーする）
+	std::vector<Move> Defragment(size_t maxMoves);
+
+	uint64_t GetCapacity() const { return capacity_; }
+	uint64_t GetUsedSize() const { return usedSize_; }
+	uint64_t GetFreeSize() const { return capacity_ - usedSize_; }
+	// 解放待ちの範囲も含めた確保の数
+	size_t GetAllocationCount() const { return allocations_.size(); }
+	size_t GetPendingFreeCount() const { return pendingFrees_.size(); }
+	// 最も大きい空きブロックのサイズ
+	uint64_t GetLargestFreeBlock() const;
+	// 断片化の度合い（0は空きが1つにまとまっている、1に近いほど細かく分かれている）
+	float GetFragmentation() const;
+
+private:
+	static constexpr uint32_t kInvalidIndex = UINT32_MAX;
+	// 2段目の区分の数（1段目の2のべき乗の範囲を16に分ける）
+	static constexpr uint32_t kSecondLevelLog2 = 4;
+	static constexpr uint32_t kSecondLevelCount = 1u << kSecondLevelLog2;
+	static constexpr uint32_t kFirstLevelCount = 64 - kSecondLevelLog2 + 1;
+
+	// GPUが使い終わるのを待っている範囲
+	struct PendingFree {
+		uint64_t fenceValue;
+		uint64_t offset;
+	};
+
+	// 領域を隙間なく区切ったブロック（単位はgranularity）
+	struct Block {
+		uint64_t offset = 0;
+		uint64_t size = 0;
+		// 確保したときのアラインメント（デフラグで同じ条件で置き直すため）
+		uint64_t alignment = 1;
+		bool isFree = false;
+		// Fenceを待って解放する範囲か
+		bool isPendingFree = false;
+		// 位置の順のつながり
+		uint32_t previousPhysical = kInvalidIndex;
+		uint32_t nextPhysical = kInvalidIndex;
+		// 同じ区分の空きブロックのリスト
+		uint32_t previousFree = kInvalidIndex;
+		uint32_t nextFree = kInvalidIndex;
+	};
+
+	// 大きさから区分を求める
+	static void Mapping(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+	// size以上の空きブロックを探す（見つからなければkInvalidIndex）
+	uint32_t FindFreeBlock(uint64_t size) const;
+	void InsertFreeBlock(uint32_t index);
+	void RemoveFreeBlock(uint32_t index);
+	// ブロックを先頭からsize単位で2つに分け、後ろのブロックを返す
+	uint32_t SplitBlock(uint32_t index, uint64_t size);
+	// 後ろのブロックを前のブロックに取り込む
+	void MergeBlocks(uint32_t index, uint32_t nextIndex);
+	// 空きブロックから、単位で表したsizeをalignmentに揃えて確保する
+	uint64_t AllocateFromBlock(uint32_t index, uint64_t size, uint64_t alignment);
+	uint32_t CreateBlock();
+	void DestroyBlock(uint32_t index);
+
+	uint64_t capacity_ = 0;
+	uint64_t granularity_ = 1;
+	uint64_t usedSize_ = 0;
+
+	std::vector<Block> blocks_;
+	std::vector<uint32_t> unusedBlocks_;
+	// 区分ごとの空きブロックのリストの先頭と、空きのある区分のビットマップ
+	std::vector<uint32_t> freeHeads_;
+	uint64_t firstLevelBitmap_ = 0;
+	uint32_t secondLevelBitmaps_[kFirstLevelCount] = {};
+	// 確保したオフセットごとのブロック
+	std::unordered_map<uint64_t, uint32_t> allocations_;
+	std::deque<PendingFree> pendingFrees_;
+	// オフセット0のブロック（位置の順の先頭）
+	uint32_t firstBlock_ = kInvalidIndex;
+};
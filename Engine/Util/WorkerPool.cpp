@@ -0,0 +1,106 @@
+#include "WorkerPool.h"
+#include <algorithm>
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+// MyClass
+#include "ParallelFor.h"
+
+WorkerPool::WorkerPool(uint32_t threadCount)
+{
+	if (threadCount == 0) {
+		threadCount = GetDefaultThreadCount();
+	}
+	workers_.reserve(threadCount - 1);
+	for (uint32_t i = 0; i < threadCount - 1; ++i) {
+		workers_.emplace_back([this, i]() { WorkerMain(i); });
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		isStopping_ = true;
+	}
+	startCondition_.notify_all();
+	for (std::thread& worker : workers_) {
+		worker.join();
+	}
+}
+
+void WorkerPool::ParallelFor(size_t count, uint32_t threadCount, const std::function<void(size_t index)>& function)
+{
+	if (threadCount == 0) {
+		threadCount = GetThreadCount();
+	}
+	// 処理の数より多くのスレッドは使わない
+	threadCount = static_cast<uint32_t>((std::min)({ size_t(threadCount), size_t(GetThreadCount()), count }));
+	if (threadCount <= 1) {
+		for (size_t i = 0; i < count; ++i) {
+			function(i);
+		}
+		return;
+	}
+
+	std::lock_guard<std::mutex> callLock(callMutex_);
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		function_ = &function;
+		count_ = count;
+		nextIndex_ = 0;
+		participantCount_ = threadCount - 1;
+		runningCount_ = threadCount - 1;
+		generation_++;
+	}
+	startCondition_.notify_all();
+
+	RunJob();
+
+	// 参加したスレッドが全て終わるまで待つ（functionは呼び出し元のものなので、戻る前に使い終わっている必要がある）
+	std::unique_lock<std::mutex> lock(mutex_);
+	finishCondition_.wait(lock, [this]() { return runningCount_ == 0; });
+	function_ = nullptr;
+}
+
+void WorkerPool::WorkerMain(uint32_t workerIndex)
+{
+#ifdef _WIN32
+	// WICでの画像の読み込みなど、COMを使う処理に備える
+	CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+#endif
+	uint64_t seenGeneration = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			startCondition_.wait(lock, [&]() { return isStopping_ || (generation_ != seenGeneration && workerIndex < participantCount_); });
+			if (isStopping_) {
+				break;
+			}
+			seenGeneration = generation_;
+		}
+
+		RunJob();
+
+		bool isLast = false;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			isLast = --runningCount_ == 0;
+		}
+		if (isLast) {
+			finishCondition_.notify_one();
+		}
+	}
+#ifdef _WIN32
+	CoUninitialize();
+#endif
+}
+
+void WorkerPool::RunJob()
+{
+	// 各スレッドが次の処理を1つずつ取っていく（処理ごとの重さが違っても偏らない）
+	for (size_t i = nextIndex_++; i < count_; i = nextIndex_++) {
+		(*function_)(i);
+	}
+}
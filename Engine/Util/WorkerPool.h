@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// スレッドを作ったまま待たせておき、ParallelForと同じように処理を分担させる
+// 毎フレーム呼ぶ処理に使う（呼ぶたびにスレッドを作って終わるのを待つParallelForは、読み込み時など1回きりの処理に使う）
+class WorkerPool
+{
+public:
+	// 呼び出したスレッドも処理を行うので、threadCount-1個のスレッドを作る（0の場合はハードウェアのスレッド数）
+	explicit WorkerPool(uint32_t threadCount = 0);
+	// 待たせているスレッドを終わらせる
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	// 0からcount-1までの処理を最大threadCount個のスレッドで分担して行う（呼び出したスレッドも処理を行い、全て終わるまで戻らない）
+	// threadCountが0の場合はプールの全てのスレッドを使う。同時に複数のスレッドから呼んだ場合は順に行い、functionの中から呼んではいけない
+	void ParallelFor(size_t count, uint32_t threadCount, const std::function<void(size_t index)>& function);
+
+	// 呼び出したスレッドを含めたスレッド数
+	uint32_t GetThreadCount() const { return uint32_t(workers_.size()) + 1; }
+
+private:
+	// 待たせているスレッドの処理
+	void WorkerMain(uint32_t workerIndex);
+	// 次の処理を1つずつ取って行う
+	void RunJob();
+
+	std::vector<std::thread> workers_;
+	// ParallelForを1つずつ行う
+	std::mutex callMutex_;
+
+	// 今の処理（generation_が変わったら、workerIndexがparticipantCount_未満のスレッドが参加する）
+	std::mutex mutex_;
+	std::condition_variable startCondition_;
+	std::condition_variable finishCondition_;
+	uint64_t generation_ = 0;
+	uint32_t participantCount_ = 0;
+	uint32_t runningCount_ = 0;
+	bool isStopping_ = false;
+	const std::function<void(size_t index)>* function_ = nullptr;
+	size_t count_ = 0;
+	std::atomic<size_t> nextIndex_ = 0;
+};
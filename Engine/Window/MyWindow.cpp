@@ -66,6 +66,13 @@ void Window::Create(LPCWSTR windowTitle, uint32_t width, uint32_t height)
 	ShowWindow(hwnd, SW_SHOW);
 }
 
+void Window::CreateHeadless(uint32_t width, uint32_t height)
+{
+	winWidth = width;
+	winHeight = height;
+	hwnd = nullptr;
+}
+
 bool Window::ProcessMessage()
 {
 	MSG msg{};
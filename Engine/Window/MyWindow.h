@@ -10,6 +10,8 @@ class Window
 public:
 	// ウィンドウの作成
 	static void Create(LPCWSTR windowTitle, uint32_t width, uint32_t height);
+	// ウィンドウを作らずにクライアント領域の大きさだけを設定する（ヘッドレスで実行する場合）
+	static void CreateHeadless(uint32_t width, uint32_t height);
 	// ウィンドウの終了を伝える
 	static bool ProcessMessage();
 
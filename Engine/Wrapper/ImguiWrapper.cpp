@@ -15,6 +15,18 @@ void ImguiWrapper::Initialize(ID3D12Device* device, int bufferCount, DXGI_FORMAT
 		srvHeap->GetGPUDescriptorHandleForHeapStart());
 }
 
+void ImguiWrapper::ResetDescriptorHeap(ID3D12Device* device, int bufferCount, DXGI_FORMAT rtvFormat, ID3D12DescriptorHeap* srvHeap)
+{
+	// DX12のバックエンドだけを作り直す（フォントのTextureは次のNewFrameで作られる）
+	ImGui_ImplDX12_Shutdown();
+	ImGui_ImplDX12_Init(device,
+		bufferCount,
+		rtvFormat,
+		srvHeap,
+		srvHeap->GetCPUDescriptorHandleForHeapStart(),
+		srvHeap->GetGPUDescriptorHandleForHeapStart());
+}
+
 void ImguiWrapper::Finalize()
 {
 	ImGui_ImplDX12_Shutdown();
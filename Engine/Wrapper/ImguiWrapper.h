@@ -10,6 +10,8 @@ class ImguiWrapper
 public:
 	static void Initialize(ID3D12Device* device, int bufferCount, DXGI_FORMAT rtvFormat, ID3D12DescriptorHeap* srvHeap);
 	static void Finalize();
+	// SRVのDescriptorHeapが作り直されたときに、先頭にフォントのSRVを作り直す（GPUが描画を終えている時に呼ぶ）
+	static void ResetDescriptorHeap(ID3D12Device* device, int bufferCount, DXGI_FORMAT rtvFormat, ID3D12DescriptorHeap* srvHeap);
 	static void NewFrame();
 	static void Render(ID3D12GraphicsCommandList* commandList);
 };
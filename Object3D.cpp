@@ -1,12 +1,20 @@
 #include "Object3D.h"
+#include <cassert>
+#include <algorithm>
+#include <cmath>
 #include "Camera.h"
 
-Object3D::Object3D()
+Object3D::Object3D(bool useSharedMaterial) : materialCB_(useSharedMaterial, true)
 {
 	transform_.translate = { 0.0f, 0.0f, 0.0f };
 	transform_.rotate = { 0.0f, 0.0f, 0.0f };
 	transform_.scale = { 1.0f, 1.0f, 1.0f };
 
+	// 共有マテリアルを使用する場合は自身の定数バッファを持たない
+	if (useSharedMaterial) {
+		return;
+	}
+
 	// 白を書き込む
 	materialCB_.data_->color = { 1.0f, 1.0f, 1.0f, 1.0f };
 	// ライティング有効化
@@ -21,38 +29,95 @@ void Object3D::UpdateMatrix()
 	Matrix viewMatrix = Camera::GetCurrent()->MakeViewMatrix();
 	Matrix projectionMatrix = Camera::GetCurrent()->MakePerspectiveFovMatrix();
 	Matrix worldViewProjectionMatrix = worldMatrix * viewMatrix * projectionMatrix;
-	wvpCB_.data_->WVP = worldViewProjectionMatrix;
-	wvpCB_.data_->World = worldMatrix;
+	transformation_.WVP = worldViewProjectionMatrix;
+	transformation_.World = worldMatrix;
+
+	// モデルの境界の箱を囲む球をワールド座標に変換する
+	if (model_) {
+		Float3 center = {
+			(model_->boundsMin.x + model_->boundsMax.x) * 0.5f,
+			(model_->boundsMin.y + model_->boundsMax.y) * 0.5f,
+			(model_->boundsMin.z + model_->boundsMax.z) * 0.5f
+		};
+		Float3 extent = {
+			model_->boundsMax.x - center.x,
+			model_->boundsMax.y - center.y,
+			model_->boundsMax.z - center.z
+		};
+		const auto& r = worldMatrix.r;
+		worldBoundsCenter_ = {
+			center.x * r[0][0] + center.y * r[1][0] + center.z * r[2][0] + r[3][0],
+			center.x * r[0][1] + center.y * r[1][1] + center.z * r[2][1] + r[3][1],
+			center.x * r[0][2] + center.y * r[1][2] + center.z * r[2][2] + r[3][2]
+		};
+		float maxScale = (std::max)({ std::abs(transform_.scale.x), std::abs(transform_.scale.y), std::abs(transform_.scale.z) });
+		worldBoundsRadius_ = std::sqrt(extent.x * extent.x + extent.y * extent.y + extent.z * extent.z) * maxScale;
+	}
 }
 
 void Object3D::Draw()
 {
-	DirectXBase* dxBase = DirectXBase::GetInstance();
+	Draw(DirectXBase::GetInstance()->GetBackend());
+}
+
+void Object3D::Draw(const int TextureHandle)
+{
+	Draw(DirectXBase::GetInstance()->GetBackend(), TextureHandle);
+}
 
-	// commandListにVBVを設定
-	dxBase->GetCommandList()->IASetVertexBuffers(0, 1, &model_->vertexBufferView);
+void Object3D::Draw(RenderBackend& backend)
+{
+	// VBVを設定
+	backend.SetVertexBuffer(model_->vertexBufferView);
 	// マテリアルCBufferの場所を設定
-	dxBase->GetCommandList()->SetGraphicsRootConstantBufferView(0, materialCB_.resource_->GetGPUVirtualAddress());
-	// wvp用のCBufferの場所を設定
-	dxBase->GetCommandList()->SetGraphicsRootConstantBufferView(1, wvpCB_.resource_->GetGPUVirtualAddress());
+	backend.SetConstantBuffer(0, GetMaterialAddress());
+	// wvp用のCBufferの場所を設定（このフレームだけ使う領域に書き込む）
+	backend.SetConstantBuffer(1, backend.UploadConstants(transformation_));
 	// SRVのDescriptorTableの先頭を設定（Textureの設定）
-	TextureManager::SetDescriptorTable(2, dxBase->GetCommandList(), model_->material.textureHandle); // モデルデータに格納されたテクスチャを使用する
+	backend.SetTexture(2, model_->material.textureHandle); // モデルデータに格納されたテクスチャを使用する
+	// 画面上の大きさからミップを決めるため、使用したテクスチャを報告する
+	backend.ReportTextureUsage(model_->material.textureHandle, worldBoundsCenter_, worldBoundsRadius_);
 	// 描画を行う（DrawCall/ドローコール）
-	dxBase->GetCommandList()->DrawInstanced(UINT(model_->vertices.size()), 1, 0, 0);
+	DrawModel(backend);
 }
 
-void Object3D::Draw(const int TextureHandle)
+void Object3D::Draw(RenderBackend& backend, const int TextureHandle)
 {
-	DirectXBase* dxBase = DirectXBase::GetInstance();
-
-	// commandListにVBVを設定
-	dxBase->GetCommandList()->IASetVertexBuffers(0, 1, &model_->vertexBufferView);
+	// VBVを設定
+	backend.SetVertexBuffer(model_->vertexBufferView);
 	// マテリアルCBufferの場所を設定
-	dxBase->GetCommandList()->SetGraphicsRootConstantBufferView(0, materialCB_.resource_->GetGPUVirtualAddress());
-	// wvp用のCBufferの場所を設定
-	dxBase->GetCommandList()->SetGraphicsRootConstantBufferView(1, wvpCB_.resource_->GetGPUVirtualAddress());
+	backend.SetConstantBuffer(0, GetMaterialAddress());
+	// wvp用のCBufferの場所を設定（このフレームだけ使う領域に書き込む）
+	backend.SetConstantBuffer(1, backend.UploadConstants(transformation_));
 	// SRVのDescriptorTableの先頭を設定（Textureの設定）
-	TextureManager::SetDescriptorTable(2, dxBase->GetCommandList(), TextureHandle); // 指定したテクスチャを使用する
+	backend.SetTexture(2, TextureHandle); // 指定したテクスチャを使用する
+	backend.ReportTextureUsage(TextureHandle, worldBoundsCenter_, worldBoundsRadius_);
 	// 描画を行う（DrawCall/ドローコール）
-	dxBase->GetCommandList()->DrawInstanced(UINT(model_->vertices.size()), 1, 0, 0);
+	DrawModel(backend);
+}
+
+void Object3D::DrawModel(RenderBackend& backend)
+{
+	// インデックスを持つモデルはインデックス描画を行う
+	if (model_->indexCount > 0) {
+		backend.SetIndexBuffer(model_->indexBufferView);
+		backend.DrawIndexed(model_->indexCount);
+	} else {
+		backend.Draw(model_->vertexCount);
+	}
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS Object3D::GetMaterialAddress() const
+{
+	// 共有マテリアルが指定されていればそれを使用する
+	if (sharedMaterialCB_) {
+		return sharedMaterialCB_->GetGPUVirtualAddress();
+	}
+	// 自身の定数バッファがあればそれを使用する
+	if (materialCB_.IsCreated()) {
+		return materialCB_.GetGPUVirtualAddress();
+	}
+	// どちらも無い場合はモデルのマテリアルを使用する
+	assert(model_->material.materialCB);
+	return model_->material.materialCB->GetGPUVirtualAddress();
 }
@@ -3,13 +3,7 @@
 #include "ModelManager.h"
 #include "TextureManager.h"
 #include "ConstBuffer.h"
-
-struct Material {
-	Float4 color;
-	int32_t enableLighting;
-	float padding[3];
-	Matrix uvTransform;
-};
+#include "RenderBackend.h"
 
 struct TransformationMatrix {
 	Matrix WVP;
@@ -19,7 +13,8 @@ struct TransformationMatrix {
 class Object3D
 {
 public:
-	Object3D();
+	// trueを指定した場合はマテリアルの定数バッファを持たず、共有マテリアルを使用する
+	Object3D(bool useSharedMaterial = false);
 
 	// マトリックス情報の更新
 	void UpdateMatrix();
@@ -29,16 +24,35 @@ public:
 
 	void Draw(const int TextureHandle);
 
-	// マテリアルの定数バッファ
+	// 指定した記録先に描画を記録する（DirectXBase::RecordDrawsInParallelで別々のスレッドから呼ぶ）
+	// 共有マテリアルは複数のスレッドから読むので、記録を始める前にGetGPUVirtualAddressで書き込んでおく
+	void Draw(RenderBackend& backend);
+
+	void Draw(RenderBackend& backend, const int TextureHandle);
+
+	// マテリアルの定数バッファ（ImGuiなどから読み書きするので、CPU側のコピーを使う）
 	ConstBuffer<Material>materialCB_;
 
-	// トランスフォームの定数バッファ
-	ConstBuffer<TransformationMatrix>wvpCB_;
+	// 共有マテリアルの定数バッファ（nullptrの場合はモデルのマテリアルを使用する）
+	ConstBuffer<Material>* sharedMaterialCB_ = nullptr;
+
+	// トランスフォームの定数データ（描画のたびにConstantBufferAllocatorから確保した領域に書き込む）
+	TransformationMatrix transformation_;
 
 	// モデル情報
 	ModelData* model_ = nullptr;
 
 	// トランスフォーム情報
 	Transform transform_;
+
+private:
+	// モデルの頂点（インデックス）を使用して描画する
+	void DrawModel(RenderBackend& backend);
+	// 使用するマテリアルの定数バッファのアドレスを取得する
+	D3D12_GPU_VIRTUAL_ADDRESS GetMaterialAddress() const;
+
+	// ワールド座標での境界球（UpdateMatrixで更新し、ミップのストリーミングに報告する）
+	Float3 worldBoundsCenter_ = { 0.0f, 0.0f, 0.0f };
+	float worldBoundsRadius_ = 0.0f;
 };
 
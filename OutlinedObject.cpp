@@ -1,10 +1,19 @@
 #include "OutlinedObject.h"
 
-OutlinedObject::OutlinedObject()
+OutlinedObject::OutlinedObject() : outline_(true)
 {
-	// アウトラインの設定
-	outline_.materialCB_.data_->color = { 0.0f, 0.0f, 0.0f, 1.0f };
-	outline_.materialCB_.data_->enableLighting = false;
+	// アウトラインの設定（全てのアウトラインで定数バッファを共有する）
+	Material material;
+	material.color = { 0.0f, 0.0f, 0.0f, 1.0f };
+	material.enableLighting = false;
+	material.uvTransform = Matrix::Identity();
+	outline_.sharedMaterialCB_ = MaterialTable::Acquire(material);
+}
+
+OutlinedObject::~OutlinedObject()
+{
+	// 共有している定数バッファの参照を手放す
+	MaterialTable::Release(outline_.sharedMaterialCB_);
 }
 
 void OutlinedObject::UpdateMatrix()
@@ -30,11 +39,16 @@ void OutlinedObject::Draw()
 	if (enableOutline) {
 		// アウトラインのモデル情報を更新
 		outline_.model_ = this->model_;
-		// アウトライン用のPSOを設定
-		dxBase->GetCommandList()->SetPipelineState(dxBase->GetPipelineStateOutline());
+		// アウトライン用のPSOを設定（ヘッドレスの場合はコマンドリストが無いので、描画を数えるだけ）
+		ID3D12GraphicsCommandList* commandList = dxBase->GetCommandList();
+		if (commandList) {
+			commandList->SetPipelineState(dxBase->GetPipelineStateOutline());
+		}
 		// アウトラインの描画
 		outline_.Draw();
 		// PSOを元に戻す
-		dxBase->GetCommandList()->SetPipelineState(dxBase->GetPipelineState());
+		if (commandList) {
+			commandList->SetPipelineState(dxBase->GetPipelineState());
+		}
 	}
 }
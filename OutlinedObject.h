@@ -5,6 +5,7 @@ class OutlinedObject:public Object3D
 {
 public:
 	OutlinedObject();
+	~OutlinedObject();
 
 	void UpdateMatrix();
 	
@@ -1,7 +1,7 @@
 #include "Particle.h"
 #include "ImguiWrapper.h"
 
-Particle::Particle(Float3 position, Float3 rotation, Float2 velocity, Float3 color)
+Particle::Particle(Float3 position, Float3 rotation, Float2 velocity, Float3 color) : triangle_(true)
 {
 	// 引数で受け取った値を設定（移動と回転に使用する数値）
 	rotation_ = rotation;
@@ -11,19 +11,25 @@ Particle::Particle(Float3 position, Float3 rotation, Float2 velocity, Float3 col
 	triangle_.transform_.translate = position;
 	// 初期サイズを設定
 	triangle_.transform_.scale = { 0.15f, 0.15f, 0.0f };
+	// マテリアルの設定（同じ色のパーティクル同士で定数バッファを共有する）
+	Material material;
 	// ライティングしないように設定
-	triangle_.materialCB_.data_->enableLighting = false;
+	material.enableLighting = false;
 	// 引数で受け取った色に設定
-	triangle_.materialCB_.data_->color = { color.x, color.y, color.z, 1.0f };
+	material.color = { color.x, color.y, color.z, 1.0f };
+	material.uvTransform = Matrix::Identity();
+	triangle_.sharedMaterialCB_ = MaterialTable::Acquire(material);
 
-	// モデル読み込み
-	static ModelData model = ModelManager::LoadObjFile("resources/Models", "triangle.obj", dxBase->GetDevice());
+	// モデル読み込み（全てのパーティクルでModelManagerのキャッシュを共有し、パーティクルが無くなったら追い出せるようにする）
 	// オブジェクトにモデルを設定
-	triangle_.model_ = &model;
+	triangle_.model_ = ModelManager::Acquire("resources/Models", "triangle.obj", dxBase->GetDevice());
 }
 
 Particle::~Particle()
 {
+	// 共有している定数バッファとモデルの参照を手放す
+	MaterialTable::Release(triangle_.sharedMaterialCB_);
+	ModelManager::Release(triangle_.model_);
 }
 
 void Particle::Update()
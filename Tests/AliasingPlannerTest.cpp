@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// MyClass
+#include "TestFramework.h"
+#include "AliasingPlanner.h"
+
+namespace {
+	const uint64_t kMiB = 1024 * 1024;
+
+	// 使う期間が重なるリソースのメモリが重ならず、アラインメントを守ってヒープに収まっているか
+	bool IsValidPlan(const std::vector<AliasingRequest>& requests, const AliasingPlan& plan)
+	{
+		if (plan.slots.size() != requests.size() || plan.heaps.size() != requests.size() || plan.offsets.size() != requests.size()) {
+			return false;
+		}
+		for (size_t a = 0; a < requests.size(); ++a) {
+			uint32_t heap = plan.heaps[a];
+			if (plan.offsets[a] % requests[a].alignment != 0 || heap >= plan.heapSizes.size() || plan.offsets[a] + requests[a].size > plan.heapSizes[heap]) {
+				return false;
+			}
+			for (size_t b = a + 1; b < requests.size(); ++b) {
+				bool isLifetimeOverlapped = requests[a].firstPass <= requests[b].lastPass && requests[b].firstPass <= requests[a].lastPass;
+				bool isMemoryOverlapped = plan.heaps[b] == heap &&
+					plan.offsets[a] < plan.offsets[b] + requests[b].size && plan.offsets[b] < plan.offsets[a] + requests[a].size;
+				if (isLifetimeOverlapped && isMemoryOverlapped) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// AとBは期間が重ならないので同じ領域に置き、Cは別の領域になる
+	std::vector<AliasingRequest> MakeKnownRequests()
+	{
+		return {
+			{ 8 * kMiB, 64 * 1024, 0, 1 },
+			{ 8 * kMiB, 64 * 1024, 2, 3 },
+			{ 4 * kMiB, 64 * 1024, 1, 2 },
+		};
+	}
+}
+
+TEST(AliasingPlanner, SharesMemoryBetweenDisjointLifetimes)
+{
+	std::vector<AliasingRequest> requests = MakeKnownRequests();
+	AliasingPlan plan = PlanAliasing(requests);
+	CHECK(IsValidPlan(requests, plan));
+	CHECK(plan.dedicatedSize == 20 * kMiB);
+	CHECK(plan.GetTotalSize() == 12 * kMiB);
+	CHECK(plan.GetSavedSize() == 8 * kMiB);
+	CHECK(plan.slots[0] == plan.slots[1] && plan.slots[2] != plan.slots[0]);
+	CHECK(plan.slotSizes.size() == 2);
+	CHECK(plan.IsAliased(0) && plan.IsAliased(1) && !plan.IsAliased(2));
+}
+
+TEST(AliasingPlanner, PacksSlotsIntoLimitedHeaps)
+{
+	// 8MiBのヒープに詰める場合は、大きい領域から順に別のヒープになる
+	std::vector<AliasingRequest> requests = MakeKnownRequests();
+	AliasingPlan plan = PlanAliasing(requests, 8 * kMiB);
+	CHECK(IsValidPlan(requests, plan));
+	CHECK(plan.heapSizes.size() == 2);
+	CHECK(plan.heapSizes[0] == 8 * kMiB && plan.heapSizes[1] == 4 * kMiB);
+	CHECK(plan.heaps[0] == 0 && plan.heaps[1] == 0 && plan.heaps[2] == 1);
+
+	// ヒープより大きい領域は専用のヒープになる
+	plan = PlanAliasing(requests, 2 * kMiB);
+	CHECK(IsValidPlan(requests, plan));
+	CHECK(plan.heapSizes.size() == 2);
+	CHECK(plan.GetTotalSize() == 12 * kMiB);
+}
+
+TEST(AliasingPlanner, EmptyRequestsNeedNoMemory)
+{
+	AliasingPlan plan = PlanAliasing({});
+	CHECK(plan.slots.empty() && plan.heapSizes.empty());
+	CHECK(plan.GetTotalSize() == 0 && plan.dedicatedSize == 0);
+}
+
+TEST(AliasingPlanner, RandomRequestsAreValidAndNearLowerBound)
+{
+	// ランダムな期間と、フル・ハーフ・クォーターの解像度でRGBA8・RGBA16Fの大きさのリソース（固定のシード）
+	std::vector<uint64_t> sizes;
+	for (uint64_t scale : { 1, 2, 4 }) {
+		for (uint64_t bytesPerPixel : { 4, 8 }) {
+			sizes.push_back((1920 / scale * 1080 / scale * bytesPerPixel + 65535) / 65536 * 65536);
+		}
+	}
+	const uint32_t kPassCount = 24;
+	std::mt19937 random(4);
+	bool isAlwaysValid = true;
+	bool isAboveLowerBound = true;
+	uint64_t dedicatedSize = 0;
+	uint64_t totalSize = 0;
+	for (uint32_t planIndex = 0; planIndex < 200; ++planIndex) {
+		std::vector<AliasingRequest> requests;
+		for (uint32_t i = 0; i < 32; ++i) {
+			AliasingRequest& request = requests.emplace_back();
+			request.size = sizes[random() % sizes.size()];
+			request.alignment = 64 * 1024;
+			request.firstPass = random() % kPassCount;
+			request.lastPass = (std::min)(kPassCount - 1, request.firstPass + uint32_t(random() % 4));
+		}
+		for (uint64_t maxHeapSize : { UINT64_MAX, 64 * kMiB }) {
+			AliasingPlan plan = PlanAliasing(requests, maxHeapSize);
+			isAlwaysValid = isAlwaysValid && IsValidPlan(requests, plan);
+
+			// 同時に使うリソースの合計の最大値より小さくはできない
+			uint64_t peak = 0;
+			for (uint32_t pass = 0; pass < kPassCount; ++pass) {
+				uint64_t live = 0;
+				for (const AliasingRequest& request : requests) {
+					live += request.firstPass <= pass && pass <= request.lastPass ? request.size : 0;
+				}
+				peak = (std::max)(peak, live);
+			}
+			isAboveLowerBound = isAboveLowerBound && plan.GetTotalSize() >= peak && plan.GetTotalSize() <= plan.dedicatedSize;
+			dedicatedSize += plan.dedicatedSize;
+			totalSize += plan.GetTotalSize();
+		}
+	}
+	CHECK(isAlwaysValid);
+	CHECK(isAboveLowerBound);
+	// 半分以上のメモリを減らせる
+	CHECK(totalSize * 2 < dedicatedSize);
+}
@@ -0,0 +1,94 @@
+#include <set>
+
+// MyClass
+#include "TestFramework.h"
+#include "DescriptorAllocator.h"
+
+TEST(DescriptorAllocator, StaleHandleIsInvalidAfterFree)
+{
+	DescriptorAllocator allocator;
+	allocator.Initialize(4);
+	uint32_t handle = allocator.Allocate();
+	CHECK(allocator.IsValid(handle));
+
+	allocator.Free(handle, 1);
+	CHECK(!allocator.IsValid(handle));
+
+	// 同じ場所を再利用しても、古いハンドルは無効のまま
+	allocator.Retire(1);
+	uint32_t reused = allocator.Allocate();
+	CHECK(DescriptorAllocator::GetIndex(reused) == DescriptorAllocator::GetIndex(handle));
+	CHECK(reused != handle);
+	CHECK(allocator.IsValid(reused));
+	CHECK(!allocator.IsValid(handle));
+	CHECK(!allocator.IsValid(DescriptorAllocator::kInvalidHandle));
+}
+
+TEST(DescriptorAllocator, SlotIsNotReusedBeforeFence)
+{
+	DescriptorAllocator allocator;
+	allocator.Initialize(8);
+	uint32_t first = allocator.Allocate();
+	allocator.Allocate();
+	allocator.Free(first, 5);
+
+	// GPUがFenceの値に到達するまでは、まだ使っていない場所から確保する
+	allocator.Retire(4);
+	uint32_t beforeFence = allocator.Allocate();
+	CHECK(DescriptorAllocator::GetIndex(beforeFence) != DescriptorAllocator::GetIndex(first));
+
+	allocator.Retire(5);
+	uint32_t afterFence = allocator.Allocate();
+	CHECK(DescriptorAllocator::GetIndex(afterFence) == DescriptorAllocator::GetIndex(first));
+	CHECK(allocator.GetAllocatedCount() == 3);
+}
+
+TEST(DescriptorAllocator, CapacityDoublesWhenFull)
+{
+	// 先頭の1つは予約済みなので、3つ確保すると埋まる
+	DescriptorAllocator allocator;
+	allocator.Initialize(4, 1);
+	std::set<uint32_t> indices;
+	for (uint32_t i = 0; i < 3; ++i) {
+		indices.insert(DescriptorAllocator::GetIndex(allocator.Allocate()));
+	}
+	CHECK(allocator.GetCapacity() == 4);
+
+	indices.insert(DescriptorAllocator::GetIndex(allocator.Allocate()));
+	CHECK(allocator.GetCapacity() == 8);
+	for (uint32_t i = 0; i < 3; ++i) {
+		indices.insert(DescriptorAllocator::GetIndex(allocator.Allocate()));
+	}
+	CHECK(allocator.GetCapacity() == 8);
+	indices.insert(DescriptorAllocator::GetIndex(allocator.Allocate()));
+	CHECK(allocator.GetCapacity() == 16);
+
+	// 予約した場所は返さず、同じ場所を2回返さない
+	CHECK(indices.size() == 8);
+	CHECK(indices.count(0) == 0);
+	CHECK(allocator.GetUsedRange() == 9);
+}
+
+TEST(DescriptorAllocator, GenerationWrapsInElevenBits)
+{
+	DescriptorAllocator allocator;
+	allocator.Initialize(1);
+	uint32_t first = allocator.Allocate();
+
+	// 世代は1～2047を巡回し、0（無効なハンドル）にも負の値にもならない
+	const uint32_t kGenerationCount = (1u << 11) - 1;
+	uint32_t handle = first;
+	for (uint64_t fenceValue = 1; fenceValue <= kGenerationCount; ++fenceValue) {
+		allocator.Free(handle, fenceValue);
+		allocator.Retire(fenceValue);
+		uint32_t next = allocator.Allocate();
+		CHECK(next != DescriptorAllocator::kInvalidHandle);
+		CHECK(int32_t(next) > 0);
+		CHECK((next >> 20) >= 1 && (next >> 20) <= kGenerationCount);
+		CHECK(!allocator.IsValid(handle));
+		CHECK(allocator.IsValid(next));
+		handle = next;
+	}
+	// 一周すると最初のハンドルに戻る
+	CHECK(handle == first);
+}
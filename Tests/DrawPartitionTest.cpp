@@ -0,0 +1,164 @@
+#include <atomic>
+#include <vector>
+
+// MyClass
+#include "TestFramework.h"
+#include "DrawPartition.h"
+#include "WorkerPool.h"
+
+namespace {
+	// チャンクごとに記録した描画の番号を並べ、提出されたときにチャンクの順につないで残す記録先
+	class MockCommandSink : public DrawCommandSink
+	{
+	public:
+		explicit MockCommandSink(uint32_t maxChunkCount) : chunks_(maxChunkCount) {}
+
+		void BeginChunk(uint32_t chunk) override {
+			chunks_[chunk].beginCount++;
+			activeChunks_++;
+		}
+		void EndChunk(uint32_t chunk) override {
+			chunks_[chunk].endCount++;
+			activeChunks_--;
+		}
+		void Submit(uint32_t chunkCount) override {
+			// 提出するときには全てのチャンクを記録し終えている
+			isSubmittedAfterRecording_ = activeChunks_ == 0;
+			submittedChunkCount_ = chunkCount;
+			for (uint32_t i = 0; i < chunkCount; ++i) {
+				submittedDraws_.insert(submittedDraws_.end(), chunks_[i].draws.begin(), chunks_[i].draws.end());
+			}
+		}
+		void Record(uint32_t chunk, size_t drawIndex) { chunks_[chunk].draws.push_back(drawIndex); }
+
+		// 各チャンクを1回ずつ記録したか
+		bool IsEachChunkRecordedOnce() const {
+			for (uint32_t i = 0; i < chunks_.size(); ++i) {
+				uint32_t expected = i < submittedChunkCount_ ? 1 : 0;
+				if (chunks_[i].beginCount != expected || chunks_[i].endCount != expected) {
+					return false;
+				}
+			}
+			return true;
+		}
+		bool IsSubmittedAfterRecording() const { return isSubmittedAfterRecording_; }
+		uint32_t GetSubmittedChunkCount() const { return submittedChunkCount_; }
+		const std::vector<size_t>& GetSubmittedDraws() const { return submittedDraws_; }
+
+	private:
+		struct Chunk {
+			std::vector<size_t> draws;
+			uint32_t beginCount = 0;
+			uint32_t endCount = 0;
+		};
+		std::vector<Chunk> chunks_;
+		std::atomic<int32_t> activeChunks_ = 0;
+		bool isSubmittedAfterRecording_ = false;
+		uint32_t submittedChunkCount_ = 0;
+		std::vector<size_t> submittedDraws_;
+	};
+
+	// 範囲が描画の順に隙間なく並び、全ての描画を1回ずつ含むか
+	bool CoversAllDrawsInOrder(const std::vector<DrawRange>& ranges, size_t drawCount)
+	{
+		size_t expected = 0;
+		for (const DrawRange& range : ranges) {
+			if (range.begin != expected || range.end <= range.begin) {
+				return false;
+			}
+			expected = range.end;
+		}
+		return expected == drawCount;
+	}
+}
+
+TEST(DrawPartition, SplitsEvenlyInOrder)
+{
+	// 余りは先頭のチャンクから1つずつ配る
+	std::vector<DrawRange> ranges = PartitionDraws(10, 4, 1);
+	CHECK(ranges.size() == 4);
+	CHECK(CoversAllDrawsInOrder(ranges, 10));
+	CHECK(ranges[0].end - ranges[0].begin == 3 && ranges[1].end - ranges[1].begin == 3);
+	CHECK(ranges[2].end - ranges[2].begin == 2 && ranges[3].end - ranges[3].begin == 2);
+
+	CHECK(PartitionDraws(0, 4, 1).empty());
+}
+
+TEST(DrawPartition, RespectsMinimumDrawsPerChunk)
+{
+	// 少ない描画は細かく分けない
+	CHECK(PartitionDraws(100, 8, 256).size() == 1);
+	CHECK(PartitionDraws(1000, 8, 256).size() == 3);
+	CHECK(PartitionDraws(100000, 8, 256).size() == 8);
+	// 0の指定は1として扱う
+	CHECK(PartitionDraws(5, 0, 0).size() == 1);
+	CHECK(PartitionDraws(5, 8, 0).size() == 5);
+
+	bool isAlwaysCovered = true;
+	for (size_t drawCount = 1; drawCount < 2000; drawCount += 37) {
+		for (uint32_t chunkCount = 1; chunkCount <= 16; ++chunkCount) {
+			std::vector<DrawRange> ranges = PartitionDraws(drawCount, chunkCount, 64);
+			isAlwaysCovered = isAlwaysCovered && ranges.size() <= chunkCount && CoversAllDrawsInOrder(ranges, drawCount);
+			for (const DrawRange& range : ranges) {
+				isAlwaysCovered = isAlwaysCovered && (ranges.size() == 1 || range.end - range.begin >= 64);
+			}
+		}
+	}
+	CHECK(isAlwaysCovered);
+}
+
+TEST(DrawPartition, ParallelRecordingSubmitsInDrawOrder)
+{
+	const size_t kDrawCount = 10000;
+	for (uint32_t threadCount = 1; threadCount <= 8; threadCount *= 2) {
+		MockCommandSink sink(threadCount);
+		RecordDrawsInParallel(kDrawCount, threadCount, 256, sink, [&](uint32_t chunk, size_t drawIndex) {
+			sink.Record(chunk, drawIndex);
+		});
+		CHECK(sink.GetSubmittedChunkCount() == threadCount);
+		CHECK(sink.IsEachChunkRecordedOnce());
+		CHECK(sink.IsSubmittedAfterRecording());
+
+		// チャンクの順につないだ描画が元の順に1つずつ並ぶ
+		const std::vector<size_t>& draws = sink.GetSubmittedDraws();
+		bool isInOrder = draws.size() == kDrawCount;
+		for (size_t i = 0; isInOrder && i < draws.size(); ++i) {
+			isInOrder = draws[i] == i;
+		}
+		CHECK(isInOrder);
+	}
+}
+
+TEST(DrawPartition, PooledRecordingSubmitsInDrawOrder)
+{
+	// 毎フレーム同じプールで記録しても、チャンクの順に元の順で提出される
+	const size_t kDrawCount = 10000;
+	WorkerPool pool(4);
+	for (int frame = 0; frame < 8; ++frame) {
+		MockCommandSink sink(pool.GetThreadCount());
+		RecordDrawsInParallel(pool, kDrawCount, 0, 256, sink, [&](uint32_t chunk, size_t drawIndex) {
+			sink.Record(chunk, drawIndex);
+		});
+		CHECK(sink.GetSubmittedChunkCount() == pool.GetThreadCount());
+		CHECK(sink.IsEachChunkRecordedOnce());
+		CHECK(sink.IsSubmittedAfterRecording());
+
+		const std::vector<size_t>& draws = sink.GetSubmittedDraws();
+		bool isInOrder = draws.size() == kDrawCount;
+		for (size_t i = 0; isInOrder && i < draws.size(); ++i) {
+			isInOrder = draws[i] == i;
+		}
+		CHECK(isInOrder);
+	}
+}
+
+TEST(DrawPartition, NoDrawsSubmitsNoChunks)
+{
+	MockCommandSink sink(4);
+	RecordDrawsInParallel(0, 4, 256, sink, [&](uint32_t chunk, size_t drawIndex) {
+		sink.Record(chunk, drawIndex);
+	});
+	CHECK(sink.GetSubmittedChunkCount() == 0);
+	CHECK(sink.GetSubmittedDraws().empty());
+	CHECK(sink.IsEachChunkRecordedOnce());
+}
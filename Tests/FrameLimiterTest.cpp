@@ -0,0 +1,111 @@
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+// MyClass
+#include "TestFramework.h"
+#include "FrameLimiter.h"
+
+namespace {
+	// 時刻を進めるだけの時計（眠るとOSのスケジューラのように0.2～1.5ms長く眠る）
+	class FakeFrameClock : public FrameClock
+	{
+	public:
+		int64_t Now() override { return time_ += kNowCost; }
+		void Sleep(int64_t nanoseconds) override {
+			time_ += nanoseconds + std::uniform_int_distribution<int64_t>(200000, 1500000)(random_);
+			sleepCount_++;
+		}
+		void Spin() override { time_ += kSpinCost; }
+		// フレームの処理で時間を進める
+		void Advance(int64_t nanoseconds) { time_ += nanoseconds; }
+
+		uint32_t GetSleepCount() const { return sleepCount_; }
+
+	private:
+		static constexpr int64_t kNowCost = 50;
+		static constexpr int64_t kSpinCost = 100;
+		std::mt19937 random_{ 11 };
+		int64_t time_ = 0;
+		uint32_t sleepCount_ = 0;
+	};
+
+	const int64_t kTargetInterval = 1000000000 / 60;
+	// 許容するずれ（0.5ms）
+	const int64_t kTolerance = 500000;
+}
+
+TEST(FrameLimiter, DoesNotAccumulateDrift)
+{
+	auto ownedClock = std::make_unique<FakeFrameClock>();
+	FakeFrameClock* clock = ownedClock.get();
+	FrameLimiter limiter(60.0, std::move(ownedClock));
+
+	// フレームの処理には目標の20～80%かかる（固定のシード）
+	std::mt19937 random(5);
+	std::uniform_int_distribution<int64_t> workDistribution(kTargetInterval / 5, kTargetInterval * 4 / 5);
+	const uint32_t kFrameCount = 1000;
+	limiter.Wait();
+	int64_t firstFrameStart = clock->Now();
+	int64_t frameStart = firstFrameStart;
+	bool isEveryIntervalOnTarget = true;
+	for (uint32_t i = 0; i < kFrameCount; ++i) {
+		clock->Advance(workDistribution(random));
+		limiter.Wait();
+		int64_t now = clock->Now();
+		isEveryIntervalOnTarget = isEveryIntervalOnTarget && std::abs(now - frameStart - kTargetInterval) <= kTolerance;
+		frameStart = now;
+	}
+	CHECK(isEveryIntervalOnTarget);
+	// 眠りすぎた分が積み重ならず、1000フレーム後も目標の時刻からずれない
+	CHECK(std::abs(frameStart - firstFrameStart - kTargetInterval * kFrameCount) <= kTolerance);
+	CHECK(std::abs(limiter.GetAverageFrameInterval() - kTargetInterval / 1000000.0) < 0.5);
+	// 待ち時間の大半は眠り、見積もりは眠りすぎる分を含む
+	CHECK(clock->GetSleepCount() > kFrameCount);
+	CHECK(limiter.GetSleepEstimate() > 1.2 && limiter.GetSleepEstimate() < 2.5);
+}
+
+TEST(FrameLimiter, RestartsAfterStallInsteadOfCatchingUp)
+{
+	auto ownedClock = std::make_unique<FakeFrameClock>();
+	FakeFrameClock* clock = ownedClock.get();
+	FrameLimiter limiter(60.0, std::move(ownedClock));
+	limiter.Wait();
+	clock->Advance(kTargetInterval / 2);
+	limiter.Wait();
+
+	// 3フレーム分止まった後は、遅れを取り戻そうと待たずに続けるのではなく、そこから1フレームずつ数え直す
+	clock->Advance(kTargetInterval * 3);
+	limiter.Wait();
+	CHECK(limiter.GetFrameInterval() * 1000000.0 >= double(kTargetInterval * 3));
+	bool isEveryIntervalOnTarget = true;
+	for (uint32_t i = 0; i < 10; ++i) {
+		clock->Advance(kTargetInterval / 2);
+		limiter.Wait();
+		isEveryIntervalOnTarget = isEveryIntervalOnTarget && std::abs(int64_t(limiter.GetFrameInterval() * 1000000.0) - kTargetInterval) <= kTolerance;
+	}
+	CHECK(isEveryIntervalOnTarget);
+}
+
+TEST(FrameLimiter, ZeroFrameRateOnlyMeasures)
+{
+	auto ownedClock = std::make_unique<FakeFrameClock>();
+	FakeFrameClock* clock = ownedClock.get();
+	FrameLimiter limiter(0.0, std::move(ownedClock));
+	CHECK(limiter.GetTargetFrameRate() == 0.0);
+	limiter.Wait();
+	for (uint32_t i = 0; i < 10; ++i) {
+		clock->Advance(5000000);
+		limiter.Wait();
+	}
+	CHECK(clock->GetSleepCount() == 0);
+	CHECK(std::abs(limiter.GetFrameInterval() - 5.0) < 0.01);
+
+	// 目標を設定すると、次のWaitから待つ
+	limiter.SetTargetFrameRate(60.0);
+	clock->Advance(5000000);
+	limiter.Wait();
+	CHECK(clock->GetSleepCount() > 0);
+	CHECK(std::abs(int64_t(limiter.GetFrameInterval() * 1000000.0) - kTargetInterval) <= kTolerance);
+}
@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// MyClass
+#include "TestFramework.h"
+#include "FrameRing.h"
+
+TEST(FrameRing, ReturnsFenceOfFrameThatUsedNextSlot)
+{
+	FrameRing ring;
+	ring.Initialize(3);
+	// 最初の一巡は使っていない領域なので待たない
+	CHECK(ring.Advance(1) == 0);
+	CHECK(ring.Advance(2) == 0);
+	CHECK(ring.GetFrameIndex() == 2);
+	// 3フレーム前が使った領域に戻る
+	CHECK(ring.Advance(3) == 1);
+	CHECK(ring.GetFrameIndex() == 0);
+	CHECK(ring.Advance(4) == 2);
+	CHECK(ring.GetFrameNumber() == 4);
+	CHECK(ring.GetFenceValue(0) == 4 && ring.GetFenceValue(1) == 2 && ring.GetFenceValue(2) == 3);
+}
+
+TEST(FrameRing, SingleFrameWaitsForItself)
+{
+	FrameRing ring;
+	ring.Initialize(1);
+	CHECK(ring.Advance(1) == 1);
+	CHECK(ring.Advance(2) == 2);
+	CHECK(ring.GetFrameIndex() == 0);
+}
+
+TEST(FrameRing, NeverReusesSlotStillInFlight)
+{
+	// 記録に4～8ms、実行に6～14msかかるフレームを、GPUを模したFenceで進める（固定のシード）
+	std::mt19937 random(7);
+	std::uniform_real_distribution<double> cpuDistribution(4.0, 8.0);
+	std::uniform_real_distribution<double> gpuDistribution(6.0, 14.0);
+
+	for (uint32_t framesInFlight = 1; framesInFlight <= 4; ++framesInFlight) {
+		FrameRing ring;
+		ring.Initialize(framesInFlight);
+
+		// Fenceの値ごとの、GPUが到達する時刻
+		std::vector<double> completionTimes(1, 0.0);
+		double cpuTime = 0.0;
+		double gpuTime = 0.0;
+		bool isSlotCompleted = true;
+		bool isWithinFrameCount = true;
+		uint32_t peakFramesInFlight = 0;
+		for (uint32_t frame = 0; frame < 1000; ++frame) {
+			cpuTime += cpuDistribution(random);
+			gpuTime = (std::max)(gpuTime, cpuTime) + gpuDistribution(random);
+			uint64_t fenceValue = completionTimes.size();
+			completionTimes.push_back(gpuTime);
+
+			// 返されたFenceの値まで待ってから次の領域を使う
+			uint64_t reuseFenceValue = ring.Advance(fenceValue);
+			cpuTime = (std::max)(cpuTime, completionTimes[reuseFenceValue]);
+
+			// 再利用する領域をGPUが使い終わっていて、実行中のフレームがフレームの数を超えていない
+			isSlotCompleted = isSlotCompleted && completionTimes[ring.GetFenceValue(ring.GetFrameIndex())] <= cpuTime;
+			uint32_t runningFrames = 0;
+			for (uint64_t value = fenceValue; value > 0 && completionTimes[value] > cpuTime; --value) {
+				runningFrames++;
+			}
+			peakFramesInFlight = (std::max)(peakFramesInFlight, runningFrames);
+			isWithinFrameCount = isWithinFrameCount && runningFrames < framesInFlight;
+		}
+		CHECK(isSlotCompleted);
+		CHECK(isWithinFrameCount);
+		// GPUの方が遅いので、フレームの数の上限まで重なる
+		CHECK(peakFramesInFlight == framesInFlight - 1);
+	}
+}
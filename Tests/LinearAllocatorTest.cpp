@@ -0,0 +1,69 @@
+// MyClass
+#include "TestFramework.h"
+#include "LinearAllocator.h"
+
+TEST(LinearAllocator, AlignsTo256Bytes)
+{
+	// 定数バッファは256バイト境界に置く
+	LinearAllocator allocator;
+	allocator.Initialize(64 * 1024);
+	LinearAllocator::Allocation first = allocator.Allocate(1, 256);
+	LinearAllocator::Allocation second = allocator.Allocate(200, 256);
+	LinearAllocator::Allocation third = allocator.Allocate(17, 256);
+
+	CHECK(first.page == 0 && first.offset == 0);
+	CHECK(second.page == 0 && second.offset == 256);
+	CHECK(third.page == 0 && third.offset == 512);
+	CHECK(allocator.GetAllocatedSize() == 218);
+}
+
+TEST(LinearAllocator, RollsOverToNewPageWhenFull)
+{
+	LinearAllocator allocator;
+	allocator.Initialize(1024);
+	LinearAllocator::Allocation first = allocator.Allocate(768, 256);
+	// 残りの256バイトに収まらないので次のページの先頭に置く
+	LinearAllocator::Allocation second = allocator.Allocate(512, 256);
+	CHECK(first.page == 0 && first.offset == 0);
+	CHECK(second.page == 1 && second.offset == 0);
+	CHECK(allocator.GetPageCount() == 2);
+
+	// ちょうどページの大きさは確保でき、それより大きい場合は確保できない
+	CHECK(allocator.Allocate(1024, 256).page == 2);
+	CHECK(allocator.Allocate(1025, 256).page == LinearAllocator::kInvalidPage);
+	CHECK(allocator.Allocate(0, 256).page == LinearAllocator::kInvalidPage);
+	CHECK(allocator.GetPageCount() == 3);
+}
+
+TEST(LinearAllocator, RecyclesPagesOnlyAfterFence)
+{
+	LinearAllocator allocator;
+	allocator.Initialize(1024);
+
+	// フレーム1で2ページ使う
+	allocator.Allocate(1024, 256);
+	allocator.Allocate(1024, 256);
+	allocator.Submit(1);
+	CHECK(allocator.GetPageCount() == 2);
+
+	// GPUがフレーム1を終えるまでは、新しいページを作る
+	allocator.Retire(0);
+	CHECK(allocator.GetFreePageCount() == 0);
+	LinearAllocator::Allocation frame2 = allocator.Allocate(1024, 256);
+	CHECK(frame2.page == 2);
+	allocator.Submit(2);
+
+	// フレーム1のページだけが空きに戻る
+	allocator.Retire(1);
+	CHECK(allocator.GetFreePageCount() == 2);
+	LinearAllocator::Allocation frame3First = allocator.Allocate(1024, 256);
+	LinearAllocator::Allocation frame3Second = allocator.Allocate(1024, 256);
+	CHECK(frame3First.page < 2 && frame3Second.page < 2 && frame3First.page != frame3Second.page);
+	CHECK(allocator.GetPageCount() == 3);
+	allocator.Submit(3);
+
+	// 確保していないフレームのSubmitは何も提出しない
+	allocator.Submit(4);
+	allocator.Retire(4);
+	CHECK(allocator.GetFreePageCount() == 3);
+}
@@ -0,0 +1,105 @@
+#include <vector>
+
+// MyClass
+#include "TestFramework.h"
+#include "MipResidency.h"
+
+namespace {
+	// 2048x2048のRGBA8のTexture（64x64のミップまでは常に常駐する）
+	StreamedTextureInfo MakeTextureInfo()
+	{
+		StreamedTextureInfo info{ 2048, 2048, {}, 5 };
+		for (uint32_t size = 2048; size > 0; size /= 2) {
+			info.mipSizes.push_back(uint64_t(size) * size * 4);
+		}
+		return info;
+	}
+
+	// 常駐しているミップのバイト数を数え直す
+	uint64_t CountResidentBytes(const MipResidency& residency, const StreamedTextureInfo& info, uint32_t textureCount)
+	{
+		uint64_t bytes = 0;
+		for (uint32_t id = 0; id < textureCount; ++id) {
+			for (uint32_t mip = residency.GetResidentMip(id); mip < info.mipSizes.size(); ++mip) {
+				bytes += info.mipSizes[mip];
+			}
+		}
+		return bytes;
+	}
+}
+
+TEST(MipResidency, ComputesDesiredMipFromProjectedSize)
+{
+	// 画面上のピクセル数がTextureの幅の半分なら1つ小さいミップでよい
+	CHECK(MipResidency::ComputeDesiredMip(2048, 2048, 12, 4096.0f) == 0);
+	CHECK(MipResidency::ComputeDesiredMip(2048, 2048, 12, 2048.0f) == 0);
+	CHECK(MipResidency::ComputeDesiredMip(2048, 2048, 12, 1024.0f) == 1);
+	CHECK(MipResidency::ComputeDesiredMip(2048, 2048, 12, 1.0f) == 11);
+	// 見えていなければ最も小さいミップ
+	CHECK(MipResidency::ComputeDesiredMip(2048, 2048, 12, 0.0f) == 11);
+}
+
+TEST(MipResidency, StaysWithinBudgetAlongCameraPath)
+{
+	const uint32_t kTextureCount = 64;
+	const uint64_t kBudget = 64ull * 1024 * 1024;
+	StreamedTextureInfo info = MakeTextureInfo();
+
+	MipResidency residency;
+	residency.SetBudget(kBudget);
+	std::vector<MipUsage> usages;
+	for (uint32_t i = 0; i < kTextureCount; ++i) {
+		uint32_t textureId = residency.AddTexture(info);
+		usages.push_back({ textureId, { 2.0f, 0.0f, float(i) * 4.0f }, 1.0f });
+	}
+	// 常に常駐させるミップだけで予算に収まる条件で確かめる
+	CHECK(residency.GetResidentBytes() <= kBudget);
+
+	// カメラは並びの手前から奥まで一定の速さで進む
+	bool isWithinBudget = true;
+	bool isCountConsistent = true;
+	bool isNeverBelowMinimum = true;
+	bool hasStreamedIn = false;
+	for (uint32_t frame = 0; frame < 300; ++frame) {
+		float z = -10.0f + float(kTextureCount) * 4.0f * float(frame) / 300.0f;
+		residency.Update(MipCamera{ { 0.0f, 0.0f, z }, 0.45f, 720.0f }, usages);
+		isWithinBudget = isWithinBudget && residency.GetResidentBytes() <= kBudget;
+		isCountConsistent = isCountConsistent && residency.GetResidentBytes() == CountResidentBytes(residency, info, kTextureCount);
+		for (const MipResidencyChange& change : residency.GetChanges()) {
+			isNeverBelowMinimum = isNeverBelowMinimum && change.newResidentMip <= info.minResidentMip && change.newResidentMip != change.oldResidentMip;
+			hasStreamedIn = hasStreamedIn || change.newResidentMip < change.oldResidentMip;
+		}
+	}
+	CHECK(isWithinBudget);
+	CHECK(isCountConsistent);
+	CHECK(isNeverBelowMinimum);
+	CHECK(hasStreamedIn);
+}
+
+TEST(MipResidency, ClosestTextureWinsWhenBudgetIsTight)
+{
+	// 常に常駐させるミップに加えて、1枚分のミップ1～4しか入らない予算
+	StreamedTextureInfo info = MakeTextureInfo();
+	uint64_t baseBytes = 0;
+	for (uint32_t mip = info.minResidentMip; mip < info.mipSizes.size(); ++mip) {
+		baseBytes += info.mipSizes[mip];
+	}
+	uint64_t streamedBytes = info.mipSizes[1] + info.mipSizes[2] + info.mipSizes[3] + info.mipSizes[4];
+
+	MipResidency residency;
+	residency.SetBudget(baseBytes * 2 + streamedBytes);
+	uint32_t nearId = residency.AddTexture(info);
+	uint32_t farId = residency.AddTexture(info);
+	std::vector<MipUsage> usages = {
+		{ farId, { 0.0f, 0.0f, 40.0f }, 1.0f },
+		{ nearId, { 0.0f, 0.0f, 1.5f }, 1.0f },
+	};
+	residency.Update(MipCamera{ { 0.0f, 0.0f, 0.0f }, 0.45f, 720.0f }, usages);
+	CHECK(residency.GetResidentMip(nearId) == 1);
+	CHECK(residency.GetResidentMip(farId) == info.minResidentMip);
+	CHECK(residency.GetResidentBytes() <= residency.GetBudget());
+
+	// 登録を外すと常駐していた分が減る
+	residency.RemoveTexture(nearId);
+	CHECK(residency.GetResidentBytes() == baseBytes);
+}
@@ -0,0 +1,145 @@
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// MyClass
+#include "TestFramework.h"
+#include "ObjParser.h"
+
+namespace {
+	// 2つの三角形で1枚の四角形を作るObj（4頂点のうち2頂点を共有する）
+	const char* kPlaneObj =
+		"mtllib plane.mtl\n"
+		"v -1.0 -1.0 0.0\n"
+		"v 1.0 -1.0 0.0\n"
+		"v -1.0 1.0 0.0\n"
+		"v 1.0 1.0 0.0\n"
+		"vt 1.0 0.0\n"
+		"vt 0.0 1.0\n"
+		"vt 0.0 0.0\n"
+		"vt 1.0 1.0\n"
+		"vn 0.0 0.0 1.0\n"
+		"usemtl Material.001\n"
+		"f 2/1/1 3/2/1 1/3/1\n"
+		"f 2/1/1 4/4/1 3/2/1\n";
+
+	bool IsSameVertex(const VertexData& a, const VertexData& b)
+	{
+		return a.position.x == b.position.x && a.position.y == b.position.y && a.position.z == b.position.z && a.position.w == b.position.w &&
+			a.texcoord.x == b.texcoord.x && a.texcoord.y == b.texcoord.y &&
+			a.normal.x == b.normal.x && a.normal.y == b.normal.y && a.normal.z == b.normal.z;
+	}
+
+	// 溶接した頂点をIndexの順に展開し、展開して読み込んだ頂点と同じになるか確認する
+	bool IsSameTriangles(const ObjMesh& expanded, const ObjMesh& welded)
+	{
+		std::vector<VertexData> vertices(welded.vertexKeys.size());
+		ObjParser::AssembleVertices(welded, vertices.data());
+		if (welded.indices.size() != expanded.vertices.size()) {
+			return false;
+		}
+		for (size_t i = 0; i < welded.indices.size(); ++i) {
+			if (!IsSameVertex(vertices[welded.indices[i]], expanded.vertices[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+TEST(ObjParser, ExpandsAndConvertsToLeftHanded)
+{
+	std::istringstream stream(kPlaneObj);
+	ObjMesh mesh;
+	CHECK(ObjParser::Parse(stream, mesh));
+	CHECK(mesh.vertices.size() == 6);
+	CHECK(mesh.indices.empty());
+	CHECK(mesh.materialLibrary == "plane.mtl");
+	CHECK(mesh.materialNames.size() == 1 && mesh.materialNames[0] == "Material.001");
+
+	// 回り順を逆にするため、1つ目の面の3頂点目が先頭に来る。xとUVのvは反転する
+	CHECK(mesh.vertices[0].position.x == 1.0f && mesh.vertices[0].position.y == -1.0f && mesh.vertices[0].position.w == 1.0f);
+	CHECK(mesh.vertices[0].texcoord.x == 0.0f && mesh.vertices[0].texcoord.y == 1.0f);
+	CHECK(mesh.vertices[2].position.x == -1.0f && mesh.vertices[2].position.y == -1.0f);
+	CHECK(mesh.vertices[0].normal.x == -0.0f && mesh.vertices[0].normal.z == 1.0f);
+	CHECK(mesh.boundsMin.x == -1.0f && mesh.boundsMax.x == 1.0f && mesh.boundsMin.y == -1.0f && mesh.boundsMax.y == 1.0f);
+}
+
+TEST(ObjParser, WeldsSharedVertices)
+{
+	std::istringstream expandedStream(kPlaneObj);
+	std::istringstream weldedStream(kPlaneObj);
+	ObjMesh expanded, welded;
+	CHECK(ObjParser::Parse(expandedStream, expanded));
+	CHECK(ObjParser::ParseWelded(weldedStream, welded));
+
+	// 共有している2頂点が1つにまとまり、同じ三角形を描画する
+	CHECK(welded.vertexKeys.size() == 4);
+	CHECK(welded.indices.size() == 6);
+	CHECK(welded.vertices.empty());
+	CHECK(IsSameTriangles(expanded, welded));
+	CHECK(welded.materialLibrary == expanded.materialLibrary);
+	CHECK(welded.boundsMin.x == expanded.boundsMin.x && welded.boundsMax.y == expanded.boundsMax.y);
+}
+
+TEST(ObjParser, ReportsMemoryOfBothPaths)
+{
+	std::ifstream expandedFile(std::string(CG2_RESOURCES_DIR) + "/Models/teapot.obj");
+	std::ifstream weldedFile(std::string(CG2_RESOURCES_DIR) + "/Models/teapot.obj");
+	CHECK(expandedFile.is_open() && weldedFile.is_open());
+	ObjMesh expanded, welded;
+	CHECK(ObjParser::Parse(expandedFile, expanded));
+	CHECK(ObjParser::ParseWelded(weldedFile, welded));
+	CHECK(IsSameTriangles(expanded, welded));
+	CHECK(welded.vertexKeys.size() < expanded.vertices.size());
+
+	// 展開した頂点は読み込み後も残り続ける
+	CHECK(expanded.memory.steadyCpuBytes == expanded.vertices.capacity() * sizeof(VertexData));
+	CHECK(expanded.memory.peakCpuBytes > expanded.memory.steadyCpuBytes);
+	CHECK(expanded.memory.gpuBytes == expanded.vertices.size() * sizeof(VertexData));
+
+	// 溶接した場合は展開した頂点を持たないので、読み込み中のピークも読み込み後もCPU側のメモリが少ない
+	CHECK(welded.memory.peakCpuBytes < expanded.memory.peakCpuBytes);
+	CHECK(welded.memory.steadyCpuBytes < expanded.memory.steadyCpuBytes);
+	CHECK(welded.memory.expandedBytes == expanded.memory.expandedBytes);
+	CHECK(welded.memory.gpuBytes == welded.vertexKeys.size() * sizeof(VertexData) + welded.indices.size() * sizeof(uint32_t));
+}
+
+TEST(ObjParser, RejectsInvalidFaces)
+{
+	// 定義されていない要素を指すIndex、0のIndex、UVを省略した頂点は読み込まない
+	const char* invalidFaces[] = { "f 1/1/1 2/1/1 5/1/1\n", "f 0/1/1 1/1/1 2/1/1\n", "f 1//1 2//1 3//1\n" };
+	for (const char* face : invalidFaces) {
+		std::string text = std::string("v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nvn 0 0 1\n") + face;
+		std::istringstream expandedStream(text);
+		std::istringstream weldedStream(text);
+		ObjMesh expanded, welded;
+		CHECK(!ObjParser::Parse(expandedStream, expanded));
+		CHECK(!expanded.error.empty());
+		CHECK(!ObjParser::ParseWelded(weldedStream, welded));
+		CHECK(!welded.error.empty());
+	}
+}
+
+TEST(ObjParser, WeldsIndicesBeyond21Bits)
+{
+	// 要素のIndexを21bitずつ詰めると溢れる数の位置でも、別々の頂点として溶接する
+	const uint32_t positionCount = (1u << 21) + 2;
+	std::string text;
+	text.reserve(positionCount * 8 + 128);
+	for (uint32_t i = 0; i < positionCount; ++i) {
+		text += "v 0 0 0\n";
+	}
+	text += "vt 0 0\nvn 0 0 1\n";
+	text += "f 1/1/1 2/1/1 " + std::to_string(positionCount) + "/1/1\n";
+	text += "f 1/1/1 " + std::to_string(positionCount) + "/1/1 " + std::to_string(positionCount - 1) + "/1/1\n";
+
+	std::istringstream stream(text);
+	ObjMesh mesh;
+	CHECK(ObjParser::ParseWelded(stream, mesh));
+	CHECK(mesh.vertexKeys.size() == 4);
+	CHECK(mesh.indices.size() == 6);
+	CHECK(mesh.vertexKeys[mesh.indices[0]].position == positionCount - 1);
+	CHECK(mesh.vertexKeys[mesh.indices[3]].position == positionCount - 2);
+}
@@ -0,0 +1,69 @@
+#include <vector>
+
+// MyClass
+#include "TestFramework.h"
+#include "PoolAllocator.h"
+
+TEST(PoolAllocator, RoundsUpToPowerOfTwoSlots)
+{
+	PoolAllocator allocator;
+	allocator.Initialize(64 * 1024, 256);
+	CHECK(allocator.GetSlotSize(1) == 256);
+	CHECK(allocator.GetSlotSize(256) == 256);
+	CHECK(allocator.GetSlotSize(257) == 512);
+	CHECK(allocator.GetSlotSize(64 * 1024) == 64 * 1024);
+
+	PoolAllocator::Allocation small = allocator.Allocate(200);
+	PoolAllocator::Allocation large = allocator.Allocate(300);
+	// 大きさの異なるスロットは別のページに分ける
+	CHECK(small.page != large.page);
+	CHECK(small.offset % 256 == 0 && large.offset % 512 == 0);
+	CHECK(allocator.GetUsedBytes() == 256 + 512);
+	CHECK(allocator.Allocate(64 * 1024 + 1).page == PoolAllocator::kInvalidPage);
+}
+
+TEST(PoolAllocator, SlotsDoNotOverlap)
+{
+	// 1ページに4スロット入る大きさで、3ページにまたがって確保する
+	PoolAllocator allocator;
+	allocator.Initialize(4096, 256);
+	std::vector<PoolAllocator::Allocation> allocations;
+	for (uint32_t i = 0; i < 10; ++i) {
+		allocations.push_back(allocator.Allocate(1024));
+	}
+	CHECK(allocator.GetPageCount() == 3);
+	for (size_t a = 0; a < allocations.size(); ++a) {
+		CHECK(allocations[a].offset % 1024 == 0 && allocations[a].offset + 1024 <= 4096);
+		for (size_t b = a + 1; b < allocations.size(); ++b) {
+			CHECK(allocations[a].page != allocations[b].page || allocations[a].offset != allocations[b].offset);
+		}
+	}
+	CHECK(allocator.GetUsedSlotCount() == 10);
+}
+
+TEST(PoolAllocator, ReusesFreedSlotsAndEmptyPages)
+{
+	PoolAllocator allocator;
+	allocator.Initialize(4096, 256);
+	PoolAllocator::Allocation first = allocator.Allocate(1024);
+	allocator.Allocate(1024);
+
+	// 解放したスロットをすぐに再利用する
+	allocator.Free(first);
+	PoolAllocator::Allocation reused = allocator.Allocate(1024);
+	CHECK(reused.page == first.page && reused.offset == first.offset);
+
+	// 2ページ目を埋めてから全て解放すると、空いたページを別の大きさに使う
+	std::vector<PoolAllocator::Allocation> allocations;
+	for (uint32_t i = 0; i < 4; ++i) {
+		allocations.push_back(allocator.Allocate(1024));
+	}
+	CHECK(allocator.GetPageCount() == 2);
+	for (const PoolAllocator::Allocation& allocation : allocations) {
+		allocator.Free(allocation);
+	}
+	PoolAllocator::Allocation other = allocator.Allocate(256);
+	CHECK(allocator.GetPageCount() == 2);
+	CHECK(other.page == allocations.back().page);
+	CHECK(allocator.GetUsedSlotCount() == 3);
+}
@@ -0,0 +1,303 @@
+#include <random>
+#include <string>
+#include <vector>
+
+// MyClass
+#include "TestFramework.h"
+#include "RenderGraph.h"
+
+namespace {
+	// コンパイルしたRenderGraphのバリアを順に適用し、各パスが宣言した状態でリソースを使えて、最後の状態に戻るか確かめる
+	bool IsValidSchedule(const RenderGraph& graph)
+	{
+		std::vector<ResourceState> states(graph.GetResourceCount());
+		std::vector<bool> isPending(graph.GetResourceCount(), false);
+		// 一時的なリソースは、メモリを切り替えてからほかのリソースに切り替えられるまでの間だけ使える
+		std::vector<bool> isActive(graph.GetResourceCount(), true);
+		for (uint32_t resource = 0; resource < graph.GetResourceCount(); ++resource) {
+			states[resource] = graph.GetInitialState(resource);
+			isActive[resource] = !graph.IsTransient(resource);
+		}
+		auto isOverlapped = [&](uint32_t a, uint32_t b) {
+			uint64_t offsetA = graph.GetHeapOffset(a);
+			uint64_t offsetB = graph.GetHeapOffset(b);
+			return graph.GetHeapIndex(a) == graph.GetHeapIndex(b) &&
+				offsetA < offsetB + graph.GetTransientDesc(b).size && offsetB < offsetA + graph.GetTransientDesc(a).size;
+		};
+
+		for (const RenderGraphStep& step : graph.GetSchedule()) {
+			for (const RenderGraphBarrier& barrier : step.barriers) {
+				uint32_t resource = barrier.resource;
+				if (barrier.type == BarrierType::Aliasing) {
+					if (!graph.IsPlaced(resource) || isPending[resource] || isActive[resource]) {
+						return false;
+					}
+					for (uint32_t other = 0; other < graph.GetResourceCount(); ++other) {
+						if (other != resource && graph.IsPlaced(other) && isOverlapped(resource, other)) {
+							// 切り替えられるリソースは遷移の途中であってはならない
+							if (isActive[other] && isPending[other]) {
+								return false;
+							}
+							isActive[other] = false;
+						}
+					}
+					isActive[resource] = true;
+					continue;
+				}
+				if (!isActive[resource]) {
+					return false;
+				}
+				if (barrier.type == BarrierType::Uav) {
+					if (isPending[resource] || states[resource] != ResourceState::UnorderedAccess) {
+						return false;
+					}
+					continue;
+				}
+				// 分割したバリアの後半だけは、遷移の途中である必要がある
+				if (isPending[resource] != (barrier.split == BarrierSplit::End) || states[resource] != barrier.before) {
+					return false;
+				}
+				isPending[resource] = barrier.split == BarrierSplit::Begin;
+				if (barrier.split != BarrierSplit::Begin) {
+					states[resource] = barrier.after;
+				}
+			}
+			if (step.pass == RenderGraph::kInvalidPass) {
+				continue;
+			}
+			for (const RenderGraph::Usage& usage : graph.GetUsages(step.pass)) {
+				ResourceState state = states[usage.resource];
+				if (!isActive[usage.resource] || isPending[usage.resource] || (usage.isWrite ? state != usage.state : (state & usage.state) != usage.state)) {
+					return false;
+				}
+			}
+		}
+
+		for (uint32_t resource = 0; resource < graph.GetResourceCount(); ++resource) {
+			if (isPending[resource] || states[resource] != graph.GetFinalState(resource)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// 4つの設定の全ての組み合わせ
+	std::vector<RenderGraphCompileOptions> GetAllOptions()
+	{
+		std::vector<RenderGraphCompileOptions> options;
+		for (uint32_t bits = 0; bits < 16; ++bits) {
+			options.push_back({ (bits & 1) != 0, (bits & 2) != 0, (bits & 4) != 0, (bits & 8) != 0 });
+		}
+		return options;
+	}
+
+	// パスの前のバリアのうち、resourceの遷移を探す（無ければnullptr）
+	const RenderGraphBarrier* FindTransition(const RenderGraph& graph, const std::string& passName, uint32_t resource)
+	{
+		for (const RenderGraphStep& step : graph.GetSchedule()) {
+			if (step.pass == RenderGraph::kInvalidPass || graph.GetPassName(step.pass) != passName) {
+				continue;
+			}
+			for (const RenderGraphBarrier& barrier : step.barriers) {
+				if (barrier.type == BarrierType::Transition && barrier.resource == resource) {
+					return &barrier;
+				}
+			}
+		}
+		return nullptr;
+	}
+}
+
+TEST(RenderGraph, ExampleGraphStatesAreCorrectAtEveryPass)
+{
+	// 影、GBuffer、ライティング、ブルーム、ポストエフェクト、UIと、どこからも読まれないデバッグ表示
+	RenderGraph graph;
+	uint32_t backBuffer = graph.ImportResource("BackBuffer", nullptr, ResourceState::Present, ResourceState::Present);
+	uint32_t depth = graph.ImportResource("Depth", nullptr, ResourceState::DepthWrite, ResourceState::DepthWrite, false);
+	uint32_t shadowMap = graph.ImportResource("ShadowMap", nullptr, ResourceState::PixelShaderResource, ResourceState::PixelShaderResource, false);
+	uint32_t gBuffer = graph.ImportResource("GBuffer", nullptr, ResourceState::RenderTarget, ResourceState::RenderTarget, false);
+	uint32_t lighting = graph.ImportResource("Lighting", nullptr, ResourceState::UnorderedAccess, ResourceState::UnorderedAccess, false);
+	uint32_t debugView = graph.ImportResource("DebugView", nullptr, ResourceState::RenderTarget, ResourceState::RenderTarget, false);
+
+	uint32_t pass = graph.AddPass("Shadow", nullptr);
+	graph.Write(pass, shadowMap, ResourceState::DepthWrite);
+	pass = graph.AddPass("GBuffer", nullptr);
+	graph.Write(pass, gBuffer, ResourceState::RenderTarget);
+	graph.Write(pass, depth, ResourceState::DepthWrite);
+	pass = graph.AddPass("Lighting", nullptr);
+	graph.Read(pass, gBuffer, ResourceState::NonPixelShaderResource);
+	graph.Read(pass, shadowMap, ResourceState::NonPixelShaderResource);
+	graph.Read(pass, depth, ResourceState::DepthRead);
+	graph.Write(pass, lighting, ResourceState::UnorderedAccess);
+	pass = graph.AddPass("Bloom", nullptr);
+	graph.Read(pass, lighting, ResourceState::UnorderedAccess);
+	graph.Write(pass, lighting, ResourceState::UnorderedAccess);
+	uint32_t debugPass = graph.AddPass("Debug", nullptr);
+	graph.Read(debugPass, gBuffer, ResourceState::PixelShaderResource);
+	graph.Write(debugPass, debugView, ResourceState::RenderTarget);
+	pass = graph.AddPass("Post", nullptr);
+	graph.Read(pass, lighting, ResourceState::PixelShaderResource);
+	graph.Read(pass, depth, ResourceState::PixelShaderResource);
+	graph.Write(pass, backBuffer, ResourceState::RenderTarget);
+	pass = graph.AddPass("UI", nullptr);
+	graph.Read(pass, backBuffer, ResourceState::RenderTarget);
+	graph.Write(pass, backBuffer, ResourceState::RenderTarget);
+
+	for (const RenderGraphCompileOptions& options : GetAllOptions()) {
+		graph.Compile(options);
+		CHECK(IsValidSchedule(graph));
+		// 出力に影響しないデバッグ表示だけを省く
+		CHECK(graph.IsCulled(debugPass) == options.cullPasses);
+		CHECK(graph.GetSchedule().back().pass == RenderGraph::kInvalidPass);
+	}
+
+	graph.Compile();
+	// 続けて読むLightingとPostの深度は、1回の遷移で両方の読み取りの状態にする
+	const RenderGraphBarrier* depthRead = FindTransition(graph, "Lighting", depth);
+	CHECK(depthRead && depthRead->after == (ResourceState::DepthRead | ResourceState::PixelShaderResource));
+	CHECK(!FindTransition(graph, "Post", depth));
+	// BloomはUAVへの書き込みを待つだけで遷移しない
+	CHECK(!FindTransition(graph, "Bloom", lighting));
+	// BackBufferは最初のパスで遷移を始め、書き込むPostの前で終える
+	const RenderGraphBarrier* backBufferBegin = FindTransition(graph, "Shadow", backBuffer);
+	const RenderGraphBarrier* backBufferEnd = FindTransition(graph, "Post", backBuffer);
+	CHECK(backBufferBegin && backBufferBegin->split == BarrierSplit::Begin);
+	CHECK(backBufferEnd && backBufferEnd->split == BarrierSplit::End);
+	CHECK(graph.GetBatchCount() == 7);
+}
+
+TEST(RenderGraph, SideEffectPassIsNotCulled)
+{
+	RenderGraph graph;
+	uint32_t backBuffer = graph.ImportResource("BackBuffer", nullptr, ResourceState::Present, ResourceState::Present);
+	uint32_t scratch = graph.ImportResource("Scratch", nullptr, ResourceState::UnorderedAccess, ResourceState::UnorderedAccess, false);
+	uint32_t unused = graph.AddPass("Unused", nullptr);
+	graph.Write(unused, scratch, ResourceState::UnorderedAccess);
+	uint32_t capture = graph.AddPass("Capture", nullptr, true);
+	graph.Write(capture, scratch, ResourceState::UnorderedAccess);
+	uint32_t draw = graph.AddPass("Draw", nullptr);
+	graph.Write(draw, backBuffer, ResourceState::RenderTarget);
+
+	graph.Compile();
+	CHECK(graph.IsCulled(unused));
+	CHECK(!graph.IsCulled(capture));
+	CHECK(!graph.IsCulled(draw));
+	CHECK(IsValidSchedule(graph));
+}
+
+TEST(RenderGraph, RandomGraphsAreValidWithEveryOption)
+{
+	// 最初の2つのリソースが出力で、残りの半分は一時的なリソース（書き込まれた後にだけ読む）
+	const uint32_t kResourceCount = 24;
+	const uint32_t kPassCount = 60;
+	const ResourceState kReadStates[] = { ResourceState::PixelShaderResource, ResourceState::NonPixelShaderResource, ResourceState::CopySource, ResourceState::DepthRead };
+	const ResourceState kWriteStates[] = { ResourceState::RenderTarget, ResourceState::UnorderedAccess, ResourceState::CopyDest, ResourceState::DepthWrite };
+	std::mt19937 random(3);
+	std::vector<RenderGraphCompileOptions> allOptions = GetAllOptions();
+	bool isAlwaysValid = true;
+	bool hasAliased = false;
+	for (uint32_t graphIndex = 0; graphIndex < 100; ++graphIndex) {
+		RenderGraph graph;
+		std::vector<bool> isWritten(kResourceCount, true);
+		for (uint32_t resource = 0; resource < kResourceCount; ++resource) {
+			if (resource >= 2 && resource % 2 == 0) {
+				ResourceState state = random() % 2 ? ResourceState::RenderTarget : ResourceState::DepthWrite;
+				graph.CreateTransientResource("Transient" + std::to_string(resource), { 256, 256, 0, state, uint64_t(1 + random() % 4) * 64 * 1024, 64 * 1024 });
+				isWritten[resource] = false;
+				continue;
+			}
+			ResourceState state = resource < 2 ? ResourceState::Present : kWriteStates[random() % 4];
+			graph.ImportResource("Resource" + std::to_string(resource), nullptr, state, state, resource < 2);
+		}
+		for (uint32_t i = 0; i < kPassCount; ++i) {
+			uint32_t pass = graph.AddPass("Pass" + std::to_string(i), nullptr);
+			uint32_t writeResource = random() % kResourceCount;
+			uint32_t readCount = 1 + random() % 3;
+			for (uint32_t j = 0; j < readCount; ++j) {
+				uint32_t resource = random() % kResourceCount;
+				if (resource != writeResource && isWritten[resource]) {
+					graph.Read(pass, resource, kReadStates[random() % 4]);
+				}
+			}
+			graph.Write(pass, writeResource, kWriteStates[random() % 4]);
+			isWritten[writeResource] = true;
+		}
+
+		for (const RenderGraphCompileOptions& options : allOptions) {
+			graph.Compile(options);
+			isAlwaysValid = isAlwaysValid && IsValidSchedule(graph);
+			hasAliased = hasAliased || (options.aliasTransients && graph.GetAliasingPlan().GetSavedSize() > 0);
+		}
+	}
+	CHECK(isAlwaysValid);
+	CHECK(hasAliased);
+}
+
+TEST(RenderGraph, PostChainAliasesTransientsWithBarriers)
+{
+	// 1920x1080のポストエフェクトの連鎖（前のパスの結果を読んで次の一時的なリソースに書き込む）
+	const uint64_t kFullSize = (1920ull * 1080 * 8 + 65535) / 65536 * 65536;
+	RenderGraph graph;
+	uint32_t backBuffer = graph.ImportResource("BackBuffer", nullptr, ResourceState::Present, ResourceState::Present);
+	std::vector<uint32_t> transients;
+	transients.push_back(graph.CreateTransientResource("Scene", { 1920, 1080, 0, ResourceState::RenderTarget, kFullSize, 64 * 1024 }));
+	uint32_t pass = graph.AddPass("Scene", nullptr);
+	graph.Write(pass, transients.back(), ResourceState::RenderTarget);
+	const char* kPostNames[] = { "Bloom", "DepthOfField", "MotionBlur", "ToneMap" };
+	for (const char* name : kPostNames) {
+		uint32_t target = graph.CreateTransientResource(name, { 1920, 1080, 0, ResourceState::RenderTarget, kFullSize, 64 * 1024 });
+		pass = graph.AddPass(name, nullptr);
+		graph.Read(pass, transients.back(), ResourceState::PixelShaderResource);
+		graph.Write(pass, target, ResourceState::RenderTarget);
+		transients.push_back(target);
+	}
+	pass = graph.AddPass("Copy", nullptr);
+	graph.Read(pass, transients.back(), ResourceState::PixelShaderResource);
+	graph.Write(pass, backBuffer, ResourceState::RenderTarget);
+
+	// 専用のメモリでは5枚分、共有すると隣り合うパスの2枚分で済む
+	RenderGraphCompileOptions options;
+	options.aliasTransients = false;
+	graph.Compile(options);
+	CHECK(IsValidSchedule(graph));
+	CHECK(graph.GetAliasingPlan().GetTotalSize() == kFullSize * 5);
+	graph.Compile();
+	CHECK(IsValidSchedule(graph));
+	const AliasingPlan& plan = graph.GetAliasingPlan();
+	CHECK(plan.slotSizes.size() == 2);
+	CHECK(plan.GetTotalSize() == kFullSize * 2);
+
+	// 手順はパスと同じ順（Scene、ポストエフェクト4つ、Copy、最後の手順）
+	const std::vector<RenderGraphStep>& schedule = graph.GetSchedule();
+	CHECK(schedule.size() == 7);
+	for (size_t i = 0; i < transients.size(); ++i) {
+		uint32_t resource = transients[i];
+		CHECK(graph.IsPlaced(resource));
+		// 最初に使う手順でメモリを切り替える
+		bool hasAliasingBarrier = false;
+		for (const RenderGraphBarrier& barrier : schedule[i].barriers) {
+			hasAliasingBarrier = hasAliasingBarrier || (barrier.type == BarrierType::Aliasing && barrier.resource == resource);
+		}
+		CHECK(hasAliasingBarrier);
+
+		// 最後に使った手順の次で作った時の状態に戻し、同じメモリを次に使うリソースの切り替えより前に置く
+		const std::vector<RenderGraphBarrier>& barriers = schedule[i + 2].barriers;
+		size_t transition = barriers.size();
+		size_t aliasing = barriers.size();
+		for (size_t b = 0; b < barriers.size(); ++b) {
+			if (barriers[b].type == BarrierType::Transition && barriers[b].resource == resource) {
+				transition = b;
+			}
+			if (barriers[b].type == BarrierType::Aliasing && i + 2 < transients.size() && barriers[b].resource == transients[i + 2]) {
+				aliasing = b;
+			}
+		}
+		CHECK(transition < barriers.size());
+		if (transition < barriers.size()) {
+			CHECK(barriers[transition].before == ResourceState::PixelShaderResource);
+			CHECK(barriers[transition].after == ResourceState::RenderTarget);
+			CHECK(barriers[transition].split == BarrierSplit::None);
+		}
+		CHECK(i + 2 >= transients.size() || (aliasing < barriers.size() && transition < aliasing && plan.slots[i] == plan.slots[i + 2]));
+	}
+}
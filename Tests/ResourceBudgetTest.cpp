@@ -0,0 +1,98 @@
+#include <cstdint>
+#include <vector>
+
+// MyClass
+#include "TestFramework.h"
+#include "ResourceBudget.h"
+
+// ResourceBudgetはシングルトンなので、各テストは記録したリソースを全て消し、予算を戻してから終える
+
+TEST(ResourceBudget, TracksUsagePerCategory)
+{
+	ResourceBudget& budget = ResourceBudget::GetInstance();
+	uint64_t textureUsage = budget.GetUsage(ResourceCategory::Texture);
+	uint64_t meshUsage = budget.GetUsage(ResourceCategory::Mesh);
+	uint64_t totalUsage = budget.GetTotalUsage();
+	size_t allocationCount = budget.GetAllocationCount();
+
+	uint64_t texture = budget.Register(ResourceCategory::Texture, 4096);
+	uint64_t mesh = budget.Register(ResourceCategory::Mesh, 1024);
+	CHECK(texture != ResourceBudget::kInvalidId && mesh != ResourceBudget::kInvalidId && texture != mesh);
+	CHECK(budget.GetUsage(ResourceCategory::Texture) == textureUsage + 4096);
+	CHECK(budget.GetUsage(ResourceCategory::Mesh) == meshUsage + 1024);
+	CHECK(budget.GetTotalUsage() == totalUsage + 4096 + 1024);
+	CHECK(budget.GetAllocationCount() == allocationCount + 2);
+
+	// 解放すると使用量は戻るが、最大の使用量は残る
+	budget.Unregister(texture);
+	CHECK(budget.GetUsage(ResourceCategory::Texture) == textureUsage);
+	CHECK(budget.GetPeak(ResourceCategory::Texture) >= textureUsage + 4096);
+	CHECK(budget.GetTotalPeak() >= totalUsage + 4096 + 1024);
+	budget.Unregister(mesh);
+	CHECK(budget.GetTotalUsage() == totalUsage);
+	CHECK(budget.GetAllocationCount() == allocationCount);
+}
+
+TEST(ResourceBudget, EvictsOldestCacheEntriesOverBudget)
+{
+	ResourceBudget& budget = ResourceBudget::GetInstance();
+	uint64_t previousBudget = budget.GetBudget();
+	uint64_t baseUsage = budget.GetTotalUsage();
+
+	// 1KBのキャッシュを3つ登録し、2つ分しか入らない予算にする
+	std::vector<uint64_t> allocationIds;
+	std::vector<uint32_t> evictedOrder;
+	for (uint32_t i = 0; i < 3; ++i) {
+		allocationIds.push_back(budget.Register(ResourceCategory::Texture, 1024));
+		budget.AddCacheEntry({ allocationIds.back() }, [&evictedOrder, i]() { evictedOrder.push_back(i); });
+	}
+	budget.SetBudget(baseUsage + 2048);
+
+	// 古い順に1つ追い出すと予算に収まる
+	CHECK(budget.Enforce() == 1);
+	CHECK(evictedOrder.size() == 1 && evictedOrder[0] == 0);
+	// 解放待ちの分は既に減ったものとして扱うので、GPUが使い終わる前に続けて呼んでも追い出さない
+	CHECK(budget.Enforce() == 0);
+	budget.Unregister(allocationIds[0]);
+	CHECK(budget.GetTotalUsage() == baseUsage + 2048);
+
+	// 予算を下げると、残りも古い順に追い出す
+	budget.SetBudget(baseUsage);
+	CHECK(budget.Enforce() == 2);
+	CHECK(evictedOrder.size() == 3 && evictedOrder[1] == 1 && evictedOrder[2] == 2);
+	CHECK(budget.Enforce() == 0);
+
+	budget.Unregister(allocationIds[1]);
+	budget.Unregister(allocationIds[2]);
+	budget.SetBudget(previousBudget);
+	CHECK(budget.GetTotalUsage() == baseUsage);
+}
+
+TEST(ResourceBudget, ReusedCacheEntryIsNotEvicted)
+{
+	ResourceBudget& budget = ResourceBudget::GetInstance();
+	uint64_t previousBudget = budget.GetBudget();
+	uint64_t baseUsage = budget.GetTotalUsage();
+
+	uint64_t older = budget.Register(ResourceCategory::Mesh, 1024);
+	uint64_t newer = budget.Register(ResourceCategory::Mesh, 1024);
+	bool isOlderEvicted = false;
+	bool isNewerEvicted = false;
+	uint64_t olderEntry = budget.AddCacheEntry({ older }, [&isOlderEvicted]() { isOlderEvicted = true; });
+	budget.AddCacheEntry({ newer }, [&isNewerEvicted]() { isNewerEvicted = true; });
+
+	// 再び使われたキャッシュは外れるので、古くても追い出さない
+	budget.RemoveCacheEntry(olderEntry);
+	budget.SetBudget(baseUsage + 1024);
+	CHECK(budget.Enforce() == 1);
+	CHECK(!isOlderEvicted && isNewerEvicted);
+
+	// 外れたキャッシュしかなければ、予算を超えていても追い出せない
+	budget.SetBudget(baseUsage);
+	CHECK(budget.Enforce() == 0);
+
+	budget.Unregister(older);
+	budget.Unregister(newer);
+	budget.SetBudget(previousBudget);
+	CHECK(budget.GetTotalUsage() == baseUsage);
+}
@@ -0,0 +1,59 @@
+// MyClass
+#include "TestFramework.h"
+#include "RingAllocator.h"
+
+TEST(RingAllocator, AlignsAndFailsWhenFull)
+{
+	RingAllocator allocator;
+	allocator.Initialize(1024);
+	CHECK(allocator.Allocate(300, 256) == 0);
+	// アラインメントで飛ばした分も使用中になる
+	CHECK(allocator.Allocate(300, 256) == 512);
+	CHECK(allocator.GetUsedSize() == 812);
+	allocator.Submit(1);
+
+	// 末尾に収まらず、先頭はまだGPUが使っている
+	CHECK(allocator.Allocate(300, 256) == RingAllocator::kInvalidOffset);
+	CHECK(allocator.Allocate(2048, 256) == RingAllocator::kInvalidOffset);
+	CHECK(allocator.GetOldestFenceValue() == 1);
+}
+
+TEST(RingAllocator, FreesOnlyAfterFence)
+{
+	RingAllocator allocator;
+	allocator.Initialize(1024);
+	allocator.Allocate(1024, 256);
+	allocator.Submit(1);
+
+	allocator.Retire(0);
+	CHECK(allocator.GetUsedSize() == 1024);
+	CHECK(allocator.Allocate(256, 256) == RingAllocator::kInvalidOffset);
+
+	allocator.Retire(1);
+	CHECK(allocator.GetUsedSize() == 0);
+	CHECK(allocator.GetOldestFenceValue() == 0);
+	CHECK(allocator.Allocate(256, 256) == 0);
+}
+
+TEST(RingAllocator, WrapsAroundBehindLiveAllocation)
+{
+	RingAllocator allocator;
+	allocator.Initialize(1024);
+	CHECK(allocator.Allocate(400, 256) == 0);
+	allocator.Submit(1);
+	uint64_t live = allocator.Allocate(400, 256);
+	CHECK(live == 512);
+	allocator.Submit(2);
+
+	// フレーム1の領域だけが空き、末尾に収まらないので先頭に折り返す
+	allocator.Retire(1);
+	uint64_t wrapped = allocator.Allocate(300, 256);
+	CHECK(wrapped == 0);
+	CHECK(wrapped + 300 <= live);
+	// フレーム2のアラインメントで飛ばした112バイトと、折り返しで飛ばした末尾の112バイトも使用中になる
+	CHECK(allocator.GetUsedSize() == 112 + 400 + 112 + 300);
+	allocator.Submit(3);
+
+	allocator.Retire(3);
+	CHECK(allocator.GetUsedSize() == 0);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <vector>
+
+// GPUとウィンドウに依存しないエンジンのクラスの単体テスト
+// TESTで登録した関数をTestMainが順に実行し、CHECKが1つでも失敗すれば終了コードを1にする
+
+// 登録されたテスト
+struct TestCase {
+	const char* suite;
+	const char* name;
+	void (*function)();
+};
+
+// 登録されたテストの一覧
+std::vector<TestCase>& GetTestCases();
+// 検査に失敗したことを記録する（テストは最後まで続ける）
+void ReportTestFailure(const char* expression, const char* file, int line);
+
+// 静的な初期化でテストを登録する
+struct TestRegistrar {
+	TestRegistrar(const char* suite, const char* name, void (*function)()) { GetTestCases().push_back({ suite, name, function }); }
+};
+
+#define TEST(suite, name) \
+	static void suite##_##name(); \
+	static TestRegistrar suite##_##name##_registrar(#suite, #name, suite##_##name); \
+	static void suite##_##name()
+
+// 式がfalseの場合に失敗を記録する（assertと違ってリリースビルドでも検査する）
+#define CHECK(expression) ((expression) ? (void)0 : ReportTestFailure(#expression, __FILE__, __LINE__))
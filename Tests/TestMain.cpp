@@ -0,0 +1,46 @@
+#include <cstdio>
+#include <cstring>
+
+// MyClass
+#include "TestFramework.h"
+
+namespace {
+	// 実行中のテストで失敗した検査の数
+	int failureCount = 0;
+}
+
+std::vector<TestCase>& GetTestCases()
+{
+	static std::vector<TestCase> testCases;
+
+	return testCases;
+}
+
+void ReportTestFailure(const char* expression, const char* file, int line)
+{
+	std::printf("  %s(%d): CHECK(%s) failed\n", file, line, expression);
+	failureCount++;
+}
+
+// 引数にスイート名を指定すると、そのスイートのテストだけを実行する
+int main(int argc, char* argv[])
+{
+	const char* suiteFilter = argc > 1 ? argv[1] : nullptr;
+
+	int runCount = 0;
+	int failedCount = 0;
+	for (const TestCase& testCase : GetTestCases()) {
+		if (suiteFilter && std::strcmp(testCase.suite, suiteFilter) != 0) {
+			continue;
+		}
+		failureCount = 0;
+		testCase.function();
+		std::printf("%s %s.%s\n", failureCount == 0 ? "[  OK  ]" : "[FAILED]", testCase.suite, testCase.name);
+		runCount++;
+		failedCount += failureCount != 0;
+	}
+
+	std::printf("%d tests, %d failed\n", runCount, failedCount);
+	// スイート名を間違えた場合に、何も実行せずに成功しないようにする
+	return runCount > 0 && failedCount == 0 ? 0 : 1;
+}
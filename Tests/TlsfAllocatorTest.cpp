@@ -0,0 +1,184 @@
+#include <cmath>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+// MyClass
+#include "TestFramework.h"
+#include "TlsfAllocator.h"
+
+namespace {
+	// 使用中の範囲（オフセット -> サイズとアラインメント）
+	using AllocationMap = std::map<uint64_t, std::pair<uint64_t, uint64_t>>;
+
+	// 使用中の範囲が重ならず、アラインメントに揃っていて、領域に収まっているか
+	bool IsValidLayout(const AllocationMap& allocations, uint64_t capacity)
+	{
+		uint64_t end = 0;
+		for (const auto& [offset, allocation] : allocations) {
+			if (offset < end || offset % allocation.second != 0) {
+				return false;
+			}
+			end = offset + allocation.first;
+		}
+		return end <= capacity;
+	}
+
+	// 256バイト～1MBのサイズと256バイト～64KBのアラインメントで、確保を少し多くして確保と解放を繰り返す（固定のシード）
+	void RunRandomOperations(TlsfAllocator& allocator, AllocationMap& allocations, uint32_t operationCount, bool& isAlwaysValid)
+	{
+		std::mt19937 random(2024);
+		std::vector<uint64_t> offsets;
+		for (uint32_t i = 0; i < operationCount; ++i) {
+			bool isAllocate = random() % 100 < 55;
+			uint64_t size = uint64_t(std::exp2(std::uniform_real_distribution<double>(8.0, 20.0)(random)));
+			uint64_t alignment = uint64_t(1) << (8 + random() % 9);
+			uint32_t freeIndex = uint32_t(random());
+			if (isAllocate || offsets.empty()) {
+				uint64_t offset = allocator.Allocate(size, alignment);
+				if (offset == TlsfAllocator::kInvalidOffset) {
+					continue;
+				}
+				offsets.push_back(offset);
+				allocations[offset] = { size, alignment };
+			} else {
+				size_t index = freeIndex % offsets.size();
+				allocator.Free(offsets[index]);
+				allocations.erase(offsets[index]);
+				offsets[index] = offsets.back();
+				offsets.pop_back();
+			}
+			isAlwaysValid = isAlwaysValid && IsValidLayout(allocations, allocator.GetCapacity()) && allocations.size() == allocator.GetAllocationCount();
+		}
+	}
+}
+
+TEST(TlsfAllocator, AllocationsDoNotOverlapAndAreAligned)
+{
+	const uint64_t kCapacity = 64 * 1024 * 1024;
+	TlsfAllocator allocator;
+	allocator.Initialize(kCapacity, 256);
+	AllocationMap allocations;
+	bool isAlwaysValid = true;
+	RunRandomOperations(allocator, allocations, 20000, isAlwaysValid);
+	CHECK(isAlwaysValid);
+
+	// 使用中のサイズは、確保したサイズを単位に切り上げた合計
+	uint64_t usedSize = 0;
+	for (const auto& [offset, allocation] : allocations) {
+		usedSize += (allocation.first + 255) / 256 * 256;
+	}
+	CHECK(allocator.GetUsedSize() == usedSize);
+	CHECK(allocator.GetUsedSize() + allocator.GetFreeSize() == kCapacity);
+}
+
+TEST(TlsfAllocator, CoalescesNeighbouringFreeBlocks)
+{
+	TlsfAllocator allocator;
+	allocator.Initialize(4096, 256);
+	uint64_t first = allocator.Allocate(1024, 256);
+	uint64_t second = allocator.Allocate(1024, 256);
+	uint64_t third = allocator.Allocate(1024, 256);
+	CHECK(first == 0 && second == 1024 && third == 2048);
+
+	// 後ろの空きとつながる
+	allocator.Free(third);
+	CHECK(allocator.GetLargestFreeBlock() == 2048);
+	// 間に使用中があるのでつながらない
+	allocator.Free(first);
+	CHECK(allocator.GetLargestFreeBlock() == 2048);
+	CHECK(allocator.GetFragmentation() > 0.0f);
+	// 前後の両方とつながって1つに戻る
+	allocator.Free(second);
+	CHECK(allocator.GetLargestFreeBlock() == 4096);
+	CHECK(allocator.GetFragmentation() == 0.0f);
+	CHECK(allocator.Allocate(4096, 256) == 0);
+}
+
+TEST(TlsfAllocator, ExactFit)
+{
+	TlsfAllocator allocator;
+	allocator.Initialize(4096, 256);
+	CHECK(allocator.Allocate(4096, 256) == 0);
+	CHECK(allocator.Allocate(1, 256) == TlsfAllocator::kInvalidOffset);
+	allocator.Free(0);
+
+	// 単位ちょうどのブロックで領域を隙間なく埋められる
+	for (uint64_t i = 0; i < 16; ++i) {
+		CHECK(allocator.Allocate(256, 256) == i * 256);
+	}
+	CHECK(allocator.GetFreeSize() == 0);
+	CHECK(allocator.Allocate(256, 256) == TlsfAllocator::kInvalidOffset);
+	CHECK(allocator.Allocate(0, 256) == TlsfAllocator::kInvalidOffset);
+}
+
+TEST(TlsfAllocator, FenceDeferredFree)
+{
+	TlsfAllocator allocator;
+	allocator.Initialize(4096, 256);
+	uint64_t offset = allocator.Allocate(4096, 256);
+	allocator.Free(offset, 5);
+
+	// Fenceに到達するまでは使用中のまま
+	allocator.Retire(4);
+	CHECK(allocator.GetAllocationCount() == 1);
+	CHECK(allocator.GetPendingFreeCount() == 1);
+	CHECK(allocator.Allocate(256, 256) == TlsfAllocator::kInvalidOffset);
+
+	allocator.Retire(5);
+	CHECK(allocator.GetAllocationCount() == 0);
+	CHECK(allocator.GetPendingFreeCount() == 0);
+	CHECK(allocator.Allocate(4096, 256) == 0);
+}
+
+TEST(TlsfAllocator, DefragmentDoesNotMovePendingFrees)
+{
+	TlsfAllocator allocator;
+	allocator.Initialize(4096, 256);
+	uint64_t first = allocator.Allocate(1024, 256);
+	uint64_t second = allocator.Allocate(1024, 256);
+	allocator.Free(first);
+	allocator.Free(second, 1);
+
+	// 前に空きがあっても、解放待ちの範囲はGPUが使っているので動かさない
+	CHECK(allocator.Defragment(SIZE_MAX).empty());
+	allocator.Retire(1);
+	CHECK(allocator.GetLargestFreeBlock() == 4096);
+}
+
+TEST(TlsfAllocator, DefragmentPlanIsValid)
+{
+	const uint64_t kCapacity = 64 * 1024 * 1024;
+	TlsfAllocator allocator;
+	allocator.Initialize(kCapacity, 256);
+	AllocationMap allocations;
+	bool isAlwaysValid = true;
+	RunRandomOperations(allocator, allocations, 20000, isAlwaysValid);
+	uint64_t largestFreeBlock = allocator.GetLargestFreeBlock();
+	size_t allocationCount = allocator.GetAllocationCount();
+
+	// 移動は後ろから前へ、サイズを変えずに行い、移した後の配置も重ならない
+	std::vector<TlsfAllocator::Move> moves = allocator.Defragment(SIZE_MAX);
+	CHECK(!moves.empty());
+	bool isValidMove = true;
+	for (const TlsfAllocator::Move& move : moves) {
+		auto allocation = allocations.extract(move.oldOffset);
+		isValidMove = isValidMove && !allocation.empty() && move.newOffset < move.oldOffset && move.size >= allocation.mapped().first;
+		if (!allocation.empty()) {
+			allocation.key() = move.newOffset;
+			allocations.insert(std::move(allocation));
+		}
+	}
+	CHECK(isValidMove);
+	CHECK(IsValidLayout(allocations, kCapacity));
+	CHECK(allocator.GetAllocationCount() == allocationCount);
+	CHECK(allocator.GetLargestFreeBlock() >= largestFreeBlock);
+
+	// 移した先のオフセットで解放できる
+	for (const auto& [offset, allocation] : allocations) {
+		allocator.Free(offset);
+	}
+	CHECK(allocator.GetUsedSize() == 0);
+	CHECK(allocator.GetLargestFreeBlock() == kCapacity);
+}
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <vector>
+
+// MyClass
+#include "TestFramework.h"
+#include "VirtualTexture.h"
+
+namespace {
+	// 間接参照テクスチャで、フィードバックのページが常駐している同じ位置のページ（またはその上のミップ）を指しているか
+	bool ResolvesToResidentPage(VirtualTextureSystem& system, const VirtualTextureLayout& layout, const VirtualPage& page)
+	{
+		uint32_t entry = system.GetIndirection(page.textureId, page.mip)[page.y * layout.GetPagesX(page.mip) + page.x];
+		uint32_t mip = (entry >> 16) & 0xff;
+		if ((entry >> 24) != 0xff || mip < page.mip || mip >= layout.GetMipLevels()) {
+			return false;
+		}
+		// 指しているミップでの位置（ミップの端ではページの数が半分より多く減ることがある）
+		VirtualPage resident = page;
+		for (; resident.mip < mip; ++resident.mip) {
+			resident.x = (std::min)(resident.x / 2, layout.GetPagesX(resident.mip + 1) - 1);
+			resident.y = (std::min)(resident.y / 2, layout.GetPagesY(resident.mip + 1) - 1);
+		}
+		uint32_t physicalPage = system.GetPhysicalPage(resident);
+		return physicalPage != VirtualTextureSystem::kInvalidId &&
+			system.GetPhysicalPageX(physicalPage) == (entry & 0xff) && system.GetPhysicalPageY(physicalPage) == ((entry >> 8) & 0xff);
+	}
+
+	// 画面の一部に見えているページのフィードバックを作る（ミップの中でページ単位の矩形）
+	void FillFeedback(std::vector<uint32_t>& feedback, uint32_t textureId, uint32_t mip, uint32_t left, uint32_t top, uint32_t pagesX, uint32_t pagesY)
+	{
+		feedback.assign(64 * 64, VirtualTextureSystem::kEmptyFeedback);
+		for (uint32_t y = 0; y < 64; ++y) {
+			for (uint32_t x = 0; x < 64; ++x) {
+				feedback[y * 64 + x] = VirtualTextureSystem::PackFeedback(textureId, mip, left + x * pagesX / 64, top + y * pagesY / 64);
+			}
+		}
+	}
+}
+
+TEST(VirtualTexture, LayoutSplitsIntoPagesUntilOnePage)
+{
+	VirtualTextureLayout layout(1000, 600, 128, 4);
+	CHECK(layout.GetTileSize() == 136);
+	CHECK(layout.GetMipLevels() == 4);
+	CHECK(layout.GetPagesX(0) == 8 && layout.GetPagesY(0) == 5);
+	CHECK(layout.GetPagesX(1) == 4 && layout.GetPagesY(1) == 3);
+	CHECK(layout.GetPagesX(2) == 2 && layout.GetPagesY(2) == 2);
+	CHECK(layout.GetPagesX(3) == 1 && layout.GetPagesY(3) == 1);
+	CHECK(layout.GetTotalPageCount() == 40 + 12 + 4 + 1);
+}
+
+TEST(VirtualTexture, ExtractTileRepeatsEdgesOutsideImage)
+{
+	// 4x4の画像を2x2のページに分け、1テクセルの縁を付ける
+	MipLevel level{ 4, 4, std::vector<uint8_t>(4 * 4 * 4) };
+	for (uint32_t i = 0; i < 16; ++i) {
+		level.pixels[i * 4] = uint8_t(i);
+	}
+	VirtualTextureLayout layout(4, 4, 2, 1);
+	std::vector<uint8_t> tile;
+	layout.ExtractTile(level, 0, 0, tile);
+	CHECK(tile.size() == 4 * 4 * 4);
+	// 左上の縁は画像の端の値を繰り返し、内側は元の画像と同じ
+	CHECK(tile[0] == 0 && tile[1 * 4] == 0 && tile[4 * 4] == 0);
+	CHECK(tile[(1 * 4 + 1) * 4] == 0 && tile[(1 * 4 + 2) * 4] == 1 && tile[(2 * 4 + 1) * 4] == 4);
+	// 右下の縁は隣のページのテクセル
+	CHECK(tile[(3 * 4 + 3) * 4] == 10);
+}
+
+TEST(VirtualTexture, PackFeedbackRoundTrips)
+{
+	uint32_t value = VirtualTextureSystem::PackFeedback(254, 15, 1023, 517);
+	CHECK(value != VirtualTextureSystem::kEmptyFeedback);
+	VirtualPage page = VirtualTextureSystem::UnpackFeedback(value);
+	CHECK(page.textureId == 254 && page.mip == 15 && page.x == 1023 && page.y == 517);
+}
+
+TEST(VirtualTexture, SampledPagesResolveToResidentPages)
+{
+	// 16384x16384（8ミップ）に対して物理ページが足りず、追い出しが起きる大きさにする
+	VirtualTextureLayout layout(16384, 16384, 128, 4);
+	VirtualTextureSystem system;
+	system.Initialize(16, 16);
+	uint32_t textureId = system.AddTexture(layout);
+
+	// 見える範囲とミップを変えながら、要求したページは1フレーム遅れで読み込みが終わる
+	std::vector<uint32_t> feedback;
+	std::vector<VirtualPage> loadingPages;
+	bool isAlwaysResolved = true;
+	for (uint32_t frame = 0; frame < 200; ++frame) {
+		uint32_t mip = frame / 10 % 4;
+		uint32_t pagesX = layout.GetPagesX(mip);
+		uint32_t visiblePages = (std::min)(pagesX, 12u);
+		uint32_t left = (frame * 3) % (pagesX - visiblePages + 1);
+		FillFeedback(feedback, textureId, mip, left, left, visiblePages, visiblePages);
+
+		for (const VirtualPage& page : loadingPages) {
+			system.CompleteLoad(page);
+		}
+		system.ProcessFeedback(feedback.data(), feedback.size());
+		loadingPages = system.PopRequests(8);
+
+		// 最も小さいミップが常駐した後は、どのページも常駐しているページを指している
+		if (frame > 0) {
+			for (uint32_t value : feedback) {
+				isAlwaysResolved = isAlwaysResolved && ResolvesToResidentPage(system, layout, VirtualTextureSystem::UnpackFeedback(value));
+			}
+		}
+	}
+	CHECK(isAlwaysResolved);
+	CHECK(system.GetEvictionCount() > 0);
+	CHECK(system.GetResidentPageCount() <= system.GetPhysicalPageCount());
+}
+
+TEST(VirtualTexture, ExactPagesBecomeResidentWhenViewIsStill)
+{
+	VirtualTextureLayout layout(4096, 4096, 128, 4);
+	VirtualTextureSystem system;
+	system.Initialize(16, 16);
+	uint32_t textureId = system.AddTexture(layout);
+
+	// 動かない画面で8x8ページを見続けると、要求が尽きて全てのテクセルで要求したページが常駐する
+	std::vector<uint32_t> feedback;
+	FillFeedback(feedback, textureId, 0, 4, 4, 8, 8);
+	std::vector<VirtualPage> loadingPages;
+	for (uint32_t frame = 0; frame < 40; ++frame) {
+		for (const VirtualPage& page : loadingPages) {
+			system.CompleteLoad(page);
+		}
+		system.ProcessFeedback(feedback.data(), feedback.size());
+		loadingPages = system.PopRequests(8);
+	}
+	CHECK(system.GetPendingRequestCount() == 0);
+	CHECK(system.GetFeedbackTexelCount() == feedback.size());
+	CHECK(system.GetResidentTexelCount() == feedback.size());
+	for (uint32_t value : feedback) {
+		VirtualPage page = VirtualTextureSystem::UnpackFeedback(value);
+		CHECK(((system.GetIndirection(textureId, 0)[page.y * layout.GetPagesX(0) + page.x] >> 16) & 0xff) == 0);
+	}
+}
+
+TEST(VirtualTexture, EvictsLeastRecentlyUsedPageButNotSmallestMip)
+{
+	// 256x256（ミップ0が2x2ページ、ミップ1が1ページ）に物理ページ2つ
+	VirtualTextureLayout layout(256, 256, 128, 0);
+	VirtualTextureSystem system;
+	system.Initialize(2, 1);
+	uint32_t textureId = system.AddTexture(layout);
+
+	// 最も小さいミップは最初に要求される
+	std::vector<VirtualPage> pages = system.PopRequests(8);
+	CHECK(pages.size() == 1 && pages[0].mip == 1);
+	uint32_t pinned = system.CompleteLoad(pages[0]);
+	CHECK(pinned != VirtualTextureSystem::kInvalidId);
+
+	std::vector<uint32_t> feedback = { VirtualTextureSystem::PackFeedback(textureId, 0, 0, 0) };
+	system.ProcessFeedback(feedback.data(), feedback.size());
+	pages = system.PopRequests(8);
+	CHECK(pages.size() == 1);
+	uint32_t first = system.CompleteLoad(pages[0]);
+	CHECK(first != VirtualTextureSystem::kInvalidId && first != pinned);
+
+	// 空きが無いので、前のフレームに使ったページを追い出して入れ替える
+	feedback = { VirtualTextureSystem::PackFeedback(textureId, 0, 1, 0) };
+	system.ProcessFeedback(feedback.data(), feedback.size());
+	pages = system.PopRequests(8);
+	CHECK(pages.size() == 1);
+	CHECK(system.CompleteLoad(pages[0]) == first);
+	CHECK(system.GetEvictionCount() == 1);
+	CHECK(system.GetPhysicalPage({ textureId, 0, 0, 0 }) == VirtualTextureSystem::kInvalidId);
+	CHECK(system.GetPhysicalPage({ textureId, 1, 0, 0 }) == pinned);
+
+	// このフレームで使われているページしか無ければ追い出さない
+	feedback = { VirtualTextureSystem::PackFeedback(textureId, 0, 1, 0), VirtualTextureSystem::PackFeedback(textureId, 0, 0, 0) };
+	system.ProcessFeedback(feedback.data(), feedback.size());
+	pages = system.PopRequests(8);
+	CHECK(pages.size() == 1);
+	CHECK(system.CompleteLoad(pages[0]) == VirtualTextureSystem::kInvalidId);
+	CHECK(system.GetEvictionCount() == 1);
+	CHECK(system.GetResidentPageCount() == 2);
+}
@@ -0,0 +1,77 @@
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+// MyClass
+#include "TestFramework.h"
+#include "WorkerPool.h"
+
+TEST(WorkerPool, RunsEveryIndexOnce)
+{
+	WorkerPool pool(4);
+	CHECK(pool.GetThreadCount() == 4);
+	for (size_t count : { size_t(0), size_t(1), size_t(3), size_t(1000) }) {
+		std::vector<std::atomic<uint32_t>> calls(count);
+		pool.ParallelFor(count, 0, [&](size_t index) { calls[index]++; });
+		bool isEachOnce = true;
+		for (const std::atomic<uint32_t>& call : calls) {
+			isEachOnce = isEachOnce && call == 1;
+		}
+		CHECK(isEachOnce);
+	}
+}
+
+TEST(WorkerPool, ReusesThreadsAcrossCalls)
+{
+	// 何度呼んでも、呼び出したスレッドとプールのスレッド以外では処理しない
+	WorkerPool pool(4);
+	std::mutex mutex;
+	std::set<std::thread::id> threadIds;
+	for (int frame = 0; frame < 100; ++frame) {
+		pool.ParallelFor(64, 0, [&](size_t) {
+			std::lock_guard<std::mutex> lock(mutex);
+			threadIds.insert(std::this_thread::get_id());
+		});
+	}
+	CHECK(threadIds.size() <= pool.GetThreadCount());
+	CHECK(threadIds.count(std::this_thread::get_id()) == 1);
+}
+
+TEST(WorkerPool, LimitsThreadCount)
+{
+	// 指定したスレッド数までしか同時に処理しない
+	WorkerPool pool(8);
+	for (uint32_t threadCount = 1; threadCount <= 8; threadCount *= 2) {
+		std::atomic<uint32_t> activeCount = 0;
+		std::atomic<uint32_t> maxActiveCount = 0;
+		pool.ParallelFor(256, threadCount, [&](size_t) {
+			uint32_t active = ++activeCount;
+			for (uint32_t observed = maxActiveCount; active > observed && !maxActiveCount.compare_exchange_weak(observed, active);) {
+			}
+			std::this_thread::yield();
+			activeCount--;
+		});
+		CHECK(maxActiveCount <= threadCount);
+	}
+}
+
+TEST(WorkerPool, SerializesCallsFromSeveralThreads)
+{
+	// 複数のスレッドから同時に呼んでも、それぞれの処理が全て行われる
+	WorkerPool pool(4);
+	std::atomic<size_t> total = 0;
+	std::vector<std::thread> callers;
+	for (int i = 0; i < 4; ++i) {
+		callers.emplace_back([&]() {
+			for (int frame = 0; frame < 50; ++frame) {
+				pool.ParallelFor(100, 0, [&](size_t) { total++; });
+			}
+		});
+	}
+	for (std::thread& caller : callers) {
+		caller.join();
+	}
+	CHECK(total == 4 * 50 * 100);
+}
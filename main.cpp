@@ -1,5 +1,13 @@
 #include <Windows.h>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <memory>
+#include <vector>
 #include <assert.h>
 
 // MyClass 
@@ -13,11 +21,18 @@
 #include "DescriptorHeap.h"
 #include "ImguiWrapper.h"
 #include "TextureManager.h"
+#include "TextureCooker.h"
+#include "TextureUploader.h"
+#include "ConstantBufferAllocator.h"
+#include "BufferHeapAllocator.h"
 #include "ModelManager.h"
 #include "ConstBuffer.h"
 #include "Object3D.h"
 #include "OutlinedObject.h"
 #include "Emitter.h"
+#include "Benchmark.h"
+#include "ParallelFor.h"
+#include "AssetHotReloader.h"
 
 struct DirectionalLight {
 	Float4 color; // ライトの色
@@ -26,40 +41,153 @@ struct DirectionalLight {
 };
 
 // Windowsアプリでのエントリーポイント(main関数)
-int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
+int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR lpCmdLine, int) {
 	D3DResourceLeakChecker::GetInstance();
 	DirectXBase* dxBase = nullptr;
 
 	// COMの初期化
 	CoInitializeEx(0, COINIT_MULTITHREADED);
-	 
-	// ウィンドウの生成
-	Window::Create(L"CG2WindowClass", 1280, 720);
 
-	// DirectX初期化処理
+	// 起動オプションに -headless が指定されていれば、ウィンドウもGPUも使わずに更新と描画のループをNフレーム（-headless=N。省略すると600）実行し、CPUのフレーム時間を計測する
+	std::string commandLine = lpCmdLine;
+	bool isHeadless = commandLine.find("-headless") != std::string::npos;
+	uint64_t headlessFrameCount = 600;
+	if (size_t position = commandLine.find("-headless="); position != std::string::npos) {
+		headlessFrameCount = std::strtoull(commandLine.c_str() + position + std::strlen("-headless="), nullptr, 10);
+	}
+
 	dxBase = DirectXBase::GetInstance();
-	dxBase->Initialize();
+	if (isHeadless) {
+		// ウィンドウの大きさだけを決め、描画は呼び出しを数えるだけにする
+		Window::CreateHeadless(1280, 720);
+		dxBase->InitializeHeadless();
+		// 定数データと定数バッファはCPUのメモリに書き込む
+		ConstantBufferAllocator::Initialize(nullptr);
+		ConstantBufferPool::Initialize(nullptr);
+	} else {
+		// ウィンドウの生成
+		Window::Create(L"CG2WindowClass", 1280, 720);
+
+		// DirectX初期化処理
+		dxBase->Initialize();
+
+		// バッファを置く大きなヒープ（以降のCreateBufferResourceはこの中に作られる）
+		BufferHeapAllocator::Initialize(dxBase->GetDevice());
+		// TextureManagerの初期化（srvHeapの生成）
+		TextureManager::Initialize(dxBase->GetDevice());
+		// Textureの転送に使うコピーキューとアップロード用のリングバッファを生成
+		TextureUploader::Initialize(dxBase->GetDevice(), dxBase->GetCommandQueue());
+		// 描画ごとの定数データを確保するページ
+		ConstantBufferAllocator::Initialize(dxBase->GetDevice());
+		// 長く使う定数バッファを切り出すページ
+		ConstantBufferPool::Initialize(dxBase->GetDevice());
+		// 大きなTextureは画面上の大きさに応じて詳細なミップを転送する
+		TextureManager::EnableMipStreaming(256ull * 1024 * 1024);
+		// 使われていないTextureとモデルは、GPUリソースの合計がこれを超えたら古い順に解放する
+		ResourceBudget::GetInstance().SetBudget(512ull * 1024 * 1024);
+		// モデルとテクスチャのファイルを監視し、変更されたら読み直す（パスごとに差し替えるので、読み込む前に開始する）
+		AssetHotReloader::Initialize({ "resources/Models", "resources/Images" }, dxBase->GetDevice());
+
+		// ImGuiの初期化
+		ImguiWrapper::Initialize(dxBase->GetDevice(), dxBase->GetFramesInFlight(), dxBase->GetRtvDesc().Format, TextureManager::GetInstance().srvHeap_.heap_.Get());
+	}
 
-	// TextureManagerの初期化（srvHeapの生成）
-	TextureManager::Initialize(dxBase->GetDevice());
+	// 起動オプションに -builtin-png が指定されていれば、PNGをWICではなく組み込みのデコーダでデコードする
+	if (commandLine.find("-builtin-png") != std::string::npos) {
+		TextureManager::SetImageDecoder(ImageDecoder::Builtin);
+	}
 
-	// ImGuiの初期化
-	ImguiWrapper::Initialize(dxBase->GetDevice(), dxBase->GetSwapChainDesc().BufferCount, dxBase->GetRtvDesc().Format, TextureManager::GetInstance().srvHeap_.heap_.Get());
+	// 起動オプション -fps=N でフレームレートを制限する（指定しなければ垂直同期だけで制限する。-novsync で垂直同期を待たない）
+	if (size_t position = commandLine.find("-fps="); position != std::string::npos) {
+		dxBase->SetTargetFrameRate(std::atof(commandLine.c_str() + position + std::strlen("-fps=")));
+	}
+	if (commandLine.find("-novsync") != std::string::npos) {
+		dxBase->SetVSync(false);
+	}
+
+	// 起動オプションに -cook が指定されていれば画像をDDSに変換する（-cook-fast では半透明の画像にBC3を使う）
+	if (!isHeadless && commandLine.find("-cook") != std::string::npos) {
+		TextureCooker::CookDirectory("resources", commandLine.find("-cook-fast") == std::string::npos);
+	}
+
+	// 起動オプションに -benchmark が指定されていれば計測を行う
+	if (!isHeadless && commandLine.find("-benchmark") != std::string::npos) {
+		// 同じメッシュのObjとglTFバイナリの読み込みを比較
+		Benchmark::CompareModelLoad("resources/Models", { "axis", "monkey", "multiMaterial", "multiMesh", "plane", "sphere", "teapot", "triangle" }, dxBase->GetDevice());
+		// Objの通常の読み込みとストリーミング読み込みのメモリ使用量を比較
+		Benchmark::CompareObjLoaders("resources/Models", { "teapot" }, dxBase->GetDevice());
+		// 画像のデコードと変換済みのDDSの読み込みを比較
+		Benchmark::CompareTextureLoad({ "resources/Images/checkerBoard.png", "resources/Images/monsterBall.png", "resources/Images/uvChecker.png", "resources/Images/white.png" });
+		// 画像のデコードとミップマップ生成をスレッド数を変えて計測
+		Benchmark::MeasureTextureDecodeThreads({ "resources/Images", "resources/Models" }, GetDefaultThreadCount());
+		// SRVの場所の確保と解放を計測
+		Benchmark::MeasureDescriptorAllocator(4096, 1000);
+		// ミップのストリーミングの常駐量を計測
+		Benchmark::SimulateMipStreaming(256, 600, 256ull * 1024 * 1024);
+		// アトラスへの矩形の詰め込みを計測
+		Benchmark::MeasureAtlasPacking(2000, 2048);
+		// ミップマップの生成をDirectXTexと比較
+		Benchmark::CompareMipGeneration({ 2048, 4096 }, GetDefaultThreadCount());
+		// PNGのデコードをWICと組み込みのデコーダで比較
+		Benchmark::CompareImageDecoders({ "resources/Images/checkerBoard.png", "resources/Images/monsterBall.png", "resources/Images/uvChecker.png", "resources/Images/white.png" }, GetDefaultThreadCount());
+		// 仮想テクスチャのフィードバックの処理と物理ページのキャッシュを計測
+		Benchmark::SimulateVirtualTexturing(65536, 32, 1200, 16);
+		// バッファを置くヒープの確保の速度と断片化を計測
+		Benchmark::MeasureHeapAllocator(256ull * 1024 * 1024, 200000);
+		// 同時にGPUで実行するフレームの数ごとのフレーム時間を模擬
+		Benchmark::SimulateFramesInFlight(DirectXBase::kMaxFramesInFlight, 10000);
+		// フレームレートの制限の精度を偽の時計と実際の時計で計測
+		Benchmark::MeasureFrameLimiter({ 60.0, 144.0, 240.0 }, 600);
+		// 描画の記録をスレッド数を変えて並列に行う
+		Benchmark::MeasureParallelRecording(50000, GetDefaultThreadCount());
+		// RenderGraphのコンパイルで生成されるバリアとパスを計測
+		Benchmark::CompileRenderGraph(64, 24, 200);
+		// 一時的なリソースのメモリの共有で減るメモリを計測
+		Benchmark::PlanTransientAliasing(32, 24, 200);
+	}
 
 	///
 	///	↓ ここから3Dオブジェクトの設定
 	/// 
 
-	// モデル読み込み
-	ModelData planeModel = ModelManager::LoadObjFile("resources/Models", "plane.obj", dxBase->GetDevice());
+	// モデル読み込み（ヘッドレスの場合はGPUのリソースを作れないので、plane.objと同じ大きさの頂点バッファの無いモデルを使う）
+	// ModelManagerのキャッシュから取得し、終了時に解放する（使われなくなったモデルは予算を超えると追い出される）
+	ModelData headlessPlaneModel{};
+	ModelData* planeModel = &headlessPlaneModel;
+	if (isHeadless) {
+		headlessPlaneModel.vertexCount = 4;
+		headlessPlaneModel.indexCount = 6;
+		headlessPlaneModel.boundsMin = { -1.0f, -1.0f, 0.0f };
+		headlessPlaneModel.boundsMax = { 1.0f, 1.0f, 0.0f };
+	} else {
+		planeModel = ModelManager::Acquire("resources/Models", "plane.obj", dxBase->GetDevice());
+	}
 
 	// 平面オブジェクトの生成
 	Object3D plane;
 	// モデルを指定
-	plane.model_ = &planeModel;
+	plane.model_ = planeModel;
 	// 初期回転角を設定
 	plane.transform_.rotate.y = 3.0f;
 
+	// 起動オプション -draws=N で平面をN個並べ、描画を複数のスレッドで記録する
+	std::vector<std::unique_ptr<Object3D>> crowd;
+	ConstBuffer<Material> crowdMaterialCB(false, true);
+	crowdMaterialCB.data_->color = { 1.0f, 1.0f, 1.0f, 1.0f };
+	crowdMaterialCB.data_->enableLighting = true;
+	crowdMaterialCB.data_->uvTransform = Matrix::Identity();
+	if (size_t position = commandLine.find("-draws="); position != std::string::npos) {
+		size_t drawCount = std::strtoull(commandLine.c_str() + position + std::strlen("-draws="), nullptr, 10);
+		size_t columns = size_t(std::ceil(std::sqrt(double(drawCount))));
+		for (size_t i = 0; i < drawCount; ++i) {
+			auto object = std::make_unique<Object3D>(true);
+			object->model_ = planeModel;
+			object->sharedMaterialCB_ = &crowdMaterialCB;
+			object->transform_.translate = { (float(i % columns) - float(columns) * 0.5f) * 2.0f, (float(i / columns) - float(columns) * 0.5f) * 2.0f, 20.0f };
+			crowd.push_back(std::move(object));
+		}
+	}
+
 	///
 	///	↑ ここまで3Dオブジェクトの設定
 	/// 
@@ -68,80 +196,77 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	///	↓ ここからスプライトの設定
 	/// 
 
-	// Sprite用のリソースを作る
-	Microsoft::WRL::ComPtr <ID3D12Resource> vertexResourceSprite = CreateBufferResource(dxBase->GetDevice(), sizeof(VertexData) * 4);
-
-	// 頂点バッファビューを作成する
+	// Sprite用の頂点とインデックスのリソース（ヘッドレスの場合は作らない）
+	Microsoft::WRL::ComPtr<ID3D12Resource> vertexResourceSprite;
+	Microsoft::WRL::ComPtr<ID3D12Resource> indexResourceSprite;
 	D3D12_VERTEX_BUFFER_VIEW vertexBufferViewSprite{};
-	// リソースの先頭のアドレスから使う
-	vertexBufferViewSprite.BufferLocation = vertexResourceSprite->GetGPUVirtualAddress();
-	// 使用するリソースのサイズは頂点4つ分のサイズ
-	vertexBufferViewSprite.SizeInBytes = sizeof(VertexData) * 4;
-	// 1頂点あたりのサイズ
-	vertexBufferViewSprite.StrideInBytes = sizeof(VertexData);
-
-	// 頂点データを設定
-	VertexData* vertexDataSprite = nullptr;
-	vertexResourceSprite->Map(0, nullptr, reinterpret_cast<void**>(&vertexDataSprite));
-	// 1枚目の三角形
-	// 左下
-	vertexDataSprite[0].position = { 0.0f, 360.0f, 0.0f, 1.0f };
-	vertexDataSprite[0].texcoord = { 0.0f, 1.0f };
-	vertexDataSprite[0].normal = { 0.0f, 0.0f, -1.0f };
-	// 左上
-	vertexDataSprite[1].position = { 0.0f, 0.0f, 0.0f, 1.0f };
-	vertexDataSprite[1].texcoord = { 0.0f, 0.0f };
-	vertexDataSprite[1].normal = { 0.0f, 0.0f, -1.0f };
-	// 右下
-	vertexDataSprite[2].position = { 640.0f, 360.0f, 0.0f, 1.0f };
-	vertexDataSprite[2].texcoord = { 1.0f, 1.0f };
-	vertexDataSprite[2].normal = { 0.0f, 0.0f, -1.0f };
-	// 右上
-	vertexDataSprite[3].position = { 640.0f, 0.0f, 0.0f, 1.0f };
-	vertexDataSprite[3].texcoord = { 1.0f, 0.0f };
-	vertexDataSprite[3].normal = { 0.0f, 0.0f, -1.0f };
-
-
-	// 頂点インデックスの作成
-	Microsoft::WRL::ComPtr<ID3D12Resource> indexResourceSprite = CreateBufferResource(dxBase->GetDevice(), sizeof(uint32_t) * 6);
-
-	// IndexBufferViewの作成
 	D3D12_INDEX_BUFFER_VIEW indexBufferViewSprite{};
-	// リソースの先頭のアドレスから使う
-	indexBufferViewSprite.BufferLocation = indexResourceSprite->GetGPUVirtualAddress();
-	// 使用するリソースのサイズはインデックス6つ分のサイズ
-	indexBufferViewSprite.SizeInBytes = sizeof(uint32_t) * 6;
-	// インデックスはuint32_tとする
-	indexBufferViewSprite.Format = DXGI_FORMAT_R32_UINT;
-
-	// インデックスリソースにデータを書き込む
-	uint32_t* indexDataSprite = nullptr;
-	indexResourceSprite->Map(0, nullptr, reinterpret_cast<void**>(&indexDataSprite));
-	indexDataSprite[0] = 0; indexDataSprite[1] = 1; indexDataSprite[2] = 2;
-	indexDataSprite[3] = 1; indexDataSprite[4] = 3; indexDataSprite[5] = 2;
-
-
-	// Sprite用のTransformationMatrix用のリソースを作る。Matrix 1つ分のサイズを用意する
-	Microsoft::WRL::ComPtr <ID3D12Resource> transformationMatrixResourceSprite = CreateBufferResource(dxBase->GetDevice(), sizeof(TransformationMatrix));
-	// データを書き込む
-	TransformationMatrix* transformationMatrixDataSprite = nullptr;
-	// 書き込むためのアドレスを取得
-	transformationMatrixResourceSprite->Map(0, nullptr, reinterpret_cast<void**>(&transformationMatrixDataSprite));
+	if (!isHeadless) {
+		// Sprite用のリソースを作る
+		vertexResourceSprite = CreateBufferResource(dxBase->GetDevice(), sizeof(VertexData) * 4, ResourceCategory::Mesh);
+
+		// 頂点バッファビューを作成する
+		// リソースの先頭のアドレスから使う
+		vertexBufferViewSprite.BufferLocation = vertexResourceSprite->GetGPUVirtualAddress();
+		// 使用するリソースのサイズは頂点4つ分のサイズ
+		vertexBufferViewSprite.SizeInBytes = sizeof(VertexData) * 4;
+		// 1頂点あたりのサイズ
+		vertexBufferViewSprite.StrideInBytes = sizeof(VertexData);
+
+		// 頂点データを設定
+		VertexData* vertexDataSprite = nullptr;
+		vertexResourceSprite->Map(0, nullptr, reinterpret_cast<void**>(&vertexDataSprite));
+		// 1枚目の三角形
+		// 左下
+		vertexDataSprite[0].position = { 0.0f, 360.0f, 0.0f, 1.0f };
+		vertexDataSprite[0].texcoord = { 0.0f, 1.0f };
+		vertexDataSprite[0].normal = { 0.0f, 0.0f, -1.0f };
+		// 左上
+		vertexDataSprite[1].position = { 0.0f, 0.0f, 0.0f, 1.0f };
+		vertexDataSprite[1].texcoord = { 0.0f, 0.0f };
+		vertexDataSprite[1].normal = { 0.0f, 0.0f, -1.0f };
+		// 右下
+		vertexDataSprite[2].position = { 640.0f, 360.0f, 0.0f, 1.0f };
+		vertexDataSprite[2].texcoord = { 1.0f, 1.0f };
+		vertexDataSprite[2].normal = { 0.0f, 0.0f, -1.0f };
+		// 右上
+		vertexDataSprite[3].position = { 640.0f, 0.0f, 0.0f, 1.0f };
+		vertexDataSprite[3].texcoord = { 1.0f, 0.0f };
+		vertexDataSprite[3].normal = { 0.0f, 0.0f, -1.0f };
+
+
+		// 頂点インデックスの作成
+		indexResourceSprite = CreateBufferResource(dxBase->GetDevice(), sizeof(uint32_t) * 6, ResourceCategory::Mesh);
+
+		// IndexBufferViewの作成
+		// リソースの先頭のアドレスから使う
+		indexBufferViewSprite.BufferLocation = indexResourceSprite->GetGPUVirtualAddress();
+		// 使用するリソースのサイズはインデックス6つ分のサイズ
+		indexBufferViewSprite.SizeInBytes = sizeof(uint32_t) * 6;
+		// インデックスはuint32_tとする
+		indexBufferViewSprite.Format = DXGI_FORMAT_R32_UINT;
+
+		// インデックスリソースにデータを書き込む
+		uint32_t* indexDataSprite = nullptr;
+		indexResourceSprite->Map(0, nullptr, reinterpret_cast<void**>(&indexDataSprite));
+		indexDataSprite[0] = 0; indexDataSprite[1] = 1; indexDataSprite[2] = 2;
+		indexDataSprite[3] = 1; indexDataSprite[4] = 3; indexDataSprite[5] = 2;
+	}
+
+
+	// Sprite用のTransformationMatrix（毎フレーム書き換えるので、描画時にそのフレームだけ使う領域に書き込む）
+	TransformationMatrix transformationMatrixSprite{};
 	// 単位行列を書き込んでおく
-	transformationMatrixDataSprite->WVP = Matrix::Identity();
-
-	// Sprite用のマテリアルのリソースを作る
-	Microsoft::WRL::ComPtr <ID3D12Resource> materialResourceSprite = CreateBufferResource(dxBase->GetDevice(), sizeof(Material));
-	// マテリアルにデータを書き込む
-	Material* materialDataSprite = nullptr;
-	// 書き込むためのアドレスを取得
-	materialResourceSprite->Map(0, nullptr, reinterpret_cast<void**>(&materialDataSprite));
+	transformationMatrixSprite.WVP = Matrix::Identity();
+
+	// Sprite用のマテリアル（uvTransformを毎フレーム書き換えるので、描画時にそのフレームだけ使う領域に書き込む）
+	Material materialSprite{};
 	// 輝度を白に設定
-	materialDataSprite->color = Float4(1.0f, 1.0f, 1.0f, 1.0f);
+	materialSprite.color = Float4(1.0f, 1.0f, 1.0f, 1.0f);
 	// SpriteはLightingしないのでfalseを設定する
-	materialDataSprite->enableLighting = false;
+	materialSprite.enableLighting = false;
 	// UVTransform行列を単位行列で初期化
-	materialDataSprite->uvTransform = Matrix::Identity();
+	materialSprite.uvTransform = Matrix::Identity();
 
 
 	// CPUで動かす用のTransformを作る
@@ -155,16 +280,12 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	/// ↓ ここから光源の設定
 	/// 
 
-	// 平行光源のResourceを作成
-	Microsoft::WRL::ComPtr <ID3D12Resource> directionalLightResource = CreateBufferResource(dxBase->GetDevice(), sizeof(DirectionalLight));
-	// データを書き込む
-	DirectionalLight* directionalLightData = nullptr;
-	// 書き込むためのアドレスを取得
-	directionalLightResource->Map(0, nullptr, reinterpret_cast<void**>(&directionalLightData));
+	// 平行光源（ImGuiで書き換えるので、描画時にそのフレームだけ使う領域に書き込む）
+	DirectionalLight directionalLight{};
 	// デフォルト値を書き込む
-	directionalLightData->color = { 1.0f,1.0f,1.0f,1.0f };
-	directionalLightData->direction = { 0.0f, -1.0f, 0.0f };
-	directionalLightData->intensity = 1.0f;
+	directionalLight.color = { 1.0f,1.0f,1.0f,1.0f };
+	directionalLight.direction = { 0.0f, -1.0f, 0.0f };
+	directionalLight.intensity = 1.0f;
 
 	///
 	/// ↑ ここまで光源の設定
@@ -174,8 +295,15 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	Camera camera{ {0.0f, 0.0f, -10.0f}, {0.0f, 0.0f, 0.0f}, 0.45f };
 	Camera::Set(&camera);
 
-	// Textureを読み込む
-	uint32_t uvCheckerGH = TextureManager::Load("resources/Images/uvChecker.png", dxBase->GetDevice());
+	// Textureを読み込む（ヘッドレスの場合は読み込まず、描画では設定を数えるだけになる）
+	uint32_t uvCheckerGH = 0;
+	if (!isHeadless) {
+		uvCheckerGH = TextureManager::Load("resources/Images/uvChecker.png", dxBase->GetDevice());
+
+		// モデルとテクスチャのファイルを監視する
+		AssetHotReloader::WatchModel(planeModel, "resources/Models", "plane.obj");
+		AssetHotReloader::WatchTexture(uvCheckerGH, "resources/Images/uvChecker.png");
+	}
 
 	// UVTransform用の変数を用意
 	Transform uvTransformSprite{
@@ -189,19 +317,43 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	// 演出を行うかどうかのフラグ
 	bool isActiveParticle = false;
 
-	// ウィンドウの×ボタンが押されるまでループ
-	while (!Window::ProcessMessage()) {
+	// ヘッドレスの場合のフレームの数と、CPUのフレーム時間（ミリ秒）
+	uint64_t frameCount = 0;
+	std::vector<double> headlessFrameTimes;
+	headlessFrameTimes.reserve(size_t(isHeadless ? headlessFrameCount : 0));
+
+	// ウィンドウの×ボタンが押されるまで（ヘッドレスの場合は指定したフレームの数だけ）ループ
+	while (isHeadless ? frameCount < headlessFrameCount : !Window::ProcessMessage()) {
+		auto frameStart = std::chrono::steady_clock::now();
+		if (!isHeadless) {
+			// 読み直したアセットの差し替え
+			AssetHotReloader::Update();
+			// 解放したTextureの後片付けと、足りなくなったDescriptorHeapの拡張
+			if (TextureManager::Update(dxBase->GetDevice())) {
+				// ImGuiのリソースは作り直すとすぐに解放されるので、前のフレームをGPUが終えるまで待つ
+				dxBase->WaitForGpu();
+				ImguiWrapper::ResetDescriptorHeap(dxBase->GetDevice(), dxBase->GetFramesInFlight(), dxBase->GetRtvDesc().Format, TextureManager::GetInstance().srvHeap_.heap_.Get());
+			}
+		}
+		// 追い出したモデルの後片付けと、予算を超えている場合の使われていないキャッシュの追い出し
+		ModelManager::Update();
+		ResourceBudget::GetInstance().Enforce();
+		// 前のフレームで描画したTextureの画面上の大きさから、常駐させるミップを更新する
+		if (!isHeadless) {
+			TextureManager::UpdateStreaming(MipCamera{ camera.transform.translate, camera.fov, float(Window::GetHeight()) }, dxBase->GetDevice());
+		}
 		// フレーム開始処理
 		dxBase->BeginFrame();
 		// 描画前処理
 		dxBase->PreDraw();
 
 		// 描画用のDescriptorHeapの設定
-		ID3D12DescriptorHeap* descriptorHeaps[] = { TextureManager::GetInstance().srvHeap_.heap_.Get() };
-		dxBase->GetCommandList()->SetDescriptorHeaps(1, descriptorHeaps);
+		dxBase->SetDescriptorHeap(TextureManager::GetInstance().srvHeap_.heap_.Get());
 
 		// ImGuiのフレーム開始処理
-		ImguiWrapper::NewFrame();
+		if (!isHeadless) {
+			ImguiWrapper::NewFrame();
+		}
 
 		///
 		///	更新処理
@@ -211,30 +363,46 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 
 		// 平面オブジェクトの行列更新
 		plane.UpdateMatrix();
+		dxBase->GetWorkerPool().ParallelFor(crowd.size(), 0, [&](size_t index) { crowd[index]->UpdateMatrix(); });
 
 		// Sprite用のWorldViewProjectionMatrixを作る
 		Matrix worldMatrixSprite = transformSprite.MakeAffineMatrix();
 		Matrix viewMatrixSprite = Matrix::Identity();
 		Matrix projectionMatrixSprite = Matrix::Orthographic(static_cast<float>(Window::GetWidth()), static_cast<float>(Window::GetHeight()), 0.0f, 1000.0f);
 		Matrix worldViewProjectionMatrixSprite = worldMatrixSprite * viewMatrixSprite * projectionMatrixSprite;
-		transformationMatrixDataSprite->WVP = worldViewProjectionMatrixSprite;
-		transformationMatrixDataSprite->World = worldMatrixSprite;
+		transformationMatrixSprite.WVP = worldViewProjectionMatrixSprite;
+		transformationMatrixSprite.World = worldMatrixSprite;
 
 
 		// UVTransform用の行列を生成する
 		Matrix uvTransformMatrix = Matrix::Scaling(uvTransformSprite.scale);
 		uvTransformMatrix = uvTransformMatrix * Matrix::RotationZ(uvTransformSprite.rotate.z);
 		uvTransformMatrix = uvTransformMatrix * Matrix::Translation(uvTransformSprite.translate);
-		materialDataSprite->uvTransform = uvTransformMatrix;
-
-		// ImGui
-		ImGui::Begin("Settings");
-		ImGui::DragFloat3("translate", &plane.transform_.translate.x, 0.01f);
-		ImGui::DragFloat3("rotate", &plane.transform_.rotate.x, 0.01f);
-		ImGui::DragFloat3("scale", &plane.transform_.scale.x, 0.01f);
-		ImGui::ColorEdit4("color", &plane.materialCB_.data_->color.x);
-		ImGui::DragFloat("Intensity", &directionalLightData->intensity, 0.01f);
-		ImGui::End();
+		materialSprite.uvTransform = uvTransformMatrix;
+
+		// ImGui（ヘッドレスの場合は使わない）
+		if (!isHeadless) {
+			ImGui::Begin("Settings");
+			ImGui::DragFloat3("translate", &plane.transform_.translate.x, 0.01f);
+			ImGui::DragFloat3("rotate", &plane.transform_.rotate.x, 0.01f);
+			ImGui::DragFloat3("scale", &plane.transform_.scale.x, 0.01f);
+			ImGui::ColorEdit4("color", &plane.materialCB_.data_->color.x);
+			ImGui::DragFloat("Intensity", &directionalLight.intensity, 0.01f);
+			const FrameLimiter& frameLimiter = dxBase->GetFrameLimiter();
+			ImGui::Text("Frame %.2fms (average %.2fms, %.1ffps)", frameLimiter.GetFrameInterval(), frameLimiter.GetAverageFrameInterval(), 1000.0 / (std::max)(frameLimiter.GetAverageFrameInterval(), 0.001));
+			ImGui::End();
+
+			// GPUリソースの使用量
+			ImGui::Begin("Memory");
+			ResourceBudget& resourceBudget = ResourceBudget::GetInstance();
+			ImGui::Text("Total %.1fMB (peak %.1fMB) / budget %.1fMB", resourceBudget.GetTotalUsage() / 1048576.0, resourceBudget.GetTotalPeak() / 1048576.0, resourceBudget.GetBudget() / 1048576.0);
+			for (size_t i = 0; i < size_t(ResourceCategory::Count); ++i) {
+				ResourceCategory category = ResourceCategory(i);
+				ImGui::Text("%s : %.2fMB (peak %.2fMB)", ResourceBudget::GetCategoryName(category), resourceBudget.GetUsage(category) / 1048576.0, resourceBudget.GetPeak(category) / 1048576.0);
+			}
+			ImGui::Text("Buffer heaps : %u, used %.1fMB, free %.1fMB, fragmentation %.2f", BufferHeapAllocator::GetHeapCount(), BufferHeapAllocator::GetUsedSize() / 1048576.0, BufferHeapAllocator::GetFreeSize() / 1048576.0, BufferHeapAllocator::GetFragmentation());
+			ImGui::End();
+		}
 
 		//////////////////////////////////////////////////////
 
@@ -242,52 +410,127 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 		///	描画処理
 		/// 
 
-		// 平行光源の情報の定数バッファのセット
-		dxBase->GetCommandList()->SetGraphicsRootConstantBufferView(3, directionalLightResource->GetGPUVirtualAddress());
-		// カメラの定数バッファを設定
-		Camera::TransferConstantBuffer();
-
-		///
-		/// ↓ ここから3Dオブジェクトの描画コマンド
-		/// 
-
-		// 平面オブジェクトの描画
-		plane.Draw(uvCheckerGH);
-
-		///
-		/// ↑ ここまで3Dオブジェクトの描画コマンド
-		/// 
-
-		///
-		/// ↓ ここからスプライトの描画コマンド
-		/// 
-
-		// VBVを設定
-		dxBase->GetCommandList()->IASetVertexBuffers(0, 1, &vertexBufferViewSprite);
-		// IBVを設定
-		dxBase->GetCommandList()->IASetIndexBuffer(&indexBufferViewSprite);
-		// マテリアルCBufferの場所を設定
-		dxBase->GetCommandList()->SetGraphicsRootConstantBufferView(0, materialResourceSprite->GetGPUVirtualAddress());
-		// TransformatinMatrixCBufferの場所を設定
-		dxBase->GetCommandList()->SetGraphicsRootConstantBufferView(1, transformationMatrixResourceSprite->GetGPUVirtualAddress());
-		// SRVのDescriptorTableの先頭を設定
-		TextureManager::SetDescriptorTable(2, dxBase->GetCommandList(), uvCheckerGH);
-		// 描画（DrawCall/ドローコール）6個のインデックスを使用し1つのインスタンスを描画
-		/*dxBase->GetCommandList()->DrawIndexedInstanced(6, 1, 0, 0, 0);*/
-
-		///
-		/// ↑ ここまでスプライトの描画コマンド
-		/// 
-
-		// ImGuiの内部コマンドを生成する
-		ImguiWrapper::Render(dxBase->GetCommandList());
-		// 描画後処理
+		// 3Dオブジェクトとスプライトを描画するパス（クリアした画面に重ねて描くので、読むことも宣言する）
+		RenderGraph& frameGraph = dxBase->GetFrameGraph();
+		uint32_t scenePass = frameGraph.AddPass("Scene", [&](ID3D12GraphicsCommandList*) {
+			// 描画の記録先（ヘッドレスの場合は呼び出しを数えるだけ）
+			RenderBackend& backend = dxBase->GetBackend();
+			// 平行光源の情報の定数バッファのセット
+			D3D12_GPU_VIRTUAL_ADDRESS directionalLightAddress = ConstantBufferAllocator::Upload(directionalLight);
+			backend.SetConstantBuffer(3, directionalLightAddress);
+			// カメラの定数バッファを設定
+			Camera::TransferConstantBuffer();
+
+			///
+			/// ↓ ここから3Dオブジェクトの描画コマンド
+			/// 
+
+			// 平面オブジェクトの描画
+			plane.Draw(uvCheckerGH);
+
+			// 並べた平面の描画を複数のスレッドで記録する（共有マテリアルは複数のスレッドから読むので先に書き込んでおく）
+			if (!crowd.empty()) {
+				crowdMaterialCB.Flush();
+				dxBase->RecordDrawsInParallel(crowd.size(), [&](RenderBackend& chunkBackend) {
+					chunkBackend.SetConstantBuffer(3, directionalLightAddress);
+					Camera::TransferConstantBuffer(chunkBackend);
+				}, [&](RenderBackend& chunkBackend, size_t drawIndex) {
+					crowd[drawIndex]->Draw(chunkBackend, uvCheckerGH);
+				});
+			}
+
+			///
+			/// ↑ ここまで3Dオブジェクトの描画コマンド
+			/// 
+
+			///
+			/// ↓ ここからスプライトの描画コマンド
+			/// 
+
+			// VBVを設定
+			backend.SetVertexBuffer(vertexBufferViewSprite);
+			// IBVを設定
+			backend.SetIndexBuffer(indexBufferViewSprite);
+			// マテリアルCBufferの場所を設定
+			backend.SetConstantBuffer(0, ConstantBufferAllocator::Upload(materialSprite));
+			// TransformatinMatrixCBufferの場所を設定
+			backend.SetConstantBuffer(1, ConstantBufferAllocator::Upload(transformationMatrixSprite));
+			// SRVのDescriptorTableの先頭を設定
+			backend.SetTexture(2, uvCheckerGH);
+			// 描画（DrawCall/ドローコール）6個のインデックスを使用し1つのインスタンスを描画
+			/*backend.DrawIndexed(6);*/
+
+			///
+			/// ↑ ここまでスプライトの描画コマンド
+			/// 
+		});
+		frameGraph.Read(scenePass, dxBase->GetBackBufferResource(), ResourceState::RenderTarget);
+		frameGraph.Write(scenePass, dxBase->GetBackBufferResource(), ResourceState::RenderTarget);
+		frameGraph.Read(scenePass, dxBase->GetDepthResource(), ResourceState::DepthWrite);
+		frameGraph.Write(scenePass, dxBase->GetDepthResource(), ResourceState::DepthWrite);
+
+		// ImGuiの内部コマンドを生成するパス
+		if (!isHeadless) {
+			uint32_t imguiPass = frameGraph.AddPass("ImGui", [](ID3D12GraphicsCommandList* commandList) {
+				ImguiWrapper::Render(commandList);
+			});
+			frameGraph.Read(imguiPass, dxBase->GetBackBufferResource(), ResourceState::RenderTarget);
+			frameGraph.Write(imguiPass, dxBase->GetBackBufferResource(), ResourceState::RenderTarget);
+		}
+		// 描画後処理（パスを順に記録して提出する）
 		dxBase->PostDraw();
 		// フレーム終了処理
 		dxBase->EndFrame();
+		// GPUが使い終わった定数データのページと定数バッファの領域を再利用する
+		ConstantBufferAllocator::EndFrame();
+		ConstantBufferPool::EndFrame();
+		// GPUが使い終わったバッファのヒープの範囲を再利用する
+		if (!isHeadless) {
+			BufferHeapAllocator::EndFrame();
+		}
+
+		frameCount++;
+		if (isHeadless) {
+			headlessFrameTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+		}
+	}
+
+	if (isHeadless) {
+		// CPUのフレーム時間の平均と中央値、最大値と、1フレームあたりの描画の呼び出しの回数
+		std::vector<double> sortedTimes = headlessFrameTimes;
+		std::sort(sortedTimes.begin(), sortedTimes.end());
+		double totalTime = 0.0;
+		for (double time : sortedTimes) {
+			totalTime += time;
+		}
+		double frames = double((std::max)(frameCount, uint64_t(1)));
+		const RenderCallCounts& counts = dxBase->GetHeadlessCounts();
+		Log(std::format("Headless : {} frames, cpu frame {:.3f}ms average, {:.3f}ms median, {:.3f}ms max\n",
+			frameCount, totalTime / frames, sortedTimes.empty() ? 0.0 : sortedTimes[sortedTimes.size() / 2], sortedTimes.empty() ? 0.0 : sortedTimes.back()));
+		Log(std::format("Headless : per frame {:.1f} passes, {:.1f} barriers, {:.1f} draws ({:.1f} vertices), {:.1f} constant buffers, {:.1f} textures, {:.1f} vertex buffers, {:.1f} index buffers\n",
+			double(counts.passes) / frames, double(counts.barriers) / frames, double(counts.draws) / frames, double(counts.vertices) / frames,
+			double(counts.constantBuffers) / frames, double(counts.textures) / frames, double(counts.vertexBuffers) / frames, double(counts.indexBuffers) / frames));
+	}
+
+	// 実行中のフレームをGPUが終えるまで待つ
+	dxBase->WaitForGpu();
+	if (!isHeadless) {
+		// ホットリロードの終了処理
+		AssetHotReloader::Finalize();
+		// モデルの解放
+		ModelManager::Release(planeModel);
+		// Textureの転送の終了処理
+		TextureUploader::Finalize();
+	}
+	// 定数データと定数バッファのページの解放
+	ConstantBufferAllocator::Finalize();
+	ConstantBufferPool::Finalize();
+	if (!isHeadless) {
+		// バッファを置いたヒープの解放
+		BufferHeapAllocator::Finalize();
+		// ImGuiの終了処理
+		ImguiWrapper::Finalize();
 	}
-	// ImGuiの終了処理
-	ImguiWrapper::Finalize();
 
 	// COMの終了処理
 	CoUninitialize();